@@ -0,0 +1,71 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.intel.oap.common.unsafe;
+
+import com.google.common.base.Preconditions;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+/**
+ * A batch of (destination, source, length) copy descriptors in a direct buffer, handed to the
+ * native batch copies so that many small copies cost a single JNI call.
+ */
+public class CopyDescriptors {
+  private static final int DESCRIPTOR_SIZE = 3 * 8;
+
+  private final ByteBuffer buffer;
+  private final int capacity;
+  private int count = 0;
+
+  public CopyDescriptors(int capacity) {
+    Preconditions.checkArgument(capacity > 0, "Capacity must be a positive number");
+    this.capacity = capacity;
+    this.buffer = ByteBuffer.allocateDirect(capacity * DESCRIPTOR_SIZE)
+      .order(ByteOrder.nativeOrder());
+  }
+
+  /**
+   * Add a copy of length bytes from the source to the destination address. For block I/O one
+   * of the addresses is a block index instead, see {@link PMemBlockPlatform#writeBatch}.
+   */
+  public void add(long destination, long source, long length) {
+    Preconditions.checkState(count < capacity, "Copy descriptors are full");
+    int offset = count * DESCRIPTOR_SIZE;
+    buffer.putLong(offset, destination);
+    buffer.putLong(offset + 8, source);
+    buffer.putLong(offset + 16, length);
+    count++;
+  }
+
+  public boolean isFull() {
+    return count == capacity;
+  }
+
+  public int count() {
+    return count;
+  }
+
+  public ByteBuffer buffer() {
+    return buffer;
+  }
+
+  public void clear() {
+    count = 0;
+  }
+}
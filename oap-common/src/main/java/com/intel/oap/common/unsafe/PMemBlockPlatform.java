@@ -21,6 +21,8 @@ import com.intel.oap.common.util.NativeLibraryLoader;
 import org.slf4j.Logger;
 import org.slf4j.LoggerFactory;
 
+import java.nio.ByteBuffer;
+
 public class PMemBlockPlatform {
 
     private static final Logger LOG = LoggerFactory.getLogger(PMemBlockPlatform.class);
@@ -47,8 +49,71 @@ public class PMemBlockPlatform {
 
     public static native void read(byte[] buffer, int index);
 
+    /**
+     * Write a batch of blocks in one call, each entry of the {@link CopyDescriptors} is
+     * (block index, source address, element size).
+     */
+    public static native void writeBatch(ByteBuffer descriptors, int count);
+
+    /**
+     * Read a batch of blocks in one call, each entry of the {@link CopyDescriptors} is
+     * (destination address, block index, element size).
+     */
+    public static native void readBatch(ByteBuffer descriptors, int count);
+
+    public static void writeBatch(CopyDescriptors descriptors) {
+        writeBatch(descriptors.buffer(), descriptors.count());
+    }
+
+    public static void readBatch(CopyDescriptors descriptors) {
+        readBatch(descriptors.buffer(), descriptors.count());
+    }
+
     public static native void clear(int index);
 
+    /**
+     * Create (or open) block pools striped across devices, global block i lives in pool
+     * i % paths.length. The pools can be file-backed for testing.
+     *
+     * @param paths      pool files, one per device
+     * @param threadNum  worker threads shared by the devices
+     */
+    public static native void createStriped(String[] paths, long elementSize, long poolSize,
+                                            int threadNum);
+
+    /**
+     * Write count blocks starting at startIndex from a contiguous off-heap buffer, in
+     * parallel across the striped devices.
+     */
+    public static native void writeRange(long address, long startIndex, int count);
+
+    /**
+     * Read count blocks starting at startIndex into a contiguous off-heap buffer, in
+     * parallel across the striped devices.
+     */
+    public static native void readRange(long address, long startIndex, int count);
+
+    public static native long getStripedBlockNum();
+
+    private static native long[] getDeviceStatsNative();
+
+    /**
+     * Get the bandwidth of every striped device in bytes per second, over all the bulk
+     * reads and writes so far.
+     */
+    public static double[] getDeviceBandwidth() {
+        long[] stats = getDeviceStatsNative();
+        double[] bandwidth = new double[stats.length / 2];
+        for (int i = 0; i < bandwidth.length; i++) {
+            long bytes = stats[2 * i];
+            long nanos = stats[2 * i + 1];
+            bandwidth[i] = nanos == 0 ? 0.0 : bytes * 1000000000.0 / nanos;
+        }
+        return bandwidth;
+    }
+
+    public static native void closeStriped();
+
     public static native void close();
 
     public static native int getBlockNum();
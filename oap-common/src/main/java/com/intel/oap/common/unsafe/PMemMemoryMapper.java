@@ -2,6 +2,8 @@ package com.intel.oap.common.unsafe;
 
 import com.intel.oap.common.util.NativeLibraryLoader;
 
+import java.nio.ByteBuffer;
+
 public class PMemMemoryMapper {
 
     private static final String LIBNAME = "pmemmemorymapper";
@@ -21,6 +23,19 @@ public class PMemMemoryMapper {
 
     public static native void pmemMemcpy(long pmemAddress, byte[] src, long length);
 
+    /**
+     * Copy all segments of a {@link CopyDescriptors} batch to pmem with non-temporal stores,
+     * and drain once at the end.
+     *
+     * @param descriptors direct buffer of (pmem address, source address, length) entries
+     * @param count       number of entries
+     */
+    public static native void pmemMemcpyBatch(ByteBuffer descriptors, int count);
+
+    public static void pmemMemcpyBatch(CopyDescriptors descriptors) {
+        pmemMemcpyBatch(descriptors.buffer(), descriptors.count());
+    }
+
     /**
      * Flush at final
      */
@@ -139,4 +139,86 @@ public class PersistentMemoryPlatform {
    * Free the memory by address.
    */
   public static native void freeMemory(long address);
+
+  /**
+   * Copy all segments of a {@link CopyDescriptors} batch in one call. Large segments are
+   * written with non-temporal stores and fenced once at the end.
+   * @param descriptors direct buffer of (destination, source, length) address entries
+   * @param count number of entries
+   */
+  public static native void copyMemoryBatch(ByteBuffer descriptors, int count);
+
+  public static void copyMemoryBatch(CopyDescriptors descriptors) {
+    copyMemoryBatch(descriptors.buffer(), descriptors.count());
+  }
+
+  /**
+   * Initialize the tiered DRAM/PMem allocator on top of the initialized persistent memory.
+   * Blocks are handed out as handles, the most frequently accessed ones are kept in DRAM
+   * and the rest are moved to persistent memory, within the given budgets.
+   * Only one tiered allocator can be initialized per process.
+   * @param dramBudget the max bytes kept in DRAM, 0 for no limit
+   * @param pmemBudget the max bytes kept in persistent memory, 0 for no limit
+   * @param sampleRate one in sampleRate accesses is counted for hot block detection
+   * @param rebalanceIntervalMs blocks are migrated in background on this interval, 0 to
+   *                            only migrate on {@link #rebalanceTieredMemory()}
+   */
+  public static void initializeTiered(long dramBudget, long pmemBudget, int sampleRate,
+      long rebalanceIntervalMs) {
+    synchronized (PersistentMemoryPlatform.class) {
+      Preconditions.checkState(initialized, "Persistent memory should be initialized first");
+      Preconditions.checkArgument(dramBudget >= 0 && pmemBudget >= 0,
+        "Tiered memory budgets must not be negative");
+      Preconditions.checkArgument(sampleRate > 0, "Sample rate must be a positive number");
+      initializeTieredNative(dramBudget, pmemBudget, sampleRate, rebalanceIntervalMs);
+    }
+  }
+
+  private static native void initializeTieredNative(long dramBudget, long pmemBudget,
+      int sampleRate, long rebalanceIntervalMs);
+
+  /**
+   * Allocate a block from the tiered allocator, new blocks go to DRAM while it is in budget.
+   * @param size the requested size
+   * @return the handle of the block, it stays valid when the block is migrated.
+   */
+  public static native long allocateTieredMemory(long size);
+
+  /**
+   * Get the current address of a tiered block and pin it in its tier. The address is only
+   * valid until {@link #releaseTieredMemory(long)}, every acquire must be released.
+   */
+  public static native long acquireTieredMemory(long handle);
+
+  /**
+   * Unpin a block acquired by {@link #acquireTieredMemory(long)}.
+   */
+  public static native void releaseTieredMemory(long handle);
+
+  /**
+   * Get the requested size of a tiered block.
+   */
+  public static native long getTieredSize(long handle);
+
+  /**
+   * Free a tiered block by handle. A handle of a freed block is no longer valid, even when
+   * its slot is reused by a later allocation.
+   * @throws IllegalStateException if the block is still acquired
+   */
+  public static native void freeTieredMemory(long handle);
+
+  /**
+   * Promote the hot blocks to DRAM and demote the cold ones to persistent memory now. Pinned
+   * blocks are skipped.
+   */
+  public static native void rebalanceTieredMemory();
+
+  /**
+   * Get the usage, DRAM hit ratio and migration bandwidth of the tiered allocator.
+   */
+  public static TieredMemoryStats getTieredMemoryStats() {
+    return new TieredMemoryStats(getTieredStatsNative());
+  }
+
+  private static native long[] getTieredStatsNative();
 }
@@ -0,0 +1,94 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.intel.oap.common.unsafe;
+
+/**
+ * A snapshot of the tiered DRAM/PMem allocator counters. Hits are sampled, so the hit ratio
+ * is an estimate over the accesses counted since initialization.
+ */
+public class TieredMemoryStats {
+  private final long dramUsed;
+  private final long pmemUsed;
+  private final long dramHits;
+  private final long pmemHits;
+  private final long promotedBytes;
+  private final long demotedBytes;
+  private final long migrationNanos;
+
+  TieredMemoryStats(long[] stats) {
+    this.dramUsed = stats[0];
+    this.pmemUsed = stats[1];
+    this.dramHits = stats[2];
+    this.pmemHits = stats[3];
+    this.promotedBytes = stats[4];
+    this.demotedBytes = stats[5];
+    this.migrationNanos = stats[6];
+  }
+
+  public long getDramUsed() {
+    return dramUsed;
+  }
+
+  public long getPmemUsed() {
+    return pmemUsed;
+  }
+
+  public long getDramHits() {
+    return dramHits;
+  }
+
+  public long getPmemHits() {
+    return pmemHits;
+  }
+
+  public long getPromotedBytes() {
+    return promotedBytes;
+  }
+
+  public long getDemotedBytes() {
+    return demotedBytes;
+  }
+
+  public long getMigrationNanos() {
+    return migrationNanos;
+  }
+
+  /**
+   * The fraction of sampled accesses served from DRAM.
+   */
+  public double getHitRatio() {
+    long total = dramHits + pmemHits;
+    return total == 0 ? 0.0 : (double) dramHits / total;
+  }
+
+  /**
+   * The migration copy bandwidth in bytes per second.
+   */
+  public double getMigrationBandwidth() {
+    return migrationNanos == 0 ? 0.0 :
+      (promotedBytes + demotedBytes) * 1000000000.0 / migrationNanos;
+  }
+
+  @Override
+  public String toString() {
+    return "TieredMemoryStats(dramUsed: " + dramUsed + ", pmemUsed: " + pmemUsed +
+      ", hitRatio: " + getHitRatio() + ", promotedBytes: " + promotedBytes +
+      ", demotedBytes: " + demotedBytes + ", migrationBandwidth: " +
+      getMigrationBandwidth() + ")";
+  }
+}
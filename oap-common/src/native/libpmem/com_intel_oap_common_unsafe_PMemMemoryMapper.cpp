@@ -23,6 +23,7 @@
 #include <cassert>
 #include <stdexcept>
 #include "com_intel_oap_common_unsafe_PMemMemoryMapper.h"
+#include "pmem_copy_batch.h"
 
 // copied form openjdk: http://hg.openjdk.java.net/jdk8/jdk8/hotspot/file/87ee5ee27509/src/share/vm/prims/unsafe.cpp
 inline void* addr_from_java(jlong addr) {
@@ -61,6 +62,15 @@ JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemMemoryMapper_pmemMem
     env->ReleaseByteArrayElements(src, srcBuf, 0);
 }
 
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemMemoryMapper_pmemMemcpyBatch
+  (JNIEnv *env, jclass clazz, jobject descriptors, jint count) {
+    const copy_descriptor* descs = get_copy_descriptors(env, descriptors, count);
+    if (descs == NULL) {
+      return;
+    }
+    pmem_copy_batch(descs, (size_t)count);
+}
+
 JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemMemoryMapper_pmemDrain
   (JNIEnv *env, jclass clazz) {
     pmem_drain();
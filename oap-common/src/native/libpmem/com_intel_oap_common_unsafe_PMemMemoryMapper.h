@@ -56,6 +56,14 @@ JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemMemoryMapper_pmemDra
 JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemMemoryMapper_pmemUnmap
   (JNIEnv *, jclass, jlong, jlong);
 
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemMemoryMapper
+ * Method:    pmemMemcpyBatch
+ * Signature: (Ljava/nio/ByteBuffer;I)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemMemoryMapper_pmemMemcpyBatch
+  (JNIEnv *, jclass, jobject, jint);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,60 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OAP_COMMON_COPY_DESCRIPTOR_H
+#define OAP_COMMON_COPY_DESCRIPTOR_H
+
+#include <jni.h>
+#include <cstdint>
+#include <string>
+
+// one entry of a scatter/gather copy, the layout matches
+// com.intel.oap.common.unsafe.CopyDescriptors. For block I/O one side of
+// the entry is a block index instead of an address.
+struct copy_descriptor {
+  uint64_t dst;
+  uint64_t src;
+  uint64_t len;
+};
+
+// the descriptors in a direct buffer, or NULL with an IllegalArgumentException
+// pending if the buffer is not direct or holds fewer than count entries
+inline const copy_descriptor* get_copy_descriptors(JNIEnv *env, jobject descriptors,
+                                                   jint count) {
+  const copy_descriptor* descs =
+    (const copy_descriptor*)env->GetDirectBufferAddress(descriptors);
+  if (descs == NULL) {
+    jclass exceptionCls = env->FindClass("java/lang/IllegalArgumentException");
+    env->ThrowNew(exceptionCls, "Copy descriptors should be a direct buffer");
+    return NULL;
+  }
+  jlong capacity = env->GetDirectBufferCapacity(descriptors);
+  if (count < 0 || capacity < (jlong)count * (jlong)sizeof(copy_descriptor)) {
+    jclass exceptionCls = env->FindClass("java/lang/IllegalArgumentException");
+    std::string errorMsg;
+    errorMsg.append("Copy descriptors buffer of ");
+    errorMsg.append(std::to_string(capacity));
+    errorMsg.append(" bytes can't hold ");
+    errorMsg.append(std::to_string(count));
+    errorMsg.append(" entries");
+    env->ThrowNew(exceptionCls, errorMsg.c_str());
+    return NULL;
+  }
+  return descs;
+}
+
+#endif  // OAP_COMMON_COPY_DESCRIPTOR_H
@@ -0,0 +1,36 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OAP_COMMON_PMEM_COPY_BATCH_H
+#define OAP_COMMON_PMEM_COPY_BATCH_H
+
+#include <libpmem.h>
+#include <cstddef>
+#include <cstdint>
+#include "copy_descriptor.h"
+
+// copy every segment with non-temporal stores and wait for all of them with a
+// single drain at the end, instead of one drain per segment
+inline void pmem_copy_batch(const copy_descriptor *descs, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    pmem_memcpy((void*)(uintptr_t)descs[i].dst, (const void*)(uintptr_t)descs[i].src,
+                descs[i].len, PMEM_F_MEM_NONTEMPORAL | PMEM_F_MEM_NODRAIN);
+  }
+  pmem_drain();
+}
+
+#endif  // OAP_COMMON_PMEM_COPY_BATCH_H
@@ -0,0 +1,115 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compare copying many small chunks into PMem one call at a time with the
+// batched scatter/gather copy.
+//
+//   pmem_copy_benchmark <pmem file> [chunk size] [chunk num]
+
+#include <libpmem.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+#include "pmem_copy_batch.h"
+
+// every variant copies with the flags pmem_copy_batch uses, so only the number
+// of calls and drains differs between them
+#define COPY_FLAGS (PMEM_F_MEM_NONTEMPORAL | PMEM_F_MEM_NODRAIN)
+
+typedef void (*copy_fn)(char* dst, const std::vector<char*>& chunks, size_t chunk_size);
+
+// one copy and one drain per chunk, as a pmemMemcpy followed by a pmemDrain
+// does per JNI call
+void copy_per_call(char* dst, const std::vector<char*>& chunks, size_t chunk_size) {
+  for (size_t i = 0; i < chunks.size(); i++) {
+    pmem_memcpy(dst + i * chunk_size, chunks[i], chunk_size, COPY_FLAGS);
+    pmem_drain();
+  }
+}
+
+// one call per chunk, drained once at the end
+void copy_per_call_single_drain(char* dst, const std::vector<char*>& chunks,
+                                size_t chunk_size) {
+  for (size_t i = 0; i < chunks.size(); i++) {
+    pmem_memcpy(dst + i * chunk_size, chunks[i], chunk_size, COPY_FLAGS);
+  }
+  pmem_drain();
+}
+
+void copy_batch(char* dst, const std::vector<char*>& chunks, size_t chunk_size) {
+  std::vector<copy_descriptor> descs(chunks.size());
+  for (size_t i = 0; i < chunks.size(); i++) {
+    descs[i].dst = (uint64_t)(uintptr_t)(dst + i * chunk_size);
+    descs[i].src = (uint64_t)(uintptr_t)chunks[i];
+    descs[i].len = chunk_size;
+  }
+  pmem_copy_batch(descs.data(), descs.size());
+}
+
+void run(const char* name, copy_fn fn, char* dst, const std::vector<char*>& chunks,
+         size_t chunk_size) {
+  // warm up once so page faults on the mapping are not measured
+  fn(dst, chunks, chunk_size);
+  int rounds = 5;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    fn(dst, chunks, chunk_size);
+  }
+  double seconds = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  double bytes = (double)chunk_size * chunks.size() * rounds;
+  printf("%-28s %10.2f MB/s %12.0f chunks/s\n", name, bytes / seconds / 1024 / 1024,
+         chunks.size() * rounds / seconds);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <pmem file> [chunk size] [chunk num]\n", argv[0]);
+    return -1;
+  }
+  const char* path = argv[1];
+  size_t chunk_size = argc > 2 ? strtoul(argv[2], NULL, 10) : 4096;
+  size_t chunk_num = argc > 3 ? strtoul(argv[3], NULL, 10) : 65536;
+  size_t len = chunk_size * chunk_num;
+
+  size_t mapped_len = 0;
+  int is_pmem = 0;
+  char* dst = (char*)pmem_map_file(path, len, PMEM_FILE_CREATE, 0666, &mapped_len, &is_pmem);
+  if (dst == NULL) {
+    perror("pmem_map_file");
+    return -1;
+  }
+  std::vector<char> src(len);
+  memset(src.data(), 'a', len);
+  // chunks are scattered in DRAM like the column chunks of a cache fill
+  std::vector<char*> chunks(chunk_num);
+  for (size_t i = 0; i < chunk_num; i++) {
+    chunks[i] = src.data() + ((i * 7919) % chunk_num) * chunk_size;
+  }
+
+  printf("%zu chunks of %zu bytes, is_pmem: %d\n", chunk_num, chunk_size, is_pmem);
+  run("per call", copy_per_call, dst, chunks, chunk_size);
+  run("per call, single drain", copy_per_call_single_drain, dst, chunks, chunk_size);
+  run("batch", copy_batch, dst, chunks, chunk_size);
+
+  pmem_unmap(dst, mapped_len);
+  unlink(path);
+  return 0;
+}
@@ -23,8 +23,30 @@
 #include <cassert>
 #include <stdexcept>
 #include "com_intel_oap_common_unsafe_PMemBlockPlatform.h"
+#include "copy_descriptor.h"
+#include "striped_blk.h"
 
 PMEMblkpool *pbp = NULL;
+striped_blk striped;
+
+// pmemblk always copies a whole block, so every entry of a batch must be
+// exactly one block long or the copy would run past the caller's buffer
+inline bool check_block_lengths(JNIEnv *env, const copy_descriptor* descs, jint count) {
+  size_t bsize = pmemblk_bsize(pbp);
+  for (jint i = 0; i < count; i++) {
+    if (descs[i].len != bsize) {
+      jclass exceptionCls = env->FindClass("java/lang/IllegalArgumentException");
+      std::string errorMsg;
+      errorMsg.append("Copy descriptor length ");
+      errorMsg.append(std::to_string(descs[i].len));
+      errorMsg.append(" doesn't match the pmem block size ");
+      errorMsg.append(std::to_string(bsize));
+      env->ThrowNew(exceptionCls, errorMsg.c_str());
+      return false;
+    }
+  }
+  return true;
+}
 
 /*
  * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
@@ -94,6 +116,60 @@ JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_read
   env->ReleaseByteArrayElements(jbuf, buf, 0);
 }
 
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
+ * Method:    writeBatch
+ * Signature: (Ljava/nio/ByteBuffer;I)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_writeBatch
+  (JNIEnv *env, jclass clazz, jobject descriptors, jint count) {
+
+  const copy_descriptor* descs = get_copy_descriptors(env, descriptors, count);
+  if (descs == NULL || !check_block_lengths(env, descs, count)) {
+    return;
+  }
+
+  for (jint i = 0; i < count; i++) {
+    // dst is the block index and src the address of the block content
+    long long index = (long long) descs[i].dst;
+    if (pmemblk_write(pbp, (const void*)(uintptr_t)descs[i].src, index) < 0) {
+      jclass exceptionCls = env->FindClass("java/lang/RuntimeException");
+      std::string errorMsg;
+      errorMsg.append("Fail to write pmem block on ");
+      errorMsg.append(std::to_string(index));
+      env->ThrowNew(exceptionCls, errorMsg.c_str());
+      return;
+    }
+  }
+}
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
+ * Method:    readBatch
+ * Signature: (Ljava/nio/ByteBuffer;I)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_readBatch
+  (JNIEnv *env, jclass clazz, jobject descriptors, jint count) {
+
+  const copy_descriptor* descs = get_copy_descriptors(env, descriptors, count);
+  if (descs == NULL || !check_block_lengths(env, descs, count)) {
+    return;
+  }
+
+  for (jint i = 0; i < count; i++) {
+    // dst is the address to read into and src the block index
+    long long index = (long long) descs[i].src;
+    if (pmemblk_read(pbp, (void*)(uintptr_t)descs[i].dst, index) < 0) {
+      jclass exceptionCls = env->FindClass("java/lang/RuntimeException");
+      std::string errorMsg;
+      errorMsg.append("Fail to read pmem block on ");
+      errorMsg.append(std::to_string(index));
+      env->ThrowNew(exceptionCls, errorMsg.c_str());
+      return;
+    }
+  }
+}
+
 /*
  * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
  * Method:    clear
@@ -134,3 +210,130 @@ JNIEXPORT jint JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_getBlo
 
   return pmemblk_nblock(pbp);
 }
+
+inline bool check_striped(JNIEnv *env) {
+  if (!striped.is_open()) {
+    jclass exceptionCls = env->FindClass("java/lang/RuntimeException");
+    env->ThrowNew(exceptionCls, "Striped pmem block pools should be created first!");
+    return false;
+  }
+  return true;
+}
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
+ * Method:    createStriped
+ * Signature: ([Ljava/lang/String;JJI)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_createStriped
+  (JNIEnv *env, jclass clazz, jobjectArray paths, jlong element_size, jlong pool_size,
+   jint thread_num) {
+
+  std::vector<std::string> s_paths;
+  jsize len = env->GetArrayLength(paths);
+  for (jsize i = 0; i < len; i++) {
+    jstring path = (jstring) env->GetObjectArrayElement(paths, i);
+    const char* s_path = env->GetStringUTFChars(path, NULL);
+    s_paths.push_back(s_path);
+    env->ReleaseStringUTFChars(path, s_path);
+    env->DeleteLocalRef(path);
+  }
+
+  int failed = striped.open(s_paths, (size_t) element_size, (size_t) pool_size,
+    (int) thread_num);
+  if (failed == STRIPED_NO_PATHS) {
+    jclass exceptionCls = env->FindClass("java/lang/IllegalArgumentException");
+    env->ThrowNew(exceptionCls, "Striped pmem block pools need at least one path");
+  } else if (failed >= 0) {
+    jclass exceptionCls = env->FindClass("java/lang/RuntimeException");
+    std::string errorMsg;
+    errorMsg.append("Fail to create pmem block pool on ");
+    errorMsg.append(s_paths[failed]);
+    env->ThrowNew(exceptionCls, errorMsg.c_str());
+  }
+}
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
+ * Method:    writeRange
+ * Signature: (JJI)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_writeRange
+  (JNIEnv *env, jclass clazz, jlong address, jlong start_index, jint count) {
+
+  if (!check_striped(env)) {
+    return;
+  }
+
+  long long failed = striped.write((const char*)(uintptr_t) address, start_index, count);
+  if (failed >= 0) {
+    jclass exceptionCls = env->FindClass("java/lang/RuntimeException");
+    std::string errorMsg;
+    errorMsg.append("Fail to write pmem block on ");
+    errorMsg.append(std::to_string(failed));
+    env->ThrowNew(exceptionCls, errorMsg.c_str());
+  }
+}
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
+ * Method:    readRange
+ * Signature: (JJI)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_readRange
+  (JNIEnv *env, jclass clazz, jlong address, jlong start_index, jint count) {
+
+  if (!check_striped(env)) {
+    return;
+  }
+
+  long long failed = striped.read((char*)(uintptr_t) address, start_index, count);
+  if (failed >= 0) {
+    jclass exceptionCls = env->FindClass("java/lang/RuntimeException");
+    std::string errorMsg;
+    errorMsg.append("Fail to read pmem block on ");
+    errorMsg.append(std::to_string(failed));
+    env->ThrowNew(exceptionCls, errorMsg.c_str());
+  }
+}
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
+ * Method:    getStripedBlockNum
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_getStripedBlockNum
+  (JNIEnv *env, jclass clazz) {
+
+  return striped.block_num();
+}
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
+ * Method:    getDeviceStatsNative
+ * Signature: ()[J
+ */
+JNIEXPORT jlongArray JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_getDeviceStatsNative
+  (JNIEnv *env, jclass clazz) {
+
+  std::vector<device_stats> stats = striped.get_stats();
+  std::vector<jlong> values;
+  for (auto &stat : stats) {
+    values.push_back((jlong) stat.bytes);
+    values.push_back((jlong) stat.nanos);
+  }
+  jlongArray result = env->NewLongArray(values.size());
+  env->SetLongArrayRegion(result, 0, values.size(), values.data());
+  return result;
+}
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
+ * Method:    closeStriped
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_closeStriped
+  (JNIEnv *env, jclass clazz) {
+
+  striped.close();
+}
@@ -48,6 +48,22 @@ JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_write
 JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_read
   (JNIEnv *, jclass, jbyteArray, jint);
 
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
+ * Method:    writeBatch
+ * Signature: (Ljava/nio/ByteBuffer;I)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_writeBatch
+  (JNIEnv *, jclass, jobject, jint);
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
+ * Method:    readBatch
+ * Signature: (Ljava/nio/ByteBuffer;I)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_readBatch
+  (JNIEnv *, jclass, jobject, jint);
+
 /*
  * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
  * Method:    clear
@@ -72,6 +88,54 @@ JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_close
 JNIEXPORT jint JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_getBlockNum
   (JNIEnv *, jclass);
 
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
+ * Method:    createStriped
+ * Signature: ([Ljava/lang/String;JJI)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_createStriped
+  (JNIEnv *, jclass, jobjectArray, jlong, jlong, jint);
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
+ * Method:    writeRange
+ * Signature: (JJI)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_writeRange
+  (JNIEnv *, jclass, jlong, jlong, jint);
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
+ * Method:    readRange
+ * Signature: (JJI)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_readRange
+  (JNIEnv *, jclass, jlong, jlong, jint);
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
+ * Method:    getStripedBlockNum
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_getStripedBlockNum
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
+ * Method:    getDeviceStatsNative
+ * Signature: ()[J
+ */
+JNIEXPORT jlongArray JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_getDeviceStatsNative
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PMemBlockPlatform
+ * Method:    closeStriped
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PMemBlockPlatform_closeStriped
+  (JNIEnv *, jclass);
+
 #ifdef __cplusplus
 }
 #endif
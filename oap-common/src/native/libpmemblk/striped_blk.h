@@ -0,0 +1,274 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OAP_COMMON_STRIPED_BLK_H
+#define OAP_COMMON_STRIPED_BLK_H
+
+#include <libpmemblk.h>
+#include <pthread.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define STRIPED_NO_PATHS -2
+
+struct device_stats {
+  uint64_t bytes;
+  uint64_t nanos;
+};
+
+// a fixed set of worker threads serving a task queue
+class blk_worker_pool {
+ public:
+  explicit blk_worker_pool(int thread_num) {
+    for (int i = 0; i < thread_num; i++) {
+      workers.emplace_back([this] { run(); });
+    }
+  }
+
+  ~blk_worker_pool() {
+    {
+      std::lock_guard<std::mutex> l(mtx);
+      stopping = true;
+    }
+    cv.notify_all();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  void submit(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> l(mtx);
+      tasks.push_back(std::move(task));
+    }
+    cv.notify_one();
+  }
+
+ private:
+  void run() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> l(mtx);
+        cv.wait(l, [this] { return stopping || !tasks.empty(); });
+        if (tasks.empty()) return;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::vector<std::thread> workers;
+  std::deque<std::function<void()>> tasks;
+  std::mutex mtx;
+  std::condition_variable cv;
+  bool stopping = false;
+};
+
+// holds a pthread rwlock for the life of the scope, shared or exclusive
+class rw_guard {
+ public:
+  rw_guard(pthread_rwlock_t *lock, bool exclusive) : lock(lock) {
+    if (exclusive) {
+      pthread_rwlock_wrlock(lock);
+    } else {
+      pthread_rwlock_rdlock(lock);
+    }
+  }
+  ~rw_guard() { pthread_rwlock_unlock(lock); }
+
+ private:
+  pthread_rwlock_t *lock;
+};
+
+/*
+ * Block pools striped across devices. Global block i lives in pool i % n at
+ * local index i / n, so a contiguous range of blocks touches every device.
+ * A bulk read or write gives every device its own share of the worker threads
+ * and returns when all of them are done, and the bytes and wall time spent on
+ * each device are accumulated for bandwidth reporting.
+ *
+ * I/O and stats calls share a lock that open and close take exclusively, so
+ * the pools are never closed under a running read or write.
+ */
+class striped_blk {
+ public:
+  ~striped_blk() {
+    close();
+    pthread_rwlock_destroy(&pools_lock);
+  }
+
+  // open the pools, closing any already open ones first. Return the index of
+  // the path that failed to open, STRIPED_NO_PATHS if paths is empty, or -1.
+  int open(const std::vector<std::string> &paths, size_t element_size,
+           size_t pool_size, int thread_num) {
+    rw_guard g(&pools_lock, true);
+    close_pools();
+    if (paths.empty()) return STRIPED_NO_PATHS;
+    for (size_t i = 0; i < paths.size(); i++) {
+      PMEMblkpool *pbp = pmemblk_create(paths[i].c_str(), element_size, pool_size, 0666);
+      if (pbp == NULL)
+        pbp = pmemblk_open(paths[i].c_str(), element_size);
+      if (pbp == NULL) {
+        close_pools();
+        return (int)i;
+      }
+      pools.push_back(pbp);
+    }
+    bsize = element_size;
+    nblock = SIZE_MAX;
+    for (auto pbp : pools) {
+      nblock = std::min(nblock, pmemblk_nblock(pbp));
+    }
+    stats.assign(pools.size(), device_stats{0, 0});
+    threads_per_device = std::max(1, thread_num / (int)pools.size());
+    workers.reset(new blk_worker_pool(threads_per_device * pools.size()));
+    return -1;
+  }
+
+  void close() {
+    rw_guard g(&pools_lock, true);
+    close_pools();
+  }
+
+  bool is_open() {
+    rw_guard g(&pools_lock, false);
+    return !pools.empty();
+  }
+
+  long long block_num() {
+    rw_guard g(&pools_lock, false);
+    return total_blocks();
+  }
+
+  // return the first block that failed, or -1. A range on closed pools fails
+  // at its start.
+  long long write(const char *src, long long start, long long count) {
+    return run(start, count, [src](PMEMblkpool *pbp, long long local, size_t offset) {
+      return pmemblk_write(pbp, src + offset, local);
+    });
+  }
+
+  long long read(char *dst, long long start, long long count) {
+    return run(start, count, [dst](PMEMblkpool *pbp, long long local, size_t offset) {
+      return pmemblk_read(pbp, dst + offset, local);
+    });
+  }
+
+  std::vector<device_stats> get_stats() {
+    rw_guard g(&pools_lock, false);
+    std::lock_guard<std::mutex> l(stats_mtx);
+    return stats;
+  }
+
+ private:
+  typedef std::function<int(PMEMblkpool*, long long, size_t)> block_op;
+
+  void close_pools() {
+    workers.reset();
+    for (auto pbp : pools) {
+      pmemblk_close(pbp);
+    }
+    pools.clear();
+  }
+
+  long long total_blocks() { return (long long)(nblock * pools.size()); }
+
+  long long run(long long start, long long count, block_op op) {
+    rw_guard g(&pools_lock, false);
+    long long n = (long long)pools.size();
+    long long end = start + count;
+    if (start < 0) return start;
+    if (n == 0) return start;
+    if (end > total_blocks()) return std::max(start, total_blocks());
+    if (count <= 0) return -1;
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::atomic<uint64_t>> elapsed(n);
+    std::atomic<long long> failed(-1);
+    std::mutex done_mtx;
+    std::condition_variable done_cv;
+    int pending = 0;
+    // only blocks that were read or written count towards the bandwidth
+    std::vector<std::atomic<uint64_t>> bytes(n);
+
+    std::unique_lock<std::mutex> l(done_mtx);
+    for (long long d = 0; d < n; d++) {
+      elapsed[d] = 0;
+      bytes[d] = 0;
+      // blocks of this device in the range are first, first + n, ...
+      long long first = start + ((d - start % n) + n) % n;
+      if (first >= end) continue;
+      long long device_count = (end - 1 - first) / n + 1;
+      long long per_task = (device_count + threads_per_device - 1) / threads_per_device;
+      for (long long from = 0; from < device_count; from += per_task) {
+        long long to = std::min(device_count, from + per_task);
+        pending++;
+        workers->submit([&, d, first, from, to] {
+          PMEMblkpool *pbp = pools[d];
+          uint64_t done = 0;
+          for (long long j = from; j < to && failed.load() < 0; j++) {
+            long long i = first + j * n;
+            if (op(pbp, i / n, (size_t)(i - start) * bsize) < 0) {
+              long long expected = -1;
+              failed.compare_exchange_strong(expected, i);
+            } else {
+              done += bsize;
+            }
+          }
+          bytes[d] += done;
+          uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count();
+          uint64_t cur = elapsed[d].load();
+          while (cur < nanos && !elapsed[d].compare_exchange_weak(cur, nanos)) {}
+          std::lock_guard<std::mutex> dl(done_mtx);
+          if (--pending == 0) done_cv.notify_one();
+        });
+      }
+    }
+    done_cv.wait(l, [&] { return pending == 0; });
+
+    std::lock_guard<std::mutex> sl(stats_mtx);
+    for (long long d = 0; d < n; d++) {
+      stats[d].bytes += bytes[d];
+      stats[d].nanos += elapsed[d];
+    }
+    return failed;
+  }
+
+  std::vector<PMEMblkpool*> pools;
+  size_t bsize = 0;
+  size_t nblock = 0;
+  int threads_per_device = 1;
+  std::unique_ptr<blk_worker_pool> workers;
+  std::vector<device_stats> stats;
+  std::mutex stats_mtx;
+  pthread_rwlock_t pools_lock = PTHREAD_RWLOCK_INITIALIZER;
+};
+
+#endif  // OAP_COMMON_STRIPED_BLK_H
@@ -22,11 +22,17 @@
 #include <cstdlib>
 #include <cassert>
 #include <stdexcept>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "com_intel_oap_common_unsafe_PersistentMemoryPlatform.h"
+#include "copy_descriptor.h"
+#include "tiered_allocator.h"
 
 using memkind = struct memkind;
 memkind *pmemkind = NULL;
 struct memkind_config *pmemkind_config;
+tiered_allocator *tiered = NULL;
 
 // copied form openjdk: http://hg.openjdk.java.net/jdk8/jdk8/hotspot/file/87ee5ee27509/src/share/vm/prims/unsafe.cpp
 inline void* addr_from_java(jlong addr) {
@@ -43,6 +49,34 @@ inline jlong addr_to_java(void* p) {
   return (uintptr_t)p;
 }
 
+// segments smaller than this are copied through the cache
+#define NT_COPY_THRESHOLD 256
+
+// copy with non-temporal stores so filling PMem does not evict the cpu cache,
+// the caller issues the store fence once for the whole batch
+inline void nt_memcpy(char *dest, const char *src, size_t sz) {
+#ifdef __SSE2__
+  if (sz >= NT_COPY_THRESHOLD) {
+    size_t head = (16 - ((uintptr_t)dest & 15)) & 15;
+    std::memcpy(dest, src, head);
+    dest += head;
+    src += head;
+    sz -= head;
+    for (; sz >= 64; sz -= 64, dest += 64, src += 64) {
+      __m128i x0 = _mm_loadu_si128((const __m128i*)src);
+      __m128i x1 = _mm_loadu_si128((const __m128i*)(src + 16));
+      __m128i x2 = _mm_loadu_si128((const __m128i*)(src + 32));
+      __m128i x3 = _mm_loadu_si128((const __m128i*)(src + 48));
+      _mm_stream_si128((__m128i*)dest, x0);
+      _mm_stream_si128((__m128i*)(dest + 16), x1);
+      _mm_stream_si128((__m128i*)(dest + 32), x2);
+      _mm_stream_si128((__m128i*)(dest + 48), x3);
+    }
+  }
+#endif
+  std::memcpy(dest, src, sz);
+}
+
 inline void check(JNIEnv *env) {
   if (NULL == pmemkind) {
     jclass exceptionCls = env->FindClass("java/lang/RuntimeException");
@@ -50,6 +84,13 @@ inline void check(JNIEnv *env) {
   }
 }
 
+inline void check_tiered(JNIEnv *env) {
+  if (NULL == tiered) {
+    jclass exceptionCls = env->FindClass("java/lang/RuntimeException");
+    env->ThrowNew(exceptionCls, "Tiered memory should be initialized first!");
+  }
+}
+
 JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_initializeKmem
   (JNIEnv *, jclass) {
   pmemkind = MEMKIND_DAX_KMEM;
@@ -132,3 +173,128 @@ JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform
   void *src = addr_from_java(source);
   std::memcpy(dest, src, sz);
 }
+
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_copyMemoryBatch
+  (JNIEnv *env, jclass clazz, jobject descriptors, jint count) {
+  const copy_descriptor *descs = get_copy_descriptors(env, descriptors, count);
+  if (descs == NULL) {
+    return;
+  }
+  for (jint i = 0; i < count; i++) {
+    nt_memcpy((char*)addr_from_java(descs[i].dst), (const char*)addr_from_java(descs[i].src),
+      (size_t)descs[i].len);
+  }
+#ifdef __SSE2__
+  _mm_sfence();
+#endif
+}
+
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_initializeTieredNative
+  (JNIEnv *env, jclass clazz, jlong dram_budget, jlong pmem_budget, jint sample_rate,
+   jlong interval_ms) {
+  check(env);
+  if (NULL == pmemkind) {
+    return;
+  }
+  if (NULL != tiered) {
+    jclass exceptionCls = env->FindClass("java/lang/IllegalStateException");
+    env->ThrowNew(exceptionCls, "Tiered memory is already initialized!");
+    return;
+  }
+  tiered = new tiered_allocator(MEMKIND_DEFAULT, pmemkind, (uint64_t)dram_budget,
+    (uint64_t)pmem_budget, (uint32_t)sample_rate, (uint64_t)interval_ms);
+}
+
+JNIEXPORT jlong JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_allocateTieredMemory
+  (JNIEnv *env, jclass clazz, jlong size) {
+  check_tiered(env);
+  if (NULL == tiered) {
+    return 0;
+  }
+
+  size_t sz = (size_t)size;
+  uint64_t handle = tiered->allocate(sz);
+  if (handle == 0) {
+    jclass errorCls = env->FindClass("java/lang/OutOfMemoryError");
+    std::string errorMsg;
+    errorMsg.append("Don't have enough tiered memory, please consider increase the DRAM ");
+    errorMsg.append("or persistent memory budget. The requested size: ");
+    errorMsg.append(std::to_string(sz));
+    env->ThrowNew(errorCls, errorMsg.c_str());
+  }
+
+  return (jlong)handle;
+}
+
+JNIEXPORT jlong JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_acquireTieredMemory
+  (JNIEnv *env, jclass clazz, jlong handle) {
+  check_tiered(env);
+  if (NULL == tiered) {
+    return 0;
+  }
+
+  void *p = tiered->acquire((uint64_t)handle);
+  if (p == NULL) {
+    jclass exceptionCls = env->FindClass("java/lang/IllegalArgumentException");
+    std::string errorMsg;
+    errorMsg.append("Invalid tiered memory handle: ");
+    errorMsg.append(std::to_string(handle));
+    env->ThrowNew(exceptionCls, errorMsg.c_str());
+  }
+
+  return addr_to_java(p);
+}
+
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_releaseTieredMemory
+  (JNIEnv *env, jclass clazz, jlong handle) {
+  check_tiered(env);
+  if (NULL != tiered) {
+    tiered->release((uint64_t)handle);
+  }
+}
+
+JNIEXPORT jlong JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_getTieredSize
+  (JNIEnv *env, jclass clazz, jlong handle) {
+  check_tiered(env);
+  if (NULL == tiered) {
+    return 0;
+  }
+  return (jlong)tiered->get_size((uint64_t)handle);
+}
+
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_freeTieredMemory
+  (JNIEnv *env, jclass clazz, jlong handle) {
+  check_tiered(env);
+  if (NULL != tiered && !tiered->free((uint64_t)handle)) {
+    jclass exceptionCls = env->FindClass("java/lang/IllegalStateException");
+    std::string errorMsg;
+    errorMsg.append("Can't free a pinned tiered memory block, release it first: ");
+    errorMsg.append(std::to_string(handle));
+    env->ThrowNew(exceptionCls, errorMsg.c_str());
+  }
+}
+
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_rebalanceTieredMemory
+  (JNIEnv *env, jclass clazz) {
+  check_tiered(env);
+  if (NULL != tiered) {
+    tiered->rebalance();
+  }
+}
+
+JNIEXPORT jlongArray JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_getTieredStatsNative
+  (JNIEnv *env, jclass clazz) {
+  check_tiered(env);
+  if (NULL == tiered) {
+    return NULL;
+  }
+
+  tiered_stats stats = tiered->get_stats();
+  jlong values[] = {(jlong)stats.dram_used, (jlong)stats.pmem_used, (jlong)stats.dram_hits,
+    (jlong)stats.pmem_hits, (jlong)stats.promoted_bytes, (jlong)stats.demoted_bytes,
+    (jlong)stats.migration_nanos};
+  jsize len = sizeof(values) / sizeof(values[0]);
+  jlongArray result = env->NewLongArray(len);
+  env->SetLongArrayRegion(result, 0, len, values);
+  return result;
+}
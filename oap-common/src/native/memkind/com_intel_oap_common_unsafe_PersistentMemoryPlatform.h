@@ -81,6 +81,78 @@ JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform
 JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_copyMemory
   (JNIEnv *, jclass, jlong, jlong, jlong);
 
+/*
+ * Class:     com_intel_oap_common_unsafe_PersistentMemoryPlatform
+ * Method:    copyMemoryBatch
+ * Signature: (Ljava/nio/ByteBuffer;I)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_copyMemoryBatch
+  (JNIEnv *, jclass, jobject, jint);
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PersistentMemoryPlatform
+ * Method:    initializeTieredNative
+ * Signature: (JJIJ)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_initializeTieredNative
+  (JNIEnv *, jclass, jlong, jlong, jint, jlong);
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PersistentMemoryPlatform
+ * Method:    allocateTieredMemory
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_allocateTieredMemory
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PersistentMemoryPlatform
+ * Method:    acquireTieredMemory
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_acquireTieredMemory
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PersistentMemoryPlatform
+ * Method:    releaseTieredMemory
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_releaseTieredMemory
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PersistentMemoryPlatform
+ * Method:    getTieredSize
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_getTieredSize
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PersistentMemoryPlatform
+ * Method:    freeTieredMemory
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_freeTieredMemory
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PersistentMemoryPlatform
+ * Method:    rebalanceTieredMemory
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_rebalanceTieredMemory
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_intel_oap_common_unsafe_PersistentMemoryPlatform
+ * Method:    getTieredStatsNative
+ * Signature: ()[J
+ */
+JNIEXPORT jlongArray JNICALL Java_com_intel_oap_common_unsafe_PersistentMemoryPlatform_getTieredStatsNative
+  (JNIEnv *, jclass);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,387 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OAP_COMMON_TIERED_ALLOCATOR_H
+#define OAP_COMMON_TIERED_ALLOCATOR_H
+
+#include <memkind.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define TIER_NONE 0
+#define TIER_DRAM 1
+#define TIER_PMEM 2
+
+// handles are indexes into a table of fixed size segments, so a lookup never
+// takes a lock and a handle is stable for the life of its block. The high
+// bits of a handle carry the generation of its slot, a slot gets a new
+// generation every time it is reused so a stale handle no longer resolves.
+#define TIERED_SEGMENT_SHIFT 16
+#define TIERED_SEGMENT_SIZE (1UL << TIERED_SEGMENT_SHIFT)
+#define TIERED_MAX_SEGMENTS (1UL << 16)
+#define TIERED_GENERATION_SHIFT 32
+#define TIERED_INDEX_MASK ((1UL << TIERED_GENERATION_SHIFT) - 1)
+
+struct tiered_block {
+  std::mutex lock;
+  // the handle of the live block in this slot, 0 while the slot is free
+  uint64_t handle = 0;
+  uint32_t generation = 0;
+  void *addr = nullptr;
+  uint64_t size = 0;
+  int tier = TIER_NONE;
+  uint32_t pins = 0;
+  // sampled access counter, halved on every rebalance so it tracks recent use
+  uint64_t hits = 0;
+  uint64_t next_free = 0;
+};
+
+struct tiered_stats {
+  uint64_t dram_used;
+  uint64_t pmem_used;
+  uint64_t dram_hits;
+  uint64_t pmem_hits;
+  uint64_t promoted_bytes;
+  uint64_t demoted_bytes;
+  uint64_t migration_nanos;
+};
+
+/*
+ * A two tier allocator over a DRAM and a PMem memkind kind. Callers hold a
+ * handle instead of an address: acquire resolves it to the current address
+ * and pins the block until release, and unpinned blocks may be moved between
+ * tiers at any time. One in sample_rate acquires is counted against its block,
+ * rebalance then keeps the hottest blocks that fit the DRAM budget in DRAM and
+ * demotes the rest to PMem. With interval_ms > 0 rebalance also runs on a
+ * background thread.
+ */
+class tiered_allocator {
+ public:
+  tiered_allocator(memkind_t dram_kind, memkind_t pmem_kind,
+                   uint64_t dram_budget, uint64_t pmem_budget,
+                   uint32_t sample_rate, uint64_t interval_ms)
+      : dram_kind(dram_kind), pmem_kind(pmem_kind), dram_budget(dram_budget),
+        pmem_budget(pmem_budget), sample_rate(sample_rate ? sample_rate : 1),
+        segments(new std::atomic<tiered_block*>[TIERED_MAX_SEGMENTS]) {
+    for (uint64_t i = 0; i < TIERED_MAX_SEGMENTS; i++) {
+      segments[i].store(nullptr, std::memory_order_relaxed);
+    }
+    if (interval_ms > 0) {
+      rebalancer = std::thread([this, interval_ms] {
+        std::unique_lock<std::mutex> l(stop_mtx);
+        while (!stopping) {
+          stop_cv.wait_for(l, std::chrono::milliseconds(interval_ms));
+          if (stopping) break;
+          l.unlock();
+          rebalance();
+          l.lock();
+        }
+      });
+    }
+  }
+
+  ~tiered_allocator() {
+    {
+      std::lock_guard<std::mutex> l(stop_mtx);
+      stopping = true;
+    }
+    stop_cv.notify_all();
+    if (rebalancer.joinable()) {
+      rebalancer.join();
+    }
+    for (uint64_t i = 0; i < table_size; i++) {
+      tiered_block *b = slot(i);
+      if (b->tier != TIER_NONE) {
+        memkind_free(kind_of(b->tier), b->addr);
+      }
+    }
+    for (uint64_t i = 0; i < TIERED_MAX_SEGMENTS; i++) {
+      delete[] segments[i].load(std::memory_order_relaxed);
+    }
+    delete[] segments;
+  }
+
+  // return a handle, or 0 if neither tier has room. New blocks go to DRAM
+  // while it is under budget.
+  uint64_t allocate(uint64_t size) {
+    int tier = TIER_DRAM;
+    void *addr = nullptr;
+    if (reserve(dram_used, dram_budget, size)) {
+      addr = memkind_malloc(dram_kind, size);
+      if (addr == nullptr) {
+        dram_used -= size;
+      }
+    }
+    if (addr == nullptr) {
+      tier = TIER_PMEM;
+      if (!reserve(pmem_used, pmem_budget, size)) {
+        return 0;
+      }
+      addr = memkind_malloc(pmem_kind, size);
+      if (addr == nullptr) {
+        pmem_used -= size;
+        return 0;
+      }
+    }
+    uint64_t handle = new_handle();
+    if (handle == 0) {
+      memkind_free(kind_of(tier), addr);
+      used_of(tier) -= size;
+      return 0;
+    }
+    tiered_block *b = slot((handle & TIERED_INDEX_MASK) - 1);
+    std::lock_guard<std::mutex> l(b->lock);
+    b->handle = handle;
+    b->addr = addr;
+    b->size = size;
+    b->tier = tier;
+    b->pins = 0;
+    b->hits = 0;
+    return handle;
+  }
+
+  // free a block, a pinned block is left alone and false is returned so its
+  // address stays valid for the holders until they release it
+  bool free(uint64_t handle) {
+    tiered_block *b = lookup(handle);
+    if (b == nullptr) return true;
+    {
+      std::lock_guard<std::mutex> l(b->lock);
+      if (b->handle != handle) return true;
+      if (b->pins > 0) return false;
+      memkind_free(kind_of(b->tier), b->addr);
+      used_of(b->tier) -= b->size;
+      b->handle = 0;
+      b->addr = nullptr;
+      b->tier = TIER_NONE;
+    }
+    std::lock_guard<std::mutex> l(table_mtx);
+    b->next_free = free_head;
+    free_head = handle & TIERED_INDEX_MASK;
+    return true;
+  }
+
+  // resolve a handle to its current address and pin the block, the address
+  // stays valid until the matching release
+  void *acquire(uint64_t handle) {
+    static thread_local uint32_t tick = 0;
+    tiered_block *b = lookup(handle);
+    if (b == nullptr) return nullptr;
+    std::lock_guard<std::mutex> l(b->lock);
+    if (b->handle != handle) return nullptr;
+    b->pins++;
+    if (++tick >= sample_rate) {
+      tick = 0;
+      b->hits++;
+      if (b->tier == TIER_DRAM) {
+        dram_hits.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        pmem_hits.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    return b->addr;
+  }
+
+  void release(uint64_t handle) {
+    tiered_block *b = lookup(handle);
+    if (b == nullptr) return;
+    std::lock_guard<std::mutex> l(b->lock);
+    if (b->handle == handle && b->pins > 0) b->pins--;
+  }
+
+  uint64_t get_size(uint64_t handle) {
+    tiered_block *b = lookup(handle);
+    if (b == nullptr) return 0;
+    std::lock_guard<std::mutex> l(b->lock);
+    return b->handle == handle ? b->size : 0;
+  }
+
+  void rebalance() {
+    std::lock_guard<std::mutex> rl(rebalance_mtx);
+    struct candidate {
+      uint64_t handle;
+      uint64_t hits;
+      uint64_t size;
+      int tier;
+    };
+    std::vector<candidate> candidates;
+    uint64_t size_ = table_size.load(std::memory_order_acquire);
+    candidates.reserve(size_);
+    for (uint64_t i = 0; i < size_; i++) {
+      tiered_block *b = slot(i);
+      std::lock_guard<std::mutex> l(b->lock);
+      if (b->tier == TIER_NONE) continue;
+      candidates.push_back({b->handle, b->hits, b->size, b->tier});
+      b->hits >>= 1;
+    }
+    // hottest first, blocks already in DRAM win ties so equally warm blocks
+    // are not swapped back and forth
+    std::sort(candidates.begin(), candidates.end(),
+              [](const candidate &a, const candidate &b) {
+                if (a.hits != b.hits) return a.hits > b.hits;
+                return a.tier < b.tier;
+              });
+    uint64_t dram_room = dram_budget != 0 ? dram_budget : UINT64_MAX;
+    std::vector<uint64_t> promote, demote;
+    for (auto &c : candidates) {
+      bool hot = c.hits > 0 && c.size <= dram_room;
+      if (hot || (c.tier == TIER_DRAM && c.size <= dram_room)) {
+        dram_room -= c.size;
+        if (c.tier == TIER_PMEM) promote.push_back(c.handle);
+      } else if (c.tier == TIER_DRAM) {
+        demote.push_back(c.handle);
+      }
+    }
+    // demote first to make room in DRAM for the promoted blocks
+    for (auto h : demote) {
+      migrate(h, TIER_PMEM);
+    }
+    for (auto h : promote) {
+      migrate(h, TIER_DRAM);
+    }
+  }
+
+  tiered_stats get_stats() {
+    tiered_stats stats;
+    stats.dram_used = dram_used.load();
+    stats.pmem_used = pmem_used.load();
+    stats.dram_hits = dram_hits.load();
+    stats.pmem_hits = pmem_hits.load();
+    stats.promoted_bytes = promoted_bytes.load();
+    stats.demoted_bytes = demoted_bytes.load();
+    stats.migration_nanos = migration_nanos.load();
+    return stats;
+  }
+
+ private:
+  memkind_t kind_of(int tier) {
+    return tier == TIER_DRAM ? dram_kind : pmem_kind;
+  }
+
+  std::atomic<uint64_t> &used_of(int tier) {
+    return tier == TIER_DRAM ? dram_used : pmem_used;
+  }
+
+  // a budget of 0 leaves the tier bounded by its kind only
+  static bool reserve(std::atomic<uint64_t> &used, uint64_t budget,
+                      uint64_t size) {
+    uint64_t cur = used.load();
+    do {
+      if (budget != 0 && cur + size > budget) return false;
+    } while (!used.compare_exchange_weak(cur, cur + size));
+    return true;
+  }
+
+  tiered_block *slot(uint64_t index) {
+    uint64_t segment = index >> TIERED_SEGMENT_SHIFT;
+    if (segment >= TIERED_MAX_SEGMENTS) return nullptr;
+    tiered_block *blocks = segments[segment].load(std::memory_order_acquire);
+    if (blocks == nullptr) return nullptr;
+    return &blocks[index & (TIERED_SEGMENT_SIZE - 1)];
+  }
+
+  // the slot a handle points at, callers compare its handle under the block
+  // lock to reject stale handles
+  tiered_block *lookup(uint64_t handle) {
+    uint64_t index = handle & TIERED_INDEX_MASK;
+    if (index == 0) return nullptr;
+    return slot(index - 1);
+  }
+
+  uint64_t new_handle() {
+    std::lock_guard<std::mutex> l(table_mtx);
+    uint64_t index;
+    tiered_block *b;
+    if (free_head != 0) {
+      index = free_head;
+      b = slot(index - 1);
+      free_head = b->next_free;
+    } else {
+      index = table_size.load(std::memory_order_relaxed) + 1;
+      uint64_t segment = (index - 1) >> TIERED_SEGMENT_SHIFT;
+      if (segment >= TIERED_MAX_SEGMENTS) return 0;
+      if (segments[segment].load(std::memory_order_relaxed) == nullptr) {
+        segments[segment].store(new tiered_block[TIERED_SEGMENT_SIZE],
+                                std::memory_order_release);
+      }
+      table_size.store(index, std::memory_order_release);
+      b = slot(index - 1);
+    }
+    std::lock_guard<std::mutex> bl(b->lock);
+    return ((uint64_t)++b->generation << TIERED_GENERATION_SHIFT) | index;
+  }
+
+  // move an unpinned block to the given tier, the copy happens under the
+  // block lock so a concurrent acquire waits for the new address
+  void migrate(uint64_t handle, int to) {
+    tiered_block *b = lookup(handle);
+    std::lock_guard<std::mutex> l(b->lock);
+    if (b->handle != handle || b->tier == to || b->pins > 0) return;
+    if (!reserve(used_of(to), to == TIER_DRAM ? dram_budget : pmem_budget,
+                 b->size)) {
+      return;
+    }
+    void *addr = memkind_malloc(kind_of(to), b->size);
+    if (addr == nullptr) {
+      used_of(to) -= b->size;
+      return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::memcpy(addr, b->addr, b->size);
+    migration_nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    memkind_free(kind_of(b->tier), b->addr);
+    used_of(b->tier) -= b->size;
+    (to == TIER_DRAM ? promoted_bytes : demoted_bytes) += b->size;
+    b->addr = addr;
+    b->tier = to;
+  }
+
+  memkind_t dram_kind;
+  memkind_t pmem_kind;
+  uint64_t dram_budget;
+  uint64_t pmem_budget;
+  uint32_t sample_rate;
+
+  std::atomic<tiered_block*> *segments;
+  std::atomic<uint64_t> table_size{0};
+  uint64_t free_head = 0;
+  std::mutex table_mtx;
+
+  std::atomic<uint64_t> dram_used{0};
+  std::atomic<uint64_t> pmem_used{0};
+  std::atomic<uint64_t> dram_hits{0};
+  std::atomic<uint64_t> pmem_hits{0};
+  std::atomic<uint64_t> promoted_bytes{0};
+  std::atomic<uint64_t> demoted_bytes{0};
+  std::atomic<uint64_t> migration_nanos{0};
+
+  std::mutex rebalance_mtx;
+  std::mutex stop_mtx;
+  std::condition_variable stop_cv;
+  bool stopping = false;
+  std::thread rebalancer;
+};
+
+#endif  // OAP_COMMON_TIERED_ALLOCATOR_H
@@ -3,8 +3,12 @@ package com.intel.oap.common.unsafe;
 import org.junit.*;
 
 import java.io.File;
+import java.nio.ByteBuffer;
+import java.util.Arrays;
 import java.util.Random;
 
+import sun.nio.ch.DirectBuffer;
+
 import static org.junit.Assume.*;
 import static org.junit.Assert.*;
 
@@ -68,6 +72,66 @@ public class PMemBlockPlatformTest {
         }
     }
 
+    @Test
+    public void testWriteReadBatch() {
+        int num = 16;
+        ByteBuffer src = ByteBuffer.allocateDirect(num * ELEMENT_SIZE);
+        byte[] bytesToWrite = new byte[num * ELEMENT_SIZE];
+        random.nextBytes(bytesToWrite);
+        src.put(bytesToWrite);
+        long srcAddress = ((DirectBuffer) src).address();
+        CopyDescriptors descriptors = new CopyDescriptors(num);
+        for (int i = 0; i < num; i++) {
+            descriptors.add(i, srcAddress + i * ELEMENT_SIZE, ELEMENT_SIZE);
+        }
+        PMemBlockPlatform.writeBatch(descriptors);
+
+        ByteBuffer dst = ByteBuffer.allocateDirect(num * ELEMENT_SIZE);
+        long dstAddress = ((DirectBuffer) dst).address();
+        descriptors.clear();
+        for (int i = 0; i < num; i++) {
+            descriptors.add(dstAddress + i * ELEMENT_SIZE, i, ELEMENT_SIZE);
+        }
+        PMemBlockPlatform.readBatch(descriptors);
+        byte[] bytesFromRead = new byte[num * ELEMENT_SIZE];
+        dst.get(bytesFromRead);
+        assertArrayEquals(bytesToWrite, bytesFromRead);
+        assertArrayEquals(readBlock(num - 1), Arrays.copyOfRange(bytesToWrite,
+            (num - 1) * ELEMENT_SIZE, num * ELEMENT_SIZE));
+    }
+
+    @Test
+    public void testStripedReadWriteRange() {
+        String[] paths = {PATH + "_stripe_0", PATH + "_stripe_1"};
+        try {
+            PMemBlockPlatform.createStriped(paths, ELEMENT_SIZE, POOL_SIZE, 4);
+            int num = 100;
+            assertTrue(PMemBlockPlatform.getStripedBlockNum() >= num);
+            ByteBuffer src = ByteBuffer.allocateDirect(num * ELEMENT_SIZE);
+            byte[] bytesToWrite = new byte[num * ELEMENT_SIZE];
+            random.nextBytes(bytesToWrite);
+            src.put(bytesToWrite);
+            PMemBlockPlatform.writeRange(((DirectBuffer) src).address(), 3, num);
+
+            ByteBuffer dst = ByteBuffer.allocateDirect(num * ELEMENT_SIZE);
+            PMemBlockPlatform.readRange(((DirectBuffer) dst).address(), 3, num);
+            byte[] bytesFromRead = new byte[num * ELEMENT_SIZE];
+            dst.get(bytesFromRead);
+            assertArrayEquals(bytesToWrite, bytesFromRead);
+
+            double[] bandwidth = PMemBlockPlatform.getDeviceBandwidth();
+            assertEquals(paths.length, bandwidth.length);
+            for (double b : bandwidth) {
+                assertTrue(b > 0);
+            }
+        } finally {
+            PMemBlockPlatform.closeStriped();
+            for (String path : paths) {
+                new File(path).delete();
+            }
+        }
+    }
+
     @Test(expected = RuntimeException.class)
     public void testWriteBlockExceedMaximum() {
         int maxNum = PMemBlockPlatform.getBlockNum();
@@ -0,0 +1,144 @@
+package com.intel.oap.common.unsafe;
+
+import com.intel.oap.common.util.NativeLibraryLoader;
+
+import org.junit.*;
+
+import java.io.File;
+import java.util.ArrayList;
+import java.util.List;
+
+import static org.junit.Assume.*;
+import static org.junit.Assert.*;
+
+public class TieredMemoryTest {
+
+    private static long BLOCK_SIZE = 64 * 1024;
+    private static int DRAM_BLOCKS = 4;
+    private static int PMEM_BLOCKS = 8;
+    private static String PATH = "target/tmp/";
+
+    private static boolean libAvailable = true;
+
+    private final List<Long> handles = new ArrayList<>();
+
+    @BeforeClass
+    public static void setUp() {
+        try {
+            NativeLibraryLoader.load("pmplatform");
+        } catch (UnsatisfiedLinkError | RuntimeException e) {
+            libAvailable = false;
+            return;
+        }
+        new File(PATH).mkdirs();
+        PersistentMemoryPlatform.initialize(PATH, 16 * 1024 * 1024, 0);
+        PersistentMemoryPlatform.initializeTiered(DRAM_BLOCKS * BLOCK_SIZE,
+            PMEM_BLOCKS * BLOCK_SIZE, 1, 0);
+    }
+
+    @Before
+    public void checkIfLibAvailable() {
+        assumeTrue(libAvailable);
+    }
+
+    @After
+    public void tearDown() {
+        for (long handle : handles) {
+            PersistentMemoryPlatform.freeTieredMemory(handle);
+        }
+        handles.clear();
+    }
+
+    private long allocate() {
+        long handle = PersistentMemoryPlatform.allocateTieredMemory(BLOCK_SIZE);
+        handles.add(handle);
+        return handle;
+    }
+
+    private void touch(long handle, int times) {
+        for (int i = 0; i < times; i++) {
+            PersistentMemoryPlatform.acquireTieredMemory(handle);
+            PersistentMemoryPlatform.releaseTieredMemory(handle);
+        }
+    }
+
+    @Test
+    public void testBudgetEnforcement() {
+        for (int i = 0; i < DRAM_BLOCKS; i++) {
+            allocate();
+        }
+        TieredMemoryStats stats = PersistentMemoryPlatform.getTieredMemoryStats();
+        assertEquals(DRAM_BLOCKS * BLOCK_SIZE, stats.getDramUsed());
+        assertEquals(0, stats.getPmemUsed());
+
+        for (int i = 0; i < PMEM_BLOCKS; i++) {
+            allocate();
+        }
+        stats = PersistentMemoryPlatform.getTieredMemoryStats();
+        assertEquals(DRAM_BLOCKS * BLOCK_SIZE, stats.getDramUsed());
+        assertEquals(PMEM_BLOCKS * BLOCK_SIZE, stats.getPmemUsed());
+
+        try {
+            PersistentMemoryPlatform.allocateTieredMemory(BLOCK_SIZE);
+            fail("allocation over both budgets should fail");
+        } catch (OutOfMemoryError e) {
+            // expected
+        }
+    }
+
+    @Test
+    public void testPromoteHotAndDemoteCold() {
+        for (int i = 0; i < DRAM_BLOCKS; i++) {
+            allocate();
+        }
+        long hot = allocate();
+        touch(hot, 16);
+
+        TieredMemoryStats before = PersistentMemoryPlatform.getTieredMemoryStats();
+        PersistentMemoryPlatform.rebalanceTieredMemory();
+        TieredMemoryStats after = PersistentMemoryPlatform.getTieredMemoryStats();
+        assertEquals(BLOCK_SIZE, after.getPromotedBytes() - before.getPromotedBytes());
+        assertEquals(BLOCK_SIZE, after.getDemotedBytes() - before.getDemotedBytes());
+        assertEquals(DRAM_BLOCKS * BLOCK_SIZE, after.getDramUsed());
+        assertEquals(BLOCK_SIZE, after.getPmemUsed());
+    }
+
+    @Test
+    public void testPinnedBlockIsNotMigrated() {
+        for (int i = 0; i < DRAM_BLOCKS; i++) {
+            allocate();
+        }
+        long hot = allocate();
+        touch(hot, 16);
+
+        long address = PersistentMemoryPlatform.acquireTieredMemory(hot);
+        TieredMemoryStats before = PersistentMemoryPlatform.getTieredMemoryStats();
+        PersistentMemoryPlatform.rebalanceTieredMemory();
+        TieredMemoryStats after = PersistentMemoryPlatform.getTieredMemoryStats();
+        assertEquals(before.getPromotedBytes(), after.getPromotedBytes());
+        assertEquals(address, PersistentMemoryPlatform.acquireTieredMemory(hot));
+        PersistentMemoryPlatform.releaseTieredMemory(hot);
+
+        try {
+            PersistentMemoryPlatform.freeTieredMemory(hot);
+            fail("freeing a pinned block should fail");
+        } catch (IllegalStateException e) {
+            // expected
+        }
+
+        PersistentMemoryPlatform.releaseTieredMemory(hot);
+        PersistentMemoryPlatform.rebalanceTieredMemory();
+        after = PersistentMemoryPlatform.getTieredMemoryStats();
+        assertEquals(BLOCK_SIZE, after.getPromotedBytes() - before.getPromotedBytes());
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void testStaleHandleIsRejected() {
+        long handle = PersistentMemoryPlatform.allocateTieredMemory(BLOCK_SIZE);
+        PersistentMemoryPlatform.freeTieredMemory(handle);
+        // the freed slot is reused, the old handle must not resolve to the new block
+        long reused = allocate();
+        assertNotEquals(handle, reused);
+        PersistentMemoryPlatform.acquireTieredMemory(handle);
+    }
+}
@@ -21,6 +21,8 @@
 #include "org_apache_spark_ml_clustering_KMeansDALImpl.h"
 #include <iostream>
 #include <chrono>
+#include <algorithm>
+#include <vector>
 
 using namespace std;
 using namespace daal;
@@ -30,37 +32,29 @@ const int ccl_root = 0;
 
 typedef double algorithmFPType; /* Algorithm floating-point type */
 
-static NumericTablePtr kmeans_compute(int rankId, const NumericTablePtr & pData, const NumericTablePtr & initialCentroids,
-    size_t nClusters, size_t nBlocks, algorithmFPType &ret_cost)
+/* Copy all rows of a numeric table into a flat row-major buffer */
+static void copyTableToBuffer(const NumericTablePtr & table, algorithmFPType *buf)
 {
-    const bool isRoot          = (rankId == ccl_root);
-    size_t CentroidsArchLength = 0;
-    InputDataArchive inputArch;
-    if (isRoot)
-    {
-        /*Retrieve the algorithm results and serialize them */
-        initialCentroids->serialize(inputArch);
-        CentroidsArchLength = inputArch.getSizeOfArchive();
-    }
-
-    ccl_request_t request;
-
-    /* Get partial results from the root node */
-    ccl_bcast(&CentroidsArchLength, sizeof(size_t), ccl_dtype_char, ccl_root, NULL, NULL, NULL, &request);
-    ccl_wait(request);
-
-    ByteBuffer nodeCentroids(CentroidsArchLength);
-    if (isRoot) inputArch.copyArchiveToArray(&nodeCentroids[0], CentroidsArchLength);
+    size_t rows = table->getNumberOfRows();
+    size_t cols = table->getNumberOfColumns();
 
-    ccl_bcast(&nodeCentroids[0], CentroidsArchLength, ccl_dtype_char, ccl_root, NULL, NULL, NULL, &request);
-    ccl_wait(request);
-
-    /* Deserialize centroids data */
-    OutputDataArchive outArch(nodeCentroids.size() ? &nodeCentroids[0] : NULL, CentroidsArchLength);
-
-    NumericTablePtr centroids(new HomogenNumericTable<algorithmFPType>());
+    BlockDescriptor<algorithmFPType> block;
+    table->getBlockOfRows(0, rows, readOnly, block);
+    std::copy(block.getBlockPtr(), block.getBlockPtr() + rows * cols, buf);
+    table->releaseBlockOfRows(block);
+}
 
-    centroids->deserialize(outArch);
+/*
+ * Every rank runs step1Local on its own data, then the partial sums, cluster
+ * sizes and objective function of all ranks are summed with a single allreduce
+ * over a flat buffer. Every rank then computes the same new centroids locally,
+ * so neither the partial results nor the centroids need to be serialized or
+ * broadcast.
+ */
+static NumericTablePtr kmeans_compute(const NumericTablePtr & pData, const NumericTablePtr & centroids,
+    size_t nClusters, algorithmFPType &ret_cost)
+{
+    size_t nFeatures = centroids->getNumberOfColumns();
 
     /* Create an algorithm to compute k-means on local nodes */
     kmeans::Distributed<step1Local, algorithmFPType> localAlgorithm(nClusters);
@@ -72,56 +66,48 @@ static NumericTablePtr kmeans_compute(int rankId, const NumericTablePtr & pData,
     /* Compute k-means */
     localAlgorithm.compute();
 
-    /* Serialize partial results required by step 2 */
-    InputDataArchive dataArch;
-    localAlgorithm.getPartialResult()->serialize(dataArch);
-    size_t perNodeArchLength = dataArch.getSizeOfArchive();
-    ByteBuffer serializedData;
-
-    /* Serialized data is of equal size on each node if each node called compute() equal number of times */
-    size_t* recvCounts = new size_t[nBlocks];
-    for (size_t i = 0; i < nBlocks; i++)
-    {
-        recvCounts[i] = perNodeArchLength;
-    }
-    serializedData.resize(perNodeArchLength * nBlocks);
+    kmeans::PartialResultPtr partialResult = localAlgorithm.getPartialResult();
+
+    /* Layout of the reduced buffer: [ nClusters x nFeatures sums | nClusters counts | objective function ] */
+    size_t sumsLength = nClusters * nFeatures;
+    size_t bufLength = sumsLength + nClusters + 1;
+    std::vector<algorithmFPType> localBuf(bufLength), globalBuf(bufLength);
 
-    ByteBuffer nodeResults(perNodeArchLength);
-    dataArch.copyArchiveToArray(&nodeResults[0], perNodeArchLength);
+    copyTableToBuffer(partialResult->get(kmeans::partialSums), &localBuf[0]);
+    copyTableToBuffer(partialResult->get(kmeans::nObservations), &localBuf[sumsLength]);
+    copyTableToBuffer(partialResult->get(kmeans::partialObjectiveFunction), &localBuf[sumsLength + nClusters]);
 
-    /* Transfer partial results to step 2 on the root node */
-    ccl_allgatherv(&nodeResults[0], perNodeArchLength, &serializedData[0], recvCounts, ccl_dtype_char, NULL, NULL, NULL, &request);
+    ccl_request_t request;
+    ccl_allreduce(&localBuf[0], &globalBuf[0], bufLength, ccl_dtype_double, ccl_reduction_sum,
+        NULL, NULL, NULL, &request);
     ccl_wait(request);
 
-    delete [] recvCounts;
+    ret_cost = globalBuf[sumsLength + nClusters];
 
-    if (isRoot)
-    {
-        /* Create an algorithm to compute k-means on the master node */
-        kmeans::Distributed<step2Master, algorithmFPType> masterAlgorithm(nClusters);
+    NumericTablePtr newCentroids(new HomogenNumericTable<algorithmFPType>(nFeatures, nClusters,
+        NumericTable::doAllocate));
 
-        for (size_t i = 0; i < nBlocks; i++)
-        {
-            /* Deserialize partial results from step 1 */
-            OutputDataArchive dataArch(&serializedData[perNodeArchLength * i], perNodeArchLength);
+    BlockDescriptor<algorithmFPType> blockOldCentroids;
+    centroids->getBlockOfRows(0, nClusters, readOnly, blockOldCentroids);
+    algorithmFPType *oldCentroids = blockOldCentroids.getBlockPtr();
 
-            kmeans::PartialResultPtr dataForStep2FromStep1(new kmeans::PartialResult());
-            dataForStep2FromStep1->deserialize(dataArch);
+    BlockDescriptor<algorithmFPType> blockNewCentroids;
+    newCentroids->getBlockOfRows(0, nClusters, writeOnly, blockNewCentroids);
+    algorithmFPType *arrayNewCentroids = blockNewCentroids.getBlockPtr();
 
-            /* Set local partial results as input for the master-node algorithm */
-            masterAlgorithm.input.add(kmeans::partialResults, dataForStep2FromStep1);
+    for (size_t i = 0; i < nClusters; i++) {
+        algorithmFPType count = globalBuf[sumsLength + i];
+        for (size_t j = 0; j < nFeatures; j++) {
+            /* An empty cluster keeps its previous centroid */
+            arrayNewCentroids[i * nFeatures + j] = count > 0 ?
+                globalBuf[i * nFeatures + j] / count : oldCentroids[i * nFeatures + j];
         }
+    }
 
-        /* Merge and finalizeCompute k-means on the master node */
-        masterAlgorithm.compute();
-        masterAlgorithm.finalizeCompute();
-
-        ret_cost = masterAlgorithm.getResult()->get(kmeans::objectiveFunction)->getValue<algorithmFPType>(0, 0);
+    newCentroids->releaseBlockOfRows(blockNewCentroids);
+    centroids->releaseBlockOfRows(blockOldCentroids);
 
-        /* Retrieve the algorithm results */
-        return masterAlgorithm.getResult()->get(kmeans::centroids);
-    }
-    return NumericTablePtr();
+    return newCentroids;
 }
 
 static bool isCenterConverged(const algorithmFPType *oldCenter, const algorithmFPType *newCenter, size_t dim, double tolerance) {
@@ -189,16 +175,10 @@ JNIEXPORT jlong JNICALL Java_org_apache_spark_ml_clustering_KMeansDALImpl_cKMean
   for (it = 0; it < iteration_num && !converged; it++) {
     auto t1 = std::chrono::high_resolution_clock::now();
 
-    newCentroids = kmeans_compute(rankId, pData, centroids, cluster_num, executor_num, totalCost);
-
-    if (rankId == ccl_root) {
-        converged = areAllCentersConverged(centroids, newCentroids, tolerance);
-    }
+    newCentroids = kmeans_compute(pData, centroids, cluster_num, totalCost);
 
-    // Sync converged status
-    ccl_request_t request;
-    ccl_bcast(&converged, 1, ccl_dtype_char, ccl_root, NULL, NULL, NULL, &request);
-    ccl_wait(request);
+    // Every rank has the same centroids, so convergence is decided locally
+    converged = areAllCentersConverged(centroids, newCentroids, tolerance);
 
     centroids = newCentroids;
 
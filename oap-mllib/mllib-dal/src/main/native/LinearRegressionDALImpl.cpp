@@ -0,0 +1,149 @@
+/*******************************************************************************
+* Copyright 2020 Intel Corporation
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#include <ccl.h>
+#include <daal.h>
+
+#include "partial_results.h"
+#include "org_apache_spark_ml_regression_LinearRegressionDALImpl.h"
+#include <iostream>
+#include <chrono>
+
+using namespace std;
+using namespace daal;
+using namespace daal::algorithms;
+
+const int ccl_root = 0;
+
+typedef double algorithmFPType; /* Algorithm floating-point type */
+
+/* Train ordinary least squares with the normal equations method */
+static NumericTablePtr linear_regression_compute(size_t rankId, const NumericTablePtr & pData,
+    const NumericTablePtr & pLabel, bool fitIntercept)
+{
+    /* Compute X'X and X'y of the local data */
+    linear_regression::training::Distributed<step1Local, algorithmFPType,
+        linear_regression::training::normEqDense> localAlgorithm;
+    localAlgorithm.input.set(linear_regression::training::data, pData);
+    localAlgorithm.input.set(linear_regression::training::dependentVariables, pLabel);
+    localAlgorithm.parameter.interceptFlag = fitIntercept;
+    localAlgorithm.compute();
+
+    linear_regression::ModelPtr partialModel =
+        localAlgorithm.getPartialResult()->get(linear_regression::training::partialModel);
+    linear_regression::ModelNormEqPtr normEqModel =
+        services::staticPointerCast<linear_regression::ModelNormEq, linear_regression::Model>(partialModel);
+
+    /* Sum X'X and X'y of all ranks */
+    allreduceTables({normEqModel->getXTXTable(), normEqModel->getXTYTable()});
+
+    if (rankId != ccl_root)
+        return NumericTablePtr();
+
+    /* The summed partial model covers all rows, solve the normal equations on the root */
+    linear_regression::training::Distributed<step2Master, algorithmFPType,
+        linear_regression::training::normEqDense> masterAlgorithm;
+    masterAlgorithm.parameter.interceptFlag = fitIntercept;
+    masterAlgorithm.input.add(linear_regression::training::partialModels, partialModel);
+    masterAlgorithm.compute();
+    masterAlgorithm.finalizeCompute();
+
+    return masterAlgorithm.getResult()->get(linear_regression::training::model)->getBeta();
+}
+
+/* Train ridge regression with the normal equations method */
+static NumericTablePtr ridge_regression_compute(size_t rankId, const NumericTablePtr & pData,
+    const NumericTablePtr & pLabel, bool fitIntercept, double regParam)
+{
+    /* Compute X'X and X'y of the local data */
+    ridge_regression::training::Distributed<step1Local, algorithmFPType> localAlgorithm;
+    localAlgorithm.input.set(ridge_regression::training::data, pData);
+    localAlgorithm.input.set(ridge_regression::training::dependentVariables, pLabel);
+    localAlgorithm.parameter.interceptFlag = fitIntercept;
+    localAlgorithm.compute();
+
+    ridge_regression::ModelPtr partialModel =
+        localAlgorithm.getPartialResult()->get(ridge_regression::training::partialModel);
+    ridge_regression::ModelNormEqPtr normEqModel =
+        services::staticPointerCast<ridge_regression::ModelNormEq, ridge_regression::Model>(partialModel);
+
+    /* Spark scales the squared error by 1 / 2n, oneDAL does not, so the penalty is scaled by n */
+    NumericTablePtr rows(new HomogenNumericTable<algorithmFPType>(1, 1, NumericTable::doAllocate,
+        (algorithmFPType)pData->getNumberOfRows()));
+
+    /* Sum X'X, X'y and the row counts of all ranks */
+    allreduceTables({normEqModel->getXTXTable(), normEqModel->getXTYTable(), rows});
+
+    if (rankId != ccl_root)
+        return NumericTablePtr();
+
+    BlockDescriptor<algorithmFPType> blockRows;
+    rows->getBlockOfRows(0, 1, readOnly, blockRows);
+    algorithmFPType totalRows = blockRows.getBlockPtr()[0];
+    rows->releaseBlockOfRows(blockRows);
+
+    /* The summed partial model covers all rows, solve the regularized normal equations on the root */
+    ridge_regression::training::Distributed<step2Master, algorithmFPType> masterAlgorithm;
+    masterAlgorithm.parameter.interceptFlag = fitIntercept;
+    masterAlgorithm.parameter.ridgeParameters = NumericTablePtr(
+        new HomogenNumericTable<algorithmFPType>(1, 1, NumericTable::doAllocate, regParam * totalRows));
+    masterAlgorithm.input.add(ridge_regression::training::partialModels, partialModel);
+    masterAlgorithm.compute();
+    masterAlgorithm.finalizeCompute();
+
+    return masterAlgorithm.getResult()->get(ridge_regression::training::model)->getBeta();
+}
+
+/*
+ * Class:     org_apache_spark_ml_regression_LinearRegressionDALImpl
+ * Method:    cLinearRegressionTrainDAL
+ * Signature: (JJZDII)J
+ */
+JNIEXPORT jlong JNICALL Java_org_apache_spark_ml_regression_LinearRegressionDALImpl_cLinearRegressionTrainDAL
+  (JNIEnv *env, jobject obj,
+  jlong pNumTabData, jlong pNumTabLabel,
+  jboolean fitIntercept, jdouble regParam,
+  jint executor_num, jint executor_cores) {
+
+  size_t rankId;
+  ccl_get_comm_rank(NULL, &rankId);
+
+  NumericTablePtr pData = *((NumericTablePtr *)pNumTabData);
+  NumericTablePtr pLabel = *((NumericTablePtr *)pNumTabLabel);
+
+  // Set number of threads for oneDAL to use for each rank
+  services::Environment::getInstance()->setNumberOfThreads(executor_cores);
+
+  int nThreadsNew = services::Environment::getInstance()->getNumberOfThreads();
+  cout << "oneDAL (native): Number of threads used: " << nThreadsNew << endl;
+
+  auto t1 = std::chrono::high_resolution_clock::now();
+
+  NumericTablePtr beta = regParam == 0 ?
+      linear_regression_compute(rankId, pData, pLabel, fitIntercept) :
+      ridge_regression_compute(rankId, pData, pLabel, fitIntercept, regParam);
+
+  auto t2 = std::chrono::high_resolution_clock::now();
+  auto duration = std::chrono::duration_cast<std::chrono::seconds>( t2 - t1 ).count();
+  std::cout << "LinearRegression (native): training took " << duration << " secs" << std::endl;
+
+  if (rankId == ccl_root) {
+    // Beta is 1 x (nFeatures + 1), the intercept comes first
+    NumericTablePtr *ret = new NumericTablePtr(beta);
+    return (jlong)ret;
+  } else
+    return (jlong)0;
+}
@@ -17,6 +17,9 @@
 #include <daal.h>
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#include <thread>
+#include <vector>
 #include "org_apache_spark_ml_util_OneDAL__.h"
 
 using namespace daal;
@@ -49,52 +52,170 @@ JNIEXPORT void JNICALL Java_org_apache_spark_ml_util_OneDAL_00024_cSetDoubleBatc
   }
 
 
+// Field and method IDs stay valid while the class is loaded, look them up once
+struct DataBatchIDs {
+    jfieldID rowOffset;
+    jfieldID values;
+    jfieldID numCols;
+};
+
+static const DataBatchIDs & getDataBatchIDs(JNIEnv *env, jobject batch) {
+    static const DataBatchIDs ids = [env, batch]() {
+        DataBatchIDs ids;
+        jclass batchClass = env->GetObjectClass(batch);
+        ids.rowOffset = env->GetFieldID(batchClass, "rowOffset", "[J");
+        ids.values = env->GetFieldID(batchClass, "values", "[D");
+        ids.numCols = env->GetFieldID(batchClass, "numCols", "I");
+        env->DeleteLocalRef(batchClass);
+        return ids;
+    }();
+    return ids;
+}
+
+// Copies smaller than this are not worth splitting across threads
+static const size_t PARALLEL_COPY_CHUNK = 4 * 1024 * 1024;
+
+// Split a large copy across as many threads as oneDAL uses on this rank
+static void parallelMemcpy(char *dst, const char *src, size_t size) {
+    size_t nThreads = std::min<size_t>(services::Environment::getInstance()->getNumberOfThreads(),
+                                       size / PARALLEL_COPY_CHUNK);
+    if (nThreads <= 1) {
+        std::memcpy(dst, src, size);
+        return;
+    }
+
+    size_t chunk = (size + nThreads - 1) / nThreads;
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < nThreads; i++) {
+        size_t offset = i * chunk;
+        size_t len = std::min(chunk, size - offset);
+        threads.emplace_back([=] { std::memcpy(dst + offset, src + offset, len); });
+    }
+    std::memcpy(dst, src, chunk);
+    for (auto &t : threads)
+        t.join();
+}
+
 JNIEXPORT void JNICALL Java_org_apache_spark_ml_util_OneDAL_00024_cSetDoubleIterator
   (JNIEnv *env, jobject, jlong numTableAddr, jobject jiter, jint curRows) {
-    
-    jclass iterClass = env->FindClass("java/util/Iterator");
-    jmethodID hasNext = env->GetMethodID(iterClass,
-                                          "hasNext", "()Z");
-    jmethodID next = env->GetMethodID(iterClass,
-                                       "next", "()Ljava/lang/Object;");
 
     HomogenNumericTable<double> *nt = static_cast<HomogenNumericTable<double> *>(
                 ((SerializationIfacePtr *)numTableAddr)->get());
-    
+
+    jclass iterClass = env->FindClass("java/util/Iterator");
+    jmethodID hasNext = env->GetMethodID(iterClass, "hasNext", "()Z");
+    jmethodID next = env->GetMethodID(iterClass, "next", "()Ljava/lang/Object;");
+    env->DeleteLocalRef(iterClass);
+
+    // Row offsets are relative to their batch, batches are appended one after another
+    jlong batchStart = curRows;
     while (env->CallBooleanMethod(jiter, hasNext)) {
-         jobject batch = env->CallObjectMethod(jiter, next);
-		 
-         jclass batchClass = env->GetObjectClass(batch);
-         jlongArray joffset = (jlongArray)env->GetObjectField(
-              batch, env->GetFieldID(batchClass, "rowOffset", "[J"));
-         jdoubleArray jvalue = (jdoubleArray)env->GetObjectField(
-              batch, env->GetFieldID(batchClass, "values", "[D"));
-         jint jcols = env->GetIntField(
-              batch, env->GetFieldID(batchClass, "numCols", "I"));
-
-         long numRows = env->GetArrayLength(joffset);
-
-         jlong* rowOffset = env->GetLongArrayElements(joffset, 0);
-		 
-		 jdouble* values = env->GetDoubleArrayElements(jvalue, 0);
-
-         for (int i = 0; i < numRows; i ++){
-            jlong curRow = rowOffset[i] + curRows;
-            for(int j = 0; j < jcols; j ++) {
-                (*nt)[curRow][j] = values[rowOffset[i] * jcols + j];
+        jobject batch = env->CallObjectMethod(jiter, next);
+        const DataBatchIDs &ids = getDataBatchIDs(env, batch);
+
+        jlongArray joffset = (jlongArray)env->GetObjectField(batch, ids.rowOffset);
+        jdoubleArray jvalue = (jdoubleArray)env->GetObjectField(batch, ids.values);
+        jint jcols = env->GetIntField(batch, ids.numCols);
+
+        long numRows = env->GetArrayLength(joffset);
+
+        jlong* rowOffset = (jlong*)env->GetPrimitiveArrayCritical(joffset, 0);
+        jdouble* values = (jdouble*)env->GetPrimitiveArrayCritical(jvalue, 0);
+
+        // Batches are dense, rows of a batch are contiguous in both the batch and the table
+        bool contiguous = true;
+        for (long i = 0; i < numRows && contiguous; i++)
+            contiguous = rowOffset[i] == rowOffset[0] + i;
+
+        if (contiguous && numRows > 0) {
+            std::memcpy((*nt)[rowOffset[0] + batchStart], &values[rowOffset[0] * jcols],
+                        numRows * jcols * sizeof(double));
+        } else {
+            for (long i = 0; i < numRows; i++)
+                std::memcpy((*nt)[rowOffset[i] + batchStart], &values[rowOffset[i] * jcols],
+                            jcols * sizeof(double));
+        }
+        batchStart += numRows;
+
+        env->ReleasePrimitiveArrayCritical(jvalue, values, JNI_ABORT);
+        env->ReleasePrimitiveArrayCritical(joffset, rowOffset, JNI_ABORT);
+        env->DeleteLocalRef(joffset);
+        env->DeleteLocalRef(jvalue);
+        env->DeleteLocalRef(batch);
+    }
+}
+
+/*
+ * Class:     org_apache_spark_ml_util_OneDAL__
+ * Method:    cSetDoubleDirect
+ * Signature: (JIJII)V
+ */
+JNIEXPORT void JNICALL Java_org_apache_spark_ml_util_OneDAL_00024_cSetDoubleDirect
+  (JNIEnv *, jobject, jlong numTableAddr, jint curRows, jlong address, jint numRows, jint numCols) {
+
+    HomogenNumericTable<double> *nt = static_cast<HomogenNumericTable<double> *>(
+                ((SerializationIfacePtr *)numTableAddr)->get());
+    parallelMemcpy((char *)(*nt)[curRows], (const char *)address,
+                   (size_t)numRows * numCols * sizeof(double));
+}
+
+/*
+ * Class:     org_apache_spark_ml_util_OneDAL__
+ * Method:    cSetDoubleColumns
+ * Signature: (JI[JI)V
+ */
+JNIEXPORT void JNICALL Java_org_apache_spark_ml_util_OneDAL_00024_cSetDoubleColumns
+  (JNIEnv *env, jobject, jlong numTableAddr, jint curRows, jlongArray jcolumns, jint numRows) {
+
+    HomogenNumericTable<double> *nt = static_cast<HomogenNumericTable<double> *>(
+                ((SerializationIfacePtr *)numTableAddr)->get());
+
+    size_t numCols = env->GetArrayLength(jcolumns);
+    std::vector<const double *> columns(numCols);
+    jlong *addresses = env->GetLongArrayElements(jcolumns, 0);
+    for (size_t j = 0; j < numCols; j++)
+        columns[j] = (const double *)addresses[j];
+    env->ReleaseLongArrayElements(jcolumns, addresses, JNI_ABORT);
+
+    double *dst = (*nt)[curRows];
+    size_t size = (size_t)numRows * numCols * sizeof(double);
+    size_t nThreads = std::max<size_t>(1, std::min<size_t>(
+        services::Environment::getInstance()->getNumberOfThreads(), size / PARALLEL_COPY_CHUNK));
+
+    // Transpose blocks of rows so the reads of every column stay sequential
+    auto transpose = [&](size_t begin, size_t end) {
+        const size_t block = 256;
+        for (size_t r0 = begin; r0 < end; r0 += block) {
+            size_t r1 = std::min(end, r0 + block);
+            for (size_t j = 0; j < numCols; j++) {
+                const double *col = columns[j];
+                for (size_t r = r0; r < r1; r++)
+                    dst[r * numCols + j] = col[r];
             }
-         }
-        
-         env->ReleaseLongArrayElements(joffset, rowOffset, 0);
-         env->DeleteLocalRef(joffset);
-         env->ReleaseDoubleArrayElements(jvalue, values, 0);
-         env->DeleteLocalRef(jvalue);
-         env->DeleteLocalRef(batch);
-         env->DeleteLocalRef(batchClass);
-  }
-  env->DeleteLocalRef(iterClass);
+        }
+    };
+
+    size_t chunk = (numRows + nThreads - 1) / nThreads;
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < nThreads; i++)
+        threads.emplace_back(transpose, i * chunk, std::min<size_t>(numRows, (i + 1) * chunk));
+    transpose(0, std::min<size_t>(numRows, chunk));
+    for (auto &t : threads)
+        t.join();
+}
 
-  }
+/*
+ * Class:     org_apache_spark_ml_util_OneDAL__
+ * Method:    cWrapDoubleDirect
+ * Signature: (JII)J
+ */
+JNIEXPORT jlong JNICALL Java_org_apache_spark_ml_util_OneDAL_00024_cWrapDoubleDirect
+  (JNIEnv *, jobject, jlong address, jint numRows, jint numCols) {
+
+    // The table does not own the buffer, it must outlive the table
+    NumericTablePtr table(new HomogenNumericTable<double>((double *)address, numCols, numRows));
+    return (jlong)new NumericTablePtr(table);
+}
 
 JNIEXPORT void JNICALL Java_org_apache_spark_ml_util_OneDAL_00024_cAddNumericTable
   (JNIEnv *, jobject,  jlong rowMergedNumericTableAddr, jlong numericTableAddr) {
@@ -0,0 +1,141 @@
+/*******************************************************************************
+* Copyright 2020 Intel Corporation
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#include <ccl.h>
+#include <daal.h>
+
+#include "partial_results.h"
+#include "org_apache_spark_ml_feature_PCADALImpl.h"
+#include <iostream>
+#include <chrono>
+
+using namespace std;
+using namespace daal;
+using namespace daal::algorithms;
+
+const int ccl_root = 0;
+
+typedef double algorithmFPType; /* Algorithm floating-point type */
+
+/*
+ * crossProduct += sign * sum' * sum / n. The step1Local cross product is
+ * centered on the local mean, adding the term gives the raw X'X, which sums
+ * across ranks, and subtracting it with the global sums centers it again.
+ */
+static void shiftCrossProduct(const NumericTablePtr & crossProduct, const NumericTablePtr & sum,
+    const NumericTablePtr & nObservations, algorithmFPType sign)
+{
+    size_t nFeatures = sum->getNumberOfColumns();
+
+    BlockDescriptor<algorithmFPType> blockN;
+    nObservations->getBlockOfRows(0, 1, readOnly, blockN);
+    algorithmFPType n = blockN.getBlockPtr()[0];
+    nObservations->releaseBlockOfRows(blockN);
+    if (n == 0)
+        return;
+
+    BlockDescriptor<algorithmFPType> blockSum;
+    sum->getBlockOfRows(0, 1, readOnly, blockSum);
+    const algorithmFPType *s = blockSum.getBlockPtr();
+
+    BlockDescriptor<algorithmFPType> blockCP;
+    crossProduct->getBlockOfRows(0, nFeatures, readWrite, blockCP);
+    algorithmFPType *cp = blockCP.getBlockPtr();
+
+    for (size_t i = 0; i < nFeatures; i++)
+        for (size_t j = 0; j < nFeatures; j++)
+            cp[i * nFeatures + j] += sign * s[i] * s[j] / n;
+
+    crossProduct->releaseBlockOfRows(blockCP);
+    sum->releaseBlockOfRows(blockSum);
+}
+
+/*
+ * Class:     org_apache_spark_ml_feature_PCADALImpl
+ * Method:    cPCADALCorrelation
+ * Signature: (JIILorg/apache/spark/ml/feature/PCAResult;)J
+ */
+JNIEXPORT jlong JNICALL Java_org_apache_spark_ml_feature_PCADALImpl_cPCADALCorrelation
+  (JNIEnv *env, jobject obj,
+  jlong pNumTabData,
+  jint executor_num, jint executor_cores,
+  jobject resultObj) {
+
+  size_t rankId;
+  ccl_get_comm_rank(NULL, &rankId);
+
+  NumericTablePtr pData = *((NumericTablePtr *)pNumTabData);
+
+  // Set number of threads for oneDAL to use for each rank
+  services::Environment::getInstance()->setNumberOfThreads(executor_cores);
+
+  int nThreadsNew = services::Environment::getInstance()->getNumberOfThreads();
+  cout << "oneDAL (native): Number of threads used: " << nThreadsNew << endl;
+
+  auto t1 = std::chrono::high_resolution_clock::now();
+
+  /* Compute the partial sums and cross products of the local data */
+  covariance::Distributed<step1Local, algorithmFPType> localAlgorithm;
+  localAlgorithm.input.set(covariance::data, pData);
+  localAlgorithm.compute();
+
+  covariance::PartialResultPtr partialResult = localAlgorithm.getPartialResult();
+  NumericTablePtr nObservations = partialResult->get(covariance::nObservations);
+  NumericTablePtr crossProduct = partialResult->get(covariance::crossProduct);
+  NumericTablePtr sum = partialResult->get(covariance::sum);
+
+  /* Sum the row counts, raw cross products and sums of all ranks */
+  shiftCrossProduct(crossProduct, sum, nObservations, 1);
+  allreduceTables({nObservations, crossProduct, sum});
+
+  if (rankId != ccl_root)
+    return (jlong)0;
+
+  /* The summed partial result covers all rows, finalize it into the covariance matrix */
+  shiftCrossProduct(crossProduct, sum, nObservations, -1);
+  covariance::Distributed<step2Master, algorithmFPType> masterAlgorithm;
+  masterAlgorithm.input.add(covariance::partialResults, partialResult);
+  masterAlgorithm.compute();
+  masterAlgorithm.finalizeCompute();
+
+  NumericTablePtr covarianceTable = masterAlgorithm.getResult()->get(covariance::covariance);
+
+  /* Eigen decomposition of the covariance matrix */
+  pca::Batch<algorithmFPType, pca::correlationDense> algorithm;
+  algorithm.input.set(pca::correlation, covarianceTable);
+  algorithm.compute();
+
+  pca::ResultPtr result = algorithm.getResult();
+  NumericTablePtr eigenvalues = result->get(pca::eigenvalues);
+  NumericTablePtr eigenvectors = result->get(pca::eigenvectors);
+
+  auto t2 = std::chrono::high_resolution_clock::now();
+  auto duration = std::chrono::duration_cast<std::chrono::seconds>( t2 - t1 ).count();
+  std::cout << "PCA (native): training took " << duration << " secs" << std::endl;
+
+  // Get the class of the input object
+  jclass clazz = env->GetObjectClass(resultObj);
+  // Get Field references
+  jfieldID explainedVarianceField = env->GetFieldID(clazz, "explainedVarianceNumericTable", "J");
+
+  // Set eigenvalues for result, explained variance is derived from them on JVM side
+  NumericTablePtr *retEigenvalues = new NumericTablePtr(eigenvalues);
+  env->SetLongField(resultObj, explainedVarianceField, (jlong)retEigenvalues);
+
+  // Principal components are the rows of eigenvectors, sorted by eigenvalue
+  NumericTablePtr *ret = new NumericTablePtr(eigenvectors);
+  return (jlong)ret;
+}
@@ -0,0 +1,21 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class org_apache_spark_ml_regression_LinearRegressionDALImpl */
+
+#ifndef _Included_org_apache_spark_ml_regression_LinearRegressionDALImpl
+#define _Included_org_apache_spark_ml_regression_LinearRegressionDALImpl
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     org_apache_spark_ml_regression_LinearRegressionDALImpl
+ * Method:    cLinearRegressionTrainDAL
+ * Signature: (JJZDII)J
+ */
+JNIEXPORT jlong JNICALL Java_org_apache_spark_ml_regression_LinearRegressionDALImpl_cLinearRegressionTrainDAL
+  (JNIEnv *, jobject, jlong, jlong, jboolean, jdouble, jint, jint);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -39,6 +39,30 @@ JNIEXPORT void JNICALL Java_org_apache_spark_ml_util_OneDAL_00024_cSetDoubleBatc
 JNIEXPORT void JNICALL Java_org_apache_spark_ml_util_OneDAL_00024_cSetDoubleIterator
   (JNIEnv *, jobject, jlong, jobject, jint);
 
+/*
+ * Class:     org_apache_spark_ml_util_OneDAL__
+ * Method:    cSetDoubleDirect
+ * Signature: (JIJII)V
+ */
+JNIEXPORT void JNICALL Java_org_apache_spark_ml_util_OneDAL_00024_cSetDoubleDirect
+  (JNIEnv *, jobject, jlong, jint, jlong, jint, jint);
+
+/*
+ * Class:     org_apache_spark_ml_util_OneDAL__
+ * Method:    cSetDoubleColumns
+ * Signature: (JI[JI)V
+ */
+JNIEXPORT void JNICALL Java_org_apache_spark_ml_util_OneDAL_00024_cSetDoubleColumns
+  (JNIEnv *, jobject, jlong, jint, jlongArray, jint);
+
+/*
+ * Class:     org_apache_spark_ml_util_OneDAL__
+ * Method:    cWrapDoubleDirect
+ * Signature: (JII)J
+ */
+JNIEXPORT jlong JNICALL Java_org_apache_spark_ml_util_OneDAL_00024_cWrapDoubleDirect
+  (JNIEnv *, jobject, jlong, jint, jint);
+
 /*
  * Class:     org_apache_spark_ml_util_OneDAL__
  * Method:    cFreeDataMemory
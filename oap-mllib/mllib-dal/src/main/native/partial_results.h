@@ -0,0 +1,88 @@
+/*******************************************************************************
+* Copyright 2020 Intel Corporation
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#pragma once
+
+#include <ccl.h>
+#include <daal.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace daal;
+using namespace daal::data_management;
+
+/*
+ * Partial results of the normal equations and covariance step1Local are sums
+ * over the local rows, nFeatures x nFeatures at most. Summing them across
+ * ranks with an allreduce costs the size of one partial result, where
+ * gathering every rank's archive costs nRanks of them on every rank.
+ */
+
+/* Copy all rows of a numeric table into a flat row-major buffer */
+inline void copyTableToBuffer(const NumericTablePtr & table, double *buf)
+{
+    size_t rows = table->getNumberOfRows();
+    size_t cols = table->getNumberOfColumns();
+
+    BlockDescriptor<double> block;
+    table->getBlockOfRows(0, rows, readOnly, block);
+    std::copy(block.getBlockPtr(), block.getBlockPtr() + rows * cols, buf);
+    table->releaseBlockOfRows(block);
+}
+
+/* Overwrite all rows of a numeric table from a flat row-major buffer */
+inline void copyBufferToTable(const double *buf, const NumericTablePtr & table)
+{
+    size_t rows = table->getNumberOfRows();
+    size_t cols = table->getNumberOfColumns();
+
+    BlockDescriptor<double> block;
+    table->getBlockOfRows(0, rows, writeOnly, block);
+    std::copy(buf, buf + rows * cols, block.getBlockPtr());
+    table->releaseBlockOfRows(block);
+}
+
+/*
+ * Sum the tables element-wise over all ranks in place, with a single
+ * allreduce over a flat buffer holding all of them back to back.
+ */
+inline void allreduceTables(const std::vector<NumericTablePtr> & tables)
+{
+    size_t bufLength = 0;
+    for (const NumericTablePtr & table : tables)
+        bufLength += table->getNumberOfRows() * table->getNumberOfColumns();
+
+    std::vector<double> localBuf(bufLength), globalBuf(bufLength);
+    size_t offset = 0;
+    for (const NumericTablePtr & table : tables)
+    {
+        copyTableToBuffer(table, &localBuf[offset]);
+        offset += table->getNumberOfRows() * table->getNumberOfColumns();
+    }
+
+    ccl_request_t request;
+    ccl_allreduce(&localBuf[0], &globalBuf[0], bufLength, ccl_dtype_double, ccl_reduction_sum,
+        NULL, NULL, NULL, &request);
+    ccl_wait(request);
+
+    offset = 0;
+    for (const NumericTablePtr & table : tables)
+    {
+        copyBufferToTable(&globalBuf[offset], table);
+        offset += table->getNumberOfRows() * table->getNumberOfColumns();
+    }
+}
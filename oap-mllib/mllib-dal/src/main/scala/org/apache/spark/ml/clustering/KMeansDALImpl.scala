@@ -42,74 +42,12 @@ class KMeansDALImpl (
 
     val executorIPAddress = Utils.sparkFirstExecutorIP(data.sparkContext)
 
-    // repartition to executorNum if not enough partitions
-    val dataForConversion = if (data.getNumPartitions < executorNum) {
-      data.repartition(executorNum).setName("Repartitioned for conversion").cache()
-    } else {
-      data
-    }
-
-    val partitionDims = Utils.getPartitionDims(dataForConversion)
-
-    // filter the empty partitions
-    val partRows = dataForConversion.mapPartitionsWithIndex { (index: Int, it: Iterator[Vector]) =>
-      Iterator(Tuple3(partitionDims(index)._1, index, it))
-    }
-    val nonEmptyPart = partRows.filter{entry => { entry._1 > 0 }}
-    
-    // convert RDD[Vector] to RDD[HomogenNumericTable]
-    val numericTables = nonEmptyPart.map { entry =>
-      val numRows = entry._1
-      val index = entry._2
-      val it = entry._3
-      val numCols = partitionDims(index)._2
-	  
-      println(s"KMeansDALImpl: Partition index: $index, numCols: $numCols, numRows: $numRows")
-
-      // Build DALMatrix, this will load libJavaAPI, libtbb, libtbbmalloc
-      val context = new DaalContext()
-      val matrix = new DALMatrix(context, classOf[java.lang.Double],
-        numCols.toLong, numRows.toLong, NumericTable.AllocationFlag.DoAllocate)
-
-      println("KMeansDALImpl: Loading native libraries" )
-      // oneDAL libs should be loaded by now, extract libMLlibDAL.so to temp file and load
-      LibLoader.loadLibraries()
-
-      import scala.collection.JavaConverters._
-      
-      var dalRow = 0
-         
-      it.foreach { curVector =>
-        val rowArr = curVector.toArray
-        OneDAL.cSetDoubleBatch(matrix.getCNumericTable, dalRow, rowArr, 1, numCols)
-        dalRow += 1
-      }
-
-      Iterator(matrix.getCNumericTable)
-
-    }.cache()
-    
-	  // workaround to fix the bug of multi executors handling same partition.
-    numericTables.foreachPartition(() => _)
-    numericTables.count()
+    val numericTables = OneDAL.rddVectorToNumericTables(data, executorNum)
 
     val cachedRdds = data.sparkContext.getPersistentRDDs
     cachedRdds.filter(r => r._2.name=="instancesRDD").foreach (r => r._2.unpersist())
-	
-    val coalescedRdd = numericTables.coalesce(1,
-      partitionCoalescer = Some(new ExecutorInProcessCoalescePartitioner()))
-
-    val coalescedTables = coalescedRdd.mapPartitions { iter =>
-      val context = new DaalContext()
-      val mergedData = new RowMergedNumericTable(context)
-	  
-      iter.foreach{ curIter =>
-        val address = curIter.next()
-        OneDAL.cAddNumericTable(mergedData.getCNumericTable, address )
-      } 
-      Iterator(mergedData.getCNumericTable)
-    
-    }.cache()
+
+    val coalescedTables = OneDAL.mergeNumericTables(numericTables)
 
     val results = coalescedTables.mapPartitions { table =>
       val tableArr = table.next()
@@ -142,11 +80,7 @@ class KMeansDALImpl (
     }.collect()
 
     // Release the native memory allocated by NumericTable.
-    numericTables.foreach( tables =>
-      tables.foreach { address =>
-        OneDAL.cFreeDataMemory(address)
-      }
-    )
+    OneDAL.freeNumericTables(numericTables)
 
     // Make sure there is only one result from rank 0
     assert(results.length == 1)
@@ -0,0 +1,94 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.apache.spark.ml.feature
+
+import org.apache.spark.internal.Logging
+import org.apache.spark.ml.linalg.{DenseMatrix, DenseVector, Vector, Vectors}
+import org.apache.spark.ml.util.{OneCCL, OneDAL, Utils}
+import org.apache.spark.rdd.RDD
+
+class PCADALImpl (
+  val k: Int,
+  val executorNum: Int,
+  val executorCores: Int
+) extends Serializable with Logging {
+
+  // Return the top k principal components (numFeatures x k) and their explained variance
+  def fitWithDAL(data: RDD[Vector]) : (DenseMatrix, DenseVector) = {
+
+    val executorIPAddress = Utils.sparkFirstExecutorIP(data.sparkContext)
+
+    val numericTables = OneDAL.rddVectorToNumericTables(data, executorNum)
+    val coalescedTables = OneDAL.mergeNumericTables(numericTables)
+
+    val results = coalescedTables.mapPartitions { table =>
+      val tableArr = table.next()
+      OneCCL.init(executorNum, executorIPAddress, OneCCL.KVS_PORT)
+
+      val result = new PCAResult()
+      val cPC = cPCADALCorrelation(
+        tableArr,
+        executorNum,
+        executorCores,
+        result
+      )
+
+      val ret = if (OneCCL.isRoot()) {
+        assert(cPC != 0)
+        // Each row is an eigenvector, sorted by eigenvalue in descending order
+        val pcVectors = OneDAL.numericTableToVectors(OneDAL.makeNumericTable(cPC))
+        val eigenvalues = OneDAL.numericTableToVectors(
+          OneDAL.makeNumericTable(result.explainedVarianceNumericTable))(0)
+        Iterator((pcVectors, eigenvalues))
+      } else {
+        Iterator.empty
+      }
+
+      OneCCL.cleanup()
+
+      ret
+    }.collect()
+
+    // Release the native memory allocated by NumericTable.
+    OneDAL.freeNumericTables(numericTables)
+
+    // Make sure there is only one result from rank 0
+    assert(results.length == 1)
+
+    val pcVectors = results(0)._1
+    val eigenvalues = results(0)._2.toArray
+    val numFeatures = pcVectors(0).size
+
+    require(k <= numFeatures,
+      s"source vector size $numFeatures must be no less than k=$k")
+
+    // Column major, principal component j is column j
+    val pc = new DenseMatrix(numFeatures, k, pcVectors.take(k).flatMap(_.toArray))
+    val eigenSum = eigenvalues.sum
+    val explainedVariance = Vectors.dense(eigenvalues.take(k).map(_ / eigenSum))
+      .asInstanceOf[DenseVector]
+
+    (pc, explainedVariance)
+  }
+
+  // Single entry to call PCA DAL backend, output eigenvectors
+  @native private def cPCADALCorrelation(data: Long,
+                                         executor_num: Int,
+                                         executor_cores: Int,
+                                         result: PCAResult): Long
+}
@@ -0,0 +1,88 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.apache.spark.ml.regression
+
+import org.apache.spark.internal.Logging
+import org.apache.spark.ml.linalg.{Vector, Vectors}
+import org.apache.spark.ml.util.{OneCCL, OneDAL, Utils}
+import org.apache.spark.rdd.RDD
+
+class LinearRegressionDALImpl (
+  val fitIntercept: Boolean,
+  val regParam: Double,
+  val executorNum: Int,
+  val executorCores: Int
+) extends Serializable with Logging {
+
+  // Train on (label, features) pairs, return the coefficients and the intercept
+  def train(data: RDD[(Double, Vector)]) : (Vector, Double) = {
+
+    val executorIPAddress = Utils.sparkFirstExecutorIP(data.sparkContext)
+
+    val numericTables = OneDAL.rddLabeledVectorToNumericTables(data, executorNum)
+    val coalescedTables = OneDAL.mergeLabeledNumericTables(numericTables)
+
+    val results = coalescedTables.mapPartitions { tables =>
+      val (featuresTable, labelTable) = tables.next()
+      OneCCL.init(executorNum, executorIPAddress, OneCCL.KVS_PORT)
+
+      val cBeta = cLinearRegressionTrainDAL(
+        featuresTable,
+        labelTable,
+        fitIntercept,
+        regParam,
+        executorNum,
+        executorCores
+      )
+
+      val ret = if (OneCCL.isRoot()) {
+        assert(cBeta != 0)
+        Iterator(OneDAL.numericTableToVectors(OneDAL.makeNumericTable(cBeta))(0))
+      } else {
+        Iterator.empty
+      }
+
+      OneCCL.cleanup()
+
+      ret
+    }.collect()
+
+    // Release the native memory allocated by NumericTable.
+    OneDAL.freeLabeledNumericTables(numericTables)
+
+    // Make sure there is only one result from rank 0
+    assert(results.length == 1)
+
+    // beta is 1 x (numFeatures + 1), beta(0) is the intercept
+    val beta = results(0).toArray
+    val coefficients = Vectors.dense(beta.drop(1))
+    val intercept = if (fitIntercept) beta(0) else 0.0
+
+    logInfo(s"OneDAL output coefficients: $coefficients, intercept: $intercept")
+
+    (coefficients, intercept)
+  }
+
+  // Single entry to call linear regression DAL backend, output beta
+  @native private def cLinearRegressionTrainDAL(data: Long,
+                                                label: Long,
+                                                fitIntercept: Boolean,
+                                                regParam: Double,
+                                                executor_num: Int,
+                                                executor_cores: Int): Long
+}
@@ -17,14 +17,19 @@
 
 package org.apache.spark.ml.util
 
-import com.intel.daal.data_management.data.{HomogenNumericTable, NumericTable, Matrix => DALMatrix}
+import com.intel.daal.data_management.data.{HomogenNumericTable, NumericTable, RowMergedNumericTable, Matrix => DALMatrix}
 import com.intel.daal.services.DaalContext
 import org.apache.spark.SparkContext
-import org.apache.spark.ml.linalg.{Vector, Vectors}
+import org.apache.spark.ml.linalg.{DenseVector, Vector, Vectors}
 import org.apache.spark.mllib.linalg.{Vector => OldVector}
+import org.apache.spark.rdd.{ExecutorInProcessCoalescePartitioner, RDD}
+import org.apache.spark.unsafe.Platform
 
 object OneDAL {
 
+  // Number of doubles staged off-heap and copied to a numeric table per JNI call
+  val INGESTION_BATCH_SIZE: Int = 1 << 22
+
   // Convert DAL numeric table to array of vectors
   def numericTableToVectors(table: NumericTable): Array[Vector] = {
     val numRows = table.getNumberOfRows.toInt
@@ -70,6 +75,160 @@ object OneDAL {
     matrix
   }
 
+  // Copy rows into a new numRows x numCols table. Rows are packed row-major into an off-heap
+  // staging buffer, every full buffer is copied into the table storage by cSetDoubleDirect,
+  // which splits large copies across threads.
+  private[util] def makeNumericTableFromRows(rows: Iterator[Vector], numRows: Int,
+                                             numCols: Int, index: Int): Long = {
+    // Build DALMatrix, this will load libJavaAPI, libtbb, libtbbmalloc
+    val context = new DaalContext()
+    val matrix = new DALMatrix(context, classOf[java.lang.Double],
+      numCols.toLong, numRows.toLong, NumericTable.AllocationFlag.DoAllocate)
+
+    // oneDAL libs should be loaded by now, extract libMLlibDAL.so to temp file and load
+    LibLoader.loadLibraries()
+
+    val batchRows = math.max(1, math.min(numRows, INGESTION_BATCH_SIZE / numCols))
+    val rowBytes = numCols.toLong * 8
+    val buffer = Platform.allocateMemory(batchRows * rowBytes)
+    var batchRow = 0
+    var dalRow = 0
+    val start = System.nanoTime()
+
+    try {
+      rows.foreach { curVector =>
+        val rowAddress = buffer + batchRow * rowBytes
+        curVector match {
+          case dense: DenseVector =>
+            Platform.copyMemory(dense.values, Platform.DOUBLE_ARRAY_OFFSET, null, rowAddress,
+              rowBytes)
+          case _ =>
+            Platform.setMemory(rowAddress, 0, rowBytes)
+            curVector.foreachActive { (col, value) =>
+              Platform.putDouble(null, rowAddress + col * 8L, value)
+            }
+        }
+        batchRow += 1
+        if (batchRow == batchRows) {
+          cSetDoubleDirect(matrix.getCNumericTable, dalRow, buffer, batchRow, numCols)
+          dalRow += batchRow
+          batchRow = 0
+        }
+      }
+      if (batchRow > 0) {
+        cSetDoubleDirect(matrix.getCNumericTable, dalRow, buffer, batchRow, numCols)
+        dalRow += batchRow
+      }
+    } finally {
+      Platform.freeMemory(buffer)
+    }
+
+    val seconds = (System.nanoTime() - start) / 1e9
+    val gigabytes = dalRow.toDouble * numCols * 8 / (1L << 30)
+    println(f"OneDAL: Partition index: $index, loaded $gigabytes%.3f GB in " +
+      f"$seconds%.3f secs, ${gigabytes / seconds}%.3f GB/s")
+
+    matrix.getCNumericTable
+  }
+
+  // Convert every non-empty partition to a numeric table, returns the cached table addresses
+  def rddVectorToNumericTables(data: RDD[Vector], executorNum: Int): RDD[Long] = {
+    rddLabeledVectorToNumericTables(data.map((0.0, _)), executorNum, withLabel = false)
+      .map(_._1)
+  }
+
+  // Convert every non-empty partition to a features table and a one column label table
+  def rddLabeledVectorToNumericTables(data: RDD[(Double, Vector)],
+                                      executorNum: Int): RDD[(Long, Long)] = {
+    rddLabeledVectorToNumericTables(data, executorNum, withLabel = true)
+  }
+
+  private def rddLabeledVectorToNumericTables(data: RDD[(Double, Vector)],
+                                              executorNum: Int,
+                                              withLabel: Boolean): RDD[(Long, Long)] = {
+    // repartition to executorNum if not enough partitions
+    val dataForConversion = if (data.getNumPartitions < executorNum) {
+      data.repartition(executorNum).setName("Repartitioned for conversion").cache()
+    } else {
+      data
+    }
+
+    val partitionDims = Utils.getPartitionDims(dataForConversion.map(_._2))
+
+    val numericTables = dataForConversion.mapPartitionsWithIndex { (index, it) =>
+      val (numRows, numCols) = partitionDims(index)
+      if (numRows == 0) {
+        Iterator.empty
+      } else {
+        println(s"OneDAL: Partition index: $index, numCols: $numCols, numRows: $numRows")
+        if (withLabel) {
+          val labels = new Array[Double](numRows)
+          var row = 0
+          val features = makeNumericTableFromRows(it.map { case (label, features) =>
+            labels(row) = label
+            row += 1
+            features
+          }, numRows, numCols, index)
+          val labelTable = makeNumericTableFromRows(
+            labels.iterator.map(Vectors.dense(_)), numRows, 1, index)
+          Iterator((features, labelTable))
+        } else {
+          Iterator((makeNumericTableFromRows(it.map(_._2), numRows, numCols, index), 0L))
+        }
+      }
+    }.cache()
+
+    // workaround to fix the bug of multi executors handling same partition.
+    numericTables.foreachPartition(() => _)
+    numericTables.count()
+
+    numericTables
+  }
+
+  // Merge the tables on each executor into one RowMergedNumericTable per executor
+  def mergeNumericTables(tables: RDD[Long]): RDD[Long] = {
+    mergeLabeledNumericTables(tables.map((_, 0L)), withLabel = false).map(_._1)
+  }
+
+  def mergeLabeledNumericTables(tables: RDD[(Long, Long)]): RDD[(Long, Long)] = {
+    mergeLabeledNumericTables(tables, withLabel = true)
+  }
+
+  private def mergeLabeledNumericTables(tables: RDD[(Long, Long)],
+                                        withLabel: Boolean): RDD[(Long, Long)] = {
+    val coalescedRdd = tables.coalesce(1,
+      partitionCoalescer = Some(new ExecutorInProcessCoalescePartitioner()))
+
+    coalescedRdd.mapPartitions { iter =>
+      val context = new DaalContext()
+      val mergedData = new RowMergedNumericTable(context)
+      val mergedLabel = if (withLabel) new RowMergedNumericTable(context) else null
+
+      iter.foreach { case (data, label) =>
+        cAddNumericTable(mergedData.getCNumericTable, data)
+        if (withLabel) {
+          cAddNumericTable(mergedLabel.getCNumericTable, label)
+        }
+      }
+      val mergedLabelAddr = if (withLabel) mergedLabel.getCNumericTable else 0L
+      Iterator((mergedData.getCNumericTable, mergedLabelAddr))
+    }.cache()
+  }
+
+  // Release the native memory allocated by the converted tables
+  def freeNumericTables(tables: RDD[Long]): Unit = {
+    freeLabeledNumericTables(tables.map((_, 0L)))
+  }
+
+  def freeLabeledNumericTables(tables: RDD[(Long, Long)]): Unit = {
+    tables.foreach { case (data, label) =>
+      cFreeDataMemory(data)
+      if (label != 0) {
+        cFreeDataMemory(label)
+      }
+    }
+  }
+
   @native def setNumericTableValue(numTableAddr: Long, rowIndex: Int, colIndex: Int, value: Double)
 
   @native def cAddNumericTable(cObject: Long, numericTableAddr: Long)
@@ -77,6 +236,18 @@ object OneDAL {
   @native def cSetDoubleBatch(numTableAddr: Long, curRows: Int, batch: Array[Double], numRows: Int, numCols: Int)
  
   @native def cSetDoubleIterator(numTableAddr: Long, iter: java.util.Iterator[DataBatch], curRows: Int)
+
+  // Copy numRows row-major rows from off-heap memory, large copies are split across threads
+  @native def cSetDoubleDirect(numTableAddr: Long, curRows: Int, address: Long, numRows: Int,
+                               numCols: Int)
+
+  // Copy off-heap columns, e.g. the data buffers of Arrow Float8Vectors without nulls
+  @native def cSetDoubleColumns(numTableAddr: Long, curRows: Int, columnAddrs: Array[Long],
+                                numRows: Int)
+
+  // Wrap off-heap row-major rows as a numeric table without copying, the memory must outlive
+  // the table
+  @native def cWrapDoubleDirect(address: Long, numRows: Int, numCols: Int): Long
   
   @native def cFreeDataMemory(numTableAddr: Long)
 
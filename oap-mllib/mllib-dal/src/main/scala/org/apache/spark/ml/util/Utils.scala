@@ -34,8 +34,13 @@ object Utils {
 
   def sparkExecutorNum(sc: SparkContext): Int = {
 
-    if (sc.master.contains("local"))
-      return 1
+    // local-cluster[N, cores, memory] runs N executors on this node
+    val LocalCluster = """local-cluster\[\s*([0-9]+)\s*,.*\]""".r
+    sc.master match {
+      case LocalCluster(executorNum) => return executorNum.toInt
+      case master if master.startsWith("local") => return 1
+      case _ =>
+    }
 
     // Create empty partitions to start executors
     sc.parallelize(Seq[Int]()).count()
@@ -0,0 +1,57 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.apache.spark.ml.feature
+
+import scala.util.Random
+
+import org.apache.spark.SparkFunSuite
+import org.apache.spark.ml.linalg.Vectors
+import org.apache.spark.ml.util.Utils
+import org.apache.spark.ml.util.TestingUtils._
+import org.apache.spark.mllib.linalg.{Vectors => OldVectors}
+import org.apache.spark.mllib.linalg.distributed.RowMatrix
+import org.apache.spark.mllib.util.LocalClusterSparkContext
+
+class PCADALImplSuite extends SparkFunSuite with LocalClusterSparkContext {
+
+  test("distributed PCA matches RowMatrix on two ranks") {
+    val k = 3
+    val numFeatures = 6
+    val random = new Random(42)
+    val rows = Array.fill(2000) {
+      Vectors.dense(Array.tabulate(numFeatures)(i => random.nextGaussian() * (i + 1) + i))
+    }
+    val data = sc.parallelize(rows, 4)
+
+    val executorNum = Utils.sparkExecutorNum(sc)
+    assert(executorNum === 2)
+
+    val (pc, explainedVariance) = new PCADALImpl(k, executorNum, 1).fitWithDAL(data)
+
+    val (expectedPC, expectedVariance) = new RowMatrix(data.map(OldVectors.fromML))
+      .computePrincipalComponentsAndExplainedVariance(k)
+
+    assert(pc.numRows === numFeatures)
+    assert(pc.numCols === k)
+    // Eigenvectors are only defined up to their sign
+    for (j <- 0 until k; i <- 0 until numFeatures) {
+      assert(math.abs(pc(i, j)) ~== math.abs(expectedPC(i, j)) absTol 1e-6)
+    }
+    assert(explainedVariance ~== expectedVariance.asML relTol 1e-6)
+  }
+}
@@ -0,0 +1,84 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.apache.spark.ml.regression
+
+import scala.util.Random
+
+import breeze.linalg.{DenseMatrix => BDM, DenseVector => BDV}
+
+import org.apache.spark.SparkFunSuite
+import org.apache.spark.ml.linalg.{Vector, Vectors}
+import org.apache.spark.ml.util.Utils
+import org.apache.spark.ml.util.TestingUtils._
+import org.apache.spark.mllib.util.LocalClusterSparkContext
+
+class LinearRegressionDALImplSuite extends SparkFunSuite with LocalClusterSparkContext {
+
+  val numFeatures = 4
+  val weights = Array(1.5, -2.0, 0.5, 3.0)
+  val intercept = 0.7
+
+  private def generate(numRows: Int, noise: Double): Array[(Double, Vector)] = {
+    val random = new Random(42)
+    Array.fill(numRows) {
+      val x = Array.fill(numFeatures)(random.nextGaussian())
+      val y = x.zip(weights).map { case (a, b) => a * b }.sum + intercept +
+        noise * random.nextGaussian()
+      (y, Vectors.dense(x))
+    }
+  }
+
+  // Minimize 1 / 2n ||y - Xw - b||^2 + regParam / 2 ||w||^2, the intercept is not penalized
+  private def closedForm(rows: Array[(Double, Vector)], regParam: Double): (Vector, Double) = {
+    val n = rows.length
+    val x = BDM.tabulate(n, numFeatures)((i, j) => rows(i)._2(j))
+    val y = BDV(rows.map(_._1))
+    val xMean = BDV.tabulate(numFeatures)(j => (0 until n).map(x(_, j)).sum / n)
+    val yMean = rows.map(_._1).sum / n
+    val xc = BDM.tabulate(n, numFeatures)((i, j) => x(i, j) - xMean(j))
+    val yc = y - yMean
+    val gram = xc.t * xc + BDM.eye[Double](numFeatures) * (regParam * n)
+    val w = gram \ (xc.t * yc)
+    (Vectors.dense(w.toArray), yMean - (xMean dot w))
+  }
+
+  test("distributed least squares recovers the model on two ranks") {
+    val rows = generate(2000, 0.0)
+    val executorNum = Utils.sparkExecutorNum(sc)
+    assert(executorNum === 2)
+
+    val (coefficients, b) = new LinearRegressionDALImpl(true, 0.0, executorNum, 1)
+      .train(sc.parallelize(rows, 4))
+
+    assert(coefficients ~== Vectors.dense(weights) absTol 1e-8)
+    assert(b ~== intercept absTol 1e-8)
+  }
+
+  test("distributed ridge regression matches the closed form on two ranks") {
+    val rows = generate(2000, 0.1)
+    val regParam = 0.3
+    val executorNum = Utils.sparkExecutorNum(sc)
+
+    val (coefficients, b) = new LinearRegressionDALImpl(true, regParam, executorNum, 1)
+      .train(sc.parallelize(rows, 4))
+    val (expectedCoefficients, expectedIntercept) = closedForm(rows, regParam)
+
+    assert(coefficients ~== expectedCoefficients relTol 1e-6)
+    assert(b ~== expectedIntercept relTol 1e-6)
+  }
+}
@@ -0,0 +1,165 @@
+/*******************************************************************************
+ * Copyright 2020 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************/
+
+package org.apache.spark.ml.util
+
+import com.intel.daal.data_management.data.{NumericTable, Matrix => DALMatrix}
+import com.intel.daal.services.DaalContext
+
+import org.apache.spark.SparkFunSuite
+import org.apache.spark.ml.linalg.{Vector, Vectors}
+import org.apache.spark.unsafe.Platform
+
+class OneDALSuite extends SparkFunSuite {
+
+  // 64 MB of doubles, large enough for the copy to be split across threads
+  val numRows = 1 << 20
+  val numCols = 8
+
+  private def value(row: Int, col: Int): Double = row * numCols + col
+
+  private def newMatrix(context: DaalContext): DALMatrix = {
+    new DALMatrix(context, classOf[java.lang.Double], numCols.toLong, numRows.toLong,
+      NumericTable.AllocationFlag.DoAllocate)
+  }
+
+  private def checkTable(table: NumericTable): Unit = {
+    for (row <- Seq(0, 1, numRows / 2, numRows - 1); col <- 0 until numCols) {
+      assert(table.getDoubleValue(col, row) === value(row, col))
+    }
+  }
+
+  private def report(name: String, seconds: Double): Unit = {
+    val gigabytes = numRows.toDouble * numCols * 8 / (1L << 30)
+    logInfo(f"$name: $gigabytes%.3f GB in $seconds%.3f secs, ${gigabytes / seconds}%.3f GB/s")
+  }
+
+  private def time(f: => Unit): Double = {
+    val start = System.nanoTime()
+    f
+    (System.nanoTime() - start) / 1e9
+  }
+
+  override def beforeAll(): Unit = {
+    super.beforeAll()
+    // Build a DALMatrix first, this will load libJavaAPI, libtbb, libtbbmalloc
+    newMatrix(new DaalContext()).getCNumericTable
+    LibLoader.loadLibraries()
+  }
+
+  test("ingest row-major off-heap rows") {
+    val size = numRows.toLong * numCols * 8
+    val address = Platform.allocateMemory(size)
+    try {
+      for (row <- 0 until numRows; col <- 0 until numCols) {
+        Platform.putDouble(null, address + (row.toLong * numCols + col) * 8, value(row, col))
+      }
+      val matrix = newMatrix(new DaalContext())
+      report("cSetDoubleDirect", time {
+        OneDAL.cSetDoubleDirect(matrix.getCNumericTable, 0, address, numRows, numCols)
+      })
+      checkTable(matrix)
+
+      val wrapped = OneDAL.makeNumericTable(OneDAL.cWrapDoubleDirect(address, numRows, numCols))
+      checkTable(wrapped)
+    } finally {
+      Platform.freeMemory(address)
+    }
+  }
+
+  test("ingest off-heap columns") {
+    val columns = Array.tabulate(numCols) { col =>
+      val address = Platform.allocateMemory(numRows.toLong * 8)
+      for (row <- 0 until numRows) {
+        Platform.putDouble(null, address + row.toLong * 8, value(row, col))
+      }
+      address
+    }
+    try {
+      val matrix = newMatrix(new DaalContext())
+      report("cSetDoubleColumns", time {
+        OneDAL.cSetDoubleColumns(matrix.getCNumericTable, 0, columns, numRows)
+      })
+      checkTable(matrix)
+    } finally {
+      columns.foreach(Platform.freeMemory)
+    }
+  }
+
+  test("ingest data batches") {
+    val rows = Iterator.tabulate(numRows) { row =>
+      Array.tabulate(numCols)(col => value(row, col))
+    }
+    import scala.collection.JavaConverters._
+    val batches = new DataBatch.BatchIterator(rows.asJava, 4096)
+    val matrix = newMatrix(new DaalContext())
+    report("cSetDoubleIterator", time {
+      OneDAL.cSetDoubleIterator(matrix.getCNumericTable, batches, 0)
+    })
+    checkTable(matrix)
+  }
+
+  test("ingestion throughput from vectors") {
+    // Every path starts from the same Spark vectors, as rddLabeledVectorToNumericTables does
+    val vectors: Array[Vector] = Array.tabulate(numRows) { row =>
+      Vectors.dense(Array.tabulate(numCols)(col => value(row, col)))
+    }
+    val batchRows = OneDAL.INGESTION_BATCH_SIZE / numCols
+    val rounds = 3
+    def best(f: => Unit): Double = (1 to rounds).map(_ => time(f)).min
+
+    report("on-heap batches", best {
+      val matrix = newMatrix(new DaalContext())
+      val batch = new Array[Double](batchRows * numCols)
+      vectors.grouped(batchRows).zipWithIndex.foreach { case (rows, i) =>
+        rows.zipWithIndex.foreach { case (v, row) =>
+          v.foreachActive { (col, x) => batch(row * numCols + col) = x }
+        }
+        OneDAL.cSetDoubleBatch(matrix.getCNumericTable, i * batchRows, batch, rows.length,
+          numCols)
+      }
+      checkTable(matrix)
+    })
+
+    import scala.collection.JavaConverters._
+    report("cSetDoubleIterator", best {
+      val matrix = newMatrix(new DaalContext())
+      val batches = new DataBatch.BatchIterator(vectors.iterator.map(_.toArray).asJava, 4096)
+      OneDAL.cSetDoubleIterator(matrix.getCNumericTable, batches, 0)
+      checkTable(matrix)
+    })
+
+    report("off-heap cSetDoubleDirect", best {
+      val table = OneDAL.makeNumericTableFromRows(vectors.iterator, numRows, numCols, 0)
+      checkTable(OneDAL.makeNumericTable(table))
+    })
+
+    val size = numRows.toLong * numCols * 8
+    val address = Platform.allocateMemory(size)
+    try {
+      report("off-heap cWrapDoubleDirect", best {
+        vectors.iterator.zipWithIndex.foreach { case (v, row) =>
+          v.foreachActive { (col, x) =>
+            Platform.putDouble(null, address + (row.toLong * numCols + col) * 8, x)
+          }
+        }
+        checkTable(OneDAL.makeNumericTable(OneDAL.cWrapDoubleDirect(address, numRows, numCols)))
+      })
+    } finally {
+      Platform.freeMemory(address)
+    }
+  }
+}
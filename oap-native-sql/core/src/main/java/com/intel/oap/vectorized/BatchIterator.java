@@ -31,6 +31,8 @@ import org.apache.arrow.vector.ipc.message.MessageSerializer;
 
 public class BatchIterator {
   private native boolean nativeHasNext(long nativeHandler);
+  private native boolean nativeNeedsMoreInput(long nativeHandler);
+  private native long nativeNumRetainedInputs(long nativeHandler);
   private native ArrowRecordBatchBuilder nativeNext(long nativeHandler);
   private native ArrowRecordBatchBuilder nativeProcess(long nativeHandler, byte[] schemaBuf, int numRows, long[] bufAddrs, long[] bufSizes);
   private native void nativeProcessAndCacheOne(long nativeHandler, byte[] schemaBuf, int numRows, long[] bufAddrs, long[] bufSizes);
@@ -57,6 +59,22 @@ public class BatchIterator {
     return nativeHasNext(nativeHandler);
   }
 
+  /**
+   * Whether rows passed to process() are held back until more input is evaluated on
+   * the evaluator this iterator was finished from.
+   */
+  public boolean needsMoreInput() throws IOException {
+    return nativeNeedsMoreInput(nativeHandler);
+  }
+
+  /**
+   * Number of the most recently evaluated input batches whose buffers are still
+   * referenced natively. They must stay alive, older ones may be released.
+   */
+  public long numRetainedInputs() throws IOException {
+    return nativeNumRetainedInputs(nativeHandler);
+  }
+
   public ArrowRecordBatch next() throws IOException {
     if (nativeHandler == 0) {
       return null;
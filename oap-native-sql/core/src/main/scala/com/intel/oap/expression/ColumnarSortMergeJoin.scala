@@ -77,44 +77,32 @@ class ColumnarSortMergeJoin(
     extends Logging {
   ColumnarPluginConfig.getConf(sparkConf)
   var probe_iterator: BatchIterator = _
-  var build_cb: ColumnarBatch = null
-  var last_cb: ColumnarBatch = null
-
+  // build batches whose buffers the native prober still references, oldest first
   val inputBatchHolder = new ListBuffer[ColumnarBatch]()
 
+  /**
+   * Build batches are fed lazily: the native prober only buffers the current key group
+   * of the build side, and reports through probe_iterator.needsMoreInput that stream rows
+   * are waiting for more build input. An empty build batch marks the end of the build side.
+   * Build batches are referenced natively without a copy, so they are retained here until
+   * probe_iterator.numRetainedInputs shows they were released.
+   */
   def columnarJoin(
     streamIter: Iterator[ColumnarBatch],
     buildIter: Iterator[ColumnarBatch]): Iterator[ColumnarBatch] = {
 
-
-    val (realbuildIter, realstreamIter) = joinType match {
+    val (realbuildIter, realstreamIter, buildPlan, streamPlan) = joinType match {
       case LeftSemi =>
-        (streamIter, buildIter)
+        (streamIter, buildIter, right, left)
       case LeftOuter =>
-        (streamIter, buildIter)
+        (streamIter, buildIter, right, left)
       case LeftAnti =>
-        (streamIter, buildIter)
+        (streamIter, buildIter, right, left)
       case _ =>
-        (buildIter, streamIter)
+        (buildIter, streamIter, left, right)
     }
 
-    while (realbuildIter.hasNext) {
-      if (build_cb != null) {
-        build_cb = null
-      }
-      build_cb = realbuildIter.next()
-      val beforeBuild = System.nanoTime()
-      val build_rb = ConverterUtils.createArrowRecordBatch(build_cb)
-      (0 until build_cb.numCols).toList.foreach(i =>
-        build_cb.column(i).asInstanceOf[ArrowWritableColumnVector].retain())
-      inputBatchHolder += build_cb
-      prober.evaluate(build_rb)
-      prepareTime += NANOSECONDS.toMillis(System.nanoTime() - beforeBuild)
-      ConverterUtils.releaseArrowRecordBatch(build_rb)
-    }
-    if (build_cb != null) {
-      build_cb = null
-    } else {
+    if (!realbuildIter.hasNext) {
       val res = new Iterator[ColumnarBatch] {
         override def hasNext: Boolean = {
           false
@@ -133,36 +121,93 @@ class ColumnarSortMergeJoin(
     probe_iterator = prober.finishByIterator()
     prepareTime += NANOSECONDS.toMillis(System.nanoTime() - beforeBuild)
 
+    def emptyBatch(plan: SparkPlan): ColumnarBatch = {
+      val vectors =
+        ArrowWritableColumnVector.allocateColumns(0, StructType.fromAttributes(plan.output))
+      new ColumnarBatch(vectors.map(v => v.asInstanceOf[ColumnVector]).toArray, 0)
+    }
+
+    var buildFinished = false
+    def evaluateNextBuild(): Unit = {
+      // empty input batches are skipped, they would end the build side early
+      var build_cb: ColumnarBatch = null
+      while (build_cb == null && realbuildIter.hasNext) {
+        val cb = realbuildIter.next()
+        if (cb.numRows > 0) {
+          build_cb = cb
+        }
+      }
+      if (build_cb == null) {
+        buildFinished = true
+        build_cb = emptyBatch(buildPlan)
+      }
+      val beforeBuild = System.nanoTime()
+      val build_rb = ConverterUtils.createArrowRecordBatch(build_cb)
+      if (buildFinished) {
+        prober.evaluate(build_rb)
+        build_cb.close()
+      } else {
+        (0 until build_cb.numCols).toList.foreach(i =>
+          build_cb.column(i).asInstanceOf[ArrowWritableColumnVector].retain())
+        inputBatchHolder += build_cb
+        prober.evaluate(build_rb)
+      }
+      ConverterUtils.releaseArrowRecordBatch(build_rb)
+      prepareTime += NANOSECONDS.toMillis(System.nanoTime() - beforeBuild)
+    }
+
+    def releaseBuild(): Unit = {
+      val retained = probe_iterator.numRetainedInputs
+      while (inputBatchHolder.size > retained) {
+        inputBatchHolder.remove(0).close()
+      }
+    }
+
+    def probe(cb: ColumnarBatch): ColumnarBatch = {
+      val beforeJoin = System.nanoTime()
+      val stream_rb: ArrowRecordBatch = ConverterUtils.createArrowRecordBatch(cb)
+      val output_rb = probe_iterator.process(stream_input_arrow_schema, stream_rb)
+
+      ConverterUtils.releaseArrowRecordBatch(stream_rb)
+      releaseBuild()
+      joinTime += NANOSECONDS.toMillis(System.nanoTime() - beforeJoin)
+      if (output_rb == null) {
+        val resultColumnVectors =
+          ArrowWritableColumnVector.allocateColumns(0, resultSchema).toArray
+        new ColumnarBatch(resultColumnVectors.map(v => v.asInstanceOf[ColumnVector]).toArray, 0)
+      } else {
+        val outputNumRows = output_rb.getLength
+        val output = ConverterUtils.fromArrowRecordBatch(output_arrow_schema, output_rb)
+        ConverterUtils.releaseArrowRecordBatch(output_rb)
+        totalOutputNumRows += outputNumRows
+        new ColumnarBatch(output.map(v => v.asInstanceOf[ColumnVector]).toArray, outputNumRows)
+      }
+    }
+
     new Iterator[ColumnarBatch] {
+      val pending = new ListBuffer[ColumnarBatch]()
+
       override def hasNext: Boolean = {
-        if (realstreamIter.hasNext) {
-          true
-        } else {
-          inputBatchHolder.foreach(cb => cb.close())
-          false
-        }
+        pending.nonEmpty || realstreamIter.hasNext
       }
 
       override def next(): ColumnarBatch = {
-        val cb = realstreamIter.next()
-        last_cb = cb
-        val beforeJoin = System.nanoTime()
-        val stream_rb: ArrowRecordBatch = ConverterUtils.createArrowRecordBatch(cb)
-        val output_rb = probe_iterator.process(stream_input_arrow_schema, stream_rb)
-
-        ConverterUtils.releaseArrowRecordBatch(stream_rb)
-        joinTime += NANOSECONDS.toMillis(System.nanoTime() - beforeJoin)
-        if (output_rb == null) {
-          val resultColumnVectors =
-            ArrowWritableColumnVector.allocateColumns(0, resultSchema).toArray
-          new ColumnarBatch(resultColumnVectors.map(v => v.asInstanceOf[ColumnVector]).toArray, 0)
-        } else {
-          val outputNumRows = output_rb.getLength
-          val output = ConverterUtils.fromArrowRecordBatch(output_arrow_schema, output_rb)
-          ConverterUtils.releaseArrowRecordBatch(output_rb)
-          totalOutputNumRows += outputNumRows
-          new ColumnarBatch(output.map(v => v.asInstanceOf[ColumnVector]).toArray, outputNumRows)
+        if (pending.isEmpty) {
+          pending += probe(realstreamIter.next())
+          // feed build batches until every stream row has seen its whole key group
+          while (!buildFinished && probe_iterator.needsMoreInput) {
+            evaluateNextBuild()
+            val empty_cb = emptyBatch(streamPlan)
+            val output = probe(empty_cb)
+            empty_cb.close()
+            if (output.numRows > 0) {
+              pending += output
+            } else {
+              output.close()
+            }
+          }
         }
+        pending.remove(0)
       }
     }
   }
@@ -175,6 +220,8 @@ class ColumnarSortMergeJoin(
       probe_iterator.close()
       probe_iterator = null
     }
+    inputBatchHolder.foreach(cb => cb.close())
+    inputBatchHolder.clear()
     totaltime_sortmergejoin.merge(prepareTime)
     totaltime_sortmergejoin.merge(joinTime)
   }
@@ -172,7 +172,7 @@ class ActionCodeGen {
     }
     ss << "std::vector<" << GetCTypeString(type) << "> " << cache_name << ";"
        << std::endl;
-    ss << "std::shared_ptr<" << GetTypeString(type, "Builder") << "> " << builder_name
+    ss << "std::shared_ptr<" << GetBatchBuilderTypeString(type) << "> " << builder_name
        << ";" << std::endl;
     return ss.str();
   }
@@ -191,7 +191,7 @@ class ActionCodeGen {
     }
     auto builder_name_tmp = name + "_builder";
     auto builder_name = name + "_builder_";
-    ss << builder_name << " = std::make_shared<" << GetTypeString(type, "Builder")
+    ss << builder_name << " = std::make_shared<" << GetBatchBuilderTypeString(type)
        << ">(ctx_->memory_pool());" << std::endl;
     return ss.str();
   }
@@ -201,18 +201,12 @@ class ActionCodeGen {
     std::stringstream ss;
     auto cache_name = name + "_vector_";
     auto builder_name = name + "_builder_";
+    // the whole [offset_, offset_ + length) slice goes in at once
+    ss << "RETURN_NOT_OK(" << builder_name << "->AppendValues(" << cache_name << ", ";
     if (validity) {
-      auto validity_name = name + "validity__vector_";
-      ss << "if (" << validity_name << "[offset_ + count]) {" << std::endl;
-      ss << "RETURN_NOT_OK(" << builder_name << "->Append(" << cache_name
-         << "[offset_ + count]));" << std::endl;
-      ss << "} else {" << std::endl;
-      ss << "RETURN_NOT_OK(" << builder_name << "->AppendNull());" << std::endl;
-      ss << "}" << std::endl;
-    } else {
-      ss << "RETURN_NOT_OK(" << builder_name << "->Append(" << cache_name
-         << "[offset_ + count]));" << std::endl;
+      ss << name << "validity__vector_, ";
     }
+    ss << "offset_, length));" << std::endl;
     return ss.str();
   }
 
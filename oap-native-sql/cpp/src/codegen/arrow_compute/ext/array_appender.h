@@ -50,6 +50,11 @@ class AppenderBase {
     return arrow::Status::NotImplemented("AppenderBase AppendNull is abstract.");
   }
 
+  // Size the builder for the rows one probe batch is expected to produce
+  virtual arrow::Status Reserve(int64_t length) {
+    return arrow::Status::NotImplemented("AppenderBase Reserve is abstract.");
+  }
+
   virtual arrow::Status Finish(std::shared_ptr<arrow::Array>* out_) {
     return arrow::Status::NotImplemented("AppenderBase Finish is abstract.");
   }
@@ -104,6 +109,8 @@ class ArrayAppender<DataType, enable_if_not_boolean<DataType>> : public Appender
 
   arrow::Status AppendNull() override { return builder_->AppendNull(); }
 
+  arrow::Status Reserve(int64_t length) override { return builder_->Reserve(length); }
+
   arrow::Status Finish(std::shared_ptr<arrow::Array>* out_) override {
     return builder_->Finish(out_);
   }
@@ -157,6 +164,8 @@ class ArrayAppender<DataType, arrow::enable_if_boolean<DataType>> : public Appen
 
   arrow::Status AppendNull() override { return builder_->AppendNull(); }
 
+  arrow::Status Reserve(int64_t length) override { return builder_->Reserve(length); }
+
   arrow::Status AppendExistence(bool is_exist) { return builder_->Append(is_exist); }
 
   arrow::Status Finish(std::shared_ptr<arrow::Array>* out_) override {
@@ -17,6 +17,7 @@
 
 #include "codegen/arrow_compute/ext/codegen_common.h"
 
+#include <dirent.h>
 #include <dlfcn.h>
 #include <fcntl.h>
 #include <sys/file.h>
@@ -24,6 +25,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <iostream>
@@ -37,7 +39,10 @@ namespace arrowcompute {
 namespace extra {
 
 std::string BaseCodes() {
+  // pch.h has to stay the first include for its precompiled form to be used
   return R"(
+#include "precompile/pch.h"
+
 #include <arrow/compute/context.h>
 #include <arrow/record_batch.h>
 
@@ -158,6 +163,17 @@ std::string GetTypeString(std::shared_ptr<arrow::DataType> type, std::string tai
       throw;
   }
 }
+// Builder type for generated code: the header-only TypedBuilder, except for
+// decimal whose builder needs the parameterized type at construction
+std::string GetBuilderTypeString(std::shared_ptr<arrow::DataType> type) {
+  if (type->id() == arrow::Type::DECIMAL) {
+    return GetTypeString(type, "Builder");
+  }
+  return GetTemplateString(type, "TypedBuilder", "Type", "arrow::");
+}
+std::string GetBatchBuilderTypeString(std::shared_ptr<arrow::DataType> type) {
+  return GetTemplateString(type, "BatchBuilder", "Type", "arrow::");
+}
 std::string GetTemplateString(std::shared_ptr<arrow::DataType> type,
                               std::string template_name, std::string tail,
                               std::string prefix) {
@@ -474,6 +490,72 @@ void FileSpinUnLock(int fd) {
   close(fd);
 }
 
+// Newest modification time of the files below dir, 0 when there are none.
+time_t GetNewestModifyTime(const std::string& dir) {
+  time_t newest = 0;
+  DIR* d = opendir(dir.c_str());
+  if (d == nullptr) {
+    return newest;
+  }
+  struct dirent* entry;
+  while ((entry = readdir(d)) != nullptr) {
+    std::string name = entry->d_name;
+    if (name == "." || name == "..") continue;
+    std::string path = dir + "/" + name;
+    struct stat path_stat;
+    if (stat(path.c_str(), &path_stat) != 0) continue;
+    newest = std::max(newest, S_ISDIR(path_stat.st_mode) ? GetNewestModifyTime(path)
+                                                         : path_stat.st_mtime);
+  }
+  closedir(d);
+  return newest;
+}
+
+// Precompile precompile/pch.h with the same flags as the generated code, and
+// return the include flag that makes gcc pick it up. The header is rebuilt
+// when any file of the extracted include dir is newer, since pch.h pulls in
+// the precompile and third_party headers, and a failed build just falls back
+// to parsing the plain header.
+std::string GetPrecompiledHeaderFlags(const std::string& env_gcc,
+                                      const std::string& flags) {
+  std::string include_dir;
+  for (auto dir : {"/nativesql_include", "/include"}) {
+    struct stat source_stat;
+    auto path = GetTempPath() + dir;
+    if (stat((path + "/precompile/pch.h").c_str(), &source_stat) == 0) {
+      include_dir = path;
+      break;
+    }
+  }
+  if (include_dir.empty()) {
+    return "";
+  }
+  std::string source = include_dir + "/precompile/pch.h";
+  std::string pch_dir = GetTempPath() + "/pch";
+  std::string pch_file = pch_dir + "/precompile/pch.h.gch";
+  std::string pch_flags = " -I" + pch_dir + "/ ";
+  struct stat pch_stat;
+  if (stat(pch_file.c_str(), &pch_stat) == 0 &&
+      pch_stat.st_mtime >= GetNewestModifyTime(include_dir)) {
+    return pch_flags;
+  }
+  mkdir(pch_dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+  mkdir((pch_dir + "/precompile").c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+  std::string cmd = env_gcc + flags + " -x c++-header " + source + " -o " + pch_file +
+                    ".tmp 2> " + pch_file + ".log && mv " + pch_file + ".tmp " +
+                    pch_file + " && cp " + source + " " + pch_dir + "/precompile/";
+#ifdef DEBUG
+  std::cout << cmd << std::endl;
+#endif
+  int ret = system(cmd.c_str());
+  if (WEXITSTATUS(ret) != EXIT_SUCCESS) {
+    std::cout << "precompiling " << source << " failed, see " << pch_file << ".log"
+              << std::endl;
+    return "";
+  }
+  return pch_flags;
+}
+
 arrow::Status CompileCodes(std::string codes, std::string signature) {
   // temporary cpp/library output files
   srand(time(NULL));
@@ -518,11 +600,14 @@ arrow::Status CompileCodes(std::string codes, std::string signature) {
     // incase there's a different location for libarrow.so
     arrow_lib2 = " -L" + std::string(env_arrow_dir) + "/lib ";
   }
+  // the precompiled header is only valid for identical compile flags
+  std::string flags = " -std=c++14 -Wno-deprecated-declarations " + arrow_header +
+                      nativesql_header + nativesql_header_2 + " -O3 -march=native -fPIC ";
+  std::string pch_flags = GetPrecompiledHeaderFlags(env_gcc, flags);
   // compile the code
-  std::string cmd = env_gcc + " -std=c++14 -Wno-deprecated-declarations " + arrow_header +
-                    arrow_lib + arrow_lib2 + nativesql_header + nativesql_header_2 +
-                    nativesql_lib + cppfile + " -o " + libfile +
-                    " -O3 -march=native -shared -fPIC -lspark_columnar_jni 2> " + logfile;
+  std::string cmd = env_gcc + pch_flags + flags + arrow_lib + arrow_lib2 + nativesql_lib +
+                    cppfile + " -o " + libfile + " -shared -lspark_columnar_jni 2> " +
+                    logfile;
 #ifdef DEBUG
   std::cout << cmd << std::endl;
 #endif
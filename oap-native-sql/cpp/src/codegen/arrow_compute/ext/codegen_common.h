@@ -44,6 +44,8 @@ std::string GetArrowTypeDefString(std::shared_ptr<arrow::DataType> type);
 std::string GetCTypeString(std::shared_ptr<arrow::DataType> type);
 std::string GetTypeString(std::shared_ptr<arrow::DataType> type,
                           std::string tail = "Type");
+std::string GetBuilderTypeString(std::shared_ptr<arrow::DataType> type);
+std::string GetBatchBuilderTypeString(std::shared_ptr<arrow::DataType> type);
 std::string GetTemplateString(std::shared_ptr<arrow::DataType> type,
                               std::string template_name, std::string tail = "",
                               std::string prefix = "");
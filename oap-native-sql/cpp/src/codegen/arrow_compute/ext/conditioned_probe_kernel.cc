@@ -450,6 +450,9 @@ class ConditionedProbeKernel::Impl {
       // put in to ArrayAppender then doing evaluate
       for (int tmp_idx = 0; tmp_idx < appender_list_.size(); tmp_idx++) {
         auto appender = appender_list_[tmp_idx];
+        // one output row per probe row covers semi, anti, existence and unique
+        // key joins in a single allocation; duplicate keys grow from there
+        RETURN_NOT_OK(appender->Reserve(key_array->length()));
         if (appender->GetType() == AppenderBase::right) {
           auto idx_exclude_exist =
               (exist_index_ == -1 || tmp_idx < exist_index_) ? tmp_idx : (tmp_idx - 1);
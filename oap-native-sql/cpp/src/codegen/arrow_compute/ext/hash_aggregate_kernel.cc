@@ -305,8 +305,8 @@ class HashAggregateKernel::Impl {
     if (!multiple_cols) {
       auto key_type = key_list_[0].first->return_type();
       if (key_type->id() == arrow::Type::STRING) {
-        hash_map_type_str = GetTypeString(arrow::utf8(), "") + "HashMap";
-        hash_map_include_str = R"(#include "precompile/hash_map.h")";
+        hash_map_type_str = "TypedHashMap<arrow::StringType>";
+        hash_map_include_str = R"(#include "precompile/typed_hash_map.h")";
       } else {
         hash_map_type_str = "SparseHashMap<" + GetCTypeString(key_type) + ">";
       }
@@ -315,11 +315,7 @@ class HashAggregateKernel::Impl {
       evaluate_get_typed_key_array_str = "auto typed_array = std::make_shared<" +
                                          GetTypeString(key_type, "Array") + ">(" +
                                          key_list_[0].second + ");\n";
-      if (key_type->id() != arrow::Type::STRING) {
-        evaluate_get_typed_key_method_str = "GetView";
-      } else {
-        evaluate_get_typed_key_method_str = "GetString";
-      }
+      evaluate_get_typed_key_method_str = "GetView";
     } else {
       evaluate_get_typed_key_array_str =
           "auto typed_array = "
@@ -330,6 +326,8 @@ class HashAggregateKernel::Impl {
     return BaseCodes() + R"(
 #include <math.h>
 #include <limits>
+#include "precompile/batch_builder.h"
+#include "precompile/bitmap.h"
 #include "precompile/builder.h"
 )" + hash_map_include_str +
            R"(  
@@ -372,26 +370,33 @@ class TypedGroupbyHashAggregateImpl : public CodeGenBase {
         }
       }
     } else {
-      for (; cur_id_ < typed_array->length(); cur_id_++) {
-        if (typed_array->IsNull(cur_id_)) {
-          memo_index = hash_table_->GetOrInsertNull([](int32_t){}, [](int32_t){});
-          if (memo_index < num_groups_) {
-            insert_on_found(memo_index);
-          } else {
-            insert_on_not_found(memo_index);
-          }
-        } else {
-          hash_table_->GetOrInsert(typed_array->)" +
+      // key validity is read 64 rows at a time, words without nulls insert
+      // their keys without testing each row's bit
+      RETURN_NOT_OK(VisitValidity(
+          typed_array->null_bitmap_data(), typed_array->offset(), typed_array->length(),
+          [&](int64_t i) {
+            cur_id_ = i;
+            hash_table_->GetOrInsert(typed_array->)" +
            evaluate_get_typed_key_method_str + R"((cur_id_),
-                                   [](int32_t){}, [](int32_t){},
-                                   &memo_index);
-        if (memo_index < num_groups_) {
-          insert_on_found(memo_index);
-        } else {
-          insert_on_not_found(memo_index);
-        }
-        }
-      }
+                                     [](int32_t){}, [](int32_t){},
+                                     &memo_index);
+            if (memo_index < num_groups_) {
+              insert_on_found(memo_index);
+            } else {
+              insert_on_not_found(memo_index);
+            }
+            return arrow::Status::OK();
+          },
+          [&](int64_t i) {
+            cur_id_ = i;
+            memo_index = hash_table_->GetOrInsertNull([](int32_t){}, [](int32_t){});
+            if (memo_index < num_groups_) {
+              insert_on_found(memo_index);
+            } else {
+              insert_on_not_found(memo_index);
+            }
+            return arrow::Status::OK();
+          }));
     }
     return arrow::Status::OK();
   }
@@ -443,12 +448,8 @@ class TypedGroupbyHashAggregateImpl : public CodeGenBase {
       auto length = (total_length_ - offset_) > )" +
            std::to_string(GetBatchSize()) + R"( ? )" + std::to_string(GetBatchSize()) +
            R"( : (total_length_ - offset_);
-      uint64_t count = 0;
-      while (count < length) {
-        )" +
-           result_cached_to_builder_str + R"(
-        count ++;
-      }
+      )" + result_cached_to_builder_str +
+           R"(
       offset_ += length;
       )" + result_cached_to_array_str +
            R"(
@@ -53,6 +53,7 @@
 #include "codegen/arrow_compute/ext/array_item_index.h"
 #include "codegen/arrow_compute/ext/codegen_common.h"
 //#include "codegen/arrow_compute/ext/codegen_node_visitor.h"
+#include "precompile/bitmap.h"
 #include "third_party/arrow/utils/hashing.h"
 #include "utils/macros.h"
 
@@ -128,13 +129,11 @@ class SplitArrayListWithActionKernel::Impl {
     // inside array, max will output incorrect result, change to handmade function for now
     int32_t max_group_id = 0;
     auto typed_in_dict = std::dynamic_pointer_cast<arrow::Int32Array>(in_dict);
-    for (int i = 0; i < typed_in_dict->length(); i++) {
-      if (typed_in_dict->IsValid(i)) {
-        if (typed_in_dict->GetView(i) > max_group_id) {
-          max_group_id = typed_in_dict->GetView(i);
-        }
-      }
-    }
+    auto group_ids = typed_in_dict->raw_values();
+    precompile::VisitSetBits(in_dict->null_bitmap_data(), in_dict->offset(),
+                             in_dict->length(), [&](int64_t i) {
+                               max_group_id = std::max(max_group_id, group_ids[i]);
+                             });
 
     std::vector<std::function<arrow::Status(int)>> eval_func_list;
     std::vector<std::function<arrow::Status()>> eval_null_func_list;
@@ -153,19 +152,22 @@ class SplitArrayListWithActionKernel::Impl {
       eval_null_func_list.push_back(null_func);
     }
 
-    for (int row_id = 0; row_id < in_dict->length(); row_id++) {
-      if (in_dict->IsValid(row_id)) {
-        auto group_id = typed_in_dict->GetView(row_id);
-        for (auto eval_func : eval_func_list) {
-          eval_func(group_id);
-        }
-      } else {
-        for (auto eval_func : eval_null_func_list) {
-          eval_func();
-        }
-      }
-    }
-    return arrow::Status::OK();
+    // group id validity is read 64 rows at a time, so a word of valid (or
+    // null) group ids dispatches without testing each row's bit
+    return precompile::VisitValidity(
+        in_dict->null_bitmap_data(), in_dict->offset(), in_dict->length(),
+        [&](int64_t row_id) {
+          for (auto& eval_func : eval_func_list) {
+            eval_func(group_ids[row_id]);
+          }
+          return arrow::Status::OK();
+        },
+        [&](int64_t row_id) {
+          for (auto& eval_func : eval_null_func_list) {
+            eval_func();
+          }
+          return arrow::Status::OK();
+        });
   }
 
   arrow::Status Finish(ArrayList* out) {
@@ -221,30 +221,54 @@ class ConditionedJoinArraysKernel::Impl {
 
   class TypedProberCodeGenImpl {
    public:
-    TypedProberCodeGenImpl(std::string indice, std::shared_ptr<arrow::DataType> data_type,
-                           bool left = true)
-        : indice_(indice), data_type_(data_type), left_(left) {}
-    std::string GetImplCachedDefine() {
+    TypedProberCodeGenImpl(std::string indice, int index,
+                           std::shared_ptr<arrow::DataType> data_type, bool left = true)
+        : indice_(indice), index_(index), data_type_(data_type), left_(left) {}
+    std::string GetAppendLeftCache() {
       std::stringstream ss;
-      ss << "using ArrayType_" << indice_ << " = " << GetTypeString(data_type_, "Array")
-         << ";" << std::endl;
-      ss << "std::vector<std::shared_ptr<ArrayType_" << indice_ << ">> cached_" << indice_
-         << "_;" << std::endl;
+      ss << "cached_" << indice_ << "_.push_back(std::make_shared<ArrayType_" << indice_
+         << ">(in[" << index_ << "]));" << std::endl;
+      return ss.str();
+    }
+    std::string GetSpillLeftCache() {
+      std::stringstream ss;
+      ss << "cached_" << indice_ << "_[b] = std::make_shared<ArrayType_" << indice_
+         << ">(in[" << index_ << "]);" << std::endl;
       return ss.str();
     }
-    std::string GetResultIteratorPrepare() {
+    std::string GetReleaseLeftCache() {
       std::stringstream ss;
-      ss << "builder_" << indice_ << "_ = std::make_shared<"
-         << GetTypeString(data_type_, "Builder") << ">(ctx_->memory_pool());"
-         << std::endl;
+      ss << "cached_" << indice_ << "_.pop_front();" << std::endl;
       return ss.str();
     }
-    std::string GetProcessFinish() {
+    std::string GetProcessRightSet() {
+      std::stringstream ss;
+      ss << "cached_" << indice_ << "_ = std::make_shared<ArrayType_" << indice_ << ">(in["
+         << index_ << "]);" << std::endl;
+      return ss.str();
+    }
+    std::string GetGatherFinish() {
       std::stringstream ss;
       ss << "std::shared_ptr<arrow::Array> out_" << indice_ << ";" << std::endl;
-      ss << "RETURN_NOT_OK(builder_" << indice_ << "_->Finish(&out_" << indice_ << "));"
-         << std::endl;
-      ss << "builder_" << indice_ << "_->Reset();" << std::endl;
+      if (index_ < 0) {
+        ss << "arrow::BooleanBuilder builder_" << indice_ << "(ctx_->memory_pool());"
+           << std::endl;
+        ss << "RETURN_NOT_OK(builder_" << indice_ << ".AppendValues(exists_));"
+           << std::endl;
+        ss << "RETURN_NOT_OK(builder_" << indice_ << ".Finish(&out_" << indice_ << "));"
+           << std::endl;
+      } else {
+        // left rows come from the buffered batches, right rows from the chunks
+        ss << "arrow::ArrayVector arrays_" << indice_ << ";" << std::endl;
+        ss << "for (auto& batch : " << (left_ ? "left_batches_" : "chunks") << ") {"
+           << std::endl;
+        ss << "  arrays_" << indice_ << ".push_back(batch[" << index_ << "]);"
+           << std::endl;
+        ss << "}" << std::endl;
+        ss << "RETURN_NOT_OK(GatherArrays(ctx_->memory_pool(), arrays_" << indice_ << ", "
+           << (left_ ? "build_indices_" : "probe_indices_") << ", &out_" << indice_
+           << "));" << std::endl;
+      }
       return ss.str();
     }
     std::string GetProcessOutList() {
@@ -254,138 +278,30 @@ class ConditionedJoinArraysKernel::Impl {
     }
     std::string GetResultIterCachedDefine() {
       std::stringstream ss;
+      ss << "using ArrayType_" << indice_ << " = " << GetTypeString(data_type_, "Array")
+         << ";" << std::endl;
       if (left_) {
-        ss << "std::vector<std::shared_ptr<" << GetTypeString(data_type_, "Array")
-           << ">> cached_" << indice_ << "_;" << std::endl;
-      } else {
-        ss << "std::shared_ptr<" << GetTypeString(data_type_, "Array") << "> cached_"
+        ss << "std::deque<std::shared_ptr<ArrayType_" << indice_ << ">> cached_"
            << indice_ << "_;" << std::endl;
+      } else {
+        ss << "std::shared_ptr<ArrayType_" << indice_ << "> cached_" << indice_ << "_;"
+           << std::endl;
       }
-      ss << "using ArrayType_" << indice_ << " = " << GetTypeString(data_type_, "Array")
-         << ";" << std::endl;
-      ss << "std::shared_ptr<" << GetTypeString(data_type_, "Builder") << "> builder_"
-         << indice_ << "_;" << std::endl;
       return ss.str();
     }
 
    private:
     std::string indice_;
+    int index_;
     std::shared_ptr<arrow::DataType> data_type_;
     bool left_;
   };
-  std::string GetJoinKeyFieldListDefine(
-      const std::vector<int>& left_key_index_list,
-      const std::vector<std::shared_ptr<arrow::Field>>& field_list) {
-    std::stringstream ss;
-    for (int i = 0; i < left_key_index_list.size(); i++) {
-      auto field = field_list[left_key_index_list[i]];
-      if (i != (left_key_index_list.size() - 1)) {
-        ss << "arrow::field(\"" << field->name()
-           << "\", arrow::" << GetArrowTypeDefString(field->type()) << "), ";
-      } else {
-        ss << "arrow::field(\"" << field->name()
-           << "\", arrow::" << GetArrowTypeDefString(field->type()) << ")";
-      }
-    }
-    return ss.str();
-  }
-  std::string GetEvaluateCacheInsert(const std::vector<int>& index_list) {
-    std::stringstream ss;
-    for (auto i : index_list) {
-      ss << "cached_0_" << i << "_.push_back(std::make_shared<ArrayType_0_" << i
-         << ">(in[" << i << "]));" << std::endl;
-    }
-    return ss.str();
-  }
-  std::string GetEncodeJoinKey(std::vector<int> key_indices) {
-    std::stringstream ss;
-    for (int i = 0; i < key_indices.size(); i++) {
-      if (i != (key_indices.size() - 1)) {
-        ss << "in[" << key_indices[i] << "], ";
-      } else {
-        ss << "in[" << key_indices[i] << "]";
-      }
-    }
-    return ss.str();
-  }
-  std::string GetFinishCachedParameter(const std::vector<int>& key_indices) {
-    std::stringstream ss;
-    for (int i = 0; i < key_indices.size(); i++) {
-      if (i != (key_indices.size() - 1)) {
-        ss << "cached_0_" << key_indices[i] << "_, ";
-      } else {
-        ss << "cached_0_" << key_indices[i] << "_";
-      }
-    }
-    auto ret = ss.str();
-    if (ret.empty()) {
-      return ret;
-    } else {
-      return ", " + ret;
-    }
-  }
-  std::string GetImplCachedDefine(
-      std::vector<std::shared_ptr<TypedProberCodeGenImpl>> codegen_list) {
+  template <typename GetCodes>
+  std::string GetCodesOfList(std::vector<std::shared_ptr<TypedProberCodeGenImpl>> codegen_list,
+                             GetCodes get_codes) {
     std::stringstream ss;
     for (auto codegen : codegen_list) {
-      ss << codegen->GetImplCachedDefine() << std::endl;
-    }
-    return ss.str();
-  }
-  std::string GetResultIteratorParams(std::vector<int> key_indices) {
-    std::stringstream ss;
-    for (int i = 0; i < key_indices.size(); i++) {
-      if (i != (key_indices.size() - 1)) {
-        ss << "const std::vector<std::shared_ptr<ArrayType_0_" << key_indices[i]
-           << ">> &cached_0_" << key_indices[i] << ", " << std::endl;
-      } else {
-        ss << "const std::vector<std::shared_ptr<ArrayType_0_" << key_indices[i]
-           << ">> &cached_0_" << key_indices[i];
-      }
-    }
-    auto ret = ss.str();
-    if (ret.empty()) {
-      return ret;
-    } else {
-      return ", " + ret;
-    }
-  }
-  std::string GetResultIteratorSet(std::vector<int> key_indices) {
-    std::stringstream ss;
-    for (auto i : key_indices) {
-      ss << "cached_0_" << i << "_ = cached_0_" << i << ";" << std::endl;
-    }
-    return ss.str();
-  }
-  std::string GetResultIteratorPrepare(
-      std::vector<std::shared_ptr<TypedProberCodeGenImpl>> left_codegen_list,
-      std::vector<std::shared_ptr<TypedProberCodeGenImpl>> right_codegen_list) {
-    std::stringstream ss;
-    for (auto codegen : left_codegen_list) {
-      ss << codegen->GetResultIteratorPrepare() << std::endl;
-    }
-    for (auto codegen : right_codegen_list) {
-      ss << codegen->GetResultIteratorPrepare() << std::endl;
-    }
-    return ss.str();
-  }
-  std::string GetProcessRightSet(std::vector<int> indices) {
-    std::stringstream ss;
-    for (auto i : indices) {
-      ss << "cached_1_" << i << "_ = std::make_shared<ArrayType_1_" << i << ">(in[" << i
-         << "]);" << std::endl;
-    }
-    return ss.str();
-  }
-  std::string GetProcessFinish(
-      std::vector<std::shared_ptr<TypedProberCodeGenImpl>> left_codegen_list,
-      std::vector<std::shared_ptr<TypedProberCodeGenImpl>> right_codegen_list) {
-    std::stringstream ss;
-    for (auto codegen : left_codegen_list) {
-      ss << codegen->GetProcessFinish() << std::endl;
-    }
-    for (auto codegen : right_codegen_list) {
-      ss << codegen->GetProcessFinish() << std::endl;
+      ss << get_codes(codegen);
     }
     return ss.str();
   }
@@ -411,351 +327,125 @@ class ConditionedJoinArraysKernel::Impl {
     }
     return ss.str();
   }
-  std::string GetResultIterCachedDefine(
-      std::vector<std::shared_ptr<TypedProberCodeGenImpl>> left_codegen_list,
-      std::vector<std::shared_ptr<TypedProberCodeGenImpl>> right_codegen_list) {
+  // list_item holds the typed key arrays of one batch, one per key column
+  std::string GetListItemDefine(const std::vector<int>& left_key_index_list,
+                                const std::vector<std::shared_ptr<arrow::Field>>& field_list) {
     std::stringstream ss;
-    for (auto codegen : left_codegen_list) {
-      ss << codegen->GetResultIterCachedDefine() << std::endl;
-    }
-    for (auto codegen : right_codegen_list) {
-      ss << codegen->GetResultIterCachedDefine() << std::endl;
-    }
-    return ss.str();
-  }
-  std::string GetInnerJoin(bool cond_check,
-                           const std::vector<int>& left_shuffle_index_list,
-                           const std::vector<int>& right_shuffle_index_list,
-                           const std::vector<int>& right_key_index_list) {
-    std::stringstream ss;
-    for (auto i : left_shuffle_index_list) {
-      ss << "RETURN_NOT_OK(builder_0_" << i << "_->Append(cached_0_" << i
-         << "_[tmp.array_id]->GetView(tmp."
-            "id)));"
-         << std::endl;
-    }
-    for (auto i : right_shuffle_index_list) {
-      ss << "RETURN_NOT_OK(builder_1_" << i << "_->Append(cached_1_" << i
-         << "_->GetView(i)));" << std::endl;
-    }
-    std::string shuffle_str;
-    if (cond_check) {
-      shuffle_str = R"(
-              if (ConditionCheck(tmp, i)) {
-                )" + ss.str() +
-                    R"(
-                out_length += 1;
-              }
-              left_it->next();
-            }
-            left_it->setpos(cur_idx, seg_len, pl);
-      )";
-    } else {
-      shuffle_str = R"(
-              )" + ss.str() +
-                    R"(
-              left_it->next();
-              out_length += 1;}
-              left_it->setpos(cur_idx, seg_len, pl);
-      )";
-    }
-    std::string right_value;
-    if (right_key_index_list.size() > 1) {
-      // TODO: fix key size
-      right_value = "item_content{typed_array_0->GetView(i), typed_array_1->GetView(i)}";
-    } else {
-      right_value = "typed_array_0->GetView(i)";
-    }
-    return R"(
-      auto right_content =)" +
-           right_value + R"(;
-        if (!typed_array_0->IsNull(i)) {
-            while (left_it->value() < right_content && left_it->hasnext()) {
-            left_it->next();
-            }
-            int64_t cur_idx, seg_len, pl; left_it->getpos(&cur_idx, &seg_len, &pl);
-            while(left_it->value() == right_content && left_it->hasnext()) {
-              auto tmp = GetArrayItemIdex(left_it);)" +
-           shuffle_str + R"(
-              //if (left_it->value() > right_content && left_it->hasnext()){
-              //continue;
-              //}
-          }
-  )";
-  }
-  std::string GetOuterJoin(bool cond_check,
-                           const std::vector<int>& left_shuffle_index_list,
-                           const std::vector<int>& right_shuffle_index_list) {
-    std::stringstream left_null_ss;
-    std::stringstream left_valid_ss;
-    std::stringstream right_valid_ss;
-    for (auto i : left_shuffle_index_list) {
-      left_valid_ss << "RETURN_NOT_OK(builder_0_" << i << "_->Append(cached_0_" << i
-                    << "_[tmp.array_id]->GetView(tmp."
-                       "id)));"
-                    << std::endl;
-      left_null_ss << "RETURN_NOT_OK(builder_0_" << i << "_->AppendNull());" << std::endl;
-    }
-    for (auto i : right_shuffle_index_list) {
-      right_valid_ss << "RETURN_NOT_OK(builder_1_" << i << "_->Append(cached_1_" << i
-                     << "_->GetView(i)));" << std::endl;
-    }
-    std::string shuffle_str;
-    if (cond_check) {
-      shuffle_str = R"(
-              if (ConditionCheck(tmp, i)) {
-                )" + left_valid_ss.str() +
-                    right_valid_ss.str() + R"(
-                out_length += 1;
-              }
-      )";
-    } else {
-      shuffle_str = R"(
-              )" + left_valid_ss.str() +
-                    right_valid_ss.str() + R"(
-              out_length += 1;
-      )";
-    }
-    return R"(
-      if (!typed_array_0->IsNull(i)) {
-         while (left_it->value() < typed_array_0->GetView(i) && left_it->hasnext()) {
-    left_it->next();
-  }
-  int64_t cur_idx, seg_len, pl; left_it->getpos(&cur_idx, &seg_len, &pl);
-  while(left_it->value() == typed_array_0->GetView(i) && left_it->hasnext()) {
-    auto tmp = GetArrayItemIdex(left_it);
-          )" +  // TODO: cond check
-           left_valid_ss.str() +
-           right_valid_ss.str() + R"(
-          left_it->next();
-          last_match_idx = i;
-          out_length += 1;
-        }
-        left_it->setpos(cur_idx, seg_len, pl);
-        if(left_it->value() > typed_array_0->GetView(i) && left_it->hasnext() ) {
-          if (last_match_idx == i) {
-            continue;
-          }
-          auto tmp = GetArrayItemIdex(left_it);
-            )" +
-           left_null_ss.str() + right_valid_ss.str() + R"(
-             out_length += 1;
-          }
-          if (!left_it->hasnext()) {
-            )" +
-           left_null_ss.str() + right_valid_ss.str() + R"(
-            out_length += 1;
-          }
-
-        } else {
-          int64_t cur_idx, seg_len, pl; left_it->getpos(&cur_idx, &seg_len, &pl);
-          while(left_it->value() == typed_array_0->GetView(i) && left_it->hasnext()) {
-            auto tmp = GetArrayItemIdex(left_it);
-            )" +
-           left_valid_ss.str() + right_valid_ss.str() + R"(
-            left_it->next();
-            out_length += 1;
-            }
-          left_it->setpos(cur_idx, seg_len, pl);
-        }
-  )";
-  }
-  std::string GetAntiJoin(bool cond_check,
-                          const std::vector<int>& left_shuffle_index_list,
-                          const std::vector<int>& right_shuffle_index_list) {
-    std::stringstream left_null_ss;
-    std::stringstream right_valid_ss;
-    for (auto i : left_shuffle_index_list) {
-      left_null_ss << "RETURN_NOT_OK(builder_0_" << i << "_->AppendNull());" << std::endl;
-    }
-    for (auto i : right_shuffle_index_list) {
-      right_valid_ss << "RETURN_NOT_OK(builder_1_" << i << "_->Append(cached_1_" << i
-                     << "_->GetView(i)));" << std::endl;
-    }
-    std::string shuffle_str;
-    if (cond_check) {
-      shuffle_str = R"(
-          hasequaled = true;
-          auto tmp = GetArrayItemIdex(left_it);
-            if (ConditionCheck(tmp, i)) {
-              found = true;
-              break;
-            }
-            left_it->next();
-    last_match_idx = i;
-    }
-          if (!found && hasequaled) {
-              )" + left_null_ss.str() +
-                    right_valid_ss.str() + R"(
-            out_length += 1;
-          }
-      )";
+    if (left_key_index_list.size() > 1) {
+      ss << "typedef std::tuple<";
+      for (int i = 0; i < left_key_index_list.size(); i++) {
+        if (i != 0) ss << ", ";
+        ss << "std::shared_ptr<"
+           << GetTypeString(field_list[left_key_index_list[i]]->type(), "Array") << ">";
+      }
+      ss << "> list_item;" << std::endl;
     } else {
-      shuffle_str = R"(
-        left_it->next();
-        last_match_idx = i;
-        }
-      )";
+      ss << "typedef std::shared_ptr<"
+         << GetTypeString(field_list[left_key_index_list[0]]->type(), "Array")
+         << "> list_item;" << std::endl;
     }
-    return R"(
-  while (left_it->value() < typed_array_0->GetView(i) && left_it->hasnext()) {
-    left_it->next();
-  }
-
-  int64_t cur_idx, seg_len, pl; left_it->getpos(&cur_idx, &seg_len, &pl);
-  bool found = false;
-  bool hasequaled = false;
-  while (left_it->value() == typed_array_0->GetView(i) && left_it->hasnext()) {
-    )" + shuffle_str +
-           R"(
-    left_it->setpos(cur_idx, seg_len, pl);
-  if (left_it->value() > typed_array_0->GetView(i) && left_it->hasnext() ) {
-    if (last_match_idx == i) {
-      continue;
-    }
-          )" +
-           left_null_ss.str() + right_valid_ss.str() + R"(
-          out_length += 1; }
-  if (!left_it->hasnext()) {
-          )" +
-           left_null_ss.str() + right_valid_ss.str() + R"(
-          out_length += 1;
-        }
-  )";
+    return ss.str();
   }
-  std::string GetSemiJoin(bool cond_check,
-                          const std::vector<int>& left_shuffle_index_list,
-                          const std::vector<int>& right_shuffle_index_list) {
+  std::string GetMakeListItem(const std::vector<int>& key_index_list,
+                              const std::vector<int>& left_key_index_list,
+                              const std::vector<std::shared_ptr<arrow::Field>>& field_list) {
     std::stringstream ss;
-    for (auto i : left_shuffle_index_list) {
-      ss << "RETURN_NOT_OK(builder_0_" << i << "_->AppendNull());" << std::endl;
-    }
-    for (auto i : right_shuffle_index_list) {
-      ss << "RETURN_NOT_OK(builder_1_" << i << "_->Append(cached_1_" << i
-         << "_->GetView(i)));" << std::endl;
-    }
-    std::string shuffle_str;
-    if (cond_check) {
-      shuffle_str = R"(
-        while (left_it->value() == typed_array_0->GetView(i) && left_it->hasnext()) {
-            auto tmp = GetArrayItemIdex(left_it);
-              if (ConditionCheck(tmp, i)) {
-                )" + ss.str() +
-                    R"(
-                out_length += 1;
-                break;
-              }
-      )";
-    } else {
-      shuffle_str = R"(
-        if (left_it->value() == typed_array_0->GetView(i) && left_it->hasnext()) {
-              )" + ss.str() +
-                    R"(
-              out_length += 1;
-      )";
-    }
-    return R"(
-             if (!typed_array_0->IsNull(i)) {
-  while (left_it->value() < typed_array_0->GetView(i) && left_it->hasnext()) {
-    left_it->next();
-  }
-  
-  int64_t cur_idx, seg_len, pl; left_it->getpos(&cur_idx, &seg_len, &pl);
-  )" + shuffle_str +
-           R"(
-      left_it->next();
+    ss << "list_item(";
+    for (int i = 0; i < key_index_list.size(); i++) {
+      if (i != 0) ss << ", ";
+      ss << "std::make_shared<"
+         << GetTypeString(field_list[left_key_index_list[i]]->type(), "Array") << ">(in["
+         << key_index_list[i] << "])";
+    }
+    ss << ")";
+    return ss.str();
   }
-  left_it->setpos(cur_idx, seg_len, pl);
-  //if (left_it->value() > typed_array_0->GetView(i) && left_it->hasnext() ) {
-  //  continue;
-  //
-  //      }
+  std::vector<std::string> GetKeyAccessList(int key_size, std::string item, std::string row,
+                                            std::string method) {
+    std::vector<std::string> ret;
+    if (key_size > 1) {
+      for (int i = 0; i < key_size; i++) {
+        ret.push_back("std::get<" + std::to_string(i) + ">(" + item + ")->" + method + "(" +
+                      row + ")");
       }
-  )";
-  }
-  std::string GetExistenceJoin(bool cond_check,
-                               const std::vector<int>& left_shuffle_index_list,
-                               const std::vector<int>& right_shuffle_index_list) {
-    std::stringstream right_exist_ss;
-    std::stringstream right_not_exist_ss;
-    std::stringstream left_valid_ss;
-    std::stringstream right_valid_ss;
-    auto right_size = right_shuffle_index_list.size();
-
-    right_exist_ss
-        << "const bool exist = true; RETURN_NOT_OK(builder_1_exists_->Append(exist));"
-        << std::endl;
-    right_not_exist_ss << "const bool not_exist = false; "
-                          "RETURN_NOT_OK(builder_1_exists_->Append(not_exist));"
-                       << std::endl;
-
-    for (auto i : right_shuffle_index_list) {
-      right_valid_ss << "RETURN_NOT_OK(builder_1_" << i << "_->Append(cached_1_" << i
-                     << "_->GetView(i)));" << std::endl;
-    }
-    std::string shuffle_str;
-    if (cond_check) {
-      shuffle_str = R"(
-              if (ConditionCheck(tmp, i)) {
-                )" + right_valid_ss.str() +
-                    right_exist_ss.str() + R"(
-                out_length += 1;
-              }
-      )";
     } else {
-      shuffle_str = R"(
-              )" + right_valid_ss.str() +
-                    right_exist_ss.str() + R"(
-              out_length += 1;
-      )";
+      ret.push_back(item + "->" + method + "(" + row + ")");
     }
-    return R"(
-        int32_t index;
-        if (!typed_array_0->IsNull(i)) {
-          index = hash_table_->Get(typed_array_0->GetView(i));
-        } else {
-          index = hash_table_->GetNull();
-        }
-        if (index == -1) {
-          )" +
-           right_valid_ss.str() + right_not_exist_ss.str() + R"(
-          out_length += 1;
-        } else {
-            )" +
-           shuffle_str + R"(
-        }
-  )";
+    return ret;
   }
-  std::string GetProcessProbe(int join_type, bool cond_check,
-                              const std::vector<int>& left_shuffle_index_list,
-                              const std::vector<int>& right_shuffle_index_list,
-                              const std::vector<int>& right_key_index_list) {
+  std::string GetKeyValue(int key_size, std::string item, std::string row) {
+    auto access_list = GetKeyAccessList(key_size, item, row, "GetView");
+    if (key_size == 1) return access_list[0];
+    std::string ret = "std::make_tuple(";
+    for (int i = 0; i < access_list.size(); i++) {
+      if (i != 0) ret += ", ";
+      ret += access_list[i];
+    }
+    return ret + ")";
+  }
+  std::string GetKeyIsNull(int key_size, std::string item, std::string row) {
+    auto access_list = GetKeyAccessList(key_size, item, row, "IsNull");
+    std::string ret = "(";
+    for (int i = 0; i < access_list.size(); i++) {
+      if (i != 0) ret += " || ";
+      ret += access_list[i];
+    }
+    return ret + ")";
+  }
+  // Codes run for every left row of the current key group, and once per right row after
+  // the group has been scanned. Semi, anti and existence joins stop at the first match.
+  arrow::Status GetProcessProbe(int join_type, bool cond_check, std::string* match_str,
+                                std::string* finish_str) {
+    std::string cond_begin = cond_check ? "if (ConditionCheck(tmp, i)) {" : "{";
+    std::string left_null_str = R"(
+          build_indices_.emplace_back(false);
+          probe_indices_.emplace_back(c, i);)";
     switch (join_type) {
       case 0: { /*Inner Join*/
-        return GetInnerJoin(cond_check, left_shuffle_index_list, right_shuffle_index_list,
-                            right_key_index_list);
+        *match_str = cond_begin + R"(
+              build_indices_.push_back(tmp);
+              probe_indices_.emplace_back(c, i);
+            })";
+        *finish_str = "";
       } break;
       case 1: { /*Outer Join*/
-        return GetOuterJoin(cond_check, left_shuffle_index_list,
-                            right_shuffle_index_list);
+        *match_str = cond_begin + R"(
+              build_indices_.push_back(tmp);
+              probe_indices_.emplace_back(c, i);
+              matched = true;
+            })";
+        *finish_str = "if (!matched) {" + left_null_str + "\n}";
       } break;
       case 2: { /*Anti Join*/
-        return GetAntiJoin(cond_check, left_shuffle_index_list, right_shuffle_index_list);
+        *match_str = cond_begin + R"(
+              matched = true;
+              resolved = true;
+              break;
+            })";
+        *finish_str = "if (!matched) {" + left_null_str + "\n}";
       } break;
       case 3: { /*Semi Join*/
-        return GetSemiJoin(cond_check, left_shuffle_index_list, right_shuffle_index_list);
+        *match_str = cond_begin + R"(
+              matched = true;
+              resolved = true;
+              break;
+            })";
+        *finish_str = "if (matched) {" + left_null_str + "\n}";
       } break;
       case 4: { /*Existence Join*/
-        return GetExistenceJoin(cond_check, left_shuffle_index_list,
-                                right_shuffle_index_list);
+        *match_str = cond_begin + R"(
+              matched = true;
+              resolved = true;
+              break;
+            })";
+        *finish_str = left_null_str + "\nexists_.push_back(matched);";
       } break;
       default:
-        std::cout << "ConditionedProbeArraysTypedImpl only support join type: InnerJoin, "
-                     "RightJoin"
-                  << std::endl;
-        throw;
+        return arrow::Status::NotImplemented(
+            "MergeJoin only support join type: InnerJoin, OuterJoin, AntiJoin, "
+            "SemiJoin, ExistenceJoin");
     }
-    return "";
+    return arrow::Status::OK();
   }
   std::string GetConditionCheckFunc(
       const std::shared_ptr<gandiva::Node>& func_node,
@@ -789,139 +479,16 @@ class ConditionedJoinArraysKernel::Impl {
     for (auto i : index_list) {
       auto field = field_list[i];
       auto codegen = std::make_shared<TypedProberCodeGenImpl>(prefix + std::to_string(i),
-                                                              field->type(), left);
+                                                              i, field->type(), left);
       (*out_list).push_back(codegen);
     }
     if (join_type == 4 && exist_index != -1) {
-      auto codegen = std::make_shared<TypedProberCodeGenImpl>(prefix + "exists",
+      auto codegen = std::make_shared<TypedProberCodeGenImpl>(prefix + "exists", -1,
                                                               arrow::boolean(), left);
       (*out_list).insert((*out_list).begin() + exist_index, codegen);
     }
     return arrow::Status::OK();
   }
-  std::vector<int> MergeKeyIndexList(const std::vector<int>& left_index_list,
-                                     const std::vector<int>& right_index_list) {
-    std::vector<int> ret = left_index_list;
-    for (auto i : right_index_list) {
-      if (std::find(left_index_list.begin(), left_index_list.end(), i) ==
-          left_index_list.end()) {
-        ret.push_back(i);
-      }
-    }
-    std::sort(ret.begin(), ret.end());
-    return ret;
-  }
-  std::string GetKeyCType(const std::vector<int>& key_index_list,
-                          const std::vector<std::shared_ptr<arrow::Field>>& field_list) {
-    auto field = field_list[key_index_list[0]];
-    return GetCTypeString(field->type());
-  }
-  std::string GetIdArrayStr(bool cond_check, int join_type) {
-    std::stringstream ss;
-    std::string tuple_str;
-    if (cond_check) {
-      tuple_str = "idx_to_arrarid_.emplace_back(cur_array_id_);";
-    } else {
-      tuple_str = "idx_to_arrarid_.emplace_back(cur_array_id_);";
-      if (join_type == 2 || join_type == 3) {
-        tuple_str = "";
-      }
-    }
-    ss << tuple_str << std::endl;
-    return ss.str();
-  }
-  std::string GetTupleStr(bool multiple_cols, int size) {
-    std::stringstream ss;
-    std::string tuple_str;
-    if (multiple_cols) {
-      tuple_str = "std::make_tuple";
-    }
-    if (multiple_cols) {
-      for (int i = 0; i < size; i++) {
-        std::string local_tuple =
-            "(typed_array_" + std::to_string(i) + "->GetView(cur_id_),";
-        tuple_str += local_tuple;
-      }
-    } else {
-      tuple_str += "typed_array_0->GetView(cur_id_),";
-    }
-    tuple_str.erase(tuple_str.end() - 1, tuple_str.end());
-    if (multiple_cols) {
-      tuple_str += "))";
-    }
-
-    ss << std::endl << "left_list_->emplace_back(" << tuple_str << ");" << std::endl;
-    return ss.str();
-  }
-  std::string GetListStr(bool multiple_cols, int size) {
-    std::stringstream ss;
-    std::string tuple_str;
-    if (multiple_cols) {
-      for (int i = 0; i < size; i++) {
-        std::string local_tuple =
-            "typed_array_" + std::to_string(i) + ",";
-        tuple_str += local_tuple;
-      }
-    } else {
-      tuple_str += "typed_array_0,";
-    }
-    tuple_str.erase(tuple_str.end() - 1, tuple_str.end());
-
-    ss << std::endl << "left_list_.emplace_back(" << tuple_str << ");" << std::endl;
-    return ss.str();
-  }
-  std::string GetListContentStr(bool multiple_cols, int size) {
-    std::stringstream ss;
-    std::string tuple_str;
-    if (multiple_cols) {
-      for (int i = 0; i < size; i++) {
-        std::string local_tuple =
-            "std::get<" + std::to_string(i) + ">(it)->GetView(segment_len),";
-        tuple_str += local_tuple;
-      }
-      tuple_str.erase(tuple_str.end() - 1, tuple_str.end());
-      ss << std::endl << "return {" + tuple_str + "};" << std::endl;
-    } else {
-
-      ss << std::endl << "return it->GetView(segment_len);" << std::endl;
-    }
-    return ss.str();
-  }
-  std::string GetTypedArray(bool multiple_cols, int idx, std::vector<int> key_list,
-                            std::vector<std::shared_ptr<arrow::Field>> field_list) {
-    std::stringstream ss;
-    if (multiple_cols) {
-      for (int i = 0; i < key_list.size(); i++) {
-        ss << "auto typed_array"
-           << "_" << i << " = std::make_shared<"
-           << GetTypeString(field_list[key_list[i]]->type(), "Array") << ">(in["
-           << key_list[i] << "]);" << std::endl;
-      }
-
-    } else {
-      ss << "auto typed_array_0 = std::make_shared<"
-         << GetTypeString(field_list[key_list[0]]->type(), "Array") << ">(in[" << idx
-         << "]);" << std::endl;
-    }
-    return ss.str();
-  }
-  std::string GetTypedArray(bool multiple_cols, std::string index, int i,
-                            std::string data_type,
-                            std::string evaluate_encode_join_key_str) {
-    std::stringstream ss;
-    if (multiple_cols) {
-      ss << "auto concat_kernel_arr_list = {" << evaluate_encode_join_key_str << "};"
-         << std::endl;
-      ss << "std::shared_ptr<arrow::Array> hash_in;" << std::endl;
-      ss << "RETURN_NOT_OK(hash_kernel_->Evaluate(concat_kernel_arr_list, &hash_in));"
-         << std::endl;
-      ss << "auto typed_array = std::make_shared<Int32Array>(hash_in);" << std::endl;
-    } else {
-      ss << "auto typed_array = std::make_shared<" << data_type << ">(in[" << i << "]);"
-         << std::endl;
-    }
-    return ss.str();
-  }
   std::string ProduceCodes(
       const std::shared_ptr<gandiva::Node>& func_node, int join_type,
       const std::vector<int>& left_key_index_list,
@@ -934,60 +501,8 @@ class ConditionedJoinArraysKernel::Impl {
     std::vector<int> left_cond_index_list;
     std::vector<int> right_cond_index_list;
     bool cond_check = false;
-    bool multiple_cols = (left_key_index_list.size() > 1);
-    std::string list_tiem_str;
-
-    std::string hash_map_include_str = "";
-
-    std::string hash_map_type_str =
-        GetTypeString(left_field_list[left_key_index_list[0]]->type(), "Array");
-    std::string item_content_str =
-        GetCTypeString(left_field_list[left_key_index_list[0]]->type());
-    list_tiem_str = R"(
-typedef  std::shared_ptr<)" + hash_map_type_str +
-                    R"(> list_item;
-typedef )" + item_content_str + " item_content;";
-    
-    std::vector<std::string> tuple_types;
-    std::vector<std::string> content_tuple_types;
-
-    if (multiple_cols) {
-      list_tiem_str = R"(
-        #include <tuple>)";
-
-      for (auto& key : left_key_index_list) {
-        tuple_types.push_back("std::shared_ptr<" + GetTypeString(left_field_list[key]->type(), "Array") + ">");
-        content_tuple_types.push_back(GetCTypeString(left_field_list[key]->type()));
-      }
+    int key_size = left_key_index_list.size();
 
-      std::string tuple_define_str = "std::tuple<";
-      for (auto type : tuple_types) {
-        tuple_define_str += type;
-        tuple_define_str += ",";
-      }
-      // remove the ending ','
-      tuple_define_str.erase(tuple_define_str.end() - 1, tuple_define_str.end());
-      
-      std::string content_define_str = "std::tuple<";
-      for (auto type : content_tuple_types) {
-        content_define_str += type;
-        content_define_str += ",";
-      }
-      // remove the ending ','
-      content_define_str.erase(content_define_str.end() - 1, content_define_str.end());
-
-      list_tiem_str += R"(
-        typedef )" + tuple_define_str +
-                       R"(> list_item;
-        typedef )" + content_define_str + "> item_content;";
-    } else {
-      tuple_types.push_back(hash_map_type_str);
-    }
-
-    hash_map_include_str += list_tiem_str;
-
-    std::string hash_map_define_str = "std::make_shared<std::vector<list_item>>();";
-    // TODO: fix multi columns case
     std::string condition_check_str;
     if (func_node) {
       condition_check_str =
@@ -995,223 +510,368 @@ typedef )" + item_content_str + " item_content;";
                                 &left_cond_index_list, &right_cond_index_list);
       cond_check = true;
     }
-    auto process_probe_str =
-        GetProcessProbe(join_type, cond_check, left_shuffle_index_list,
-                        right_shuffle_index_list, right_key_index_list);
-    auto left_cache_index_list =
-        MergeKeyIndexList(left_cond_index_list, left_shuffle_index_list);
-    auto right_cache_index_list =
-        MergeKeyIndexList(right_cond_index_list, right_shuffle_index_list);
+    std::string process_match_str;
+    std::string process_finish_str;
+    THROW_NOT_OK(
+        GetProcessProbe(join_type, cond_check, &process_match_str, &process_finish_str));
 
-    std::vector<std::shared_ptr<TypedProberCodeGenImpl>> left_cache_codegen_list;
+    std::vector<std::shared_ptr<TypedProberCodeGenImpl>> left_cond_codegen_list;
+    std::vector<std::shared_ptr<TypedProberCodeGenImpl>> right_cond_codegen_list;
     std::vector<std::shared_ptr<TypedProberCodeGenImpl>> left_shuffle_codegen_list;
     std::vector<std::shared_ptr<TypedProberCodeGenImpl>> right_shuffle_codegen_list;
-    GetTypedProberCodeGen("0_", true, left_cache_index_list, left_field_list, exist_index,
-                          &left_cache_codegen_list);
+    GetTypedProberCodeGen("0_", true, left_cond_index_list, left_field_list, exist_index,
+                          &left_cond_codegen_list);
+    GetTypedProberCodeGen("1_", false, right_cond_index_list, right_field_list,
+                          exist_index, &right_cond_codegen_list);
     GetTypedProberCodeGen("0_", true, left_shuffle_index_list, left_field_list,
                           exist_index, &left_shuffle_codegen_list);
     GetTypedProberCodeGen("1_", false, right_shuffle_index_list, right_field_list,
                           exist_index, &right_shuffle_codegen_list, join_type);
-    auto join_key_type_list_define_str =
-        GetJoinKeyFieldListDefine(left_key_index_list, left_field_list);
-    auto evaluate_cache_insert_str = GetEvaluateCacheInsert(left_cache_index_list);
-    auto evaluate_encode_join_key_str = GetEncodeJoinKey(left_key_index_list);
-    auto finish_cached_parameter_str = GetFinishCachedParameter(left_cache_index_list);
-    auto impl_cached_define_str = GetImplCachedDefine(left_cache_codegen_list);
-    auto result_iter_params_str = GetResultIteratorParams(left_cache_index_list);
-    auto result_iter_set_str = GetResultIteratorSet(left_cache_index_list);
-    auto result_iter_prepare_str =
-        GetResultIteratorPrepare(left_shuffle_codegen_list, right_shuffle_codegen_list);
-    auto process_right_set_str = GetProcessRightSet(right_cache_index_list);
-    auto process_encode_join_key_str = GetEncodeJoinKey(right_key_index_list);
-    auto process_finish_str =
-        GetProcessFinish(left_shuffle_codegen_list, right_shuffle_codegen_list);
+
+    using CodeGen = std::shared_ptr<TypedProberCodeGenImpl>;
+    auto list_item_define_str = GetListItemDefine(left_key_index_list, left_field_list);
+    auto append_left_cache_str = GetCodesOfList(
+        left_cond_codegen_list, [](CodeGen c) { return c->GetAppendLeftCache(); });
+    auto spill_left_cache_str = GetCodesOfList(
+        left_cond_codegen_list, [](CodeGen c) { return c->GetSpillLeftCache(); });
+    auto release_left_cache_str = GetCodesOfList(
+        left_cond_codegen_list, [](CodeGen c) { return c->GetReleaseLeftCache(); });
+    auto process_right_set_str = GetCodesOfList(
+        right_cond_codegen_list, [](CodeGen c) { return c->GetProcessRightSet(); });
+    auto gather_finish_str =
+        GetCodesOfList(left_shuffle_codegen_list,
+                       [](CodeGen c) { return c->GetGatherFinish(); }) +
+        GetCodesOfList(right_shuffle_codegen_list,
+                       [](CodeGen c) { return c->GetGatherFinish(); });
+    auto result_iter_cached_define_str =
+        GetCodesOfList(left_cond_codegen_list,
+                       [](CodeGen c) { return c->GetResultIterCachedDefine(); }) +
+        GetCodesOfList(right_cond_codegen_list,
+                       [](CodeGen c) { return c->GetResultIterCachedDefine(); });
     auto process_out_list_str = GetProcessOutList(
         result_schema_index_list, left_shuffle_codegen_list, right_shuffle_codegen_list);
-    auto result_iter_cached_define_str =
-        GetResultIterCachedDefine(left_cache_codegen_list, right_shuffle_codegen_list);
-    auto evaluate_get_typed_array_str = GetTypedArray(
-        multiple_cols, left_key_index_list[0], left_key_index_list, left_field_list);
-    auto process_get_typed_array_str = GetTypedArray(
-        multiple_cols, right_key_index_list[0], right_key_index_list, right_field_list);
-    auto evaluate_get_typed_array_str1 = GetTypedArray(
-        multiple_cols, "0_" + std::to_string(left_key_index_list[0]),
-        left_key_index_list[0],
-        GetTypeString(left_field_list[left_key_index_list[0]]->type(), "Array"),
-        evaluate_encode_join_key_str);
-    auto process_get_typed_array_str1 = GetTypedArray(
-        multiple_cols, "1_" + std::to_string(right_key_index_list[0]),
-        right_key_index_list[0],
-        GetTypeString(left_field_list[left_key_index_list[0]]->type(), "Array"),
-        process_encode_join_key_str);
-    auto make_tuple_str = GetTupleStr(multiple_cols, left_key_index_list.size());
-    auto make_idarray_str = GetIdArrayStr(cond_check, join_type);
-    auto make_list_str = GetListStr(multiple_cols, left_key_index_list.size());
-    auto make_list_content_str = GetListContentStr(multiple_cols, left_key_index_list.size());
+    auto make_left_item_str =
+        GetMakeListItem(left_key_index_list, left_key_index_list, left_field_list);
+    auto make_right_item_str =
+        GetMakeListItem(right_key_index_list, left_key_index_list, left_field_list);
+    auto right_is_null_str = GetKeyIsNull(key_size, "right_keys", "i");
+    auto right_value_str = GetKeyValue(key_size, "right_keys", "i");
+    auto cursor_is_null_str =
+        GetKeyIsNull(key_size, "left_keys_[cursor_batch_]", "cursor_row_");
+    auto cursor_value_str = GetKeyValue(key_size, "left_keys_[cursor_batch_]", "cursor_row_");
+    auto left_is_null_str = GetKeyIsNull(key_size, "left_keys_[b]", "r");
+    auto left_value_str = GetKeyValue(key_size, "left_keys_[b]", "r");
 
     return BaseCodes() + R"(
-#include "codegen/arrow_compute/ext/array_item_index.h"
-#include "precompile/builder.h"
-#include <numeric>
-using namespace sparkcolumnarplugin::precompile;
-)" + hash_map_include_str +
-           R"(
-class FVector {
-
-public:
-FVector(std::vector<list_item>* left_list, std::vector<int64_t> segment_info) {
-  left_list_ = left_list;
-  total_len_ = std::accumulate(segment_info.begin(), segment_info.end(), 0);
-  segment_info_ = segment_info;
-  it = (*left_list_)[0];
-  segment_len = 0;
-}
-
-void getpos(int64_t* cur_idx, int64_t* cur_segmeng_len, int64_t *passlen) {
-  *cur_idx = idx;
-  *cur_segmeng_len = segment_len;
-  *passlen = passed_len;
-}
-
-void setpos(int64_t cur_idx, int64_t cur_segment_len, int64_t cur_passed_len) {
-  idx = cur_idx;
-  it = (*left_list_)[idx];
-  segment_len = cur_segment_len;
-  passed_len = cur_passed_len;
-}
+#include <arrow/array/concatenate.h>
+#include <arrow/builder.h>
 
-item_content value() {
-  )" + make_list_content_str +
-R"(}
+#include <deque>
+#include <tuple>
 
-bool hasnext() {
- return (passed_len <= total_len_-1);
-}
+#include "codegen/arrow_compute/ext/array_item_index.h"
+#include "precompile/gather.h"
+#include "precompile/spill.h"
+using namespace sparkcolumnarplugin::precompile;
 
-void next() {
-  segment_len++;
-  if (segment_len == segment_info_[idx] && passed_len != total_len_ -1) {
-    idx++;
-    segment_len = 0;
-    it = (*left_list_)[idx];
+)" + list_item_define_str +
+           R"(
+// Copy rows [offset, offset + length) so that the caller may release its buffers
+inline arrow::Status CopyArrays(arrow::MemoryPool* pool, const ArrayList& in,
+                                int64_t offset, int64_t length, ArrayList* out) {
+  out->clear();
+  for (auto& array : in) {
+    std::shared_ptr<arrow::Array> copied;
+    RETURN_NOT_OK(arrow::Concatenate({array->Slice(offset, length)}, pool, &copied));
+    out->push_back(copied);
   }
-  passed_len++;
+  return arrow::Status::OK();
 }
 
-public:
-std::vector<list_item>* left_list_;
-int64_t total_len_;
-std::vector<int64_t> segment_info_;
-
-int64_t idx = 0;
-int64_t passed_len = 0;
-int64_t segment_len = 0;
-list_item it;
-};
-
-
 class TypedProberImpl : public CodeGenBase {
  public:
   TypedProberImpl(arrow::compute::FunctionContext *ctx) : ctx_(ctx) {
   }
   ~TypedProberImpl() {}
 
+  // left batches are referenced, not copied, see NumRetainedInputs()
   arrow::Status Evaluate(const ArrayList& in) override {
-    )" + evaluate_cache_insert_str +
-           evaluate_get_typed_array_str +
-           make_list_str +
-           R"(
-
-    idx_to_arrarid_.push_back(typed_array_0->length());
-
+    if (result_iter_) {
+      return result_iter_->AppendLeft(in);
+    }
+    pending_left_.push_back(in);
     return arrow::Status::OK();
   }
 
   arrow::Status MakeResultIterator(
       std::shared_ptr<arrow::Schema> schema,
       std::shared_ptr<ResultIterator<arrow::RecordBatch>> *out) override {
-    *out = std::make_shared<ProberResultIterator>(
-        ctx_, schema, &left_list_, &idx_to_arrarid_)" +
-           finish_cached_parameter_str + R"(
-    );
+    result_iter_ = std::make_shared<ProberResultIterator>(ctx_, schema);
+    for (auto& left : pending_left_) {
+      RETURN_NOT_OK(result_iter_->AppendLeft(left));
+    }
+    pending_left_.clear();
+    *out = result_iter_;
     return arrow::Status::OK();
   }
 
 private:
-  uint64_t cur_array_id_ = 0;
-  uint64_t cur_id_ = 0;
-  uint64_t idx = 0;
-  uint64_t num_items_ = 0;
-  arrow::compute::FunctionContext *ctx_;
-  std::vector<list_item> left_list_;
-  std::vector<int64_t> idx_to_arrarid_;
-  )" + impl_cached_define_str +
-           R"( 
-
   class ProberResultIterator : public ResultIterator<arrow::RecordBatch> {
   public:
     ProberResultIterator(
         arrow::compute::FunctionContext *ctx,
-        std::shared_ptr<arrow::Schema> schema,
-        std::vector<list_item>* left_list,
-        std::vector<int64_t> *idx_to_arrarid)" +
-           result_iter_params_str + R"(
-        )
-        : ctx_(ctx), result_schema_(schema), left_list_(left_list), last_pos(0), idx_to_arrarid_(idx_to_arrarid) {
-            )" +
-           result_iter_set_str + result_iter_prepare_str + R"(
-
-            left_it = new FVector(left_list_, *idx_to_arrarid_);
-    }
+        std::shared_ptr<arrow::Schema> schema)
+        : ctx_(ctx), result_schema_(schema), spill_threshold_(GetSpillThreshold()) {}
 
     std::string ToString() override { return "ProberResultIterator"; }
 
-    ArrayItemIndex GetArrayItemIdex(FVector* left_it) {
-      int64_t local_arrayid, local_seglen, local_pl;
-      left_it->getpos(&local_arrayid, &local_seglen, &local_pl);
-      return ArrayItemIndex(local_arrayid, local_seglen);
+    // deferred right rows are waiting for more left batches
+    bool NeedsMoreInput() override { return !left_finished_ && deferred_length_ > 0; }
+
+    // buffered left batches still referencing caller memory, always the newest ones
+    int64_t NumRetainedInputs() override { return retained_inputs_; }
+
+    // Buffer one sorted left batch, a zero-length batch marks the end of left input
+    arrow::Status AppendLeft(const ArrayList& left) {
+      if (left_finished_) {
+        return arrow::Status::Invalid("MergeJoin got left input after its end");
+      }
+      auto length = left[0]->length();
+      ArrayList in = left;
+      if (length == 0) {
+        left_finished_ = true;
+        // the empty batch is kept only to gather unmatched rows with its types
+        if (!left_batches_.empty()) return arrow::Status::OK();
+        RETURN_NOT_OK(CopyArrays(ctx_->memory_pool(), left, 0, 0, &in));
+      } else {
+        retained_inputs_++;
+        left_bytes_ += ArraysBufferSize(in);
+      }
+      left_batches_.push_back(in);
+      left_keys_.push_back()" +
+           make_left_item_str + R"();
+      left_lengths_.push_back(length);
+      left_retained_.push_back(length > 0);
+      )" + append_left_cache_str +
+           R"(
+      return SpillLeft();
     }
 
     arrow::Status
-    Process(const ArrayList &in, std::shared_ptr<arrow::RecordBatch> *out,
+    Process(const ArrayList &batch, std::shared_ptr<arrow::RecordBatch> *out,
             const std::shared_ptr<arrow::Array> &selection) override {
-      uint64_t out_length = 0;
-      )" + process_right_set_str +
-           process_get_typed_array_str +
+      // right rows deferred by earlier calls go first, the new batch is the last chunk
+      std::vector<ArrayList> chunks = deferred_;
+      chunks.push_back(batch);
+      if (left_batches_.empty()) {
+        RETURN_NOT_OK(Defer(chunks, 0, 0));
+        return MakeEmptyBatch(out);
+      }
+      build_indices_.clear();
+      probe_indices_.clear();
+      exists_.clear();
+      build_indices_.reserve(deferred_length_ + batch[0]->length());
+      probe_indices_.reserve(deferred_length_ + batch[0]->length());
+
+      size_t c = 0;
+      int64_t i = 0;
+      for (; c < chunks.size(); c++) {
+        auto& in = chunks[c];
+        int64_t length = in[0]->length();
+        )" + process_right_set_str +
            R"(
-      auto length = cached_1_0_->length();
-      left_it->setpos(last_idx, last_seg, last_pl);
-      int last_match_idx = -1;
-
-      for (int i = 0; i < length; i++) {)" +
-           process_probe_str + R"(
+        auto right_keys = )" +
+           make_right_item_str + R"(;
+        for (i = 0; i < length; i++) {
+          auto mark = probe_indices_.size();
+          bool matched = false;
+          bool resolved = true;
+          if (!)" +
+           right_is_null_str + R"() {
+            auto right_content = )" +
+           right_value_str + R"(;
+            // left rows with null or smaller keys match no later right row either
+            while (cursor_batch_ < left_batches_.size()) {
+              if (cursor_row_ == left_lengths_[cursor_batch_]) {
+                cursor_batch_++;
+                cursor_row_ = 0;
+              } else if ()" +
+           cursor_is_null_str + " || " + cursor_value_str + R"( < right_content) {
+                cursor_row_++;
+              } else {
+                break;
+              }
+            }
+            // the key group is complete once a larger left key or the end of left input
+            // is seen, otherwise more of it may arrive with the next left batch
+            resolved = left_finished_;
+            auto b = cursor_batch_;
+            int64_t r = cursor_row_;
+            while (b < left_batches_.size()) {
+              if (r == left_lengths_[b]) {
+                b++;
+                r = 0;
+                continue;
+              }
+              if (!)" +
+           left_is_null_str + R"() {
+                if ()" +
+           left_value_str + R"( != right_content) {
+                  resolved = true;
+                  break;
+                }
+                auto tmp = ArrayItemIndex(b, r);
+                )" +
+           process_match_str + R"(
+              }
+              r++;
+            }
+          }
+          if (!resolved) {
+            build_indices_.resize(mark);
+            probe_indices_.resize(mark);
+            break;
+          }
+          )" + process_finish_str +
+           R"(
+        }
+        if (i < length) break;
       }
-      )" + process_finish_str +
+
+      uint64_t out_length = probe_indices_.size();
+      )" + gather_finish_str +
            R"(
-      left_it->getpos(&last_idx, &last_seg, &last_pl);
+      // rows from chunk c, row i on have not seen their whole key group yet
+      RETURN_NOT_OK(Defer(chunks, c, i));
+      ReleaseLeft();
       *out = arrow::RecordBatch::Make(
           result_schema_, out_length,
           {)" +
            process_out_list_str + R"(});
-      //arrow::PrettyPrint(*(*out).get(), 2, &std::cout);
       return arrow::Status::OK();
     }
 
   private:
     arrow::compute::FunctionContext *ctx_;
     std::shared_ptr<arrow::Schema> result_schema_;
-    std::vector<list_item>* left_list_;
-    FVector* left_it;
-    int64_t last_pos;
-    int64_t last_idx = 0;
-    int64_t last_seg = 0;
-    int64_t last_pl = 0;
-    std::vector<int64_t> *idx_to_arrarid_;
+    // Sorted left batches from the current key group on. Once the batches still in
+    // caller memory outgrow the spill threshold, as a skewed key group does, all but
+    // the newest are moved to spill files and read back from there while scanned.
+    std::deque<ArrayList> left_batches_;
+    std::deque<list_item> left_keys_;
+    std::deque<int64_t> left_lengths_;
+    std::deque<bool> left_retained_;
+    bool left_finished_ = false;
+    int64_t retained_inputs_ = 0;
+    int64_t left_bytes_ = 0;
+    int64_t spill_threshold_;
+    // first left row whose key is not smaller than the last right key
+    size_t cursor_batch_ = 0;
+    int64_t cursor_row_ = 0;
+    // deferred right rows as owned chunks, each row is copied or spilled at most once
+    std::vector<ArrayList> deferred_;
+    std::vector<int64_t> deferred_bytes_;
+    int64_t deferred_length_ = 0;
+    std::vector<ArrayItemIndex> build_indices_;
+    std::vector<ArrayItemIndex> probe_indices_;
+    std::vector<bool> exists_;
 )" + result_iter_cached_define_str +
            R"(
+    // batches before the cursor can not match any more right rows, the last one is
+    // always kept so that its types are known
+    void ReleaseLeft() {
+      while (cursor_batch_ > 0 && left_batches_.size() > 1) {
+        if (left_retained_.front()) {
+          retained_inputs_--;
+          left_bytes_ -= ArraysBufferSize(left_batches_.front());
+        }
+        left_batches_.pop_front();
+        left_keys_.pop_front();
+        left_lengths_.pop_front();
+        left_retained_.pop_front();
+        )" + release_left_cache_str +
+           R"(
+        cursor_batch_--;
+      }
+    }
+
+    // Spill every left batch but the newest one, so that the caller may release them
+    arrow::Status SpillLeft() {
+      if (left_bytes_ <= spill_threshold_) return arrow::Status::OK();
+      for (size_t b = 0; b + 1 < left_batches_.size(); b++) {
+        if (!left_retained_[b]) continue;
+        ArrayList in;
+        RETURN_NOT_OK(SpillArrays(GetSpillDir(), left_batches_[b], 0, left_lengths_[b],
+                                  &in));
+        left_bytes_ -= ArraysBufferSize(left_batches_[b]);
+        left_batches_[b] = in;
+        left_keys_[b] = )" +
+           make_left_item_str + R"(;
+        )" + spill_left_cache_str +
+           R"(
+        left_retained_[b] = false;
+        retained_inputs_--;
+      }
+      return arrow::Status::OK();
+    }
+
+    // Keep right rows from chunks[c] row i on. Earlier chunks are owned already and
+    // only sliced, the caller's batch is the last chunk and is copied, or spilled when
+    // the deferred rows would outgrow the spill threshold.
+    arrow::Status Defer(const std::vector<ArrayList>& chunks, size_t c, int64_t i) {
+      std::vector<ArrayList> deferred;
+      std::vector<int64_t> deferred_bytes;
+      int64_t deferred_length = 0;
+      int64_t heap_bytes = 0;
+      for (; c < chunks.size(); c++, i = 0) {
+        auto length = chunks[c][0]->length() - i;
+        if (length == 0) continue;
+        ArrayList rows;
+        int64_t bytes = 0;
+        if (c + 1 == chunks.size()) {
+          // the whole batch bounds the size of the rows kept from it
+          if (heap_bytes + ArraysBufferSize(chunks[c]) > spill_threshold_) {
+            RETURN_NOT_OK(SpillArrays(GetSpillDir(), chunks[c], i, length, &rows));
+          } else {
+            RETURN_NOT_OK(CopyArrays(ctx_->memory_pool(), chunks[c], i, length, &rows));
+            bytes = ArraysBufferSize(rows);
+          }
+        } else {
+          for (auto& array : chunks[c]) {
+            rows.push_back(array->Slice(i, length));
+          }
+          bytes = deferred_bytes_[c];
+        }
+        deferred.push_back(rows);
+        deferred_bytes.push_back(bytes);
+        deferred_length += length;
+        heap_bytes += bytes;
+      }
+      deferred_ = std::move(deferred);
+      deferred_bytes_ = std::move(deferred_bytes);
+      deferred_length_ = deferred_length;
+      return arrow::Status::OK();
+    }
+
+    arrow::Status MakeEmptyBatch(std::shared_ptr<arrow::RecordBatch> *out) {
+      ArrayList columns;
+      for (auto& field : result_schema_->fields()) {
+        std::unique_ptr<arrow::ArrayBuilder> builder;
+        std::shared_ptr<arrow::Array> column;
+        RETURN_NOT_OK(arrow::MakeBuilder(ctx_->memory_pool(), field->type(), &builder));
+        RETURN_NOT_OK(builder->Finish(&column));
+        columns.push_back(column);
+      }
+      *out = arrow::RecordBatch::Make(result_schema_, 0, columns);
+      return arrow::Status::OK();
+    }
       )" + condition_check_str +
            R"(
   };
+
+  arrow::compute::FunctionContext *ctx_;
+  std::vector<ArrayList> pending_left_;
+  std::shared_ptr<ProberResultIterator> result_iter_;
 };
 
 extern "C" void MakeCodeGen(arrow::compute::FunctionContext *ctx,
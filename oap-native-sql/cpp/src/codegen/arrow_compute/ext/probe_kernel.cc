@@ -300,10 +300,14 @@ class ConditionedProbeArraysKernel::Impl {
     std::string GetResultIteratorPrepare() {
       std::stringstream ss;
       ss << "builder_" << indice_ << "_ = std::make_shared<"
-         << GetTypeString(data_type_, "Builder") << ">(ctx_->memory_pool());"
+         << GetBatchBuilderTypeString(data_type_) << ">(ctx_->memory_pool());"
          << std::endl;
       return ss.str();
     }
+    std::string GetProcessReserve() {
+      // anti, semi and existence joins output at most one row per probe row
+      return "RETURN_NOT_OK(builder_" + indice_ + "_->Reserve(length));\n";
+    }
     std::string GetProcessFinish() {
       std::stringstream ss;
       ss << "std::shared_ptr<arrow::Array> out_" << indice_ << ";" << std::endl;
@@ -312,6 +316,27 @@ class ConditionedProbeArraysKernel::Impl {
       ss << "builder_" << indice_ << "_->Reset();" << std::endl;
       return ss.str();
     }
+    std::string GetGatherPrepare() {
+      std::stringstream ss;
+      if (left_) {
+        ss << "for (auto& array : cached_" << indice_ << "_) {" << std::endl;
+        ss << "  build_arrays_" << indice_ << "_.push_back(array->cache_);" << std::endl;
+        ss << "}" << std::endl;
+      }
+      return ss.str();
+    }
+    std::string GetGatherFinish() {
+      std::stringstream ss;
+      ss << "std::shared_ptr<arrow::Array> out_" << indice_ << ";" << std::endl;
+      if (left_) {
+        ss << "RETURN_NOT_OK(GatherArrays(ctx_->memory_pool(), build_arrays_" << indice_
+           << "_, build_indices_, &out_" << indice_ << "));" << std::endl;
+      } else {
+        ss << "RETURN_NOT_OK(GatherArray(ctx_->memory_pool(), cached_" << indice_
+           << "_->cache_, probe_indices_, &out_" << indice_ << "));" << std::endl;
+      }
+      return ss.str();
+    }
     std::string GetProcessOutList() {
       std::stringstream ss;
       ss << "out_" << indice_;
@@ -322,13 +347,14 @@ class ConditionedProbeArraysKernel::Impl {
       if (left_) {
         ss << "std::vector<std::shared_ptr<" << GetTypeString(data_type_, "Array")
            << ">> cached_" << indice_ << "_;" << std::endl;
+        ss << "arrow::ArrayVector build_arrays_" << indice_ << "_;" << std::endl;
       } else {
         ss << "std::shared_ptr<" << GetTypeString(data_type_, "Array") << "> cached_"
            << indice_ << "_;" << std::endl;
       }
       ss << "using ArrayType_" << indice_ << " = " << GetTypeString(data_type_, "Array")
          << ";" << std::endl;
-      ss << "std::shared_ptr<" << GetTypeString(data_type_, "Builder") << "> builder_"
+      ss << "std::shared_ptr<" << GetBatchBuilderTypeString(data_type_) << "> builder_"
          << indice_ << "_;" << std::endl;
       return ss.str();
     }
@@ -503,6 +529,18 @@ class ConditionedProbeArraysKernel::Impl {
     }
     return ss.str();
   }
+  std::string GetProcessReserve(
+      std::vector<std::shared_ptr<TypedProberCodeGenImpl>> left_codegen_list,
+      std::vector<std::shared_ptr<TypedProberCodeGenImpl>> right_codegen_list) {
+    std::stringstream ss;
+    for (auto codegen : left_codegen_list) {
+      ss << codegen->GetProcessReserve();
+    }
+    for (auto codegen : right_codegen_list) {
+      ss << codegen->GetProcessReserve();
+    }
+    return ss.str();
+  }
   std::string GetProcessFinish(
       std::vector<std::shared_ptr<TypedProberCodeGenImpl>> left_codegen_list,
       std::vector<std::shared_ptr<TypedProberCodeGenImpl>> right_codegen_list) {
@@ -515,6 +553,27 @@ class ConditionedProbeArraysKernel::Impl {
     }
     return ss.str();
   }
+  std::string GetGatherPrepare(
+      std::vector<std::shared_ptr<TypedProberCodeGenImpl>> left_codegen_list) {
+    std::stringstream ss;
+    for (auto codegen : left_codegen_list) {
+      ss << codegen->GetGatherPrepare() << std::endl;
+    }
+    return ss.str();
+  }
+  std::string GetGatherFinish(
+      std::vector<std::shared_ptr<TypedProberCodeGenImpl>> left_codegen_list,
+      std::vector<std::shared_ptr<TypedProberCodeGenImpl>> right_codegen_list) {
+    std::stringstream ss;
+    ss << "out_length = probe_indices_.size();" << std::endl;
+    for (auto codegen : left_codegen_list) {
+      ss << codegen->GetGatherFinish() << std::endl;
+    }
+    for (auto codegen : right_codegen_list) {
+      ss << codegen->GetGatherFinish() << std::endl;
+    }
+    return ss.str();
+  }
   std::string GetProcessOutList(
       const std::vector<std::pair<int, int>>& result_schema_index_list,
       std::vector<std::shared_ptr<TypedProberCodeGenImpl>> left_codegen_list,
@@ -549,47 +608,29 @@ class ConditionedProbeArraysKernel::Impl {
     }
     return ss.str();
   }
-  std::string GetInnerJoin(bool cond_check,
-                           const std::vector<int>& left_shuffle_index_list,
-                           const std::vector<int>& right_shuffle_index_list) {
-    std::stringstream ss;
-    for (auto i : left_shuffle_index_list) {
-      ss << "if (cached_0_" << i << "_[tmp.array_id]->IsNull(tmp.id)) {" << std::endl;
-      ss << "  RETURN_NOT_OK(builder_0_" << i << "_->AppendNull());" << std::endl;
-      ss << "} else {" << std::endl;
-      ss << "  RETURN_NOT_OK(builder_0_" << i << "_->Append(cached_0_" << i
-         << "_[tmp.array_id]->GetView(tmp.id)));" << std::endl;
-      ss << "}" << std::endl;
-    }
-    for (auto i : right_shuffle_index_list) {
-      ss << "if (cached_1_" << i << "_->IsNull(i)) {" << std::endl;
-      ss << "  RETURN_NOT_OK(builder_1_" << i << "_->AppendNull());" << std::endl;
-      ss << "} else {" << std::endl;
-      ss << "  RETURN_NOT_OK(builder_1_" << i << "_->Append(cached_1_" << i
-         << "_->GetView(i)));" << std::endl;
-      ss << "}" << std::endl;
-    }
+  // Inner and outer joins probe in two phases. The lookup below only records
+  // matching (build row, probe row) pairs, output columns are gathered from them
+  // once the whole probe batch has been looked up.
+  std::string GetInnerJoin(bool cond_check) {
     std::string shuffle_str;
     if (cond_check) {
       shuffle_str = R"(
               if (ConditionCheck(tmp, i)) {
-                )" + ss.str() +
-                    R"(
-                out_length += 1;
+                build_indices_.push_back(tmp);
+                probe_indices_.push_back(i);
               }
       )";
     } else {
       shuffle_str = R"(
-              )" + ss.str() +
-                    R"(
-              out_length += 1;
+              build_indices_.push_back(tmp);
+              probe_indices_.push_back(i);
       )";
     }
     return R"(
-        if (!typed_array->IsNull(i)) {
+        if (!key_is_null) {
           auto index = hash_table_->Get(typed_array->GetView(i));
           if (index != -1) {
-            for (auto tmp : (*memo_index_to_arrayid_)[index]) {
+            for (const auto& tmp : (*memo_index_to_arrayid_)[index]) {
               )" +
            shuffle_str + R"(
             }
@@ -597,82 +638,66 @@ class ConditionedProbeArraysKernel::Impl {
         }
   )";
   }
-  std::string GetOuterJoin(bool cond_check,
-                           const std::vector<int>& left_shuffle_index_list,
-                           const std::vector<int>& right_shuffle_index_list) {
-    std::stringstream left_null_ss;
-    std::stringstream left_valid_ss;
-    std::stringstream right_valid_ss;
-    for (auto i : left_shuffle_index_list) {
-      left_valid_ss << "if (cached_0_" << i << "_[tmp.array_id]->IsNull(tmp.id)) {"
-                    << std::endl;
-      left_valid_ss << "  RETURN_NOT_OK(builder_0_" << i << "_->AppendNull());"
-                    << std::endl;
-      left_valid_ss << "} else {" << std::endl;
-      left_valid_ss << "  RETURN_NOT_OK(builder_0_" << i << "_->Append(cached_0_" << i
-                    << "_[tmp.array_id]->GetView(tmp.id)));" << std::endl;
-      left_valid_ss << "}" << std::endl;
-      left_null_ss << "RETURN_NOT_OK(builder_0_" << i << "_->AppendNull());" << std::endl;
-    }
-    for (auto i : right_shuffle_index_list) {
-      right_valid_ss << "if (cached_1_" << i << "_->IsNull(i)) {" << std::endl;
-      right_valid_ss << "  RETURN_NOT_OK(builder_1_" << i << "_->AppendNull());"
-                     << std::endl;
-      right_valid_ss << "} else {" << std::endl;
-      right_valid_ss << "  RETURN_NOT_OK(builder_1_" << i << "_->Append(cached_1_" << i
-                     << "_->GetView(i)));" << std::endl;
-      right_valid_ss << "}" << std::endl;
-    }
+  std::string GetOuterJoin(bool cond_check) {
     std::string shuffle_str;
     if (cond_check) {
       shuffle_str = R"(
               if (ConditionCheck(tmp, i)) {
-                )" + left_valid_ss.str() +
-                    right_valid_ss.str() + R"(
-                out_length += 1;
+                build_indices_.push_back(tmp);
+                probe_indices_.push_back(i);
               }
       )";
     } else {
       shuffle_str = R"(
-              )" + left_valid_ss.str() +
-                    right_valid_ss.str() + R"(
-              out_length += 1;
+              build_indices_.push_back(tmp);
+              probe_indices_.push_back(i);
       )";
     }
     return R"(
         int32_t index;
-        if (!typed_array->IsNull(i)) {
+        if (!key_is_null) {
           index = hash_table_->Get(typed_array->GetView(i));
         } else {
           index = hash_table_->GetNull();
         }
         if (index == -1) {
-          )" +
-           left_null_ss.str() + right_valid_ss.str() + R"(
-          out_length += 1;
+          build_indices_.emplace_back(false);
+          probe_indices_.push_back(i);
         } else {
-          for (auto tmp : (*memo_index_to_arrayid_)[index]) {
+          for (const auto& tmp : (*memo_index_to_arrayid_)[index]) {
             )" +
            shuffle_str + R"(
           }
         }
   )";
   }
-  std::string GetAntiJoin(bool cond_check,
-                          const std::vector<int>& left_shuffle_index_list,
-                          const std::vector<int>& right_shuffle_index_list) {
+  // Append of a probe side value, only string bytes can outgrow the Reserve
+  std::string GetAppendRightValue(
+      int i, const std::vector<std::shared_ptr<arrow::Field>>& right_field_list) {
+    std::stringstream ss;
+    auto builder = "builder_1_" + std::to_string(i) + "_";
+    auto value = "cached_1_" + std::to_string(i) + "_->GetView(i)";
+    if (right_field_list[i]->type()->id() == arrow::Type::STRING) {
+      ss << "  RETURN_NOT_OK(" << builder << "->Append(" << value << "));";
+    } else {
+      ss << "  " << builder << "->UnsafeAppend(" << value << ");";
+    }
+    return ss.str();
+  }
+  std::string GetAntiJoin(
+      bool cond_check, const std::vector<int>& left_shuffle_index_list,
+      const std::vector<int>& right_shuffle_index_list,
+      const std::vector<std::shared_ptr<arrow::Field>>& right_field_list) {
     std::stringstream left_null_ss;
     std::stringstream right_valid_ss;
     for (auto i : left_shuffle_index_list) {
-      left_null_ss << "RETURN_NOT_OK(builder_0_" << i << "_->AppendNull());" << std::endl;
+      left_null_ss << "builder_0_" << i << "_->UnsafeAppendNull();" << std::endl;
     }
     for (auto i : right_shuffle_index_list) {
       right_valid_ss << "if (cached_1_" << i << "_->IsNull(i)) {" << std::endl;
-      right_valid_ss << "  RETURN_NOT_OK(builder_1_" << i << "_->AppendNull());"
-                     << std::endl;
+      right_valid_ss << "  builder_1_" << i << "_->UnsafeAppendNull();" << std::endl;
       right_valid_ss << "} else {" << std::endl;
-      right_valid_ss << "  RETURN_NOT_OK(builder_1_" << i << "_->Append(cached_1_" << i
-                     << "_->GetView(i)));" << std::endl;
+      right_valid_ss << GetAppendRightValue(i, right_field_list) << std::endl;
       right_valid_ss << "}" << std::endl;
     }
     std::string shuffle_str;
@@ -695,7 +720,7 @@ class ConditionedProbeArraysKernel::Impl {
     }
     return R"(
         int32_t index;
-        if (!typed_array->IsNull(i)) {
+        if (!key_is_null) {
           index = hash_table_->Get(typed_array->GetView(i));
         } else {
           index = hash_table_->GetNull();
@@ -709,19 +734,19 @@ class ConditionedProbeArraysKernel::Impl {
         }
   )";
   }
-  std::string GetSemiJoin(bool cond_check,
-                          const std::vector<int>& left_shuffle_index_list,
-                          const std::vector<int>& right_shuffle_index_list) {
+  std::string GetSemiJoin(
+      bool cond_check, const std::vector<int>& left_shuffle_index_list,
+      const std::vector<int>& right_shuffle_index_list,
+      const std::vector<std::shared_ptr<arrow::Field>>& right_field_list) {
     std::stringstream ss;
     for (auto i : left_shuffle_index_list) {
-      ss << "RETURN_NOT_OK(builder_0_" << i << "_->AppendNull());" << std::endl;
+      ss << "builder_0_" << i << "_->UnsafeAppendNull();" << std::endl;
     }
     for (auto i : right_shuffle_index_list) {
       ss << "if (cached_1_" << i << "_->IsNull(i)) {" << std::endl;
-      ss << "  RETURN_NOT_OK(builder_1_" << i << "_->AppendNull());" << std::endl;
+      ss << "  builder_1_" << i << "_->UnsafeAppendNull();" << std::endl;
       ss << "} else {" << std::endl;
-      ss << "  RETURN_NOT_OK(builder_1_" << i << "_->Append(cached_1_" << i
-         << "_->GetView(i)));" << std::endl;
+      ss << GetAppendRightValue(i, right_field_list) << std::endl;
       ss << "}" << std::endl;
     }
     std::string shuffle_str;
@@ -744,7 +769,7 @@ class ConditionedProbeArraysKernel::Impl {
       )";
     }
     return R"(
-        if (!typed_array->IsNull(i)) {
+        if (!key_is_null) {
           auto index = hash_table_->Get(typed_array->GetView(i));
           if (index != -1) {
                 )" +
@@ -753,29 +778,24 @@ class ConditionedProbeArraysKernel::Impl {
         }
   )";
   }
-  std::string GetExistenceJoin(bool cond_check,
-                               const std::vector<int>& left_shuffle_index_list,
-                               const std::vector<int>& right_shuffle_index_list) {
+  std::string GetExistenceJoin(
+      bool cond_check, const std::vector<int>& left_shuffle_index_list,
+      const std::vector<int>& right_shuffle_index_list,
+      const std::vector<std::shared_ptr<arrow::Field>>& right_field_list) {
     std::stringstream right_exist_ss;
     std::stringstream right_not_exist_ss;
     std::stringstream left_valid_ss;
     std::stringstream right_valid_ss;
     auto right_size = right_shuffle_index_list.size();
 
-    right_exist_ss
-        << "const bool exist = true; RETURN_NOT_OK(builder_1_exists_->Append(exist));"
-        << std::endl;
-    right_not_exist_ss << "const bool not_exist = false; "
-                          "RETURN_NOT_OK(builder_1_exists_->Append(not_exist));"
-                       << std::endl;
+    right_exist_ss << "builder_1_exists_->UnsafeAppend(true);" << std::endl;
+    right_not_exist_ss << "builder_1_exists_->UnsafeAppend(false);" << std::endl;
 
     for (auto i : right_shuffle_index_list) {
       right_valid_ss << "if (cached_1_" << i << "_->IsNull(i)) {" << std::endl;
-      right_valid_ss << "  RETURN_NOT_OK(builder_1_" << i << "_->AppendNull());"
-                     << std::endl;
+      right_valid_ss << "  builder_1_" << i << "_->UnsafeAppendNull();" << std::endl;
       right_valid_ss << "} else {" << std::endl;
-      right_valid_ss << "  RETURN_NOT_OK(builder_1_" << i << "_->Append(cached_1_" << i
-                     << "_->GetView(i)));" << std::endl;
+      right_valid_ss << GetAppendRightValue(i, right_field_list) << std::endl;
       right_valid_ss << "}" << std::endl;
     }
     std::string shuffle_str;
@@ -796,7 +816,7 @@ class ConditionedProbeArraysKernel::Impl {
     }
     return R"(
         int32_t index;
-        if (!typed_array->IsNull(i)) {
+        if (!key_is_null) {
           index = hash_table_->Get(typed_array->GetView(i));
         } else {
           index = hash_table_->GetNull();
@@ -811,27 +831,28 @@ class ConditionedProbeArraysKernel::Impl {
         }
   )";
   }
-  std::string GetProcessProbe(int join_type, bool cond_check,
-                              const std::vector<int>& left_shuffle_index_list,
-                              const std::vector<int>& right_shuffle_index_list) {
+  std::string GetProcessProbe(
+      int join_type, bool cond_check, const std::vector<int>& left_shuffle_index_list,
+      const std::vector<int>& right_shuffle_index_list,
+      const std::vector<std::shared_ptr<arrow::Field>>& right_field_list) {
     switch (join_type) {
       case 0: { /*Inner Join*/
-        return GetInnerJoin(cond_check, left_shuffle_index_list,
-                            right_shuffle_index_list);
+        return GetInnerJoin(cond_check);
       } break;
       case 1: { /*Outer Join*/
-        return GetOuterJoin(cond_check, left_shuffle_index_list,
-                            right_shuffle_index_list);
+        return GetOuterJoin(cond_check);
       } break;
       case 2: { /*Anti Join*/
-        return GetAntiJoin(cond_check, left_shuffle_index_list, right_shuffle_index_list);
+        return GetAntiJoin(cond_check, left_shuffle_index_list, right_shuffle_index_list,
+                           right_field_list);
       } break;
       case 3: { /*Semi Join*/
-        return GetSemiJoin(cond_check, left_shuffle_index_list, right_shuffle_index_list);
+        return GetSemiJoin(cond_check, left_shuffle_index_list, right_shuffle_index_list,
+                           right_field_list);
       } break;
       case 4: { /*Existence Join*/
         return GetExistenceJoin(cond_check, left_shuffle_index_list,
-                                right_shuffle_index_list);
+                                right_shuffle_index_list, right_field_list);
       } break;
       default:
         std::cout << "ConditionedProbeArraysTypedImpl only support join type: InnerJoin, "
@@ -961,6 +982,7 @@ class ConditionedProbeArraysKernel::Impl {
     std::vector<int> right_cond_index_list;
     bool cond_check = false;
     bool multiple_cols = (left_key_index_list.size() > 1);
+    bool two_phase = (join_type == 0 || join_type == 1);
     std::string hash_map_include_str = R"(#include "precompile/sparse_hash_map.h")";
     std::string hash_map_type_str =
         "SparseHashMap<" + GetCTypeString(arrow::int64()) + ">";
@@ -968,10 +990,8 @@ class ConditionedProbeArraysKernel::Impl {
         "std::make_shared<" + hash_map_type_str + ">(ctx_->memory_pool());";
     if (!multiple_cols) {
       if (left_field_list[left_key_index_list[0]]->type()->id() == arrow::Type::STRING) {
-        hash_map_type_str =
-            GetTypeString(left_field_list[left_key_index_list[0]]->type(), "") +
-            "HashMap";
-        hash_map_include_str = R"(#include "precompile/hash_map.h")";
+        hash_map_type_str = "TypedHashMap<arrow::StringType>";
+        hash_map_include_str = R"(#include "precompile/typed_hash_map.h")";
       } else {
         hash_map_type_str =
             "SparseHashMap<" +
@@ -998,8 +1018,9 @@ class ConditionedProbeArraysKernel::Impl {
       }
       cond_check = true;
     }
-    auto process_probe_str = GetProcessProbe(
-        join_type, cond_check, left_shuffle_index_list, right_shuffle_index_list);
+    auto process_probe_str =
+        GetProcessProbe(join_type, cond_check, left_shuffle_index_list,
+                        right_shuffle_index_list, right_field_list);
     auto left_cache_index_list =
         MergeKeyIndexList(left_cond_index_list, left_shuffle_index_list);
     auto right_cache_index_list =
@@ -1031,11 +1052,17 @@ class ConditionedProbeArraysKernel::Impl {
     auto result_iter_projected_set_str =
         GetResultIteratorProjectedSet(left_projected_batch_list);
     auto result_iter_prepare_str =
-        GetResultIteratorPrepare(left_shuffle_codegen_list, right_shuffle_codegen_list);
+        two_phase
+            ? GetGatherPrepare(left_shuffle_codegen_list)
+            : GetResultIteratorPrepare(left_shuffle_codegen_list, right_shuffle_codegen_list);
     auto process_right_set_str = GetProcessRightSet(right_cache_index_list);
     auto process_encode_join_key_str = GetEncodeJoinKey(right_key_index_list);
+    auto process_reserve_str =
+        two_phase ? ""
+                  : GetProcessReserve(left_shuffle_codegen_list, right_shuffle_codegen_list);
     auto process_finish_str =
-        GetProcessFinish(left_shuffle_codegen_list, right_shuffle_codegen_list);
+        two_phase ? GetGatherFinish(left_shuffle_codegen_list, right_shuffle_codegen_list)
+                  : GetProcessFinish(left_shuffle_codegen_list, right_shuffle_codegen_list);
     auto process_out_list_str = GetProcessOutList(
         result_schema_index_list, left_shuffle_codegen_list, right_shuffle_codegen_list);
     auto result_iter_cached_define_str =
@@ -1052,7 +1079,11 @@ class ConditionedProbeArraysKernel::Impl {
         process_encode_join_key_str);
     return BaseCodes() + R"(
 #include "codegen/arrow_compute/ext/array_item_index.h"
+#include "precompile/batch_builder.h"
+#include "precompile/bitmap.h"
 #include "precompile/builder.h"
+#include "precompile/typed_builder.h"
+#include "precompile/gather.h"
 #include "precompile/hash_arrays_kernel.h"
 )" + hash_map_include_str +
            R"(
@@ -1101,20 +1132,27 @@ class TypedProberImpl : public CodeGenBase {
         }
       }
     } else {
-      for (; cur_id_ < typed_array->length(); cur_id_++) {
-        if (typed_array->IsNull(cur_id_)) {
-          hash_table_->GetOrInsertNull([](int32_t){}, [](int32_t){});
-        } else {
-          hash_table_->GetOrInsert(typed_array->GetView(cur_id_),
-                                   [](int32_t){}, [](int32_t){},
-                                   &memo_index);
-        if (memo_index < num_items_) {
-          insert_on_found(memo_index);
-        } else {
-          insert_on_not_found(memo_index);
-        }
-        }
-      }
+      // key validity is read 64 rows at a time, words without nulls insert
+      // their keys without testing each row's bit
+      RETURN_NOT_OK(VisitValidity(
+          typed_array->null_bitmap_data(), typed_array->offset(), typed_array->length(),
+          [&](int64_t i) {
+            cur_id_ = i;
+            hash_table_->GetOrInsert(typed_array->GetView(cur_id_),
+                                     [](int32_t){}, [](int32_t){},
+                                     &memo_index);
+            if (memo_index < num_items_) {
+              insert_on_found(memo_index);
+            } else {
+              insert_on_not_found(memo_index);
+            }
+            return arrow::Status::OK();
+          },
+          [&](int64_t i) {
+            cur_id_ = i;
+            hash_table_->GetOrInsertNull([](int32_t){}, [](int32_t){});
+            return arrow::Status::OK();
+          }));
     }
     cur_array_id_++;
     return arrow::Status::OK();
@@ -1172,9 +1210,29 @@ private:
            process_get_typed_array_str + right_projected_prepare_str +
            R"(
       auto length = cached_1_0_->length();
+      build_indices_.clear();
+      probe_indices_.clear();
+      build_indices_.reserve(length);
+      probe_indices_.reserve(length);
+      )" + process_reserve_str + R"(
 
-      for (int i = 0; i < length; i++) {)" +
+      // the probe key validity is read 64 rows at a time; a word without null
+      // keys runs a copy of the probe body where key_is_null is a constant
+      for (int base = 0; base < length; base += kBitmapWordBits) {
+        int n = std::min<int64_t>(kBitmapWordBits, length - base);
+        auto key_valid_bits = LoadBitmapWord(typed_array->null_bitmap_data(),
+                                             typed_array->offset() + base, n);
+        if (IsAllSet(key_valid_bits, n)) {
+          constexpr bool key_is_null = false;
+          for (int i = base; i < base + n; i++) {)" +
+           process_probe_str + R"(
+          }
+        } else {
+          for (int i = base; i < base + n; i++) {
+            const bool key_is_null = !((key_valid_bits >> (i - base)) & 1);)" +
            process_probe_str + R"(
+          }
+        }
       }
       )" + process_finish_str +
            R"(
@@ -1193,6 +1251,9 @@ private:
     std::shared_ptr<)" +
            hash_map_type_str + R"(> hash_table_;
     std::vector<std::vector<ArrayItemIndex>> *memo_index_to_arrayid_;
+    // matched (build row, probe row) pairs of the current probe batch
+    std::vector<ArrayItemIndex> build_indices_;
+    std::vector<int32_t> probe_indices_;
 )" + result_iter_cached_define_str +
            impl_projected_define_str + res_iter_projected_define_str +
            R"(
@@ -38,6 +38,7 @@
 #include "codegen/arrow_compute/ext/typed_node_visitor.h"
 #include "third_party/ska_sort.hpp"
 #include "precompile/array.h"
+#include "precompile/batch_builder.h"
 #include "precompile/type.h"
 #include "array_appender.h"
 #include "utils/macros.h"
@@ -206,19 +207,39 @@ class SortArraysToIndicesKernel::Impl {
       std::stringstream ss;
       ss << "cached_" << indice_ << "_ = cached_" << indice_ << ";" << std::endl;
       ss << "builder_" + indice_ + "_ = std::make_shared<"
-         << GetTypeString(data_type_, "Builder") << ">(ctx_->memory_pool());"
+         << GetBatchBuilderTypeString(data_type_) << ">(ctx_->memory_pool());"
          << std::endl;
       return ss.str();
     }
     std::string GetFieldDefine() {
       return "arrow::field(\"" + name_ + "\", data_type_" + indice_ + ")";
     }
+    std::string GetTypedReserve() {
+      return "RETURN_NOT_OK(builder_" + indice_ + "_->Reserve(length));";
+    }
+    std::string GetTypedBuild() {
+      std::stringstream ss;
+      auto cached = "cached_" + indice_ + "_[item->array_id]";
+      ss << "if (!" << cached << "->IsNull(item->id)) {\n";
+      // string value bytes are not known up front, so only they grow and check
+      if (data_type_->id() == arrow::Type::STRING) {
+        ss << "  RETURN_NOT_OK(builder_" << indice_ << "_->Append(" << cached
+           << "->GetView(item->id)));\n";
+      } else {
+        ss << "  builder_" << indice_ << "_->UnsafeAppend(" << cached
+           << "->GetView(item->id));\n";
+      }
+      ss << "} else {\n"
+         << "  builder_" << indice_ << "_->UnsafeAppendNull();\n"
+         << "}" << std::endl;
+      return ss.str();
+    }
     std::string GetResultIterVariables() {
       std::stringstream ss;
       ss << "using ArrayType_" << indice_ << " = " + GetTypeString(data_type_, "Array")
          << ";" << std::endl;
       ss << "using BuilderType_" << indice_ << " = "
-         << GetTypeString(data_type_, "Builder") << ";" << std::endl;
+         << GetBatchBuilderTypeString(data_type_) << ";" << std::endl;
       ss << "std::vector<std::shared_ptr<ArrayType_" << indice_ << ">> cached_" << indice_
          << "_;" << std::endl;
       ss << "std::shared_ptr<BuilderType_" << indice_ << "> builder_" << indice_ << "_;"
@@ -267,7 +288,9 @@ class SortArraysToIndicesKernel::Impl {
 
     std::string result_iter_define_str = GetResultIterDefine(shuffle_typed_codegen_list);
 
-    std::string typed_build_str = GetTypedBuild(shuffle_typed_codegen_list.size());
+    std::string typed_reserve_str = GetTypedReserve(shuffle_typed_codegen_list);
+
+    std::string typed_build_str = GetTypedBuild(shuffle_typed_codegen_list);
 
     std::string result_variables_define_str =
         GetResultIterVariables(shuffle_typed_codegen_list);
@@ -290,7 +313,9 @@ class SortArraysToIndicesKernel::Impl {
 #include <algorithm>
 
 #include "codegen/arrow_compute/ext/array_item_index.h"
+#include "precompile/batch_builder.h"
 #include "precompile/builder.h"
+#include "precompile/typed_builder.h"
 #include "precompile/type.h"
 #include "third_party/ska_sort.hpp"
 using namespace sparkcolumnarplugin::precompile;
@@ -385,6 +410,8 @@ class TypedSorterImpl : public CodeGenBase {
       auto length = (total_length_ - offset_) > )" +
            std::to_string(GetBatchSize()) + R"( ? )" + std::to_string(GetBatchSize()) +
            R"( : (total_length_ - offset_);
+      )" + typed_reserve_str +
+           R"(
       uint64_t count = 0;
       while (count < length) {
         auto item = indices_begin_ + offset_ + count++;
@@ -617,15 +644,19 @@ extern "C" void MakeCodeGen(arrow::compute::FunctionContext* ctx,
        << std::endl;
     return ss.str();
   }
-  std::string GetTypedBuild(int shuffle_size) {
+  std::string GetTypedReserve(
+      std::vector<std::shared_ptr<TypedSorterCodeGenImpl>> shuffle_typed_codegen_list) {
     std::stringstream ss;
-    for (int i = 0; i < shuffle_size; i++) {
-      ss << "if (!cached_" << i << "_[item->array_id]->IsNull(item->id)) {\n"
-         << "  RETURN_NOT_OK(builder_" << i << "_->Append(cached_" << i
-         << "_[item->array_id]->GetView(item->id)));\n"
-         << "} else {\n"
-         << "  RETURN_NOT_OK(builder_" << i << "_->AppendNull());\n"
-         << "}" << std::endl;
+    for (auto codegen : shuffle_typed_codegen_list) {
+      ss << codegen->GetTypedReserve() << std::endl;
+    }
+    return ss.str();
+  }
+  std::string GetTypedBuild(
+      std::vector<std::shared_ptr<TypedSorterCodeGenImpl>> shuffle_typed_codegen_list) {
+    std::stringstream ss;
+    for (auto codegen : shuffle_typed_codegen_list) {
+      ss << codegen->GetTypedBuild();
     }
     return ss.str();
   }
@@ -789,10 +820,7 @@ class SortInplaceKernel : public SortArraysToIndicesKernel::Impl {
           total_length_(result_arr->length()),
           nulls_total_(result_arr->null_count()) {
       result_arr_ = std::dynamic_pointer_cast<ArrayType_0>(result_arr);
-      std::unique_ptr<arrow::ArrayBuilder> builder_0;
-      arrow::MakeBuilder(ctx_->memory_pool(), data_type_0, &builder_0);
-      builder_0_.reset(
-          arrow::internal::checked_cast<BuilderType_0*>(builder_0.release()));
+      builder_0_ = std::make_shared<BuilderType_0>(ctx_->memory_pool());
       batch_size_ = GetBatchSize();
     }
 
@@ -820,10 +848,11 @@ class SortInplaceKernel : public SortArraysToIndicesKernel::Impl {
       **/
       uint64_t valid_count = 0;
       uint64_t total_count = 0;
+      RETURN_NOT_OK(builder_0_->Reserve(length));
       if (total_offset_ >= nulls_total_) {
         // If no null value
         while (total_count < length) {
-          RETURN_NOT_OK(builder_0_->Append(result_arr_->GetView(valid_offset_ + valid_count)));
+          builder_0_->UnsafeAppend(result_arr_->GetView(valid_offset_ + valid_count));
           valid_count++;
           total_count++;
         }
@@ -835,12 +864,12 @@ class SortInplaceKernel : public SortArraysToIndicesKernel::Impl {
           if ((total_offset_ + total_count) < nulls_total_) {
             // Append nulls first
             // TODO: support nulls_last
-            RETURN_NOT_OK(builder_0_->AppendNull());
+            builder_0_->UnsafeAppendNull();
           } else {
             // After appending all null value, append valid value
             // Because result_arr_ from arrow sort is nulls_last, valid_count is used to
             // access data from the beginning of result_arr_.
-            RETURN_NOT_OK(builder_0_->Append(result_arr_->GetView(valid_offset_ + valid_count)));
+            builder_0_->UnsafeAppend(result_arr_->GetView(valid_offset_ + valid_count));
             // Add valid_count after appending one valid value
             valid_count++;
           }
@@ -860,7 +889,7 @@ class SortInplaceKernel : public SortArraysToIndicesKernel::Impl {
 
    private:
     using ArrayType_0 = typename arrow::TypeTraits<DATATYPE>::ArrayType;
-    using BuilderType_0 = typename arrow::TypeTraits<DATATYPE>::BuilderType;
+    using BuilderType_0 = BatchBuilder<DATATYPE>;
     std::shared_ptr<arrow::DataType> data_type_0 =
         arrow::TypeTraits<DATATYPE>::type_singleton();
     std::shared_ptr<ArrayType_0> result_arr_;
@@ -220,6 +220,7 @@ class WholeStageCodeGenKernel::Impl {
     std::stringstream define_ss;
     codes_ss << BaseCodes() << std::endl;
     codes_ss << R"(#include "precompile/builder.h")" << std::endl;
+    codes_ss << R"(#include "precompile/typed_builder.h")" << std::endl;
     std::vector<std::string> headers;
     for (auto codegen_ctx : codegen_ctx_list) {
       for (auto header : codegen_ctx->header_codes) {
@@ -420,7 +421,7 @@ extern "C" void MakeCodeGen(arrow::compute::FunctionContext *ctx,
                  << ", ctx_->memory_pool());" << std::endl;
       } else {
         codes_ss << "builder_" << i << "_ = std::make_shared<"
-                 << GetTypeString(data_type, "Builder") << ">(ctx_->memory_pool());"
+                 << GetBuilderTypeString(data_type) << ">(ctx_->memory_pool());"
                  << std::endl;
       }
     }
@@ -431,7 +432,7 @@ extern "C" void MakeCodeGen(arrow::compute::FunctionContext *ctx,
     std::stringstream codes_ss;
     for (int i = 0; i < output_field_list.size(); i++) {
       auto data_type = output_field_list[i]->type();
-      codes_ss << "std::shared_ptr<" << GetTypeString(data_type, "Builder")
+      codes_ss << "std::shared_ptr<" << GetBuilderTypeString(data_type)
                << "> builder_" << i << "_;" << std::endl;
     }
     return codes_ss.str();
@@ -18,10 +18,12 @@
 #pragma once
 
 #include "codegen/common/hash_relation.h"
+#include "precompile/bitmap.h"
 #include "precompile/sparse_hash_map.h"
 using sparkcolumnarplugin::codegen::arrowcompute::extra::ArrayItemIndex;
 using sparkcolumnarplugin::precompile::enable_if_number;
 using sparkcolumnarplugin::precompile::TypeTraits;
+using sparkcolumnarplugin::precompile::VisitValidity;
 
 /////////////////////////////////////////////////////////////////////////
 
@@ -43,13 +45,10 @@ class TypedHashRelation<DataType, enable_if_number<DataType>> : public HashRelat
         RETURN_NOT_OK(Insert(typed_array->GetView(i), num_arrays_, i));
       }
     } else {
-      for (int i = 0; i < typed_array->length(); i++) {
-        if (typed_array->IsNull(i)) {
-          RETURN_NOT_OK(InsertNull(num_arrays_, i));
-        } else {
-          RETURN_NOT_OK(Insert(typed_array->GetView(i), num_arrays_, i));
-        }
-      }
+      RETURN_NOT_OK(VisitValidity(
+          typed_array->null_bitmap_data(), typed_array->offset(), typed_array->length(),
+          [&](int64_t i) { return Insert(typed_array->GetView(i), num_arrays_, i); },
+          [&](int64_t i) { return InsertNull(num_arrays_, i); }));
     }
     num_arrays_++;
     return arrow::Status::OK();
@@ -20,12 +20,14 @@
 #include <arrow/util/string_view.h>
 
 #include "codegen/common/hash_relation.h"
+#include "precompile/bitmap.h"
 #include "precompile/hash_map.h"
 using sparkcolumnarplugin::codegen::arrowcompute::extra::ArrayItemIndex;
 using sparkcolumnarplugin::precompile::enable_if_string_like;
 using sparkcolumnarplugin::precompile::StringArray;
 using sparkcolumnarplugin::precompile::StringHashMap;
 using sparkcolumnarplugin::precompile::TypeTraits;
+using sparkcolumnarplugin::precompile::VisitValidity;
 
 /////////////////////////////////////////////////////////////////////////
 
@@ -46,14 +48,10 @@ class TypedHashRelation<DataType, enable_if_string_like<DataType>> : public Hash
         RETURN_NOT_OK(Insert(typed_array->GetView(i), num_arrays_, i));
       }
     } else {
-      for (int i = 0; i < typed_array->length(); i++) {
-        if (typed_array->IsNull(i)) {
-          RETURN_NOT_OK(InsertNull(num_arrays_, i));
-
-        } else {
-          RETURN_NOT_OK(Insert(typed_array->GetView(i), num_arrays_, i));
-        }
-      }
+      RETURN_NOT_OK(VisitValidity(
+          typed_array->null_bitmap_data(), typed_array->offset(), typed_array->length(),
+          [&](int64_t i) { return Insert(typed_array->GetView(i), num_arrays_, i); },
+          [&](int64_t i) { return InsertNull(num_arrays_, i); }));
     }
     num_arrays_++;
     return arrow::Status::OK();
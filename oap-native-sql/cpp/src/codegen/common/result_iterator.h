@@ -23,6 +23,11 @@
 class ResultIteratorBase {
  public:
   virtual bool HasNext() { return false; }
+  // true while rows given to Process() are held back until more input is evaluated
+  virtual bool NeedsMoreInput() { return false; }
+  // number of the most recently evaluated inputs still referenced without a copy, the
+  // caller must keep their buffers alive and may release any older ones
+  virtual int64_t NumRetainedInputs() { return 0; }
   virtual std::string ToString() { return ""; }
 };
 
@@ -721,6 +721,18 @@ JNIEXPORT jboolean JNICALL Java_com_intel_oap_vectorized_BatchIterator_nativeHas
   return iter->HasNext();
 }
 
+JNIEXPORT jboolean JNICALL Java_com_intel_oap_vectorized_BatchIterator_nativeNeedsMoreInput(
+    JNIEnv* env, jobject obj, jlong id) {
+  auto iter = GetBatchIterator(env, id);
+  return iter->NeedsMoreInput();
+}
+
+JNIEXPORT jlong JNICALL Java_com_intel_oap_vectorized_BatchIterator_nativeNumRetainedInputs(
+    JNIEnv* env, jobject obj, jlong id) {
+  auto iter = GetBatchIterator(env, id);
+  return iter->NumRetainedInputs();
+}
+
 JNIEXPORT jobject JNICALL Java_com_intel_oap_vectorized_BatchIterator_nativeNext(
     JNIEnv* env, jobject obj, jlong id) {
   arrow::Status status;
@@ -17,6 +17,8 @@ class Array {
   }
   int64_t length() const { return length_; }
   int64_t null_count() const { return null_count_; }
+  int64_t offset() const { return offset_; }
+  const uint8_t* null_bitmap_data() const { return null_bitmap_data_; }
   const uint8_t* value_data() const { return raw_value_; }
 
   std::shared_ptr<arrow::Array> cache_;
@@ -44,6 +46,8 @@ class BooleanArray {
   }
   int64_t length() const { return length_; }
   int64_t null_count() const { return null_count_; }
+  int64_t offset() const { return offset_; }
+  const uint8_t* null_bitmap_data() const { return null_bitmap_data_; }
 
   std::shared_ptr<arrow::Array> cache_;
 
@@ -55,28 +59,30 @@ class BooleanArray {
   uint64_t null_count_;
 };
 
-#define TYPED_ARRAY_DEFINE(TYPENAME, TYPE)                     \
-  class TYPENAME {                                             \
-   public:                                                     \
-    TYPENAME(const std::shared_ptr<arrow::Array>&);            \
-    TYPE GetView(int64_t i) const { return raw_value_[i]; }    \
-    bool IsNull(int64_t i) const {                             \
-      i += offset_;                                            \
-      return null_bitmap_data_ != NULLPTR &&                   \
-             !((null_bitmap_data_[i >> 3] >> (i & 0x07)) & 1); \
-    }                                                          \
-    int64_t length() const { return length_; }                 \
-    int64_t null_count() const { return null_count_; }         \
-    const TYPE* value_data() const { return raw_value_; }      \
-                                                               \
-    std::shared_ptr<arrow::Array> cache_;                      \
-                                                               \
-   private:                                                    \
-    const TYPE* raw_value_;                                    \
-    const uint8_t* null_bitmap_data_;                          \
-    uint64_t offset_;                                          \
-    uint64_t length_;                                          \
-    uint64_t null_count_;                                      \
+#define TYPED_ARRAY_DEFINE(TYPENAME, TYPE)                                \
+  class TYPENAME {                                                        \
+   public:                                                                \
+    TYPENAME(const std::shared_ptr<arrow::Array>&);                       \
+    TYPE GetView(int64_t i) const { return raw_value_[i]; }               \
+    bool IsNull(int64_t i) const {                                        \
+      i += offset_;                                                       \
+      return null_bitmap_data_ != NULLPTR &&                              \
+             !((null_bitmap_data_[i >> 3] >> (i & 0x07)) & 1);            \
+    }                                                                     \
+    int64_t length() const { return length_; }                            \
+    int64_t null_count() const { return null_count_; }                    \
+    int64_t offset() const { return offset_; }                            \
+    const uint8_t* null_bitmap_data() const { return null_bitmap_data_; } \
+    const TYPE* value_data() const { return raw_value_; }                 \
+                                                                          \
+    std::shared_ptr<arrow::Array> cache_;                                 \
+                                                                          \
+   private:                                                               \
+    const TYPE* raw_value_;                                               \
+    const uint8_t* null_bitmap_data_;                                     \
+    uint64_t offset_;                                                     \
+    uint64_t length_;                                                     \
+    uint64_t null_count_;                                                 \
   };
 
 TYPED_ARRAY_DEFINE(Int8Array, int8_t)
@@ -111,6 +117,8 @@ TYPED_ARRAY_DEFINE(Date64Array, int64_t)
     }                                                                                  \
     int64_t length() const { return length_; }                                         \
     int64_t null_count() const { return null_count_; }                                 \
+    int64_t offset() const { return offset_; }                                         \
+    const uint8_t* null_bitmap_data() const { return null_bitmap_data_; }              \
                                                                                        \
     std::shared_ptr<arrow::Array> cache_;                                              \
                                                                                        \
@@ -140,6 +148,8 @@ class FixedSizeBinaryArray {
   }
   int64_t length() const { return length_; }
   int64_t null_count() const { return null_count_; }
+  int64_t offset() const { return offset_; }
+  const uint8_t* null_bitmap_data() const { return null_bitmap_data_; }
   const uint8_t* value_data() const { return raw_value_; }
 
   std::shared_ptr<arrow::Array> cache_;
@@ -0,0 +1,316 @@
+#pragma once
+#include <arrow/array.h>
+#include <arrow/buffer.h>
+#include <arrow/memory_pool.h>
+#include <arrow/type_traits.h>
+#include <arrow/util/bit_util.h>
+#include <arrow/util/macros.h>
+#include <arrow/util/string_view.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace sparkcolumnarplugin {
+namespace precompile {
+
+/// Output builders for result iterators which know how many rows the next
+/// batch holds. Reserve allocates the buffers for exactly that many rows, the
+/// UnsafeAppend calls write through raw pointers without capacity or status
+/// checks, and Finish wraps the buffers into ArrayData with no copy. Finish
+/// leaves the builder empty, so Reserve has to be called again per batch.
+///
+/// Validity starts all set and a null only clears its bit, so valid rows never
+/// touch the bitmap, and the bitmap is dropped at Finish if no null was seen.
+class BatchBuilderBase {
+ public:
+  BatchBuilderBase(std::shared_ptr<arrow::DataType> type, arrow::MemoryPool* pool)
+      : type_(std::move(type)), pool_(pool) {}
+
+  int64_t length() const { return length_; }
+  int64_t null_count() const { return null_count_; }
+
+ protected:
+  arrow::Status ReserveValidity(int64_t capacity) {
+    ARROW_ASSIGN_OR_RAISE(
+        validity_buffer_,
+        arrow::AllocateBuffer(arrow::BitUtil::BytesForBits(capacity), pool_));
+    validity_ = validity_buffer_->mutable_data();
+    std::memset(validity_, 0xff, validity_buffer_->size());
+    length_ = 0;
+    null_count_ = 0;
+    return arrow::Status::OK();
+  }
+
+  inline void ClearValidity() {
+    arrow::BitUtil::ClearBit(validity_, length_);
+    null_count_++;
+  }
+
+  // Pack validity[offset, offset + length) into the bitmap a byte at a time
+  void CopyValidity(const std::vector<bool>& validity, int64_t offset, int64_t length) {
+    for (int64_t i = 0; i < length; i += 8) {
+      uint8_t bits = 0;
+      auto n = std::min<int64_t>(8, length - i);
+      for (int64_t j = 0; j < n; j++) {
+        bits |= static_cast<uint8_t>(validity[offset + i + j]) << j;
+      }
+      validity_[i >> 3] = bits;
+    }
+    null_count_ = length - arrow::internal::CountSetBits(validity_, 0, length);
+  }
+
+  arrow::Status FinishInternal(std::vector<std::shared_ptr<arrow::Buffer>> buffers,
+                               std::shared_ptr<arrow::Array>* out) {
+    buffers.insert(buffers.begin(), null_count_ == 0 ? nullptr : validity_buffer_);
+    *out = arrow::MakeArray(
+        arrow::ArrayData::Make(type_, length_, std::move(buffers), null_count_));
+    validity_buffer_ = nullptr;
+    validity_ = nullptr;
+    length_ = 0;
+    null_count_ = 0;
+    return arrow::Status::OK();
+  }
+
+  std::shared_ptr<arrow::DataType> type_;
+  arrow::MemoryPool* pool_;
+  std::shared_ptr<arrow::Buffer> validity_buffer_;
+  uint8_t* validity_ = nullptr;
+  int64_t length_ = 0;
+  int64_t null_count_ = 0;
+};
+
+template <typename DataType, typename Enable = void>
+class BatchBuilder {};
+
+/// Fixed width numeric and date types
+template <typename DataType>
+class BatchBuilder<DataType,
+                   arrow::enable_if_t<arrow::has_c_type<DataType>::value &&
+                                      !std::is_same<DataType, arrow::BooleanType>::value>>
+    : public BatchBuilderBase {
+ public:
+  using CType = typename DataType::c_type;
+
+  explicit BatchBuilder(arrow::MemoryPool* pool)
+      : BatchBuilderBase(arrow::TypeTraits<DataType>::type_singleton(), pool) {}
+
+  arrow::Status Reserve(int64_t capacity) {
+    RETURN_NOT_OK(ReserveValidity(capacity));
+    ARROW_ASSIGN_OR_RAISE(values_buffer_,
+                          arrow::AllocateBuffer(capacity * sizeof(CType), pool_));
+    values_ = reinterpret_cast<CType*>(values_buffer_->mutable_data());
+    return arrow::Status::OK();
+  }
+
+  inline void UnsafeAppend(CType value) { values_[length_++] = value; }
+  inline void UnsafeAppendNull() {
+    values_[length_] = CType();
+    ClearValidity();
+    length_++;
+  }
+
+  /// Build the batch from values[offset, offset + length)
+  template <typename T>
+  arrow::Status AppendValues(const std::vector<T>& values, int64_t offset,
+                             int64_t length) {
+    RETURN_NOT_OK(Reserve(length));
+    std::copy(values.begin() + offset, values.begin() + offset + length, values_);
+    length_ = length;
+    return arrow::Status::OK();
+  }
+  template <typename T>
+  arrow::Status AppendValues(const std::vector<T>& values,
+                             const std::vector<bool>& validity, int64_t offset,
+                             int64_t length) {
+    RETURN_NOT_OK(AppendValues(values, offset, length));
+    CopyValidity(validity, offset, length);
+    return arrow::Status::OK();
+  }
+
+  arrow::Status Finish(std::shared_ptr<arrow::Array>* out) {
+    if (values_buffer_ == nullptr) {
+      RETURN_NOT_OK(Reserve(0));
+    }
+    RETURN_NOT_OK(FinishInternal({values_buffer_}, out));
+    return Reset();
+  }
+  arrow::Status Reset() {
+    values_buffer_ = nullptr;
+    values_ = nullptr;
+    return arrow::Status::OK();
+  }
+
+ private:
+  std::shared_ptr<arrow::Buffer> values_buffer_;
+  CType* values_ = nullptr;
+};
+
+template <>
+class BatchBuilder<arrow::BooleanType> : public BatchBuilderBase {
+ public:
+  explicit BatchBuilder(arrow::MemoryPool* pool)
+      : BatchBuilderBase(arrow::boolean(), pool) {}
+
+  arrow::Status Reserve(int64_t capacity) {
+    RETURN_NOT_OK(ReserveValidity(capacity));
+    ARROW_ASSIGN_OR_RAISE(
+        values_buffer_,
+        arrow::AllocateBuffer(arrow::BitUtil::BytesForBits(capacity), pool_));
+    values_ = values_buffer_->mutable_data();
+    std::memset(values_, 0, values_buffer_->size());
+    return arrow::Status::OK();
+  }
+
+  inline void UnsafeAppend(bool value) {
+    if (value) arrow::BitUtil::SetBit(values_, length_);
+    length_++;
+  }
+  inline void UnsafeAppendNull() {
+    ClearValidity();
+    length_++;
+  }
+
+  template <typename T>
+  arrow::Status AppendValues(const std::vector<T>& values, int64_t offset,
+                             int64_t length) {
+    RETURN_NOT_OK(Reserve(length));
+    for (int64_t i = 0; i < length; i++) {
+      UnsafeAppend(values[offset + i]);
+    }
+    return arrow::Status::OK();
+  }
+  template <typename T>
+  arrow::Status AppendValues(const std::vector<T>& values,
+                             const std::vector<bool>& validity, int64_t offset,
+                             int64_t length) {
+    RETURN_NOT_OK(AppendValues(values, offset, length));
+    CopyValidity(validity, offset, length);
+    return arrow::Status::OK();
+  }
+
+  arrow::Status Finish(std::shared_ptr<arrow::Array>* out) {
+    if (values_buffer_ == nullptr) {
+      RETURN_NOT_OK(Reserve(0));
+    }
+    RETURN_NOT_OK(FinishInternal({values_buffer_}, out));
+    return Reset();
+  }
+  arrow::Status Reset() {
+    values_buffer_ = nullptr;
+    values_ = nullptr;
+    return arrow::Status::OK();
+  }
+
+ private:
+  std::shared_ptr<arrow::Buffer> values_buffer_;
+  uint8_t* values_ = nullptr;
+};
+
+/// String and binary. The offsets are sized exactly by Reserve; the value
+/// bytes are exact when the caller passes data_length, otherwise Append grows
+/// them geometrically.
+template <typename DataType>
+class BatchBuilder<DataType,
+                   arrow::enable_if_t<std::is_same<DataType, arrow::StringType>::value ||
+                                      std::is_same<DataType, arrow::BinaryType>::value>>
+    : public BatchBuilderBase {
+ public:
+  explicit BatchBuilder(arrow::MemoryPool* pool)
+      : BatchBuilderBase(arrow::TypeTraits<DataType>::type_singleton(), pool) {}
+
+  arrow::Status Reserve(int64_t capacity, int64_t data_length = 0) {
+    if (data_length > INT32_MAX) {
+      return arrow::Status::CapacityError("BatchBuilder data exceeds 2GB");
+    }
+    RETURN_NOT_OK(ReserveValidity(capacity));
+    ARROW_ASSIGN_OR_RAISE(offsets_buffer_,
+                          arrow::AllocateBuffer((capacity + 1) * sizeof(int32_t), pool_));
+    offsets_ = reinterpret_cast<int32_t*>(offsets_buffer_->mutable_data());
+    offsets_[0] = 0;
+    ARROW_ASSIGN_OR_RAISE(data_buffer_,
+                          arrow::AllocateResizableBuffer(data_length, pool_));
+    data_ = data_buffer_->mutable_data();
+    data_length_ = 0;
+    return arrow::Status::OK();
+  }
+
+  /// The value bytes must fit in the data_length given to Reserve
+  inline void UnsafeAppend(arrow::util::string_view value) {
+    std::memcpy(data_ + data_length_, value.data(), value.size());
+    data_length_ += value.size();
+    offsets_[++length_] = static_cast<int32_t>(data_length_);
+  }
+  inline arrow::Status Append(arrow::util::string_view value) {
+    if (ARROW_PREDICT_FALSE(data_length_ + static_cast<int64_t>(value.size()) >
+                            data_buffer_->size())) {
+      RETURN_NOT_OK(GrowData(value.size()));
+    }
+    UnsafeAppend(value);
+    return arrow::Status::OK();
+  }
+  inline void UnsafeAppendNull() {
+    ClearValidity();
+    offsets_[++length_] = static_cast<int32_t>(data_length_);
+  }
+
+  arrow::Status AppendValues(const std::vector<std::string>& values, int64_t offset,
+                             int64_t length) {
+    int64_t data_length = 0;
+    for (int64_t i = 0; i < length; i++) {
+      data_length += values[offset + i].size();
+    }
+    RETURN_NOT_OK(Reserve(length, data_length));
+    for (int64_t i = 0; i < length; i++) {
+      UnsafeAppend(arrow::util::string_view(values[offset + i]));
+    }
+    return arrow::Status::OK();
+  }
+  arrow::Status AppendValues(const std::vector<std::string>& values,
+                             const std::vector<bool>& validity, int64_t offset,
+                             int64_t length) {
+    RETURN_NOT_OK(AppendValues(values, offset, length));
+    CopyValidity(validity, offset, length);
+    return arrow::Status::OK();
+  }
+
+  arrow::Status Finish(std::shared_ptr<arrow::Array>* out) {
+    if (offsets_buffer_ == nullptr) {
+      RETURN_NOT_OK(Reserve(0));
+    }
+    RETURN_NOT_OK(data_buffer_->Resize(data_length_, false));
+    std::shared_ptr<arrow::Buffer> data_buffer = std::move(data_buffer_);
+    RETURN_NOT_OK(FinishInternal({offsets_buffer_, data_buffer}, out));
+    return Reset();
+  }
+  arrow::Status Reset() {
+    offsets_buffer_ = nullptr;
+    data_buffer_ = nullptr;
+    offsets_ = nullptr;
+    data_ = nullptr;
+    data_length_ = 0;
+    return arrow::Status::OK();
+  }
+
+ private:
+  arrow::Status GrowData(int64_t extra) {
+    if (data_length_ + extra > INT32_MAX) {
+      return arrow::Status::CapacityError("BatchBuilder data exceeds 2GB");
+    }
+    auto size = std::min<int64_t>(
+        INT32_MAX, std::max(data_length_ + extra, 2 * data_buffer_->size()));
+    RETURN_NOT_OK(data_buffer_->Resize(size, false));
+    data_ = data_buffer_->mutable_data();
+    return arrow::Status::OK();
+  }
+
+  std::shared_ptr<arrow::Buffer> offsets_buffer_;
+  std::shared_ptr<arrow::ResizableBuffer> data_buffer_;
+  int32_t* offsets_ = nullptr;
+  uint8_t* data_ = nullptr;
+  int64_t data_length_ = 0;
+};
+
+}  // namespace precompile
+}  // namespace sparkcolumnarplugin
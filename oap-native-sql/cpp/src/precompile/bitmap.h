@@ -0,0 +1,138 @@
+#pragma once
+#include <arrow/status.h>
+#include <arrow/util/bit_util.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace sparkcolumnarplugin {
+namespace precompile {
+
+/// Word-at-a-time kernels over Arrow validity bitmaps. A bitmap is read as 64
+/// row words, so loops test one word per 64 rows and take a fast path when a
+/// word is all valid (or all null) instead of testing each row's bit. A null
+/// bitmap pointer stands for an array without nulls and reads as all set.
+
+constexpr int64_t kBitmapWordBits = 64;
+
+/// A word with the low n bits set, n <= 64
+inline uint64_t LowBitsMask(int64_t n) {
+  return n >= kBitmapWordBits ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+}
+
+/// Bits [offset, offset + n) of bitmap as the low n bits of a word, n <= 64.
+/// Only the bytes holding those bits are read.
+inline uint64_t LoadBitmapWord(const uint8_t* bitmap, int64_t offset, int64_t n) {
+  if (bitmap == nullptr) return LowBitsMask(n);
+  const uint8_t* bytes = bitmap + (offset >> 3);
+  const int shift = offset & 7;
+  const int64_t num_bytes = arrow::BitUtil::BytesForBits(shift + n);
+  uint64_t word = 0;
+  std::memcpy(&word, bytes, std::min<int64_t>(num_bytes, 8));
+  word = arrow::BitUtil::FromLittleEndian(word) >> shift;
+  if (num_bytes > 8) {
+    word |= static_cast<uint64_t>(bytes[8]) << (kBitmapWordBits - shift);
+  }
+  return word & LowBitsMask(n);
+}
+
+/// Store the low n bits of word at bit 0 of out + (base >> 3), base a multiple of 64
+inline void StoreBitmapWord(uint8_t* out, int64_t base, uint64_t word, int64_t n) {
+  word = arrow::BitUtil::ToLittleEndian(word);
+  std::memcpy(out + (base >> 3), &word, arrow::BitUtil::BytesForBits(n));
+}
+
+inline bool IsAllSet(uint64_t word, int64_t n) { return word == LowBitsMask(n); }
+
+inline int64_t CountSetBits(const uint8_t* bitmap, int64_t offset, int64_t length) {
+  if (bitmap == nullptr) return length;
+  int64_t count = 0;
+  for (int64_t base = 0; base < length; base += kBitmapWordBits) {
+    auto n = std::min(kBitmapWordBits, length - base);
+    count += arrow::BitUtil::PopCount(LoadBitmapWord(bitmap, offset + base, n));
+  }
+  return count;
+}
+
+/// Call visit(i) for every set bit i in [0, length), in order
+template <typename Visit>
+inline void VisitSetBits(const uint8_t* bitmap, int64_t offset, int64_t length,
+                         Visit&& visit) {
+  for (int64_t base = 0; base < length; base += kBitmapWordBits) {
+    auto n = std::min(kBitmapWordBits, length - base);
+    auto word = LoadBitmapWord(bitmap, offset + base, n);
+    if (IsAllSet(word, n)) {
+      for (int64_t i = base; i < base + n; i++) visit(i);
+    } else {
+      while (word != 0) {
+        visit(base + __builtin_ctzll(word));
+        word &= word - 1;
+      }
+    }
+  }
+}
+
+/// Call on_valid(i) or on_null(i) for every row i in [0, length), in order.
+/// Words which are all valid or all null run one callback without per-row bit
+/// tests. Both callbacks return arrow::Status and the first error stops the visit.
+template <typename OnValid, typename OnNull>
+inline arrow::Status VisitValidity(const uint8_t* bitmap, int64_t offset, int64_t length,
+                                   OnValid&& on_valid, OnNull&& on_null) {
+  if (bitmap == nullptr) {
+    for (int64_t i = 0; i < length; i++) RETURN_NOT_OK(on_valid(i));
+    return arrow::Status::OK();
+  }
+  for (int64_t base = 0; base < length; base += kBitmapWordBits) {
+    auto n = std::min(kBitmapWordBits, length - base);
+    auto word = LoadBitmapWord(bitmap, offset + base, n);
+    if (IsAllSet(word, n)) {
+      for (int64_t i = base; i < base + n; i++) RETURN_NOT_OK(on_valid(i));
+    } else if (word == 0) {
+      for (int64_t i = base; i < base + n; i++) RETURN_NOT_OK(on_null(i));
+    } else {
+      for (int64_t i = base; i < base + n; i++, word >>= 1) {
+        if (word & 1) {
+          RETURN_NOT_OK(on_valid(i));
+        } else {
+          RETURN_NOT_OK(on_null(i));
+        }
+      }
+    }
+  }
+  return arrow::Status::OK();
+}
+
+/// out[0, length) = left[left_offset, ...) & right[right_offset, ...), the
+/// validity of a row which needs both inputs. A null input is all valid, so
+/// with both null out is all set. Returns the null count of out.
+inline int64_t BitmapAnd(const uint8_t* left, int64_t left_offset, const uint8_t* right,
+                         int64_t right_offset, int64_t length, uint8_t* out) {
+  int64_t null_count = 0;
+  for (int64_t base = 0; base < length; base += kBitmapWordBits) {
+    auto n = std::min(kBitmapWordBits, length - base);
+    auto word = LoadBitmapWord(left, left_offset + base, n) &
+                LoadBitmapWord(right, right_offset + base, n);
+    StoreBitmapWord(out, base, word, n);
+    null_count += n - arrow::BitUtil::PopCount(word);
+  }
+  return null_count;
+}
+
+/// out[0, length) = left[left_offset, ...) | right[right_offset, ...), the
+/// validity of a row which needs either input. Returns the null count of out.
+inline int64_t BitmapOr(const uint8_t* left, int64_t left_offset, const uint8_t* right,
+                        int64_t right_offset, int64_t length, uint8_t* out) {
+  int64_t null_count = 0;
+  for (int64_t base = 0; base < length; base += kBitmapWordBits) {
+    auto n = std::min(kBitmapWordBits, length - base);
+    auto word = LoadBitmapWord(left, left_offset + base, n) |
+                LoadBitmapWord(right, right_offset + base, n);
+    StoreBitmapWord(out, base, word, n);
+    null_count += n - arrow::BitUtil::PopCount(word);
+  }
+  return null_count;
+}
+
+}  // namespace precompile
+}  // namespace sparkcolumnarplugin
@@ -0,0 +1,273 @@
+#include "precompile/gather.h"
+
+#include <arrow/array.h>
+#include <arrow/buffer.h>
+#include <arrow/memory_pool.h>
+#include <arrow/type.h>
+#include <arrow/util/bit_util.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace sparkcolumnarplugin::codegen::arrowcompute::extra;
+namespace sparkcolumnarplugin {
+namespace precompile {
+
+namespace {
+
+// Raw buffers of every source array, resolved once per gather
+struct GatherSources {
+  explicit GatherSources(const arrow::ArrayVector& arrays) {
+    for (auto& array : arrays) {
+      auto& data = array->data();
+      offset.push_back(data->offset);
+      validity.push_back(array->null_count() == 0 ? nullptr : array->null_bitmap_data());
+      values.push_back(data->buffers.size() > 1 && data->buffers[1]
+                           ? data->buffers[1]->data()
+                           : nullptr);
+      binary.push_back(data->buffers.size() > 2 && data->buffers[2]
+                           ? data->buffers[2]->data()
+                           : nullptr);
+      has_nulls |= validity.back() != nullptr;
+    }
+  }
+  std::vector<int64_t> offset;
+  std::vector<const uint8_t*> validity;
+  std::vector<const uint8_t*> values;
+  std::vector<const uint8_t*> binary;
+  bool has_nulls = false;
+};
+
+// Locate output row i as (source array, physical row), source is -1 for a null
+struct BuildLocator {
+  const std::vector<ArrayItemIndex>& indices;
+  const GatherSources& sources;
+  inline int32_t operator()(int64_t i, int64_t* row) const {
+    const auto& index = indices[i];
+    if (!index.valid) return -1;
+    *row = sources.offset[index.array_id] + index.id;
+    return index.array_id;
+  }
+};
+
+struct ProbeLocator {
+  const std::vector<int32_t>& indices;
+  const GatherSources& sources;
+  inline int32_t operator()(int64_t i, int64_t* row) const {
+    *row = sources.offset[0] + indices[i];
+    return 0;
+  }
+};
+
+template <typename Locator>
+arrow::Status GatherValidity(arrow::MemoryPool* pool, int64_t length, bool has_nulls,
+                             const GatherSources& sources, const Locator& locate,
+                             std::shared_ptr<arrow::Buffer>* out, int64_t* null_count) {
+  *null_count = 0;
+  if (!has_nulls) {
+    *out = nullptr;
+    return arrow::Status::OK();
+  }
+  std::shared_ptr<arrow::Buffer> buffer;
+  ARROW_ASSIGN_OR_RAISE(buffer,
+                        arrow::AllocateBuffer(arrow::BitUtil::BytesForBits(length), pool));
+  auto bitmap = buffer->mutable_data();
+  // assemble a whole byte of validity bits before storing it
+  for (int64_t i = 0; i < length; i += 8) {
+    uint8_t bits = 0;
+    auto n = std::min<int64_t>(8, length - i);
+    for (int64_t j = 0; j < n; j++) {
+      int64_t row;
+      auto source = locate(i + j, &row);
+      bool valid = source >= 0 && (sources.validity[source] == nullptr ||
+                                   arrow::BitUtil::GetBit(sources.validity[source], row));
+      bits |= static_cast<uint8_t>(valid) << j;
+    }
+    bitmap[i >> 3] = bits;
+  }
+  *null_count = length - arrow::internal::CountSetBits(bitmap, 0, length);
+  *out = buffer;
+  return arrow::Status::OK();
+}
+
+template <typename CType, typename Locator>
+arrow::Status GatherPrimitive(arrow::MemoryPool* pool, int64_t length,
+                              const GatherSources& sources, const Locator& locate,
+                              std::vector<std::shared_ptr<arrow::Buffer>>* buffers) {
+  std::shared_ptr<arrow::Buffer> buffer;
+  ARROW_ASSIGN_OR_RAISE(buffer, arrow::AllocateBuffer(length * sizeof(CType), pool));
+  auto out_values = reinterpret_cast<CType*>(buffer->mutable_data());
+  for (int64_t i = 0; i < length; i++) {
+    int64_t row;
+    auto source = locate(i, &row);
+    out_values[i] = source < 0
+                        ? CType()
+                        : reinterpret_cast<const CType*>(sources.values[source])[row];
+  }
+  buffers->push_back(buffer);
+  return arrow::Status::OK();
+}
+
+template <typename Locator>
+arrow::Status GatherBoolean(arrow::MemoryPool* pool, int64_t length,
+                            const GatherSources& sources, const Locator& locate,
+                            std::vector<std::shared_ptr<arrow::Buffer>>* buffers) {
+  std::shared_ptr<arrow::Buffer> buffer;
+  ARROW_ASSIGN_OR_RAISE(buffer,
+                        arrow::AllocateBuffer(arrow::BitUtil::BytesForBits(length), pool));
+  auto out_bits = buffer->mutable_data();
+  for (int64_t i = 0; i < length; i += 8) {
+    uint8_t bits = 0;
+    auto n = std::min<int64_t>(8, length - i);
+    for (int64_t j = 0; j < n; j++) {
+      int64_t row;
+      auto source = locate(i + j, &row);
+      bool value = source >= 0 && arrow::BitUtil::GetBit(sources.values[source], row);
+      bits |= static_cast<uint8_t>(value) << j;
+    }
+    out_bits[i >> 3] = bits;
+  }
+  buffers->push_back(buffer);
+  return arrow::Status::OK();
+}
+
+template <typename Locator>
+arrow::Status GatherFixedSizeBinary(arrow::MemoryPool* pool, int64_t length,
+                                    int32_t byte_width, const GatherSources& sources,
+                                    const Locator& locate,
+                                    std::vector<std::shared_ptr<arrow::Buffer>>* buffers) {
+  std::shared_ptr<arrow::Buffer> buffer;
+  ARROW_ASSIGN_OR_RAISE(buffer, arrow::AllocateBuffer(length * byte_width, pool));
+  auto out_values = buffer->mutable_data();
+  for (int64_t i = 0; i < length; i++) {
+    int64_t row;
+    auto source = locate(i, &row);
+    if (source < 0) {
+      std::memset(out_values + i * byte_width, 0, byte_width);
+    } else {
+      std::memcpy(out_values + i * byte_width, sources.values[source] + row * byte_width,
+                  byte_width);
+    }
+  }
+  buffers->push_back(buffer);
+  return arrow::Status::OK();
+}
+
+// Two passes over the indices: size the offsets, then copy the value bytes
+template <typename Locator>
+arrow::Status GatherBinary(arrow::MemoryPool* pool, int64_t length,
+                           const GatherSources& sources, const Locator& locate,
+                           std::vector<std::shared_ptr<arrow::Buffer>>* buffers) {
+  std::shared_ptr<arrow::Buffer> offsets_buffer;
+  ARROW_ASSIGN_OR_RAISE(offsets_buffer,
+                        arrow::AllocateBuffer((length + 1) * sizeof(int32_t), pool));
+  auto out_offsets = reinterpret_cast<int32_t*>(offsets_buffer->mutable_data());
+  int64_t total = 0;
+  out_offsets[0] = 0;
+  for (int64_t i = 0; i < length; i++) {
+    int64_t row;
+    auto source = locate(i, &row);
+    if (source >= 0) {
+      auto offsets = reinterpret_cast<const int32_t*>(sources.values[source]);
+      total += offsets[row + 1] - offsets[row];
+    }
+    if (total > INT32_MAX) {
+      return arrow::Status::CapacityError("gathered binary data exceeds 2GB");
+    }
+    out_offsets[i + 1] = static_cast<int32_t>(total);
+  }
+
+  std::shared_ptr<arrow::Buffer> data_buffer;
+  ARROW_ASSIGN_OR_RAISE(data_buffer, arrow::AllocateBuffer(total, pool));
+  auto out_data = data_buffer->mutable_data();
+  for (int64_t i = 0; i < length; i++) {
+    int64_t row;
+    auto source = locate(i, &row);
+    if (source >= 0) {
+      auto offsets = reinterpret_cast<const int32_t*>(sources.values[source]);
+      std::memcpy(out_data + out_offsets[i], sources.binary[source] + offsets[row],
+                  out_offsets[i + 1] - out_offsets[i]);
+    }
+  }
+  buffers->push_back(offsets_buffer);
+  buffers->push_back(data_buffer);
+  return arrow::Status::OK();
+}
+
+template <typename Locator>
+arrow::Status Gather(arrow::MemoryPool* pool, const std::shared_ptr<arrow::DataType>& type,
+                     int64_t length, bool has_nulls, const GatherSources& sources,
+                     const Locator& locate, std::shared_ptr<arrow::Array>* out) {
+  std::vector<std::shared_ptr<arrow::Buffer>> buffers(1);
+  int64_t null_count;
+  RETURN_NOT_OK(GatherValidity(pool, length, has_nulls, sources, locate, &buffers[0],
+                               &null_count));
+  switch (type->id()) {
+#define PROCESS(TYPE_ID, CTYPE)                                                  \
+  case arrow::Type::TYPE_ID:                                                     \
+    RETURN_NOT_OK(GatherPrimitive<CTYPE>(pool, length, sources, locate, &buffers)); \
+    break;
+    PROCESS(UINT8, uint8_t)
+    PROCESS(INT8, int8_t)
+    PROCESS(UINT16, uint16_t)
+    PROCESS(INT16, int16_t)
+    PROCESS(UINT32, uint32_t)
+    PROCESS(INT32, int32_t)
+    PROCESS(UINT64, uint64_t)
+    PROCESS(INT64, int64_t)
+    PROCESS(FLOAT, float)
+    PROCESS(DOUBLE, double)
+    PROCESS(DATE32, int32_t)
+    PROCESS(DATE64, int64_t)
+    PROCESS(TIMESTAMP, int64_t)
+#undef PROCESS
+    case arrow::Type::BOOL:
+      RETURN_NOT_OK(GatherBoolean(pool, length, sources, locate, &buffers));
+      break;
+    case arrow::Type::STRING:
+    case arrow::Type::BINARY:
+      RETURN_NOT_OK(GatherBinary(pool, length, sources, locate, &buffers));
+      break;
+    case arrow::Type::FIXED_SIZE_BINARY:
+    case arrow::Type::DECIMAL: {
+      auto byte_width =
+          std::static_pointer_cast<arrow::FixedSizeBinaryType>(type)->byte_width();
+      RETURN_NOT_OK(
+          GatherFixedSizeBinary(pool, length, byte_width, sources, locate, &buffers));
+    } break;
+    default:
+      return arrow::Status::NotImplemented("Gather does not support type ",
+                                           type->ToString());
+  }
+  *out = arrow::MakeArray(arrow::ArrayData::Make(type, length, buffers, null_count));
+  return arrow::Status::OK();
+}
+
+}  // namespace
+
+arrow::Status GatherArrays(arrow::MemoryPool* pool, const arrow::ArrayVector& arrays,
+                           const std::vector<ArrayItemIndex>& indices,
+                           std::shared_ptr<arrow::Array>* out) {
+  if (arrays.empty()) {
+    return arrow::Status::Invalid("GatherArrays requires at least one source array");
+  }
+  GatherSources sources(arrays);
+  bool has_nulls = sources.has_nulls;
+  for (auto it = indices.begin(); !has_nulls && it != indices.end(); ++it) {
+    has_nulls = !it->valid;
+  }
+  BuildLocator locate{indices, sources};
+  return Gather(pool, arrays[0]->type(), indices.size(), has_nulls, sources, locate, out);
+}
+
+arrow::Status GatherArray(arrow::MemoryPool* pool, const std::shared_ptr<arrow::Array>& array,
+                          const std::vector<int32_t>& indices,
+                          std::shared_ptr<arrow::Array>* out) {
+  GatherSources sources({array});
+  ProbeLocator locate{indices, sources};
+  return Gather(pool, array->type(), indices.size(), sources.has_nulls, sources, locate,
+                out);
+}
+
+}  // namespace precompile
+}  // namespace sparkcolumnarplugin
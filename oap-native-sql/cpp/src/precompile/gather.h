@@ -0,0 +1,31 @@
+#pragma once
+
+#include <arrow/type_fwd.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "codegen/arrow_compute/ext/array_item_index.h"
+
+using namespace sparkcolumnarplugin::codegen::arrowcompute::extra;
+namespace sparkcolumnarplugin {
+namespace precompile {
+
+/// \brief Materialize rows of cached build side arrays into one output array.
+///
+/// indices[i] addresses row indices[i].id of arrays[indices[i].array_id]; an index
+/// with valid == false produces a null. The output is allocated once with exact
+/// size, values are copied with a typed loop and the validity bitmap is only built
+/// when a source array has nulls or an index is invalid.
+arrow::Status GatherArrays(arrow::MemoryPool* pool, const arrow::ArrayVector& arrays,
+                           const std::vector<ArrayItemIndex>& indices,
+                           std::shared_ptr<arrow::Array>* out);
+
+/// \brief Materialize rows indices[0], indices[1], ... of one probe side array.
+arrow::Status GatherArray(arrow::MemoryPool* pool, const std::shared_ptr<arrow::Array>& array,
+                          const std::vector<int32_t>& indices,
+                          std::shared_ptr<arrow::Array>* out);
+
+}  // namespace precompile
+}  // namespace sparkcolumnarplugin
@@ -0,0 +1,13 @@
+#pragma once
+// Headers shared by every generated kernel. CompileCodes precompiles this file
+// once per codegen directory and the generated sources include it first, so
+// the arrow headers and the header-only precompile templates are parsed once
+// rather than once per kernel.
+#include <arrow/builder.h>
+#include <arrow/compute/context.h>
+#include <arrow/record_batch.h>
+#include <arrow/type_traits.h>
+
+#include "precompile/bitmap.h"
+#include "precompile/typed_builder.h"
+#include "precompile/typed_hash_map.h"
@@ -0,0 +1,124 @@
+#include "precompile/spill.h"
+
+#include <arrow/array.h>
+#include <arrow/buffer.h>
+#include <arrow/filesystem/localfs.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/reader.h>
+#include <arrow/ipc/writer.h>
+#include <arrow/record_batch.h>
+#include <arrow/type.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace sparkcolumnarplugin {
+namespace precompile {
+
+namespace {
+
+int64_t ArrayDataBufferSize(const std::shared_ptr<arrow::ArrayData>& data) {
+  int64_t size = 0;
+  for (auto& buffer : data->buffers) {
+    if (buffer) size += buffer->size();
+  }
+  for (auto& child : data->child_data) {
+    size += ArrayDataBufferSize(child);
+  }
+  return size;
+}
+
+// Create an empty file named uniquely in dir
+arrow::Result<std::string> CreateSpillFile(const std::string& dir) {
+  auto fs = std::make_shared<arrow::fs::LocalFileSystem>();
+  ARROW_ASSIGN_OR_RAISE(auto dir_info, fs->GetFileInfo(dir));
+  if (dir_info.type() == arrow::fs::FileType::NotFound) {
+    RETURN_NOT_OK(fs->CreateDir(dir, true));
+  }
+  std::string path = dir + "/nativesql_spill_XXXXXX";
+  std::vector<char> name(path.begin(), path.end());
+  name.push_back('\0');
+  int fd = mkstemp(name.data());
+  if (fd < 0) {
+    return arrow::Status::IOError("Failed to create spill file in ", dir, ": ",
+                                  strerror(errno));
+  }
+  close(fd);
+  return std::string(name.data());
+}
+
+}  // namespace
+
+std::string GetSpillDir() {
+  const char* local_dirs = std::getenv("NATIVESQL_SPARK_LOCAL_DIRS");
+  if (local_dirs != nullptr && strlen(local_dirs) > 0) {
+    auto dirs = std::string(local_dirs);
+    return dirs.substr(0, dirs.find(','));
+  }
+  const char* tmp_dir = std::getenv("NATIVESQL_TMP_DIR");
+  if (tmp_dir != nullptr && strlen(tmp_dir) > 0) {
+    return std::string(tmp_dir);
+  }
+  return "/tmp";
+}
+
+int64_t GetSpillThreshold() {
+  int64_t threshold;
+  const char* env_threshold = std::getenv("NATIVESQL_SPILL_THRESHOLD");
+  if (env_threshold != nullptr) {
+    threshold = atoll(env_threshold);
+  } else {
+    threshold = 512LL << 20;
+  }
+  return threshold;
+}
+
+int64_t ArraysBufferSize(const arrow::ArrayVector& arrays) {
+  int64_t size = 0;
+  for (auto& array : arrays) {
+    size += ArrayDataBufferSize(array->data());
+  }
+  return size;
+}
+
+arrow::Status SpillArrays(const std::string& dir, const arrow::ArrayVector& arrays,
+                          int64_t offset, int64_t length, arrow::ArrayVector* out) {
+  std::vector<std::shared_ptr<arrow::Field>> fields;
+  arrow::ArrayVector columns;
+  for (size_t i = 0; i < arrays.size(); i++) {
+    fields.push_back(arrow::field("c" + std::to_string(i), arrays[i]->type()));
+    columns.push_back(arrays[i]->Slice(offset, length));
+  }
+  auto schema = arrow::schema(fields);
+  auto batch = arrow::RecordBatch::Make(schema, length, columns);
+
+  ARROW_ASSIGN_OR_RAISE(auto path, CreateSpillFile(dir));
+  ARROW_ASSIGN_OR_RAISE(auto os, arrow::io::FileOutputStream::Open(path));
+  auto options = arrow::ipc::IpcWriteOptions::Defaults();
+  options.use_threads = false;
+  ARROW_ASSIGN_OR_RAISE(auto writer, arrow::ipc::NewFileWriter(os.get(), schema, options));
+  RETURN_NOT_OK(writer->WriteRecordBatch(*batch));
+  RETURN_NOT_OK(writer->Close());
+  RETURN_NOT_OK(os->Close());
+
+  // buffers read from the map keep it alive after the file is closed and unlinked
+  ARROW_ASSIGN_OR_RAISE(auto file, arrow::io::MemoryMappedFile::Open(
+                                       path, arrow::io::FileMode::READ));
+  ARROW_ASSIGN_OR_RAISE(auto reader, arrow::ipc::RecordBatchFileReader::Open(file.get()));
+  ARROW_ASSIGN_OR_RAISE(auto spilled, reader->ReadRecordBatch(0));
+  RETURN_NOT_OK(file->Close());
+  auto fs = std::make_shared<arrow::fs::LocalFileSystem>();
+  RETURN_NOT_OK(fs->DeleteFile(path));
+
+  out->clear();
+  for (int i = 0; i < spilled->num_columns(); i++) {
+    out->push_back(spilled->column(i));
+  }
+  return arrow::Status::OK();
+}
+
+}  // namespace precompile
+}  // namespace sparkcolumnarplugin
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <arrow/type_fwd.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace sparkcolumnarplugin {
+namespace precompile {
+
+/// \brief Directory for spill files: the first of NATIVESQL_SPARK_LOCAL_DIRS, else
+/// NATIVESQL_TMP_DIR, else /tmp.
+std::string GetSpillDir();
+
+/// \brief Bytes of buffered rows above which an operator spills, read from
+/// NATIVESQL_SPILL_THRESHOLD, 512MB by default.
+int64_t GetSpillThreshold();
+
+/// \brief Bytes held by the buffers of arrays, a sliced array counts in full.
+int64_t ArraysBufferSize(const arrow::ArrayVector& arrays);
+
+/// \brief Write rows [offset, offset + length) of arrays to an Arrow IPC file in dir
+/// and read them back from a memory map of it.
+///
+/// The file is unlinked once mapped, so the returned arrays hold no heap memory: their
+/// pages are read from disk on access and may be dropped again under memory pressure.
+arrow::Status SpillArrays(const std::string& dir, const arrow::ArrayVector& arrays,
+                          int64_t offset, int64_t length, arrow::ArrayVector* out);
+
+}  // namespace precompile
+}  // namespace sparkcolumnarplugin
@@ -0,0 +1,50 @@
+#pragma once
+#include <arrow/builder.h>
+#include <arrow/type_traits.h>
+
+#include <string>
+
+namespace sparkcolumnarplugin {
+namespace precompile {
+
+/// Header-only counterpart of the builders in builder.h. Generated code calls
+/// Append once per row, so keeping the arrow builder visible here lets the
+/// codegen compiler inline those calls instead of crossing a pimpl boundary.
+/// Only types with a parameter-free type singleton are supported; decimal
+/// still goes through precompile::Decimal128Builder.
+template <typename DataType>
+class TypedBuilder {
+ public:
+  using BuilderType = typename arrow::TypeTraits<DataType>::BuilderType;
+
+  explicit TypedBuilder(arrow::MemoryPool* pool)
+      : builder_(arrow::TypeTraits<DataType>::type_singleton(), pool) {}
+
+  template <typename T>
+  inline arrow::Status Append(const T& val) {
+    return builder_.Append(val);
+  }
+  /// Same as precompile::StringBuilder::AppendString, for string builders only
+  inline arrow::Status AppendString(const std::string& val) { return builder_.Append(val); }
+  inline arrow::Status AppendNull() { return builder_.AppendNull(); }
+  inline arrow::Status AppendNulls(int64_t length) { return builder_.AppendNulls(length); }
+  inline arrow::Status Reserve(int64_t length) { return builder_.Reserve(length); }
+  /// Appends without a capacity check, the caller must have called Reserve
+  template <typename T>
+  inline void UnsafeAppend(const T& val) {
+    builder_.UnsafeAppend(val);
+  }
+  inline void UnsafeAppendNull() { builder_.UnsafeAppendNull(); }
+  arrow::Status Finish(std::shared_ptr<arrow::Array>* out) { return builder_.Finish(out); }
+  arrow::Status Reset() {
+    builder_.Reset();
+    return arrow::Status::OK();
+  }
+  int64_t length() const { return builder_.length(); }
+
+ private:
+  BuilderType builder_;
+};
+
+}  // namespace precompile
+}  // namespace sparkcolumnarplugin
@@ -0,0 +1,16 @@
+#pragma once
+#include <arrow/type_traits.h>
+
+#include "third_party/arrow/utils/hashing.h"
+
+namespace sparkcolumnarplugin {
+namespace precompile {
+
+/// Header-only counterpart of the hash maps in hash_map.h. The memo table is
+/// used directly, so GetOrInsert and its on_found/on_not_found callbacks can be
+/// inlined into the generated per-row loop.
+template <typename DataType>
+using TypedHashMap = typename arrow::internal::HashTraits<DataType>::MemoTableType;
+
+}  // namespace precompile
+}  // namespace sparkcolumnarplugin
@@ -24,6 +24,7 @@
 #include <gandiva/projector.h>
 #include <gandiva/tree_expr_builder.h>
 
+#include "precompile/bitmap.h"
 #include "shuffle/splitter.h"
 #include "shuffle/utils.h"
 #include "utils/macros.h"
@@ -768,15 +769,39 @@ arrow::Status Splitter::SplitFixedWidthValidityBuffer(const arrow::RecordBatch&
       auto src_addr = const_cast<uint8_t*>(rb.column_data(col_idx)->buffers[0]->data());
       std::fill(std::begin(partition_buffer_idx_offset_),
                 std::end(partition_buffer_idx_offset_), 0);
-      for (auto row = 0; row < num_rows; ++row) {
-        auto pid = partition_id_[row];
-        auto dst_offset =
-            partition_buffer_idx_base_[pid] + partition_buffer_idx_offset_[pid];
-        dst_addrs[pid][dst_offset >> 3] ^=
-            (dst_addrs[pid][dst_offset >> 3] >> (dst_offset & 7) ^
-             src_addr[row >> 3] >> (row & 7))
-            << (dst_offset & 7);
-        partition_buffer_idx_offset_[pid]++;
+      // source validity is read 64 rows at a time: rows of an all-valid or
+      // all-null word set or clear their destination bit, only mixed words copy
+      // the bit out of the word
+      for (int64_t base = 0; base < num_rows; base += precompile::kBitmapWordBits) {
+        auto n = std::min(precompile::kBitmapWordBits, num_rows - base);
+        auto valid_bits = precompile::LoadBitmapWord(src_addr, base, n);
+        if (precompile::IsAllSet(valid_bits, n)) {
+          for (auto row = base; row < base + n; ++row) {
+            auto pid = partition_id_[row];
+            auto dst_offset =
+                partition_buffer_idx_base_[pid] + partition_buffer_idx_offset_[pid];
+            arrow::BitUtil::SetBit(dst_addrs[pid], dst_offset);
+            partition_buffer_idx_offset_[pid]++;
+          }
+        } else if (valid_bits == 0) {
+          for (auto row = base; row < base + n; ++row) {
+            auto pid = partition_id_[row];
+            auto dst_offset =
+                partition_buffer_idx_base_[pid] + partition_buffer_idx_offset_[pid];
+            arrow::BitUtil::ClearBit(dst_addrs[pid], dst_offset);
+            partition_buffer_idx_offset_[pid]++;
+          }
+        } else {
+          for (auto row = base; row < base + n; ++row, valid_bits >>= 1) {
+            auto pid = partition_id_[row];
+            auto dst_offset =
+                partition_buffer_idx_base_[pid] + partition_buffer_idx_offset_[pid];
+            dst_addrs[pid][dst_offset >> 3] ^=
+                ((dst_addrs[pid][dst_offset >> 3] >> (dst_offset & 7) ^ valid_bits) & 1)
+                << (dst_offset & 7);
+            partition_buffer_idx_offset_[pid]++;
+          }
+        }
       }
     }
   }
@@ -814,15 +839,14 @@ arrow::Status Splitter::AppendBinary(
       RETURN_NOT_OK(dst_builders[partition_id_[row]]->Append(value, length));
     }
   } else {
-    for (auto row = 0; row < num_rows; ++row) {
-      if (src_arr->IsValid(row)) {
-        offset_type length;
-        auto value = src_arr->GetValue(row, &length);
-        RETURN_NOT_OK(dst_builders[partition_id_[row]]->Append(value, length));
-      } else {
-        RETURN_NOT_OK(dst_builders[partition_id_[row]]->AppendNull());
-      }
-    }
+    RETURN_NOT_OK(precompile::VisitValidity(
+        src_arr->null_bitmap_data(), src_arr->offset(), num_rows,
+        [&](int64_t row) {
+          offset_type length;
+          auto value = src_arr->GetValue(row, &length);
+          return dst_builders[partition_id_[row]]->Append(value, length);
+        },
+        [&](int64_t row) { return dst_builders[partition_id_[row]]->AppendNull(); }));
   }
   return arrow::Status::OK();
 }
@@ -20,6 +20,7 @@
 #include <arrow/record_batch.h>
 #include <gtest/gtest.h>
 
+#include <cstdlib>
 #include <memory>
 
 #include "codegen/code_generator.h"
@@ -114,6 +115,7 @@ TEST(TestArrowComputeMergeJoin, JoinTestUsingInnerJoin) {
   for (auto batch : table_0) {
     ASSERT_NOT_OK(expr_probe->evaluate(batch, &dummy_result_batches));
   }
+  ASSERT_NOT_OK(expr_probe->evaluate(table_0[0]->Slice(0, 0), &dummy_result_batches));
   std::shared_ptr<ResultIterator<arrow::RecordBatch>> probe_result_iterator;
   std::shared_ptr<ResultIteratorBase> probe_result_iterator_base;
   ASSERT_NOT_OK(expr_probe->finish(&probe_result_iterator_base));
@@ -205,9 +207,9 @@ TEST(TestArrowComputeMergeJoin, JoinTestUsingOuterJoin) {
   std::vector<std::shared_ptr<RecordBatch>> expected_table;
   std::shared_ptr<arrow::RecordBatch> expected_result;
   std::vector<std::string> expected_result_string = {
-      "[0, 0, null, 2, 2, 3, null, 5, null]", "[0, 0, null, 2, 2, 3, null, 5, null]",
-      "[0, 0, null, 2, 2, 3, null, 5, null]", "[0, 0, 1, 2, 2, 3, 4, 5, 6]",
-      "[0, 0, 1, 2, 2, 3, 4, 5, 6]"};
+      "[null, null, 2, 2, 3, null, 5, null]", "[null, null, 2, 2, 3, null, 5, null]",
+      "[null, null, 2, 2, 3, null, 5, null]", "[null, 1, 2, 2, 3, 4, 5, 6]",
+      "[null, 1, 2, 2, 3, 4, 5, 6]"};
   auto res_sch = arrow::schema({f_res, f_res, f_res, f_res, f_res});
   MakeInputBatch(expected_result_string, res_sch, &expected_result);
   expected_table.push_back(expected_result);
@@ -222,6 +224,7 @@ TEST(TestArrowComputeMergeJoin, JoinTestUsingOuterJoin) {
   for (auto batch : table_0) {
     ASSERT_NOT_OK(expr_probe->evaluate(batch, &dummy_result_batches));
   }
+  ASSERT_NOT_OK(expr_probe->evaluate(table_0[0]->Slice(0, 0), &dummy_result_batches));
   std::shared_ptr<ResultIterator<arrow::RecordBatch>> probe_result_iterator;
   std::shared_ptr<ResultIteratorBase> probe_result_iterator_base;
   ASSERT_NOT_OK(expr_probe->finish(&probe_result_iterator_base));
@@ -323,6 +326,7 @@ TEST(TestArrowComputeMergeJoin, JoinTestUsingAntiJoin) {
   for (auto batch : table_0) {
     ASSERT_NOT_OK(expr_probe->evaluate(batch, &dummy_result_batches));
   }
+  ASSERT_NOT_OK(expr_probe->evaluate(table_0[0]->Slice(0, 0), &dummy_result_batches));
   std::shared_ptr<ResultIterator<arrow::RecordBatch>> probe_result_iterator;
   std::shared_ptr<ResultIteratorBase> probe_result_iterator_base;
   ASSERT_NOT_OK(expr_probe->finish(&probe_result_iterator_base));
@@ -424,6 +428,7 @@ TEST(TestArrowComputeMergeJoin, JoinTestUsingSemiJoin) {
   for (auto batch : table_0) {
     ASSERT_NOT_OK(expr_probe->evaluate(batch, &dummy_result_batches));
   }
+  ASSERT_NOT_OK(expr_probe->evaluate(table_0[0]->Slice(0, 0), &dummy_result_batches));
   std::shared_ptr<ResultIterator<arrow::RecordBatch>> probe_result_iterator;
   std::shared_ptr<ResultIteratorBase> probe_result_iterator_base;
   ASSERT_NOT_OK(expr_probe->finish(&probe_result_iterator_base));
@@ -530,6 +535,7 @@ TEST(TestArrowComputeMergeJoin, JoinTestUsingSemiJoinWithCondition) {
   for (auto batch : table_0) {
     ASSERT_NOT_OK(expr_probe->evaluate(batch, &dummy_result_batches));
   }
+  ASSERT_NOT_OK(expr_probe->evaluate(table_0[0]->Slice(0, 0), &dummy_result_batches));
   std::shared_ptr<ResultIterator<arrow::RecordBatch>> probe_result_iterator;
   std::shared_ptr<ResultIteratorBase> probe_result_iterator_base;
   ASSERT_NOT_OK(expr_probe->finish(&probe_result_iterator_base));
@@ -638,6 +644,7 @@ TEST(TestArrowComputeMergeJoin, JoinTestUsingInnerJoinWithCondition) {
   for (auto batch : table_0) {
     ASSERT_NOT_OK(expr_probe->evaluate(batch, &dummy_result_batches));
   }
+  ASSERT_NOT_OK(expr_probe->evaluate(table_0[0]->Slice(0, 0), &dummy_result_batches));
   std::shared_ptr<ResultIterator<arrow::RecordBatch>> probe_result_iterator;
   std::shared_ptr<ResultIteratorBase> probe_result_iterator_base;
   ASSERT_NOT_OK(expr_probe->finish(&probe_result_iterator_base));
@@ -749,6 +756,7 @@ TEST(TestArrowComputeMergeJoin, JoinTestWithTwoKeysUsingInnerJoin) {
   for (auto batch : table_0) {
     ASSERT_NOT_OK(expr_probe->evaluate(batch, &dummy_result_batches));
   }
+  ASSERT_NOT_OK(expr_probe->evaluate(table_0[0]->Slice(0, 0), &dummy_result_batches));
   std::shared_ptr<ResultIterator<arrow::RecordBatch>> probe_result_iterator;
   std::shared_ptr<ResultIteratorBase> probe_result_iterator_base;
   ASSERT_NOT_OK(expr_probe->finish(&probe_result_iterator_base));
@@ -854,6 +862,7 @@ TEST(TestArrowComputeMergeJoin, JoinTestUsingAntiJoinWithCondition) {
   for (auto batch : table_0) {
     ASSERT_NOT_OK(expr_probe->evaluate(batch, &dummy_result_batches));
   }
+  ASSERT_NOT_OK(expr_probe->evaluate(table_0[0]->Slice(0, 0), &dummy_result_batches));
   std::shared_ptr<ResultIterator<arrow::RecordBatch>> probe_result_iterator;
   std::shared_ptr<ResultIteratorBase> probe_result_iterator_base;
   ASSERT_NOT_OK(expr_probe->finish(&probe_result_iterator_base));
@@ -875,5 +884,260 @@ TEST(TestArrowComputeMergeJoin, JoinTestUsingAntiJoinWithCondition) {
   }
 }
 
+TEST(TestArrowComputeMergeJoin, JoinTestUsingInnerJoinWithStreamingLeft) {
+  ////////////////////// prepare expr_vector ///////////////////////
+  auto table0_f0 = field("table0_f0", uint32());
+  auto table0_f1 = field("table0_f1", uint32());
+  auto table0_f2 = field("table0_f2", uint32());
+  auto table1_f0 = field("table1_f0", uint32());
+  auto table1_f1 = field("table1_f1", uint32());
+
+  auto n_left = TreeExprBuilder::MakeFunction(
+      "codegen_left_schema",
+      {TreeExprBuilder::MakeField(table0_f0), TreeExprBuilder::MakeField(table0_f1),
+       TreeExprBuilder::MakeField(table0_f2)},
+      uint32());
+  auto n_right = TreeExprBuilder::MakeFunction(
+      "codegen_right_schema",
+      {TreeExprBuilder::MakeField(table1_f0), TreeExprBuilder::MakeField(table1_f1)},
+      uint32());
+  auto f_res = field("res", uint32());
+
+  auto n_left_key = TreeExprBuilder::MakeFunction(
+      "codegen_left_key_schema", {TreeExprBuilder::MakeField(table0_f0)}, uint32());
+  auto n_right_key = TreeExprBuilder::MakeFunction(
+      "codegen_right_key_schema", {TreeExprBuilder::MakeField(table1_f0)}, uint32());
+  auto n_probeArrays = TreeExprBuilder::MakeFunction("conditionedJoinArraysInner",
+                                                     {n_left_key, n_right_key}, uint32());
+  auto n_codegen_probe = TreeExprBuilder::MakeFunction(
+      "codegen_withTwoInputs", {n_probeArrays, n_left, n_right}, uint32());
+  auto probeArrays_expr = TreeExprBuilder::MakeExpression(n_codegen_probe, f_res);
+
+  auto schema_table_0 = arrow::schema({table0_f0, table0_f1, table0_f2});
+  auto schema_table_1 = arrow::schema({table1_f0, table1_f1});
+  ///////////////////// Calculation //////////////////
+  std::shared_ptr<CodeGenerator> expr_probe;
+  ASSERT_NOT_OK(CreateCodeGenerator(
+      schema_table_0, {probeArrays_expr},
+      {table0_f0, table0_f1, table0_f2, table1_f0, table1_f1}, &expr_probe, true));
+  std::shared_ptr<arrow::RecordBatch> input_batch;
+
+  std::vector<std::shared_ptr<arrow::RecordBatch>> dummy_result_batches;
+
+  std::vector<std::shared_ptr<arrow::RecordBatch>> table_0;
+  std::vector<std::shared_ptr<arrow::RecordBatch>> table_1;
+
+  std::vector<std::string> input_data_string = {"[1, 3, 3]", "[1, 3, 3]", "[1, 3, 3]"};
+  MakeInputBatch(input_data_string, schema_table_0, &input_batch);
+  table_0.push_back(input_batch);
+
+  input_data_string = {"[3, 5, 8]", "[3, 5, 8]", "[3, 5, 8]"};
+  MakeInputBatch(input_data_string, schema_table_0, &input_batch);
+  table_0.push_back(input_batch);
+
+  std::vector<std::string> input_data_2_string = {"[1, 3, 4]", "[1, 3, 4]"};
+  MakeInputBatch(input_data_2_string, schema_table_1, &input_batch);
+  table_1.push_back(input_batch);
+
+  input_data_2_string = {"[5, 9]", "[5, 9]"};
+  MakeInputBatch(input_data_2_string, schema_table_1, &input_batch);
+  table_1.push_back(input_batch);
+
+  //////////////////////// data prepared /////////////////////////
+
+  std::vector<std::shared_ptr<RecordBatch>> expected_table;
+  std::shared_ptr<arrow::RecordBatch> expected_result;
+  auto res_sch = arrow::schema({f_res, f_res, f_res, f_res, f_res});
+  std::vector<std::string> expected_result_string = {"[1]", "[1]", "[1]", "[1]", "[1]"};
+  MakeInputBatch(expected_result_string, res_sch, &expected_result);
+  expected_table.push_back(expected_result);
+
+  expected_result_string = {"[3, 3, 3]", "[3, 3, 3]", "[3, 3, 3]", "[3, 3, 3]",
+                            "[3, 3, 3]"};
+  MakeInputBatch(expected_result_string, res_sch, &expected_result);
+  expected_table.push_back(expected_result);
+
+  expected_result_string = {"[5]", "[5]", "[5]", "[5]", "[5]"};
+  MakeInputBatch(expected_result_string, res_sch, &expected_result);
+  expected_table.push_back(expected_result);
+
+  ////////////////////// evaluate //////////////////////
+  std::shared_ptr<ResultIterator<arrow::RecordBatch>> probe_result_iterator;
+  std::shared_ptr<ResultIteratorBase> probe_result_iterator_base;
+  ASSERT_NOT_OK(expr_probe->finish(&probe_result_iterator_base));
+  probe_result_iterator = std::dynamic_pointer_cast<ResultIterator<arrow::RecordBatch>>(
+      probe_result_iterator_base);
+
+  auto get_columns = [](const std::shared_ptr<arrow::RecordBatch>& batch) {
+    std::vector<std::shared_ptr<arrow::Array>> input;
+    for (int i = 0; i < batch->num_columns(); i++) {
+      input.push_back(batch->column(i));
+    }
+    return input;
+  };
+  auto empty_right = get_columns(table_1[0]->Slice(0, 0));
+  std::shared_ptr<arrow::RecordBatch> result_batch;
+
+  // right rows 3 and 4 wait for the rest of key group 3
+  ASSERT_NOT_OK(expr_probe->evaluate(table_0[0], &dummy_result_batches));
+  ASSERT_NOT_OK(probe_result_iterator->Process(get_columns(table_1[0]), &result_batch));
+  ASSERT_NOT_OK(Equals(*(expected_table[0]).get(), *result_batch.get()));
+  ASSERT_TRUE(probe_result_iterator->NeedsMoreInput());
+
+  ASSERT_NOT_OK(expr_probe->evaluate(table_0[1], &dummy_result_batches));
+  ASSERT_NOT_OK(probe_result_iterator->Process(empty_right, &result_batch));
+  ASSERT_NOT_OK(Equals(*(expected_table[1]).get(), *result_batch.get()));
+  ASSERT_FALSE(probe_result_iterator->NeedsMoreInput());
+  // the first left batch is behind the cursor and no longer referenced
+  ASSERT_EQ(probe_result_iterator->NumRetainedInputs(), 1);
+
+  // right row 9 is only resolved by the end of left input
+  ASSERT_NOT_OK(probe_result_iterator->Process(get_columns(table_1[1]), &result_batch));
+  ASSERT_NOT_OK(Equals(*(expected_table[2]).get(), *result_batch.get()));
+  ASSERT_TRUE(probe_result_iterator->NeedsMoreInput());
+
+  ASSERT_NOT_OK(expr_probe->evaluate(table_0[0]->Slice(0, 0), &dummy_result_batches));
+  ASSERT_NOT_OK(probe_result_iterator->Process(empty_right, &result_batch));
+  ASSERT_EQ(result_batch->num_rows(), 0);
+  ASSERT_FALSE(probe_result_iterator->NeedsMoreInput());
+  ASSERT_EQ(probe_result_iterator->NumRetainedInputs(), 1);
+}
+
+TEST(TestArrowComputeMergeJoin, JoinTestUsingInnerJoinWithSpilledKeyGroup) {
+  ////////////////////// prepare expr_vector ///////////////////////
+  auto table0_f0 = field("table0_f0", uint32());
+  auto table0_f1 = field("table0_f1", uint32());
+  auto table0_f2 = field("table0_f2", uint32());
+  auto table1_f0 = field("table1_f0", uint32());
+  auto table1_f1 = field("table1_f1", uint32());
+
+  auto n_left = TreeExprBuilder::MakeFunction(
+      "codegen_left_schema",
+      {TreeExprBuilder::MakeField(table0_f0), TreeExprBuilder::MakeField(table0_f1),
+       TreeExprBuilder::MakeField(table0_f2)},
+      uint32());
+  auto n_right = TreeExprBuilder::MakeFunction(
+      "codegen_right_schema",
+      {TreeExprBuilder::MakeField(table1_f0), TreeExprBuilder::MakeField(table1_f1)},
+      uint32());
+  auto f_res = field("res", uint32());
+
+  auto n_left_key = TreeExprBuilder::MakeFunction(
+      "codegen_left_key_schema", {TreeExprBuilder::MakeField(table0_f0)}, uint32());
+  auto n_right_key = TreeExprBuilder::MakeFunction(
+      "codegen_right_key_schema", {TreeExprBuilder::MakeField(table1_f0)}, uint32());
+  auto n_probeArrays = TreeExprBuilder::MakeFunction("conditionedJoinArraysInner",
+                                                     {n_left_key, n_right_key}, uint32());
+  auto n_codegen_probe = TreeExprBuilder::MakeFunction(
+      "codegen_withTwoInputs", {n_probeArrays, n_left, n_right}, uint32());
+  auto probeArrays_expr = TreeExprBuilder::MakeExpression(n_codegen_probe, f_res);
+
+  auto schema_table_0 = arrow::schema({table0_f0, table0_f1, table0_f2});
+  auto schema_table_1 = arrow::schema({table1_f0, table1_f1});
+  ///////////////////// Calculation //////////////////
+  std::shared_ptr<CodeGenerator> expr_probe;
+  ASSERT_NOT_OK(CreateCodeGenerator(
+      schema_table_0, {probeArrays_expr},
+      {table0_f0, table0_f1, table0_f2, table1_f0, table1_f1}, &expr_probe, true));
+  std::shared_ptr<arrow::RecordBatch> input_batch;
+
+  std::vector<std::shared_ptr<arrow::RecordBatch>> dummy_result_batches;
+
+  std::vector<std::shared_ptr<arrow::RecordBatch>> table_0;
+  std::vector<std::shared_ptr<arrow::RecordBatch>> table_1;
+
+  // key group 3 spans four left batches
+  std::vector<std::string> input_data_string = {"[1, 3, 3]", "[1, 3, 3]", "[1, 3, 3]"};
+  MakeInputBatch(input_data_string, schema_table_0, &input_batch);
+  table_0.push_back(input_batch);
+
+  input_data_string = {"[3, 3, 3]", "[3, 3, 3]", "[3, 3, 3]"};
+  MakeInputBatch(input_data_string, schema_table_0, &input_batch);
+  table_0.push_back(input_batch);
+  table_0.push_back(input_batch);
+
+  input_data_string = {"[3, 5, 8]", "[3, 5, 8]", "[3, 5, 8]"};
+  MakeInputBatch(input_data_string, schema_table_0, &input_batch);
+  table_0.push_back(input_batch);
+
+  std::vector<std::string> input_data_2_string = {"[1, 3, 4]", "[1, 3, 4]"};
+  MakeInputBatch(input_data_2_string, schema_table_1, &input_batch);
+  table_1.push_back(input_batch);
+
+  input_data_2_string = {"[5, 9]", "[5, 9]"};
+  MakeInputBatch(input_data_2_string, schema_table_1, &input_batch);
+  table_1.push_back(input_batch);
+
+  //////////////////////// data prepared /////////////////////////
+
+  std::vector<std::shared_ptr<RecordBatch>> expected_table;
+  std::shared_ptr<arrow::RecordBatch> expected_result;
+  auto res_sch = arrow::schema({f_res, f_res, f_res, f_res, f_res});
+  std::vector<std::string> expected_result_string = {"[1]", "[1]", "[1]", "[1]", "[1]"};
+  MakeInputBatch(expected_result_string, res_sch, &expected_result);
+  expected_table.push_back(expected_result);
+
+  std::string threes = "[3, 3, 3, 3, 3, 3, 3, 3, 3]";
+  expected_result_string = {threes, threes, threes, threes, threes};
+  MakeInputBatch(expected_result_string, res_sch, &expected_result);
+  expected_table.push_back(expected_result);
+
+  expected_result_string = {"[5]", "[5]", "[5]", "[5]", "[5]"};
+  MakeInputBatch(expected_result_string, res_sch, &expected_result);
+  expected_table.push_back(expected_result);
+
+  ////////////////////// evaluate //////////////////////
+  // every buffered batch but the newest one goes to a spill file
+  setenv("NATIVESQL_SPILL_THRESHOLD", "1", 1);
+  std::shared_ptr<ResultIterator<arrow::RecordBatch>> probe_result_iterator;
+  std::shared_ptr<ResultIteratorBase> probe_result_iterator_base;
+  ASSERT_NOT_OK(expr_probe->finish(&probe_result_iterator_base));
+  unsetenv("NATIVESQL_SPILL_THRESHOLD");
+  probe_result_iterator = std::dynamic_pointer_cast<ResultIterator<arrow::RecordBatch>>(
+      probe_result_iterator_base);
+
+  auto get_columns = [](const std::shared_ptr<arrow::RecordBatch>& batch) {
+    std::vector<std::shared_ptr<arrow::Array>> input;
+    for (int i = 0; i < batch->num_columns(); i++) {
+      input.push_back(batch->column(i));
+    }
+    return input;
+  };
+  auto empty_right = get_columns(table_1[0]->Slice(0, 0));
+  std::shared_ptr<arrow::RecordBatch> result_batch;
+
+  // right rows 3 and 4 are deferred to a spill file until key group 3 is complete
+  ASSERT_NOT_OK(expr_probe->evaluate(table_0[0], &dummy_result_batches));
+  ASSERT_NOT_OK(probe_result_iterator->Process(get_columns(table_1[0]), &result_batch));
+  ASSERT_NOT_OK(Equals(*(expected_table[0]).get(), *result_batch.get()));
+  ASSERT_TRUE(probe_result_iterator->NeedsMoreInput());
+
+  // the group stays buffered, but only its newest batch in caller memory
+  for (int i = 1; i < 3; i++) {
+    ASSERT_NOT_OK(expr_probe->evaluate(table_0[i], &dummy_result_batches));
+    ASSERT_EQ(probe_result_iterator->NumRetainedInputs(), 1);
+    ASSERT_NOT_OK(probe_result_iterator->Process(empty_right, &result_batch));
+    ASSERT_EQ(result_batch->num_rows(), 0);
+    ASSERT_TRUE(probe_result_iterator->NeedsMoreInput());
+  }
+
+  // the group is read back from the spill files once its end is seen
+  ASSERT_NOT_OK(expr_probe->evaluate(table_0[3], &dummy_result_batches));
+  ASSERT_EQ(probe_result_iterator->NumRetainedInputs(), 1);
+  ASSERT_NOT_OK(probe_result_iterator->Process(empty_right, &result_batch));
+  ASSERT_NOT_OK(Equals(*(expected_table[1]).get(), *result_batch.get()));
+  ASSERT_FALSE(probe_result_iterator->NeedsMoreInput());
+  ASSERT_EQ(probe_result_iterator->NumRetainedInputs(), 1);
+
+  ASSERT_NOT_OK(probe_result_iterator->Process(get_columns(table_1[1]), &result_batch));
+  ASSERT_NOT_OK(Equals(*(expected_table[2]).get(), *result_batch.get()));
+  ASSERT_TRUE(probe_result_iterator->NeedsMoreInput());
+
+  ASSERT_NOT_OK(expr_probe->evaluate(table_0[0]->Slice(0, 0), &dummy_result_batches));
+  ASSERT_NOT_OK(probe_result_iterator->Process(empty_right, &result_batch));
+  ASSERT_EQ(result_batch->num_rows(), 0);
+  ASSERT_FALSE(probe_result_iterator->NeedsMoreInput());
+}
+
 }  // namespace codegen
 }  // namespace sparkcolumnarplugin
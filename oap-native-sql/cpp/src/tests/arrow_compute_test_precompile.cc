@@ -15,11 +15,17 @@
  * limitations under the License.
  */
 
+#include <arrow/builder.h>
 #include <arrow/record_batch.h>
 #include <arrow/type.h>
 #include <gtest/gtest.h>
 
 #include "precompile/array.h"
+#include "precompile/batch_builder.h"
+#include "precompile/bitmap.h"
+#include "precompile/gather.h"
+#include "precompile/typed_builder.h"
+#include "precompile/typed_hash_map.h"
 #include "tests/test_utils.h"
 
 namespace sparkcolumnarplugin {
@@ -41,5 +47,210 @@ TEST(TestArrowCompute, BooleanArrayTest) {
     }
   }
 }
+
+TEST(TestArrowCompute, GatherArraysTest) {
+  auto sch = arrow::schema(
+      {field("int_col", arrow::int32()), field("str_col", arrow::utf8()),
+       field("bool_col", arrow::boolean())});
+  std::shared_ptr<arrow::RecordBatch> build_0;
+  MakeInputBatch({"[1, null, 3]", R"(["a", "bb", null])", "[true, false, null]"}, sch,
+                 &build_0);
+  std::shared_ptr<arrow::RecordBatch> build_1;
+  MakeInputBatch({"[4, 5]", R"(["ccc", "d"])", "[false, true]"}, sch, &build_1);
+
+  // invalid indices come from unmatched rows of an outer join
+  std::vector<ArrayItemIndex> indices = {
+      ArrayItemIndex(1, 0), ArrayItemIndex(0, 1), ArrayItemIndex(false),
+      ArrayItemIndex(0, 0), ArrayItemIndex(1, 1), ArrayItemIndex(0, 2)};
+  std::vector<std::shared_ptr<arrow::Array>> out_list;
+  for (int i = 0; i < sch->num_fields(); i++) {
+    std::shared_ptr<arrow::Array> out;
+    ASSERT_NOT_OK(precompile::GatherArrays(arrow::default_memory_pool(),
+                                           {build_0->column(i), build_1->column(i)},
+                                           indices, &out));
+    out_list.push_back(out);
+  }
+  auto result = arrow::RecordBatch::Make(sch, indices.size(), out_list);
+
+  std::shared_ptr<arrow::RecordBatch> expected;
+  MakeInputBatch({"[4, null, null, 1, 5, 3]", R"(["ccc", "bb", null, "a", "d", null])",
+                  "[false, false, null, true, true, null]"},
+                 sch, &expected);
+  ASSERT_NOT_OK(Equals(*expected.get(), *result.get()));
+}
+
+TEST(TestArrowCompute, GatherArrayTest) {
+  auto sch = arrow::schema({field("int_col", arrow::int64())});
+  std::shared_ptr<arrow::RecordBatch> probe;
+  MakeInputBatch({"[10, 11, 12, 13, 14, 15]"}, sch, &probe);
+
+  // a sliced probe batch reads through the array offset
+  std::shared_ptr<arrow::Array> out;
+  ASSERT_NOT_OK(precompile::GatherArray(arrow::default_memory_pool(),
+                                        probe->column(0)->Slice(2), {0, 0, 3, 1}, &out));
+  auto result = arrow::RecordBatch::Make(sch, out->length(), {out});
+
+  std::shared_ptr<arrow::RecordBatch> expected;
+  MakeInputBatch({"[12, 12, 15, 13]"}, sch, &expected);
+  ASSERT_NOT_OK(Equals(*expected.get(), *result.get()));
+}
+
+TEST(TestArrowCompute, TypedBuilderTest) {
+  auto sch =
+      arrow::schema({field("int_col", arrow::int32()), field("str_col", arrow::utf8())});
+  precompile::TypedBuilder<arrow::Int32Type> int_builder(arrow::default_memory_pool());
+  precompile::TypedBuilder<arrow::StringType> str_builder(arrow::default_memory_pool());
+  ASSERT_NOT_OK(int_builder.Reserve(4));
+  int_builder.UnsafeAppend(1);
+  int_builder.UnsafeAppendNull();
+  ASSERT_NOT_OK(int_builder.Append(3));
+  ASSERT_NOT_OK(int_builder.AppendNulls(1));
+  ASSERT_NOT_OK(str_builder.Append(arrow::util::string_view("a")));
+  ASSERT_NOT_OK(str_builder.AppendNull());
+  ASSERT_NOT_OK(str_builder.AppendString("ccc"));
+  ASSERT_NOT_OK(str_builder.Append(arrow::util::string_view("")));
+  std::shared_ptr<arrow::Array> int_out;
+  std::shared_ptr<arrow::Array> str_out;
+  ASSERT_NOT_OK(int_builder.Finish(&int_out));
+  ASSERT_NOT_OK(str_builder.Finish(&str_out));
+  auto result = arrow::RecordBatch::Make(sch, 4, {int_out, str_out});
+
+  std::shared_ptr<arrow::RecordBatch> expected;
+  MakeInputBatch({"[1, null, 3, null]", R"(["a", null, "ccc", ""])"}, sch, &expected);
+  ASSERT_NOT_OK(Equals(*expected.get(), *result.get()));
+}
+
+TEST(TestArrowCompute, TypedHashMapTest) {
+  precompile::TypedHashMap<arrow::StringType> hash_map(arrow::default_memory_pool());
+  std::vector<std::string> keys = {"a", "bb", "a", "", "bb"};
+  std::vector<int32_t> memo_indices;
+  int32_t not_found = 0;
+  for (auto& key : keys) {
+    int32_t memo_index;
+    ASSERT_NOT_OK(hash_map.GetOrInsert(
+        arrow::util::string_view(key), [](int32_t) {},
+        [&not_found](int32_t) { not_found++; }, &memo_index));
+    memo_indices.push_back(memo_index);
+  }
+  ASSERT_EQ(memo_indices, std::vector<int32_t>({0, 1, 0, 2, 1}));
+  ASSERT_EQ(not_found, 3);
+  ASSERT_EQ(hash_map.Get(arrow::util::string_view("bb")), 1);
+  ASSERT_EQ(hash_map.Get(arrow::util::string_view("c")), -1);
+  ASSERT_EQ(hash_map.GetNull(), -1);
+  ASSERT_EQ(hash_map.GetOrInsertNull([](int32_t) {}, [](int32_t) {}), 3);
+}
+
+TEST(TestArrowCompute, BatchBuilderTest) {
+  auto sch = arrow::schema({field("int_col", arrow::int32()),
+                            field("str_col", arrow::utf8()),
+                            field("bool_col", arrow::boolean())});
+  precompile::BatchBuilder<arrow::Int32Type> int_builder(arrow::default_memory_pool());
+  precompile::BatchBuilder<arrow::StringType> str_builder(arrow::default_memory_pool());
+  precompile::BatchBuilder<arrow::BooleanType> bool_builder(arrow::default_memory_pool());
+  ASSERT_NOT_OK(int_builder.Reserve(4));
+  int_builder.UnsafeAppend(1);
+  int_builder.UnsafeAppendNull();
+  int_builder.UnsafeAppend(3);
+  int_builder.UnsafeAppendNull();
+  // no data reserved, Append has to grow the value bytes
+  ASSERT_NOT_OK(str_builder.Reserve(4));
+  ASSERT_NOT_OK(str_builder.Append(arrow::util::string_view("a")));
+  str_builder.UnsafeAppendNull();
+  ASSERT_NOT_OK(str_builder.Append(arrow::util::string_view("ccc")));
+  ASSERT_NOT_OK(str_builder.Append(arrow::util::string_view("")));
+  ASSERT_NOT_OK(bool_builder.AppendValues(std::vector<bool>({true, false, true, false}),
+                                          std::vector<bool>({true, true, false, true}), 0,
+                                          4));
+  std::shared_ptr<arrow::Array> int_out;
+  std::shared_ptr<arrow::Array> str_out;
+  std::shared_ptr<arrow::Array> bool_out;
+  ASSERT_NOT_OK(int_builder.Finish(&int_out));
+  ASSERT_NOT_OK(str_builder.Finish(&str_out));
+  ASSERT_NOT_OK(bool_builder.Finish(&bool_out));
+  auto result = arrow::RecordBatch::Make(sch, 4, {int_out, str_out, bool_out});
+
+  std::shared_ptr<arrow::RecordBatch> expected;
+  MakeInputBatch({"[1, null, 3, null]", R"(["a", null, "ccc", ""])",
+                  "[true, false, null, false]"},
+                 sch, &expected);
+  ASSERT_NOT_OK(Equals(*expected.get(), *result.get()));
+
+  // a slice of cached vectors, as the aggregation result iterator emits it
+  std::vector<int64_t> values = {5, 6, 7, 8};
+  std::vector<std::string> strs = {"x", "yy", "zzz", "w"};
+  precompile::BatchBuilder<arrow::Int64Type> long_builder(arrow::default_memory_pool());
+  ASSERT_NOT_OK(long_builder.AppendValues(values, 1, 2));
+  ASSERT_NOT_OK(str_builder.AppendValues(strs, 1, 2));
+  std::shared_ptr<arrow::Array> long_out;
+  ASSERT_NOT_OK(long_builder.Finish(&long_out));
+  ASSERT_NOT_OK(str_builder.Finish(&str_out));
+  ASSERT_EQ(long_out->null_count(), 0);
+  auto slice_sch =
+      arrow::schema({field("long_col", arrow::int64()), field("str_col", arrow::utf8())});
+  auto slice_result = arrow::RecordBatch::Make(slice_sch, 2, {long_out, str_out});
+  std::shared_ptr<arrow::RecordBatch> slice_expected;
+  MakeInputBatch({"[6, 7]", R"(["yy", "zzz"])"}, slice_sch, &slice_expected);
+  ASSERT_NOT_OK(Equals(*slice_expected.get(), *slice_result.get()));
+}
+
+TEST(TestArrowCompute, BitmapTest) {
+  // 130 rows after the slice: an all-valid word, an all-null word and a mixed
+  // tail, with words starting off a byte boundary
+  std::vector<bool> validity;
+  for (int i = 0; i < 133; i++) {
+    validity.push_back(i < 67 || (i >= 131 && i % 2 == 0));
+  }
+  std::vector<int32_t> values(validity.size(), 1);
+  arrow::Int32Builder builder;
+  ASSERT_NOT_OK(builder.AppendValues(values, validity));
+  std::shared_ptr<arrow::Array> array;
+  ASSERT_NOT_OK(builder.Finish(&array));
+  array = array->Slice(3);
+  auto bitmap = array->null_bitmap_data();
+  auto offset = array->offset();
+  auto length = array->length();
+
+  ASSERT_EQ(precompile::CountSetBits(bitmap, offset, length), length - array->null_count());
+  ASSERT_EQ(precompile::CountSetBits(nullptr, 0, length), length);
+
+  std::vector<int64_t> set_bits;
+  precompile::VisitSetBits(bitmap, offset, length,
+                           [&](int64_t i) { set_bits.push_back(i); });
+  std::vector<int64_t> valid_rows;
+  std::vector<int64_t> null_rows;
+  ASSERT_NOT_OK(precompile::VisitValidity(
+      bitmap, offset, length,
+      [&](int64_t i) {
+        valid_rows.push_back(i);
+        return arrow::Status::OK();
+      },
+      [&](int64_t i) {
+        null_rows.push_back(i);
+        return arrow::Status::OK();
+      }));
+  std::vector<int64_t> expected_valid_rows;
+  std::vector<int64_t> expected_null_rows;
+  for (int64_t i = 0; i < length; i++) {
+    (array->IsValid(i) ? expected_valid_rows : expected_null_rows).push_back(i);
+  }
+  ASSERT_EQ(set_bits, expected_valid_rows);
+  ASSERT_EQ(valid_rows, expected_valid_rows);
+  ASSERT_EQ(null_rows, expected_null_rows);
+
+  // a null bitmap is all valid for AND and OR alike
+  std::vector<uint8_t> out(arrow::BitUtil::BytesForBits(length));
+  ASSERT_EQ(precompile::BitmapAnd(bitmap, offset, nullptr, 0, length, out.data()),
+            array->null_count());
+  for (int64_t i = 0; i < length; i++) {
+    ASSERT_EQ(arrow::BitUtil::GetBit(out.data(), i), array->IsValid(i));
+  }
+  ASSERT_EQ(precompile::BitmapOr(bitmap, offset, nullptr, 0, length, out.data()), 0);
+  ASSERT_EQ(precompile::BitmapAnd(bitmap, offset, bitmap, offset + 1, length - 1,
+                                  out.data()),
+            length - 1 - 63);
+  ASSERT_EQ(precompile::BitmapOr(bitmap, offset, bitmap, offset + 1, length - 1,
+                                 out.data()),
+            length - 1 - 65);
+}
 }  // namespace codegen
 }  // namespace sparkcolumnarplugin
\ No newline at end of file
@@ -13,6 +13,11 @@ public class PersistentMemoryPool {
     private static native long nativeGetRoot(long deviceHandler);
     private static native int nativeCloseDevice(long deviceHandler);
     private static native long nativeRemoveBlock(long deviceHandler, String key);
+    private static native long nativeRemoveMap(long deviceHandler, long shuffleId, long mapId, long partitionNum);
+    private static native long nativeRemoveShuffle(long deviceHandler, long shuffleId);
+    private static native long nativeAcquireBlock(long deviceHandler, String key);
+    private static native ByteBuffer[] nativeGetBlockBuffers(long deviceHandler, long blockHandler);
+    private static native int nativeReleaseBlock(long deviceHandler, long blockHandler);
   
     private static final long DEFAULT_PMPOOL_SIZE = 0L;
 
@@ -46,6 +51,46 @@ public class PersistentMemoryPool {
         return nativeRemoveBlock(this.deviceHandler, key);
     }
 
+    /**
+     * Remove all partitions of a map output. Blocks are freed in the
+     * background, the call does not wait for PMem to be reclaimed.
+     */
+    public long removeMap(long shuffleId, long mapId, long partitionNum) {
+        return nativeRemoveMap(this.deviceHandler, shuffleId, mapId, partitionNum);
+    }
+
+    /**
+     * Remove all map outputs of a shuffle, blocks are freed in the background.
+     */
+    public long removeShuffle(long shuffleId) {
+        return nativeRemoveShuffle(this.deviceHandler, shuffleId);
+    }
+
+    /**
+     * Pin the PMem segments of a partition, they stay readable until
+     * releasePartition is called even if the partition is removed meanwhile.
+     * Returns 0 if the partition does not exist.
+     */
+    public long acquirePartition(String key) {
+      return nativeAcquireBlock(this.deviceHandler, key);
+    }
+
+    /**
+     * Return read-only ByteBuffers over the PMem segments of a pinned
+     * partition, the data is not copied.
+     */
+    public ByteBuffer[] getPartitionBuffers(long blockHandler) {
+      ByteBuffer[] buffers = nativeGetBlockBuffers(this.deviceHandler, blockHandler);
+      for (int i = 0; i < buffers.length; i++) {
+        buffers[i] = buffers[i].asReadOnlyBuffer();
+      }
+      return buffers;
+    }
+
+    public void releasePartition(long blockHandler) {
+      nativeReleaseBlock(this.deviceHandler, blockHandler);
+    }
+
     public long getRootAddr() {
         return nativeGetRoot(this.deviceHandler);
     }
@@ -28,10 +28,11 @@ private[spark] class PmemShuffleBlockResolver(
   override def removeDataByMap(shuffleId: ShuffleId, mapId: Long): Unit ={
     val partitionNumber = conf.get("spark.sql.shuffle.partitions")
     val persistentMemoryHandler = PersistentMemoryHandler.getPersistentMemoryHandler
+    persistentMemoryHandler.removeMap(shuffleId, mapId, partitionNumber.toInt + 1)
+  }
 
-    for (i <- 0 to partitionNumber.toInt){
-      val key = "shuffle_" + shuffleId + "_" + mapId + "_" + i
-      persistentMemoryHandler.removeBlock(key)
-    }
+  def removeDataByShuffle(shuffleId: ShuffleId): Unit = {
+    val persistentMemoryHandler = PersistentMemoryHandler.getPersistentMemoryHandler
+    persistentMemoryHandler.removeShuffle(shuffleId)
   }
 }
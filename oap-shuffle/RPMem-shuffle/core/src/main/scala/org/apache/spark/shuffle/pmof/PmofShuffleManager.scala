@@ -82,8 +82,14 @@ private[spark] class PmofShuffleManager(conf: SparkConf) extends ShuffleManager
      */
 
     Option(taskIdMapsForShuffle.remove(shuffleId)).foreach { mapTaskIds =>
-      mapTaskIds.iterator.foreach { mapTaskId =>
-        shuffleBlockResolver.removeDataByMap(shuffleId, mapTaskId)
+      shuffleBlockResolver match {
+        case resolver: PmemShuffleBlockResolver =>
+          // drop all map outputs in one pass
+          resolver.removeDataByShuffle(shuffleId)
+        case resolver =>
+          mapTaskIds.iterator.foreach { mapTaskId =>
+            resolver.removeDataByMap(shuffleId, mapTaskId)
+          }
       }
     }
     true
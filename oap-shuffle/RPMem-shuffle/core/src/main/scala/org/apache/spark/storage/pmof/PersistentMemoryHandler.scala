@@ -79,6 +79,26 @@ private[spark] class PersistentMemoryHandler(
     pmpool.removeBlock(blockId)
   }
 
+  def removeMap(shuffleId: Long, mapId: Long, partitionNum: Long): Long = {
+    pmpool.removeMap(shuffleId, mapId, partitionNum)
+  }
+
+  def removeShuffle(shuffleId: Long): Long = {
+    pmpool.removeShuffle(shuffleId)
+  }
+
+  def acquirePartition(blockId: String): Long = {
+    pmpool.acquirePartition(blockId)
+  }
+
+  def getPartitionBuffers(blockHandler: Long): Array[ByteBuffer] = {
+    pmpool.getPartitionBuffers(blockHandler)
+  }
+
+  def releasePartition(blockHandler: Long): Unit = {
+    pmpool.releasePartition(blockHandler)
+  }
+
   def getPartitionManagedBuffer(blockId: String): ManagedBuffer = {
     new PmemManagedBuffer(this, blockId)
   }
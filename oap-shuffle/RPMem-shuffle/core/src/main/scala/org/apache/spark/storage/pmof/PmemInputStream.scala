@@ -1,73 +1,79 @@
 package org.apache.spark.storage.pmof
 
 import java.io.InputStream
+import java.nio.ByteBuffer
 import org.apache.spark.internal.Logging
-import scala.util.control.Breaks._
 
+/**
+ * Read a partition in place from PMem. The PMem segments of the partition are
+ * pinned until close, so they are neither copied to DRAM nor freed by a
+ * concurrent removeBlock while the stream is open.
+ */
 class PmemInputStream(
   persistentMemoryHandler: PersistentMemoryHandler,
   blockId: String) extends InputStream with Logging {
+  val blockHandler: Long = persistentMemoryHandler.acquirePartition(blockId)
+  val segments: Array[ByteBuffer] =
+    if (blockHandler == 0) Array.empty else persistentMemoryHandler.getPartitionBuffers(blockHandler)
+  val buffers: Array[ByteBuffer] = segments.map(_.duplicate())
   var index: Int = 0
-  var remaining: Int = 0
-  val blockInfo: Array[(Long, Int)] = persistentMemoryHandler.getPartitionBlockInfo(blockId)
-  var available_bytes: Int = persistentMemoryHandler.getPartitionSize(blockId).toInt
-  val buf = new PmemBuffer(available_bytes)
+  var available_bytes: Int = buffers.map(_.remaining()).sum
+  var closed: Boolean = false
   logDebug(s"${blockId} size ${available_bytes}")
 
-  load(available_bytes)
-
-  def loadNextStream(): Int = {
-    if (index >= blockInfo.length)
-      return 0
-    val data_length = blockInfo(index)._2
-    val data_addr = blockInfo(index)._1
-    buf.load(data_addr, data_length)
-
-    index += 1
-    remaining += data_length
-    data_length
+  def nextSegment(): ByteBuffer = {
+    while (index < buffers.length && !buffers(index).hasRemaining) {
+      index += 1
+    }
+    if (index < buffers.length) buffers(index) else null
   }
 
   override def read(): Int = {
-    if (remaining == 0) {
-      if (loadNextStream() == 0) {
-        return -1
-      }
+    val buf = nextSegment()
+    if (buf == null) {
+      return -1
     }
-    remaining -= 1
     available_bytes -= 1
-    buf.get()
+    buf.get() & 0xFF
   }
 
   override def read(bytes: Array[Byte], off: Int, len: Int): Int = {
-    if (remaining == 0) {
+    if (len == 0) {
+      return 0
+    }
+    var read_len = 0
+    var buf = nextSegment()
+    if (buf == null) {
       return -1
     }
-
-    val real_len = Math.min(len, remaining)
-    buf.get(bytes, off, real_len)
-    remaining -= real_len
-    available_bytes -= real_len
-    real_len
-  }
-
-  def load(len: Int): Unit = {
-    breakable { while ((remaining > 0 && remaining < len) || remaining == 0) {
-      if (loadNextStream() == 0) {
-        break
-      }
-    } }
+    while (buf != null && read_len < len) {
+      val real_len = Math.min(len - read_len, buf.remaining())
+      buf.get(bytes, off + read_len, real_len)
+      read_len += real_len
+      buf = nextSegment()
+    }
+    available_bytes -= read_len
+    read_len
   }
 
-  def getByteBufferDirectAddr: Long = {
-    buf.getDirectAddr
+  /**
+   * Return read-only views over all PMem segments of the partition, they are
+   * only valid until the stream is closed.
+   */
+  def getByteBuffers: Array[ByteBuffer] = {
+    segments.map(_.duplicate())
   }
 
   override def available(): Int = {
     available_bytes
   }
 
-  override def close(): Unit = {
-    buf.close()
+  override def close(): Unit = synchronized {
+    if (!closed) {
+      if (blockHandler != 0) {
+        persistentMemoryHandler.releasePartition(blockHandler)
+      }
+      closed = true
+    }
   }
 }
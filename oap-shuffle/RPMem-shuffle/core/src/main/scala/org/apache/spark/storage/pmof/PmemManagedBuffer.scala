@@ -72,8 +72,8 @@ class PmemManagedBuffer(pmHandler: PersistentMemoryHandler, blockId: String) ext
   }
 
   override def convertToNetty(): Object = {
+    // wrap the PMem segments without copying, they stay pinned until release
     val in = createInputStream()
-    val data_length = size().toInt
-    Unpooled.wrappedBuffer(in.asInstanceOf[PmemInputStream].getByteBufferDirectAddr, data_length, false)
+    Unpooled.wrappedBuffer(in.asInstanceOf[PmemInputStream].getByteBuffers: _*)
   }
 }
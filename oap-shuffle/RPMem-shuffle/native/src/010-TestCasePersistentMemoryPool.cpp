@@ -1,5 +1,7 @@
 #define CATCH_CONFIG_MAIN
 
+#include <sys/wait.h>
+
 #include "catch.hpp"
 #include "pmemkv.h"
 #include "PmemBuffer.h"
@@ -117,6 +119,115 @@ TEST_CASE("pmemkv operations", "[pmemkv]") {
     delete kv;
   }
 
+  SECTION("test pinned segments survive remove") {
+    std::string key = "pinned-key";
+    pmemkv* kv = new pmemkv("/dev/dax0.0");
+    kv->put(key, "hello", 5);
+    kv->put(key, " world", 6);
+    struct memory_segments ms;
+    REQUIRE(kv->get_segments(key, &ms) == 0);
+    REQUIRE(ms.segments.size() == 2);
+    REQUIRE(ms.total_size == 11);
+    REQUIRE(kv->remove(key) == 0);
+    // blocks are freed on release, not on remove
+    REQUIRE(kv->getBytesWritten() == 11);
+    REQUIRE(strncmp(ms.segments[0].data, "hello", 5) == 0);
+    REQUIRE(strncmp(ms.segments[1].data, " world", 6) == 0);
+    uint64_t size = 0;
+    REQUIRE(kv->get_value_size(key, &size) == -1);
+    kv->release_segments(&ms);
+    kv->wait_reclaim();
+    REQUIRE(kv->getBytesWritten() == 0);
+    REQUIRE(kv->get_segments(key, &ms) == -1);
+    kv->free_all();
+    delete kv;
+  }
+
+  SECTION("test remove blocks of a map output and a shuffle") {
+    pmemkv* kv = new pmemkv("/dev/dax0.0");
+    for (int map = 0; map < 3; map++) {
+      for (int partition = 0; partition < 4; partition++) {
+        std::string key = "shuffle_0_" + std::to_string(map) + "_" + std::to_string(partition);
+        kv->put(key, "hello", 5);
+      }
+    }
+    std::string other_key = "shuffle_1_0_0";
+    kv->put(other_key, "world", 5);
+    kv->removeBlocks(0, 1, 4);
+    kv->wait_reclaim();
+    REQUIRE(kv->getBytesWritten() == 45);
+    uint64_t size = 0;
+    std::string removed_key = "shuffle_0_1_2";
+    REQUIRE(kv->get_value_size(removed_key, &size) == -1);
+    kv->removeShuffle(0);
+    kv->wait_reclaim();
+    REQUIRE(kv->getBytesWritten() == 5);
+    REQUIRE(kv->get_value_size(other_key, &size) == 0);
+    kv->free_all();
+    delete kv;
+  }
+
+  SECTION("test concurrent put to the same key") {
+    pmemkv* kv = new pmemkv("/dev/dax0.0");
+    std::string key = "concurrent-key";
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++) {
+      threads.emplace_back([kv, &key] {
+        for (int j = 0; j < 100; j++) {
+          kv->put(key, "hello", 5);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    uint64_t size = 0;
+    kv->get_value_size(key, &size);
+    REQUIRE(size == 8 * 100 * 5);
+    REQUIRE(kv->getBytesWritten() == 8 * 100 * 5);
+    REQUIRE(kv->remove(key) == 0);
+    REQUIRE(kv->getBytesWritten() == 0);
+    kv->free_all();
+    delete kv;
+  }
+
+  SECTION("test removed keys stay removed after reopen") {
+    // file-backed (non-DAX) pool
+    const char* path = "/tmp/pmemkv_reopen_after_remove";
+    unlink(path);
+    std::string removed_key = "shuffle_0_0_0";
+    std::string kept_key = "shuffle_0_1_0";
+    pid_t pid = fork();
+    if (pid == 0) {
+      // the removed key is still pinned, so its blocks are not freed, and
+      // the pool is not closed, like on a crash
+      pmemkv* kv = new pmemkv(path, 64UL*1024*1024);
+      kv->put(removed_key, "hello", 5);
+      kv->put(kept_key, "world", 5);
+      struct memory_segments ms;
+      kv->get_segments(removed_key, &ms);
+      kv->remove(removed_key);
+      _exit(0);
+    }
+    int status = 0;
+    REQUIRE(waitpid(pid, &status, 0) == pid);
+    REQUIRE(WIFEXITED(status));
+    pmemkv* kv = new pmemkv(path);
+    REQUIRE(kv->is_open());
+    uint64_t size = 0;
+    REQUIRE(kv->get_value_size(removed_key, &size) == -1);
+    REQUIRE(kv->get_value_size(kept_key, &size) == 0);
+    kv->wait_reclaim();
+    REQUIRE(kv->getBytesWritten() == 5);
+    // keys put before the reopen are found by their shuffle id
+    kv->removeShuffle(0);
+    kv->wait_reclaim();
+    REQUIRE(kv->getBytesWritten() == 0);
+    REQUIRE(kv->get_value_size(kept_key, &size) == -1);
+    delete kv;
+    unlink(path);
+  }
+
   SECTION("test remove element from an empty list"){
     std::string key = "remove-element-from-empty-list";
     pmemkv* kv = new pmemkv("/dev/dax0.0");
@@ -334,6 +445,40 @@ SECTION("test remove an element in specific sequence"){
     delete kv;
   }
 
+  SECTION("pmemkv recovery benchmark") {
+    // file-backed (non-DAX) pool
+    const char* path = "/tmp/pmemkv_recovery_benchmark";
+    unlink(path);
+    pmemkv* kv = new pmemkv(path, 4UL*1024*1024*1024);
+    uint64_t block_num = 10000000;
+    int thread_num = 8;
+    char tmp[64];
+    memset(tmp, '0', 64);
+    std::atomic<uint64_t> count{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_num; i++) {
+      threads.emplace_back([&] {
+        for (uint64_t j = count++; j < block_num; j = count++) {
+          std::string key = "shuffle_0_" + std::to_string(j / 100) + "_" + std::to_string(j % 10);
+          kv->put(key, tmp, 64);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    delete kv;
+
+    uint64_t start = timestamp_now();
+    kv = new pmemkv(path);
+    uint64_t end = timestamp_now();
+    std::cout << "pmemkv recovery test: " << block_num << " blocks, " << std::thread::hardware_concurrency() << " cpus, consumes " << (end-start)/1000.0 << "s, " << block_num/((end-start)/1000.0) << " blocks/s" << std::endl;
+    REQUIRE(kv->getBytesWritten() == block_num * 64);
+    kv->free_all();
+    delete kv;
+    unlink(path);
+  }
+
   SECTION("pmemkv get benchmark") {
     pmemkv* kv = new pmemkv("/dev/dax0.0");
 
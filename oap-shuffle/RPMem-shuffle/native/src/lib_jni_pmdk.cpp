@@ -5,8 +5,14 @@
 JNIEXPORT jlong JNICALL Java_org_apache_spark_storage_pmof_PersistentMemoryPool_nativeOpenDevice
   (JNIEnv *env, jclass obj, jstring path, jlong size) {
   const char *CStr = env->GetStringUTFChars(path, 0);
-  pmemkv* kv= new pmemkv(CStr);
+  pmemkv* kv= new pmemkv(CStr, size);
   env->ReleaseStringUTFChars(path, CStr);
+  if (!kv->is_open()) {
+    // e.g. a pool created with an older layout, which has to be recreated
+    env->ThrowNew(env->FindClass("java/io/IOException"), kv->get_error().c_str());
+    delete kv;
+    return 0;
+  }
   return (long)kv;
 }
 
@@ -58,6 +64,58 @@ JNIEXPORT jlong JNICALL Java_org_apache_spark_storage_pmof_PersistentMemoryPool_
   return result;
 }
 
+JNIEXPORT jlong JNICALL Java_org_apache_spark_storage_pmof_PersistentMemoryPool_nativeRemoveMap
+  (JNIEnv *env, jclass obj, jlong kv, jlong shuffleId, jlong mapId, jlong partitionNum) {
+  pmemkv *pmkv = static_cast<pmemkv*>((void*)kv);
+  return pmkv->removeBlocks(shuffleId, mapId, partitionNum);
+}
+
+JNIEXPORT jlong JNICALL Java_org_apache_spark_storage_pmof_PersistentMemoryPool_nativeRemoveShuffle
+  (JNIEnv *env, jclass obj, jlong kv, jlong shuffleId) {
+  pmemkv *pmkv = static_cast<pmemkv*>((void*)kv);
+  return pmkv->removeShuffle(shuffleId);
+}
+
+JNIEXPORT jlong JNICALL Java_org_apache_spark_storage_pmof_PersistentMemoryPool_nativeAcquireBlock
+  (JNIEnv *env, jclass obj, jlong kv, jstring key) {
+  const char *CStr = env->GetStringUTFChars(key, 0);
+  string key_str(CStr);
+  env->ReleaseStringUTFChars(key, CStr);
+  pmemkv *pmkv = static_cast<pmemkv*>((void*)kv);
+  struct memory_segments* ms = new memory_segments();
+  if (pmkv->get_segments(key_str, ms)) {
+    delete ms;
+    return 0;
+  }
+  return (long)ms;
+}
+
+JNIEXPORT jobjectArray JNICALL Java_org_apache_spark_storage_pmof_PersistentMemoryPool_nativeGetBlockBuffers
+  (JNIEnv *env, jclass obj, jlong kv, jlong handle) {
+  struct memory_segments* ms = (struct memory_segments*)handle;
+  jclass byteBufferClass = env->FindClass("java/nio/ByteBuffer");
+  jobjectArray buffers = env->NewObjectArray(ms->segments.size(), byteBufferClass, nullptr);
+  if (buffers == nullptr) {
+    return nullptr;
+  }
+  for (uint64_t i = 0; i < ms->segments.size(); i++) {
+    // wrap pmem in place, no copy
+    jobject buffer = env->NewDirectByteBuffer(ms->segments[i].data, ms->segments[i].size);
+    env->SetObjectArrayElement(buffers, i, buffer);
+    env->DeleteLocalRef(buffer);
+  }
+  return buffers;
+}
+
+JNIEXPORT jint JNICALL Java_org_apache_spark_storage_pmof_PersistentMemoryPool_nativeReleaseBlock
+  (JNIEnv *env, jclass obj, jlong kv, jlong handle) {
+  pmemkv *pmkv = static_cast<pmemkv*>((void*)kv);
+  struct memory_segments* ms = (struct memory_segments*)handle;
+  int result = pmkv->release_segments(ms);
+  delete ms;
+  return result;
+}
+
 JNIEXPORT jint JNICALL Java_org_apache_spark_storage_pmof_PersistentMemoryPool_nativeCloseDevice
   (JNIEnv *env, jclass obj, jlong kv) {
   pmemkv *pmkv = static_cast<pmemkv*>((void*)kv);
@@ -55,6 +55,46 @@ JNIEXPORT jlong JNICALL Java_org_apache_spark_storage_pmof_PersistentMemoryPool_
 JNIEXPORT jlong JNICALL Java_org_apache_spark_storage_pmof_PersistentMemoryPool_nativeRemoveBlock
   (JNIEnv *, jclass, jlong, jstring);
 
+/*
+ * Class:     lib_jni_pmdk
+ * Method:    nativeAcquireBlock
+ * Signature: (JLjava/lang/String;)J
+ */
+JNIEXPORT jlong JNICALL Java_org_apache_spark_storage_pmof_PersistentMemoryPool_nativeAcquireBlock
+  (JNIEnv *, jclass, jlong, jstring);
+
+/*
+ * Class:     lib_jni_pmdk
+ * Method:    nativeGetBlockBuffers
+ * Signature: (JJ)[Ljava/nio/ByteBuffer;
+ */
+JNIEXPORT jobjectArray JNICALL Java_org_apache_spark_storage_pmof_PersistentMemoryPool_nativeGetBlockBuffers
+  (JNIEnv *, jclass, jlong, jlong);
+
+/*
+ * Class:     lib_jni_pmdk
+ * Method:    nativeReleaseBlock
+ * Signature: (JJ)I
+ */
+JNIEXPORT jint JNICALL Java_org_apache_spark_storage_pmof_PersistentMemoryPool_nativeReleaseBlock
+  (JNIEnv *, jclass, jlong, jlong);
+
+/*
+ * Class:     lib_jni_pmdk
+ * Method:    nativeRemoveMap
+ * Signature: (JJJJ)J
+ */
+JNIEXPORT jlong JNICALL Java_org_apache_spark_storage_pmof_PersistentMemoryPool_nativeRemoveMap
+  (JNIEnv *, jclass, jlong, jlong, jlong, jlong);
+
+/*
+ * Class:     lib_jni_pmdk
+ * Method:    nativeRemoveShuffle
+ * Signature: (JJ)J
+ */
+JNIEXPORT jlong JNICALL Java_org_apache_spark_storage_pmof_PersistentMemoryPool_nativeRemoveShuffle
+  (JNIEnv *, jclass, jlong, jlong);
+
 /*
  * Class:     lib_jni_pmdk
  * Method:    nativeGetRoot
@@ -10,14 +10,30 @@
 #include <string>
 #include <iostream>
 #include <cassert>
+#include <algorithm>
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include <libpmemobj.h>
 #include <libcuckoo/cuckoohash_map.hh>
 
 #include "xxhash.hpp"
 
-#define PMEMKV_LAYOUT_NAME "pmemkv_layout"
+#define PMEMKV_LAYOUT_NAME "pmemkv_layout_v4"
+// layouts of earlier releases, pools created with them can't be opened by
+// this version and have to be recreated
+static const char* const PMEMKV_OLD_LAYOUT_NAMES[] = {"pmemkv_layout", "pmemkv_layout_v2", "pmemkv_layout_v3"};
+// number of append lists, every writer thread appends to its own one
+#define PMEMKV_ARENA_NUM 64
+// number of keys freed in one transaction by the reclaim thread
+#define PMEMKV_RECLAIM_BATCH_SIZE 1024
+// shuffle and map id of keys that are not shuffle block names
+#define PMEMKV_NO_SHUFFLE UINT64_MAX
 
 // block header stored in pmem
 struct block_hdr {
@@ -25,6 +41,15 @@ struct block_hdr {
   PMEMoid pre;
   uint64_t key;
   uint64_t size;
+  // order of puts across arenas
+  uint64_t seq;
+  // ids parsed from a shuffle block key, the shuffle index is rebuilt from
+  // them on open
+  uint64_t shuffle_id;
+  uint64_t map_id;
+  // tombstone, set once the key is removed. Blocks that were not freed
+  // before the pool was closed are freed on the next open.
+  uint64_t removed;
 };
 
 // block data entry stored in pmem
@@ -33,14 +58,20 @@ struct block_entry {
   PMEMoid data;
 };
 
-// pmem root entry
-struct base {
+// block entry list stored in pmem, the lock is only contended when there
+// are more writer threads than arenas
+struct arena {
   PMEMoid head;
   PMEMoid tail;
-  PMEMrwlock rwlock;
+  PMEMmutex lock;
   uint64_t bytes_written;
 };
 
+// pmem root entry
+struct base {
+  struct arena arenas[PMEMKV_ARENA_NUM];
+};
+
 // block metadata stored in memory
 struct block_meta {
   block_meta* next;
@@ -48,13 +79,19 @@ struct block_meta {
   uint64_t size;
   block_entry* bep;
   PMEMoid beo;
+  uint32_t arena;
+  uint64_t seq;
 };
 
+// block metadata list of one key, one reference is held by index_map and
+// one by every reader that pinned the key with get_segments. PMem blocks
+// are freed when the last reference is dropped.
 struct block_meta_list {
   block_meta* head;
   block_meta* tail;
   uint64_t total_size;
   uint64_t length;
+  std::atomic<uint64_t> refs;
 };
 
 // block data stored in memory 
@@ -69,6 +106,20 @@ struct memory_meta {
   uint64_t length;
 };
 
+// block data segment in pmem
+struct memory_segment {
+  char* data;
+  uint64_t size;
+};
+
+// block data segments of one key pinned by get_segments, the segments stay
+// readable until release_segments is called even if the key is removed.
+struct memory_segments {
+  block_meta_list* bml;
+  std::vector<memory_segment> segments;
+  uint64_t total_size;
+};
+
 // pmem data allocation types
 enum types {
   BLOCK_ENTRY_TYPE,
@@ -78,8 +129,8 @@ enum types {
 
 /*
 pmemkv data and index were stored in persistent memory.
-data and index structure:
-base[head,                                                       tail]
+data and index structure, one list per arena:
+arena[head,                                                      tail]
      |                                                            |
      block_entry_1[block_hdr[next, key, size], data]              |
                           |                                       |
@@ -87,7 +138,9 @@ base[head,                                                       tail]
                                          |                        |
                                          block_entry_3[...[next...]]
 
-index map was stored in memory, rebuild index map when opening pmemkv
+index map was stored in memory, rebuild index map and shuffle index when
+opening pmemkv, arenas are scanned in parallel and blocks of a key are ordered
+by seq, blocks of removed keys are freed instead of being indexed
 index structure:
 key_1 --> block_meta_list_1[block_meta, block_meta, block_meta]
 key_2 --> block_meta_list_2[block_meta, block_meta, block_meta]
@@ -95,13 +148,19 @@ key_3 --> block_meta_list_3[block_meta, block_meta, block_meta]
 */
 class pmemkv {
   public:
-    explicit pmemkv(const char* dev_path_) : pmem_pool(nullptr), dev_path(dev_path_), bp(nullptr) {
+    // pool_size is only used when creating a file-backed pool, 0 takes the
+    // size of an existing file or device
+    explicit pmemkv(const char* dev_path_, uint64_t pool_size_ = 0) : pmem_pool(nullptr), dev_path(dev_path_), pool_size(pool_size_), bp(nullptr) {
       if (create()) {
         int res = open();
         if (res) {
-          std::cout << "failed to open pmem pool, errmsg: " << pmemobj_errormsg() << std::endl; 
+          if (open_error.empty()) {
+            open_error = std::string("failed to open pmem pool ") + dev_path + ", errmsg: " + pmemobj_errormsg();
+          }
+          std::cout << open_error << std::endl;
         }
       }
+      reclaimer = std::thread(&pmemkv::reclaim, this);
     }
 
     ~pmemkv() {
@@ -111,8 +170,22 @@ class pmemkv {
     pmemkv(const pmemkv&) = delete;
     pmemkv& operator= (const pmemkv&) = delete;
 
+    // false if the pool could neither be created nor opened, get_error
+    // tells why
+    bool is_open() {
+      return bp != nullptr;
+    }
+
+    const std::string& get_error() {
+      return open_error;
+    }
+
     int put(std::string &key, const char* buf, const uint64_t count) {
       xxh::hash64_t key_i = xxh::xxhash<64>(key);
+      uint64_t shuffle_id, map_id;
+      parse_shuffle_key(key, &shuffle_id, &map_id);
+      uint32_t arena_id = get_arena();
+      struct arena* ap = &bp->arenas[arena_id];
       // set the return point
       jmp_buf env;
       if (setjmp(env)) {
@@ -121,8 +194,8 @@ class pmemkv {
         return -1;
       }
 
-      // begin a transaction, also acquiring the write lock for the data
-      if (pmemobj_tx_begin(pmem_pool, env, TX_PARAM_RWLOCK, &bp->rwlock,
+      // begin a transaction, also acquiring the lock of this thread's arena
+      if (pmemobj_tx_begin(pmem_pool, env, TX_PARAM_MUTEX, &ap->lock,
           TX_PARAM_NONE)) {
         perror("pmemobj_tx_begin failed in pmemkv put");
         return -1;
@@ -135,209 +208,197 @@ class pmemkv {
         return -1;
       }
       struct block_entry* bep = (struct block_entry*)pmemobj_direct(beo);
-      bep->data = pmemobj_tx_zalloc(count, DATA_TYPE);
+      // data is neither zeroed nor flushed by the allocator, it is written
+      // once with non-temporal stores and drained by the commit
+      bep->data = pmemobj_tx_xalloc(count, DATA_TYPE, POBJ_XALLOC_NO_FLUSH);
       if (bep->data.off == 0) {
         (void) pmemobj_tx_end();
-        perror("pmemobj_tx_zalloc failed in pmemkv put");
+        perror("pmemobj_tx_xalloc failed in pmemkv put");
         return -1;
       }
       char* pmem_data = (char*)pmemobj_direct(bep->data);
-      memcpy(pmem_data, buf, count);
-      bep->hdr.pre = bp->tail;
+      pmemobj_memcpy(pmem_pool, pmem_data, buf, count,
+          PMEMOBJ_F_MEM_NONTEMPORAL | PMEMOBJ_F_MEM_NODRAIN);
+      bep->hdr.pre = ap->tail;
       bep->hdr.next = OID_NULL;
       bep->hdr.key = key_i;
       bep->hdr.size = count;
-
-      // add the modified root object to the undo data
-      pmemobj_tx_add_range(bo, 0, sizeof(struct base));
-      if (bp->tail.off == 0) {
+      bep->hdr.seq = next_seq++;
+      bep->hdr.shuffle_id = shuffle_id;
+      bep->hdr.map_id = map_id;
+      bep->hdr.removed = 0;
+
+      // add the modified arena to the undo data
+      pmemobj_tx_add_range_direct(ap, sizeof(struct arena));
+      if (ap->tail.off == 0) {
         // update head
-        bp->head = beo;
+        ap->head = beo;
       } else {
-        // add the modified tail entry to the undo data
-        pmemobj_tx_add_range(bp->tail, 0, sizeof(struct block_entry));
-        ((struct block_entry*)pmemobj_direct(bp->tail))->hdr.next = beo;
+        // add the modified link of the tail entry to the undo data, only the
+        // link so that an abort can't undo a tombstone set meanwhile
+        struct block_entry* tail_bep = (struct block_entry*)pmemobj_direct(ap->tail);
+        pmemobj_tx_add_range_direct(&tail_bep->hdr.next, sizeof(PMEMoid));
+        tail_bep->hdr.next = beo;
       }
 
-      bp->tail = beo; // update tail
-      bp->bytes_written += count;
+      ap->tail = beo; // update tail
+      ap->bytes_written += count;
       pmemobj_tx_commit();
       (void) pmemobj_tx_end();
 
       // update in-memory index
-      if (update_meta(bep, beo)) {
+      bool inserted = false;
+      if (update_meta(bep, beo, arena_id, &inserted)) {
         return -1;
       }
+      if (inserted) {
+        update_shuffle_index(shuffle_id, map_id, key_i);
+      }
       return 0;
     }
 
     int get(std::string &key, struct memory_block *mb) {
-      xxh::hash64_t key_i = xxh::xxhash<64>(key);
-      if (!index_map.contains(key_i)) {
+      struct memory_segments ms;
+      if (get_segments(key, &ms)) {
         perror("no such key in index_map");
         return -1;
       }
-      if (pmemobj_rwlock_rdlock(pmem_pool, &bp->rwlock) != 0) {
-		    return -1;
-      }
-      struct block_meta_list* bml = nullptr;
-      index_map.find(key_i, bml);
-      assert(bml != nullptr);
-      struct block_meta* bm = bml->head;
       uint64_t read_offset = 0;
-      while (bm != nullptr && (read_offset+bm->size <= mb->size)) {
-        memcpy(mb->data+read_offset, (char*)bm->off, bm->size);
-        read_offset += bm->size;
-        assert(read_offset <= mb->size);
-        bm = bm->next;
+      for (auto &segment : ms.segments) {
+        if (read_offset+segment.size > mb->size) {
+          break;
+        }
+        memcpy(mb->data+read_offset, segment.data, segment.size);
+        read_offset += segment.size;
       }
-      pmemobj_rwlock_unlock(pmem_pool, &bp->rwlock);
+      release_segments(&ms);
       return 0;
     }
 
-    int removeBlocks(uint64_t shuffleId, uint64_t mapId, uint64_t partitionId){
-        for (int i = 0; i < partitionId; i++){
-            std::string key = "shuffle_" + std::to_string(shuffleId) + "_" + std::to_string(mapId) + "_" + std::to_string(i);
-            //std::cout<<"key="<<key<<std::endl;
-            remove(key);
+    // pin the pmem segments of key, the caller reads them in place and has
+    // to call release_segments when done. Only the index bucket of key is
+    // locked while pinning, no pool wide lock is taken.
+    int get_segments(std::string &key, struct memory_segments *ms) {
+      xxh::hash64_t key_i = xxh::xxhash<64>(key);
+      ms->bml = nullptr;
+      ms->segments.clear();
+      ms->total_size = 0;
+      bool found = index_map.find_fn(key_i, [ms](block_meta_list* const &bml) {
+        bml->refs++;
+        ms->bml = bml;
+        ms->segments.reserve(bml->length);
+        for (struct block_meta* bm = bml->head; bm != nullptr; bm = bm->next) {
+          ms->segments.push_back({(char*)bm->off, bm->size});
         }
-        return 0;
+        ms->total_size = bml->total_size;
+      });
+      return found ? 0 : -1;
     }
 
-    int getBytesWritten(){
-        return bp->bytes_written;
+    int release_segments(struct memory_segments *ms) {
+      if (ms->bml == nullptr) {
+        return 0;
+      }
+      struct block_meta_list* bml = ms->bml;
+      ms->bml = nullptr;
+      ms->segments.clear();
+      ms->total_size = 0;
+      // don't free on the reader's thread
+      return unref(bml, true);
     }
 
-    int remove(std::string &key){
-      std::lock_guard<std::mutex> l(mtx);
-      xxh::hash64_t key_i = xxh::xxhash<64>(key);
-      if (!index_map.contains(key_i)){
-        //std::cout<<"Data with key="<<key_i<<" doesn't exist"<<std::endl;
-        return -1;
+    // drop all partitions of one map output in one pass. Keys are unlinked
+    // from the index right away, their blocks are freed in batches on the
+    // reclaim thread.
+    int removeBlocks(uint64_t shuffleId, uint64_t mapId, uint64_t partitionNum){
+      std::vector<uint64_t> keys;
+      {
+        std::lock_guard<std::mutex> l(shuffle_mtx);
+        auto shuffle = shuffle_index.find(shuffleId);
+        if (shuffle != shuffle_index.end()) {
+          auto map = shuffle->second.find(mapId);
+          if (map != shuffle->second.end()) {
+            keys.swap(map->second);
+            shuffle->second.erase(map);
+          }
+          if (shuffle->second.empty()) {
+            shuffle_index.erase(shuffle);
+          }
+        }
       }
-
-      // set the return point
-      jmp_buf env;
-      if (setjmp(env)) {
-        // end the transaction
-        (void) pmemobj_tx_end();
-        return -1;
+      if (keys.empty()) {
+        // map output is not in the shuffle index, look its partitions up by
+        // name
+        for (uint64_t i = 0; i < partitionNum; i++){
+          std::string key = "shuffle_" + std::to_string(shuffleId) + "_" + std::to_string(mapId) + "_" + std::to_string(i);
+          keys.push_back(xxh::xxhash<64>(key));
+        }
       }
+      return remove_keys(keys);
+    }
 
-      // begin a transaction, also acquiring the write lock for the data
-      if (pmemobj_tx_begin(pmem_pool, env, TX_PARAM_RWLOCK, &bp->rwlock,TX_PARAM_NONE)) {
-        std::cout<<"pmemobj_tx_begin failed in pmemkv put"<<std::endl;
-        perror("pmemobj_tx_begin failed in pmemkv put");
-        return -1;
+    // drop all map outputs of one shuffle in one pass.
+    int removeShuffle(uint64_t shuffleId) {
+      std::vector<uint64_t> keys;
+      {
+        std::lock_guard<std::mutex> l(shuffle_mtx);
+        auto shuffle = shuffle_index.find(shuffleId);
+        if (shuffle == shuffle_index.end()) {
+          return 0;
+        }
+        for (auto &map : shuffle->second) {
+          keys.insert(keys.end(), map.second.begin(), map.second.end());
+        }
+        shuffle_index.erase(shuffle);
       }
+      return remove_keys(keys);
+    }
 
-      // Remove data by block meta list
-      struct block_meta_list* bml;
-      index_map.find(key_i, bml);
-
-      struct block_meta* cur = bml->head;
-
-      //Delete block_entry in bml one by one
-      while (cur != nullptr) {
-        block_entry* bep = cur->bep;
-        //Node to be deleted is at the head
-        if(bep == (struct block_entry*)pmemobj_direct(bp->head)){
-            if (pmemobj_direct(bep->hdr.next) == nullptr){
-                //There is only one block_entry
-                bp->head = OID_NULL;
-                bp->tail = OID_NULL;
-                bp->bytes_written = bp->bytes_written - bep->hdr.size;
-                pmemobj_free(&bep->data);
-                pmemobj_free(&cur->beo);
-                struct block_meta *next = cur->next;
-                cur->next = nullptr;
-                std::free(cur);
-                cur = next;
-                bytes_allocated -= sizeof(block_meta);
-                //std::cout<<"Only key in head is removed. key="<<key<<std::endl;
-                continue;
-            }
+    // block until the reclaim thread freed all removed keys.
+    void wait_reclaim() {
+      std::unique_lock<std::mutex> l(reclaim_mtx);
+      reclaim_cv.wait(l, [this] { return reclaim_queue.empty() && !reclaiming; });
+    }
 
-            //There are two or more block_entry
-            bp->head = bep->hdr.next;
-            block_entry* new_head_pointer = (struct block_entry*)pmemobj_direct(bp->head);
-            new_head_pointer->hdr.pre = OID_NULL;
-            bp->bytes_written = bp->bytes_written - bep->hdr.size;
-            pmemobj_free(&bep->data);
-            pmemobj_free(&cur->beo);
-            struct block_meta *next = cur->next;
-            cur->next = nullptr;
-            std::free(cur);
-            cur = next;
-            bytes_allocated -= sizeof(block_meta);
-            //std::cout<<"Key in head is removed. key="<<key<<std::endl;
-            continue;
-        }
-        //Node to be deleted is at the tail
-        if (pmemobj_direct(bep->hdr.next) == nullptr){
-            //The one node scenario is already covered in head judgement, there are two or more nodes here
-            struct block_entry* prebep = (struct block_entry*)pmemobj_direct(bep->hdr.pre);
-            prebep->hdr.next = OID_NULL;
-            bp->tail = bep->hdr.pre;
-            if((struct block_entry*)pmemobj_direct(bp->tail) == nullptr){
-                std::cout<<"Error. The bp->tail should not be nullptr"<<std::endl;
-            }
-            bp->bytes_written = bp->bytes_written - bep->hdr.size;
-            pmemobj_free(&bep->data);
-            pmemobj_free(&cur->beo);
-            struct block_meta *next = cur->next;
-            cur->next = nullptr;
-            std::free(cur);
-            cur = next;
-            bytes_allocated -= sizeof(block_meta);
-            //std::cout<<"Key in tail is removed. key="<<key<<std::endl;
-            continue;
+    int getBytesWritten(){
+        uint64_t bytes_written = 0;
+        for (auto &arena : bp->arenas) {
+          bytes_written += arena.bytes_written;
         }
+        return bytes_written;
+    }
 
-        //Node to be deleted is at the middle, no head or tail, there are at least three nodes
-        struct block_entry* prebep = (struct block_entry*)pmemobj_direct(bep->hdr.pre);
-        prebep->hdr.next = bep->hdr.next;
-        struct block_entry* nextbep = (struct block_entry*)pmemobj_direct(bep->hdr.next);
-        nextbep->hdr.pre = bep->hdr.pre;
-        bp->bytes_written = bp->bytes_written - bep->hdr.size;
-        pmemobj_free(&bep->data);
-        pmemobj_free(&cur->beo);
-        struct block_meta *next = cur->next;
-        cur->next = nullptr;
-        std::free(cur);
-        cur = next;
-        bytes_allocated -= sizeof(block_meta);
-        //std::cout<<"Key neither in head nor in tail is removed. key="<<key<<std::endl;
+    int remove(std::string &key){
+      xxh::hash64_t key_i = xxh::xxhash<64>(key);
+      // unlink key from index_map, blocks are freed once pinned readers
+      // released them
+      struct block_meta_list* bml = nullptr;
+      if (!index_map.erase_fn(key_i, [&bml](block_meta_list* &value) {
+            bml = value;
+            return true;
+          })) {
+        return -1;
       }
-
-      bytes_allocated -= sizeof(block_meta_list);
-      std::free(bml);
-      index_map.erase(key_i);
-      pmemobj_tx_commit();
-      (void) pmemobj_tx_end();
-      return 0;
+      std::vector<block_meta_list*> bmls{bml};
+      mark_removed(bmls);
+      return unref(bml);
     }
 
     int get_value_size(std::string &key, uint64_t* size) {
       xxh::hash64_t key_i = xxh::xxhash<64>(key);
-      if (!index_map.contains(key_i)) {
-        *size = 0;
+      *size = 0;
+      if (!index_map.find_fn(key_i, [size](block_meta_list* const &bml) {
+            *size = bml->total_size;
+          })) {
         return -1;
-      } else {
-        struct block_meta_list* bml;
-        index_map.find(key_i, bml);
-        *size = bml->total_size;
-        return 0;
       }
+      return 0;
     }
 
     int get_meta(std::string &key, struct memory_meta* mm) {
       xxh::hash64_t key_i = xxh::xxhash<64>(key);
-      if (!index_map.contains(key_i)) {
-        mm = nullptr;
-      } else {
-        struct block_meta_list* bml;
-        index_map.find(key_i, bml);
+      mm->length = 0;
+      index_map.find_fn(key_i, [mm](block_meta_list* const &bml) {
         uint64_t index = 0;
         struct block_meta *next = bml->head;
         while (next != nullptr) {
@@ -347,63 +408,65 @@ class pmemkv {
           next = next->next;
         }
         mm->length = index;
-      }
+      });
       return 0;
     }
 
     int get_meta_size(std::string &key, uint64_t* size) {
       xxh::hash64_t key_i = xxh::xxhash<64>(key);
-      if (!index_map.contains(key_i)) {
-        *size = 0;
+      *size = 0;
+      if (!index_map.find_fn(key_i, [size](block_meta_list* const &bml) {
+            *size = bml->length;
+          })) {
         return -1;
-      } else {
-        struct block_meta_list* bml;
-        index_map.find(key_i, bml);
-        *size = bml->length;
-        return 0;
       }
+      return 0;
     }
 
     int dump_all() {
-      if (pmemobj_rwlock_rdlock(pmem_pool, &bp->rwlock) != 0) {
-		    return -1;
+      for (auto &arena : bp->arenas) {
+        if (pmemobj_mutex_lock(pmem_pool, &arena.lock) != 0) {
+          return -1;
+        }
+        struct block_entry* next_bep = (struct block_entry*)pmemobj_direct(arena.head);
+        uint64_t read_offset = 0;
+        while (next_bep != nullptr) {
+          char* pmem_data = (char*)pmemobj_direct(next_bep->data);
+          char* tmp = (char*)std::malloc(next_bep->hdr.size);
+          memcpy(tmp, pmem_data, next_bep->hdr.size);
+          std::cout << "key " << next_bep->hdr.key << " value " << pmem_data << std::endl;
+          read_offset += next_bep->hdr.size;
+          std::free(tmp);
+          next_bep = (struct block_entry*)pmemobj_direct(next_bep->hdr.next);
+        }
+        pmemobj_mutex_unlock(pmem_pool, &arena.lock);
       }
-      struct block_entry* next_bep = (struct block_entry*)pmemobj_direct(bp->head);
-      uint64_t read_offset = 0;
-      while (next_bep != nullptr) {
-        char* pmem_data = (char*)pmemobj_direct(next_bep->data);
-        char* tmp = (char*)std::malloc(next_bep->hdr.size);
-        memcpy(tmp, pmem_data, next_bep->hdr.size);
-        std::cout << "key " << next_bep->hdr.key << " value " << pmem_data << std::endl;
-        read_offset += next_bep->hdr.size;
-        std::free(tmp);
-        next_bep = (struct block_entry*)pmemobj_direct(next_bep->hdr.next);
-      }
-      pmemobj_rwlock_unlock(pmem_pool, &bp->rwlock);
       return 0; 
     }
 
     int reverse_dump_all() {
-      if (pmemobj_rwlock_rdlock(pmem_pool, &bp->rwlock) != 0) {
-            return -1;
+      for (auto &arena : bp->arenas) {
+        if (pmemobj_mutex_lock(pmem_pool, &arena.lock) != 0) {
+          return -1;
+        }
+        struct block_entry* next_bep = (struct block_entry*)pmemobj_direct(arena.tail);
+        uint64_t read_offset = 0;
+        while (next_bep != nullptr) {
+          char* pmem_data = (char*)pmemobj_direct(next_bep->data);
+          char* tmp = (char*)std::malloc(next_bep->hdr.size);
+          memcpy(tmp, pmem_data, next_bep->hdr.size);
+          std::cout << "key " << next_bep->hdr.key << " value " << pmem_data << std::endl;
+          read_offset += next_bep->hdr.size;
+          std::free(tmp);
+          next_bep = (struct block_entry*)pmemobj_direct(next_bep->hdr.pre);
+        }
+        pmemobj_mutex_unlock(pmem_pool, &arena.lock);
       }
-      struct block_entry* next_bep = (struct block_entry*)pmemobj_direct(bp->tail);
-      uint64_t read_offset = 0;
-      while (next_bep != nullptr) {
-        char* pmem_data = (char*)pmemobj_direct(next_bep->data);
-        char* tmp = (char*)std::malloc(next_bep->hdr.size);
-        memcpy(tmp, pmem_data, next_bep->hdr.size);
-        std::cout << "key " << next_bep->hdr.key << " value " << pmem_data << std::endl;
-        read_offset += next_bep->hdr.size;
-        std::free(tmp);
-        next_bep = (struct block_entry*)pmemobj_direct(next_bep->hdr.pre);
-      }
-      pmemobj_rwlock_unlock(pmem_pool, &bp->rwlock);
       return 0;
     }
 
     int dump_meta() {
-      std::cout << "pmemkv total bytes written " << bp->bytes_written << std::endl;
+      std::cout << "pmemkv total bytes written " << getBytesWritten() << std::endl;
       std::lock_guard<std::mutex> l(mtx);
       auto locked_index_map = index_map.lock_table();
       for (const auto &it : locked_index_map) {
@@ -416,25 +479,28 @@ class pmemkv {
     }
 
     int free_all() {
-      //std::cout<<"free's begining: bp->bytes_written: "<<bp->bytes_written<<std::endl;
+      wait_reclaim();
+      //std::cout<<"free's begining: bytes_written: "<<getBytesWritten()<<std::endl;
       // don't implement transaction here, if any issue happens, we need to rebuild the pmem pool.
-      PMEMoid next_beo = bp->head;
-      struct block_entry* next_bep = (struct block_entry*)pmemobj_direct(next_beo);
-      while (next_bep != nullptr) {
-        // add block entry to undo log
-        PMEMoid pre_beo =  next_beo;
-        struct block_entry* pre_bep = next_bep;
-        pmemobj_free(&pre_beo);
-        pmemobj_free(&pre_bep->data);
-        next_beo = next_bep->hdr.next;
-        next_bep = (struct block_entry*)pmemobj_direct(next_beo);
-        bp->bytes_written -= pre_bep->hdr.size;
-      }
-      // add root block to undo log
-      bp->head = OID_NULL;
-      bp->tail = OID_NULL;
-      //std::cout<<"free: bp->bytes_written: "<<bp->bytes_written<<std::endl;
-      assert(bp->bytes_written == 0);
+      for (auto &arena : bp->arenas) {
+        PMEMoid next_beo = arena.head;
+        struct block_entry* next_bep = (struct block_entry*)pmemobj_direct(next_beo);
+        while (next_bep != nullptr) {
+          // add block entry to undo log
+          PMEMoid pre_beo =  next_beo;
+          struct block_entry* pre_bep = next_bep;
+          pmemobj_free(&pre_beo);
+          pmemobj_free(&pre_bep->data);
+          next_beo = next_bep->hdr.next;
+          next_bep = (struct block_entry*)pmemobj_direct(next_beo);
+          arena.bytes_written -= pre_bep->hdr.size;
+        }
+        // add root block to undo log
+        arena.head = OID_NULL;
+        arena.tail = OID_NULL;
+        //std::cout<<"free: arena.bytes_written: "<<arena.bytes_written<<std::endl;
+        assert(arena.bytes_written == 0);
+      }
 
       // free metadata
       if (free_meta()) {
@@ -453,15 +519,17 @@ class pmemkv {
       int sds_write_value = 0;
       pmemobj_ctl_set(nullptr, "sds.at_create", &sds_write_value);
 
-      pmem_pool = pmemobj_create(dev_path, PMEMKV_LAYOUT_NAME, 0, 0666);
+      pmem_pool = pmemobj_create(dev_path, PMEMKV_LAYOUT_NAME, pool_size, 0666);
       if (pmem_pool == nullptr) {
         return -1;
       }
       bo = pmemobj_root(pmem_pool, sizeof(struct base));
       bp = (struct base*)pmemobj_direct(bo);
-      bp->head = OID_NULL;
-      bp->tail = OID_NULL;
-      bp->bytes_written = 0;
+      for (auto &arena : bp->arenas) {
+        arena.head = OID_NULL;
+        arena.tail = OID_NULL;
+        arena.bytes_written = 0;
+      }
 
       return 0;
     }
@@ -472,27 +540,131 @@ class pmemkv {
       pmemobj_ctl_set(nullptr, "sds.at_create", &sds_write_value);
       pmem_pool = pmemobj_open(dev_path, PMEMKV_LAYOUT_NAME);
       if (pmem_pool == nullptr) {
+        report_old_layout();
         return -1;
       }
       // rebuild in-memory index
       // walk through all the block entry in pmem, don't need lock here
       bo = pmemobj_root(pmem_pool, sizeof(struct base));
       bp = (struct base*)pmemobj_direct(bo);
-      struct block_entry *next = (struct block_entry*)pmemobj_direct(bp->head);
-      PMEMoid next_beo = bp->head;
-      while (next != nullptr) {
-        if (update_meta(next, next_beo)) {
-          return -1;
-        }
-        next_beo = next->hdr.next;
-        next = (struct block_entry*)pmemobj_direct(next_beo);
+      // every thread walks whole arenas, arenas are picked round robin
+      unsigned thread_num = std::max(1u, std::thread::hardware_concurrency());
+      thread_num = std::min<unsigned>(thread_num, PMEMKV_ARENA_NUM);
+      std::atomic<uint32_t> next_arena{0};
+      std::atomic<uint64_t> max_seq{0};
+      std::atomic<int> res{0};
+      std::vector<std::vector<block_meta_list*>> removed(thread_num);
+      std::vector<std::thread> threads;
+      for (unsigned i = 0; i < thread_num; i++) {
+        threads.emplace_back([&, i] {
+          uint64_t seq = 0;
+          for (uint32_t arena_id = next_arena++; arena_id < PMEMKV_ARENA_NUM; arena_id = next_arena++) {
+            PMEMoid next_beo = bp->arenas[arena_id].head;
+            struct block_entry *next = (struct block_entry*)pmemobj_direct(next_beo);
+            while (next != nullptr) {
+              seq = std::max(seq, next->hdr.seq);
+              if (next->hdr.removed) {
+                // removed before the pool was closed, but not freed yet
+                struct block_meta_list* bml = new_removed_list(next, next_beo, arena_id);
+                if (bml == nullptr) {
+                  res = -1;
+                  return;
+                }
+                removed[i].push_back(bml);
+              } else {
+                bool inserted = false;
+                if (update_meta(next, next_beo, arena_id, &inserted)) {
+                  res = -1;
+                  return;
+                }
+                if (inserted) {
+                  update_shuffle_index(next->hdr.shuffle_id, next->hdr.map_id, next->hdr.key);
+                }
+              }
+              next_beo = next->hdr.next;
+              next = (struct block_entry*)pmemobj_direct(next_beo);
+            }
+          }
+          uint64_t cur = max_seq.load();
+          while (seq > cur && !max_seq.compare_exchange_weak(cur, seq)) {}
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      if (res) {
+        return -1;
+      }
+      next_seq = max_seq + 1;
+      sort_meta();
+      // the reclaim thread frees the removed blocks once it is started
+      for (auto &bmls : removed) {
+        reclaim_queue.insert(reclaim_queue.end(), bmls.begin(), bmls.end());
       }
       return 0;
     }
+
+    // pools written by an earlier release fail to open with a layout
+    // mismatch, name the layout they were created with so the error says the
+    // pool has to be recreated.
+    void report_old_layout() {
+      for (auto layout : PMEMKV_OLD_LAYOUT_NAMES) {
+        PMEMobjpool* pop = pmemobj_open(dev_path, layout);
+        if (pop != nullptr) {
+          pmemobj_close(pop);
+          open_error = std::string("pmem pool ") + dev_path + " was created with layout " + layout +
+            ", this version needs " PMEMKV_LAYOUT_NAME ", recreate the pool to use it";
+          return;
+        }
+      }
+    }
+
+    // blocks of a key put from several threads come from several arenas,
+    // restore the order they were put in.
+    void sort_meta() {
+      auto locked_index_map = index_map.lock_table();
+      std::vector<block_meta*> blocks;
+      for (const auto &it : locked_index_map) {
+        struct block_meta_list* bml = it.second;
+        bool sorted = true;
+        for (struct block_meta* bm = bml->head; bm->next != nullptr; bm = bm->next) {
+          if (bm->seq > bm->next->seq) {
+            sorted = false;
+            break;
+          }
+        }
+        if (sorted) {
+          continue;
+        }
+        blocks.clear();
+        for (struct block_meta* bm = bml->head; bm != nullptr; bm = bm->next) {
+          blocks.push_back(bm);
+        }
+        std::sort(blocks.begin(), blocks.end(), [](block_meta* a, block_meta* b) {
+          return a->seq < b->seq;
+        });
+        for (size_t i = 0; i + 1 < blocks.size(); i++) {
+          blocks[i]->next = blocks[i + 1];
+        }
+        blocks.back()->next = nullptr;
+        bml->head = blocks.front();
+        bml->tail = blocks.back();
+      }
+    }
     
     void close() {
-      pmemobj_close(pmem_pool);
+      {
+        std::lock_guard<std::mutex> l(reclaim_mtx);
+        stopping = true;
+      }
+      reclaim_cv.notify_all();
+      reclaimer.join();
+      if (pmem_pool != nullptr) {
+        pmemobj_close(pmem_pool);
+      }
       free_meta();
+      std::lock_guard<std::mutex> l(shuffle_mtx);
+      shuffle_index.clear();
     }
 
     int free_meta() {
@@ -509,7 +681,7 @@ class pmemkv {
           bytes_allocated -= sizeof(block_meta);
           cur = next;
         }
-        std::free(bml);
+        delete bml;
         bytes_allocated -= sizeof(block_meta_list);
         bml = nullptr;
       }
@@ -518,63 +690,280 @@ class pmemkv {
       return 0;
     }
 
-    int update_meta(struct block_entry* bep, PMEMoid beo) {
+    // writer threads are spread over arenas round robin, a thread always
+    // appends to the same arena.
+    uint32_t get_arena() {
+      static std::atomic<uint32_t> next_arena{0};
+      thread_local uint32_t arena_id = next_arena++ % PMEMKV_ARENA_NUM;
+      return arena_id;
+    }
+
+    // shuffle id and map id of a shuffle block name, PMEMKV_NO_SHUFFLE for
+    // other keys.
+    static void parse_shuffle_key(std::string &key, uint64_t* shuffle_id, uint64_t* map_id) {
+      unsigned long shuffle, map, partition;
+      if (sscanf(key.c_str(), "shuffle_%lu_%lu_%lu", &shuffle, &map, &partition) != 3) {
+        *shuffle_id = PMEMKV_NO_SHUFFLE;
+        *map_id = PMEMKV_NO_SHUFFLE;
+        return;
+      }
+      *shuffle_id = shuffle;
+      *map_id = map;
+    }
+
+    // group key by shuffle id and map id, keys that are not shuffle block
+    // names are not grouped.
+    void update_shuffle_index(uint64_t shuffle_id, uint64_t map_id, uint64_t key_i) {
+      if (shuffle_id == PMEMKV_NO_SHUFFLE) {
+        return;
+      }
+      std::lock_guard<std::mutex> l(shuffle_mtx);
+      shuffle_index[shuffle_id][map_id].push_back(key_i);
+    }
+
+    int remove_keys(std::vector<uint64_t> &keys) {
+      std::vector<block_meta_list*> bmls;
+      for (auto key_i : keys) {
+        index_map.erase_fn(key_i, [&bmls](block_meta_list* &value) {
+          bmls.push_back(value);
+          return true;
+        });
+      }
+      mark_removed(bmls);
+      for (auto bml : bmls) {
+        unref(bml, true);
+      }
+      return 0;
+    }
+
+    // persist a tombstone in every block of keys that were just unlinked
+    // from index_map, so that the next open does not bring back blocks that
+    // are still pinned or queued for reclaim when the pool is closed. The
+    // caller still holds the index reference of every list.
+    void mark_removed(std::vector<block_meta_list*> &bmls) {
+      if (bmls.empty()) {
+        return;
+      }
+      for (auto bml : bmls) {
+        for (struct block_meta* bm = bml->head; bm != nullptr; bm = bm->next) {
+          bm->bep->hdr.removed = 1;
+          pmemobj_flush(pmem_pool, &bm->bep->hdr.removed, sizeof(uint64_t));
+        }
+      }
+      pmemobj_drain(pmem_pool);
+    }
+
+    // drop a reference, the last one frees the blocks right away or, if
+    // deferred, on the reclaim thread.
+    int unref(struct block_meta_list* bml, bool deferred = false) {
+      if (bml->refs.fetch_sub(1) != 1) {
+        return 0;
+      }
+      if (deferred) {
+        {
+          std::lock_guard<std::mutex> l(reclaim_mtx);
+          reclaim_queue.push_back(bml);
+        }
+        reclaim_cv.notify_all();
+        return 0;
+      }
+      std::vector<block_meta_list*> bmls{bml};
+      return free_blocks(bmls);
+    }
+
+    void reclaim() {
+      std::vector<block_meta_list*> bmls;
+      while (true) {
+        {
+          std::unique_lock<std::mutex> l(reclaim_mtx);
+          reclaiming = false;
+          reclaim_cv.notify_all();
+          reclaim_cv.wait(l, [this] { return stopping || !reclaim_queue.empty(); });
+          if (reclaim_queue.empty()) {
+            return;
+          }
+          bmls.swap(reclaim_queue);
+          reclaiming = true;
+        }
+        for (size_t i = 0; i < bmls.size(); i += PMEMKV_RECLAIM_BATCH_SIZE) {
+          size_t end = std::min(bmls.size(), i + PMEMKV_RECLAIM_BATCH_SIZE);
+          std::vector<block_meta_list*> batch(bmls.begin() + i, bmls.begin() + end);
+          free_blocks(batch);
+        }
+        bmls.clear();
+      }
+    }
+
+    // free the pmem blocks of keys that were removed from index_map and are
+    // no longer pinned by any reader, all in one transaction. The in-memory
+    // lists are only freed once it committed, after an abort the blocks stay
+    // linked with their tombstone and are freed on the next open.
+    int free_blocks(std::vector<block_meta_list*> &bmls) {
       std::lock_guard<std::mutex> l(mtx);
-      if (!index_map.contains(bep->hdr.key)) {  // allocate new block_meta_list
-        struct block_meta* bm = (struct block_meta*)std::malloc(sizeof(block_meta));
-        if (!bm) {
-          perror("malloc error in pmemkv update_meta");
-          return -1;
+      // set the return point
+      jmp_buf env;
+      if (setjmp(env)) {
+        // end the transaction
+        (void) pmemobj_tx_end();
+        return -1;
+      }
+
+      // begin a transaction, the locks of the arenas touched are acquired
+      // on the way and held until the transaction ends
+      if (pmemobj_tx_begin(pmem_pool, env, TX_PARAM_NONE)) {
+        perror("pmemobj_tx_begin failed in pmemkv remove");
+        return -1;
+      }
+
+      bool locked[PMEMKV_ARENA_NUM] = {};
+      for (auto bml : bmls) {
+        for (struct block_meta* cur = bml->head; cur != nullptr; cur = cur->next) {
+          block_entry* bep = cur->bep;
+          struct arena* ap = &bp->arenas[cur->arena];
+          if (!locked[cur->arena]) {
+            pmemobj_tx_lock(TX_PARAM_MUTEX, &ap->lock);
+            locked[cur->arena] = true;
+            // add the modified arena to the undo data, the lock is not logged
+            pmemobj_tx_add_range_direct(&ap->head, 2 * sizeof(PMEMoid));
+            pmemobj_tx_add_range_direct(&ap->bytes_written, sizeof(uint64_t));
+          }
+          // unlink block entry, the neighbours' links are logged first
+          if (OID_IS_NULL(bep->hdr.pre)) {
+            ap->head = bep->hdr.next;
+          } else {
+            struct block_entry* pre_bep = (struct block_entry*)pmemobj_direct(bep->hdr.pre);
+            pmemobj_tx_add_range_direct(&pre_bep->hdr.next, sizeof(PMEMoid));
+            pre_bep->hdr.next = bep->hdr.next;
+          }
+          if (OID_IS_NULL(bep->hdr.next)) {
+            ap->tail = bep->hdr.pre;
+          } else {
+            struct block_entry* next_bep = (struct block_entry*)pmemobj_direct(bep->hdr.next);
+            pmemobj_tx_add_range_direct(&next_bep->hdr.pre, sizeof(PMEMoid));
+            next_bep->hdr.pre = bep->hdr.pre;
+          }
+          ap->bytes_written -= bep->hdr.size;
+          pmemobj_tx_free(bep->data);
+          pmemobj_tx_free(cur->beo);
         }
-        bytes_allocated += sizeof(block_meta);
-        bm->off = (uint64_t)pmemobj_direct(bep->data);
-        bm->size = bep->hdr.size;
-        bm->next = nullptr;
-        bm->bep = bep;
-        bm->beo = beo;
-        struct block_meta_list* bml = (struct block_meta_list*)std::malloc(sizeof(block_meta_list));
+      }
+      pmemobj_tx_commit();
+      (void) pmemobj_tx_end();
+
+      for (auto bml : bmls) {
+        struct block_meta* cur = bml->head;
+        while (cur != nullptr) {
+          struct block_meta* next = cur->next;
+          std::free(cur);
+          bytes_allocated -= sizeof(block_meta);
+          cur = next;
+        }
+        bytes_allocated -= sizeof(block_meta_list);
+        delete bml;
+      }
+      return 0;
+    }
+
+    // append block to the block_meta_list of its key, the list is only
+    // modified under the index bucket lock so that readers pinning the same
+    // key see a consistent list.
+    int update_meta(struct block_entry* bep, PMEMoid beo, uint32_t arena_id, bool* inserted = nullptr) {
+      struct block_meta* bm = new_block_meta(bep, beo, arena_id);
+      if (!bm) {
+        return -1;
+      }
+      auto append = [bm](block_meta_list* &bml) {
+        bml->tail->next = bm;
+        bml->tail = bm;
+        bml->total_size += bm->size;
+        bml->length += 1;
+      };
+      // append block_meta to existing block_meta_list, or allocate new
+      // block_meta_list, retry if another thread inserted the key meanwhile
+      while (!index_map.update_fn(bep->hdr.key, append)) {
+        struct block_meta_list* bml = new (std::nothrow) block_meta_list();
         if (!bml) {
           perror("malloc error in pmemkv update_meta");
           return -1;
         }
-        bytes_allocated += sizeof(block_meta_list);
         bml->head = bm;
         bml->tail = bml->head;
-        bml->total_size = 0;
-        bml->total_size += bm->size;
-        bml->length = 0;
-        bml->length += 1;
-        index_map.insert(bep->hdr.key, bml);
-      } else {   // append block_meta to existing block_meta_list
-        struct block_meta_list* bml = nullptr;
-        index_map.find(bep->hdr.key, bml);
-        struct block_meta* bm = (struct block_meta*)std::malloc(sizeof(block_meta));
-        if (!bm) {
-          perror("malloc error in pmemkv update_meta");
-          return -1;
+        bml->total_size = bm->size;
+        bml->length = 1;
+        bml->refs = 1;
+        if (index_map.insert(bep->hdr.key, bml)) {
+          bytes_allocated += sizeof(block_meta_list);
+          if (inserted) {
+            *inserted = true;
+          }
+          break;
         }
-        bytes_allocated += sizeof(block_meta);
-        bm->off = (uint64_t)pmemobj_direct(bep->data);
-        bm->size = bep->hdr.size;
-        bm->next = nullptr;
-        bm->bep = bep;
-        bm->beo = beo;
-        bml->tail->next = bm;
-        bml->tail = bm;
-        bml->total_size += bm->size;
-        bml->length += 1;
+        delete bml;
       }
       return 0;
     }
 
+    struct block_meta* new_block_meta(struct block_entry* bep, PMEMoid beo, uint32_t arena_id) {
+      struct block_meta* bm = (struct block_meta*)std::malloc(sizeof(block_meta));
+      if (!bm) {
+        perror("malloc error in pmemkv new_block_meta");
+        return nullptr;
+      }
+      bytes_allocated += sizeof(block_meta);
+      bm->off = (uint64_t)pmemobj_direct(bep->data);
+      bm->size = bep->hdr.size;
+      bm->next = nullptr;
+      bm->bep = bep;
+      bm->beo = beo;
+      bm->arena = arena_id;
+      bm->seq = bep->hdr.seq;
+      return bm;
+    }
+
+    // unindexed list holding one block found with a tombstone on open, it
+    // is handed to the reclaim thread.
+    struct block_meta_list* new_removed_list(struct block_entry* bep, PMEMoid beo, uint32_t arena_id) {
+      struct block_meta* bm = new_block_meta(bep, beo, arena_id);
+      if (!bm) {
+        return nullptr;
+      }
+      struct block_meta_list* bml = new (std::nothrow) block_meta_list();
+      if (!bml) {
+        std::free(bm);
+        bytes_allocated -= sizeof(block_meta);
+        perror("malloc error in pmemkv new_removed_list");
+        return nullptr;
+      }
+      bytes_allocated += sizeof(block_meta_list);
+      bml->head = bm;
+      bml->tail = bm;
+      bml->total_size = bm->size;
+      bml->length = 1;
+      bml->refs = 0;
+      return bml;
+    }
+
   private:
     PMEMobjpool* pmem_pool;
     const char* dev_path;
+    uint64_t pool_size;
     struct base* bp;
     PMEMoid bo;
     libcuckoo::cuckoohash_map<uint64_t, block_meta_list*> index_map;
     std::mutex mtx;
     std::atomic<uint64_t> bytes_allocated{0};
+    std::atomic<uint64_t> next_seq{1};
+    // shuffle id -> map id -> keys
+    std::unordered_map<uint64_t, std::unordered_map<uint64_t, std::vector<uint64_t>>> shuffle_index;
+    std::mutex shuffle_mtx;
+    // removed keys whose blocks wait to be freed
+    std::vector<block_meta_list*> reclaim_queue;
+    std::mutex reclaim_mtx;
+    std::condition_variable reclaim_cv;
+    bool reclaiming = false;
+    bool stopping = false;
+    std::thread reclaimer;
+    std::string open_error;
 };
 
 #endif
@@ -9,27 +9,54 @@
 
 #include <string.h>
 
-#include "pmpool/buffer/CircularBuffer.h"
-
+#include <atomic>
 #include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "pmpool/buffer/CircularBuffer.h"
 
 uint64_t timestamp_now() {
   return std::chrono::high_resolution_clock::now().time_since_epoch() /
-         std::chrono::milliseconds(1);
+         std::chrono::microseconds(1);
+}
+
+std::atomic<uint64_t> count = {0};
+uint64_t buffer_size = 4096;
+uint64_t buffer_num = 4096;
+uint64_t op_num = 10000000;
+std::vector<int> thread_nums = {1, 2, 4, 8, 16, 32};
+
+void func(CircularBuffer* circularbuffer) {
+  while (true) {
+    uint64_t count_ = count++;
+    if (count_ >= op_num) {
+      break;
+    }
+    char* buf = circularbuffer->get(buffer_size);
+    circularbuffer->put(buf, buffer_size);
+  }
 }
 
 int main() {
-  CircularBuffer circularbuffer(1024 * 1024, 2048);
-  uint64_t start = timestamp_now();
-  char str[1048576];
-  memset(str, '0', 1048576);
-  for (int i = 0; i < 20480; i++) {
-    char* buf = circularbuffer.get(1048576);
-    memcpy(buf, str, 1048576);
-    circularbuffer.put(buf, 1048576);
+  CircularBuffer circularbuffer(buffer_size, buffer_num);
+  for (auto thread_num : thread_nums) {
+    count = 0;
+    std::vector<std::thread*> threads;
+    uint64_t start = timestamp_now();
+    for (int i = 0; i < thread_num; i++) {
+      threads.push_back(new std::thread(func, &circularbuffer));
+    }
+    for (int i = 0; i < thread_num; i++) {
+      threads[i]->join();
+      delete threads[i];
+    }
+    uint64_t end = timestamp_now();
+    double seconds = (end - start) / 1000000.0;
+    std::cout << "circular buffer test: " << buffer_size << " bytes, "
+              << thread_num << " threads, consumes " << seconds
+              << "s, get/put throughput is " << op_num / seconds << " ops/s"
+              << std::endl;
   }
-  uint64_t end = timestamp_now();
-  std::cout << "pmemkv put test: 1048576 "
-            << " bytes test, consumes " << (end - start) / 1000.0 << std::endl;
   return 0;
-}
\ No newline at end of file
+}
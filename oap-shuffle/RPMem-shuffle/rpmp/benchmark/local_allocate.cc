@@ -9,37 +9,41 @@
 
 #include <string.h>
 
+#include <atomic>
 #include <iostream>
 #include <memory>
-#include <mutex>   // NOLINT
 #include <thread>  // NOLINT
 #include <vector>
 
 #include "../pmpool/AllocatorProxy.h"
 #include "../pmpool/Config.h"
 #include "../pmpool/Log.h"
-#include "gtest/gtest.h"
 
 uint64_t timestamp_now() {
   return std::chrono::high_resolution_clock::now().time_since_epoch() /
-         std::chrono::milliseconds(1);
+         std::chrono::microseconds(1);
 }
 
-std::mutex mtx;
-uint64_t count = 0;
+std::atomic<uint64_t> count = {0};
 char str[1048576];
+uint64_t block_size = 4096;
+uint64_t block_num = 1000000;
+std::vector<int> thread_nums = {1, 2, 4, 8, 16, 32};
+/// blocks up to SMALL_BLOCK_SIZE are appended to extents, larger ones are
+/// allocated one by one.
+std::vector<uint64_t> block_sizes = {256, 4096, SMALL_BLOCK_SIZE,
+                                     2 * SMALL_BLOCK_SIZE};
+/// bytes written per round, caps block_num of large blocks.
+uint64_t bytes_per_round = 8UL * 1024 * 1024 * 1024;
 
-void func(AllocatorProxy *proxy, int index) {
+/// every thread allocates from the same device to measure allocator scaling.
+void func(AllocatorProxy *proxy) {
   while (true) {
-    std::unique_lock<std::mutex> lk(mtx);
     uint64_t count_ = count++;
-    lk.unlock();
-    if (count_ < 20480) {
-      uint64_t addr = proxy->allocate_and_write(1048576, nullptr, index);
-      proxy->write(addr, str, 1048576);
-    } else {
+    if (count_ >= block_num) {
       break;
     }
+    proxy->allocate_and_write(block_size, str, 0);
   }
 }
 
@@ -49,37 +53,33 @@ int main() {
   std::shared_ptr<Log> log = std::make_shared<Log>(config.get());
   auto allocatorProxy = new AllocatorProxy(config.get(), log.get(), nullptr);
   allocatorProxy->init();
-  std::vector<std::thread *> threads;
   memset(str, '0', 1048576);
 
-  uint64_t start = timestamp_now();
-  int num = 0;
-  for (int i = 0; i < 4; i++) {
-    num++;
-    auto t = new std::thread(func, allocatorProxy, i);
-    threads.push_back(t);
-    cpu_set_t cpuset;
-    CPU_ZERO(&cpuset);
-    if (i == 0) {
-      CPU_SET(2, &cpuset);
-    } else if (i == 1) {
-      CPU_SET(40, &cpuset);
-    } else if (i == 2) {
-      CPU_SET(27, &cpuset);
-    } else {
-      CPU_SET(60, &cpuset);
+  for (auto size : block_sizes) {
+    block_size = size;
+    block_num = std::min<uint64_t>(1000000, bytes_per_round / block_size);
+    for (auto thread_num : thread_nums) {
+      count = 0;
+      std::vector<std::thread *> threads;
+      uint64_t start = timestamp_now();
+      for (int i = 0; i < thread_num; i++) {
+        auto t = new std::thread(func, allocatorProxy);
+        threads.push_back(t);
+      }
+      for (int i = 0; i < thread_num; i++) {
+        threads[i]->join();
+        delete threads[i];
+      }
+      uint64_t end = timestamp_now();
+      double seconds = (end - start) / 1000000.0;
+      std::cout << "local allocate test: " << block_size << " bytes, "
+                << thread_num << " threads, consumes " << seconds
+                << "s, allocations/s is " << block_num / seconds
+                << ", throughput is "
+                << block_num / 1024.0 * block_size / 1024.0 / seconds << "MB/s"
+                << std::endl;
+      allocatorProxy->release_all();
     }
-    int rc =
-        pthread_setaffinity_np(t->native_handle(), sizeof(cpu_set_t), &cpuset);
   }
-  for (int i = 0; i < num; i++) {
-    threads[i]->join();
-    delete threads[i];
-  }
-  uint64_t end = timestamp_now();
-  std::cout << "pmemkv put test: 1048576 "
-            << " bytes test, consumes " << (end - start) / 1000.0
-            << "s, throughput is " << 20480 / ((end - start) / 1000.0) << "MB/s"
-            << std::endl;
-  allocatorProxy->release_all();
+  delete allocatorProxy;
 }
@@ -0,0 +1,100 @@
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "../pmpool/AllocatorProxy.h"
+#include "../pmpool/Config.h"
+#include "../pmpool/Digest.h"
+#include "../pmpool/Log.h"
+
+uint64_t timestamp_now() {
+  return std::chrono::high_resolution_clock::now().time_since_epoch() /
+         std::chrono::milliseconds(1);
+}
+
+std::atomic<uint64_t> count = {0};
+char str[4096];
+uint64_t block_size = 64;
+uint64_t block_num = 10000000;
+uint64_t blocks_per_key = 4;
+int thread_num = 8;
+
+void func(AllocatorProxy *proxy, int index) {
+  while (true) {
+    uint64_t count_ = count++;
+    if (count_ >= block_num) {
+      break;
+    }
+    uint64_t key;
+    Digest::computeKeyHash("key_" + std::to_string(count_ / blocks_per_key),
+                           &key);
+    uint64_t addr = proxy->allocate_and_write(block_size, str, index);
+    proxy->cache_chunk(key, addr, block_size);
+  }
+}
+
+// recovery is measured on a file-backed, non-DAX pool by default, pass a
+// device dax path to measure it on PMem.
+int main(int argc, char **argv) {
+  std::shared_ptr<Config> config = std::make_shared<Config>();
+  config->init(0, nullptr);
+  string path = argc > 1 ? argv[1] : "/tmp/rpmp_recovery.pool";
+  uint64_t pool_size = 4UL * 1024 * 1024 * 1024;
+  if (path.find("/dev/dax") != 0) {
+    // libpmemobj takes the size of a pre-allocated file when size is 0
+    unlink(path.c_str());
+    int fd = ::open(path.c_str(), O_CREAT | O_RDWR, 0666);
+    if (fd < 0 || ftruncate(fd, pool_size)) {
+      perror("failed to create pool file");
+      return -1;
+    }
+    close(fd);
+  }
+  config->set_pool_paths({path});
+  config->set_pool_sizes({pool_size});
+  std::shared_ptr<Log> log = std::make_shared<Log>(config.get());
+  memset(str, '0', 4096);
+
+  auto allocatorProxy = new AllocatorProxy(config.get(), log.get(), nullptr);
+  allocatorProxy->init();
+  std::vector<std::thread *> threads;
+  for (int i = 0; i < thread_num; i++) {
+    auto t = new std::thread(func, allocatorProxy, i);
+    threads.push_back(t);
+  }
+  for (int i = 0; i < thread_num; i++) {
+    threads[i]->join();
+    delete threads[i];
+  }
+  delete allocatorProxy;
+  std::cout << "put " << block_num << " blocks of " << block_size
+            << " bytes." << std::endl;
+
+  uint64_t start = timestamp_now();
+  allocatorProxy = new AllocatorProxy(config.get(), log.get(), nullptr);
+  allocatorProxy->init();
+  uint64_t end = timestamp_now();
+  std::cout << "recovery test: " << block_num << " blocks, "
+            << std::thread::hardware_concurrency() << " cpus, consumes "
+            << (end - start) / 1000.0 << "s, "
+            << block_num / ((end - start) / 1000.0) << " blocks/s"
+            << std::endl;
+
+  uint64_t key;
+  Digest::computeKeyHash("key_0", &key);
+  std::cout << "key_0 has " << allocatorProxy->get_cached_chunk(key).size()
+            << " blocks after recovery." << std::endl;
+  allocatorProxy->release_all();
+  delete allocatorProxy;
+  if (path.find("/dev/dax") != 0) {
+    unlink(path.c_str());
+  }
+  return 0;
+}
@@ -8,71 +8,99 @@
  */
 
 #include <string.h>
+
 #include <atomic>
+#include <deque>
+#include <future>  // NOLINT
 #include <thread>  // NOLINT
+#include <vector>
+
 #include "pmpool/Event.h"
 #include "pmpool/client/PmPoolClient.h"
 
 char str[1048576];
-char str_read[1048576];
 std::atomic<uint64_t> count = {0};
-std::mutex mtx;
 std::vector<PmPoolClient *> clients;
 std::vector<uint64_t> addresses;
-uint64_t buffer_size = 1024*64;
+std::vector<char *> read_buffers;
+uint64_t buffer_size = 1024 * 64;
 uint64_t buffer_num = 1000000;
 int thread_num = 1;
+std::vector<uint64_t> queue_depths = {1, 2, 4, 8, 16, 32, 64};
+/// register destination buffers to skip the staging copy on client.
+bool register_user_buffer = true;
 
 uint64_t timestamp_now() {
   return std::chrono::high_resolution_clock::now().time_since_epoch() /
-         std::chrono::milliseconds(1);
+         std::chrono::microseconds(1);
 }
 
-void func(uint64_t i) {
+/// keep at most depth reads in flight per client, every in-flight read has
+/// its own destination slot.
+void func(uint64_t i, uint64_t depth) {
+  std::deque<std::future<int>> inflight;
+  uint64_t slot = 0;
   while (true) {
     uint64_t count_ = count++;
-    if (count_ < buffer_num) {
-      clients[i]->begin_tx();
-      clients[i]->read(addresses[i], str_read, buffer_size);
-      clients[i]->end_tx();
-    } else {
+    if (count_ >= buffer_num) {
       break;
     }
+    if (inflight.size() >= depth) {
+      inflight.front().get();
+      inflight.pop_front();
+    }
+    char *dest = read_buffers[i] + (slot++ % depth) * buffer_size;
+    inflight.push_back(clients[i]->read_async(addresses[i], dest, buffer_size));
+  }
+  while (!inflight.empty()) {
+    inflight.front().get();
+    inflight.pop_front();
   }
 }
 
 int main() {
-  std::vector<std::thread *> threads;
-
   memset(str, '0', buffer_size);
   for (int i = 0; i < thread_num; i++) {
-    PmPoolClient *client = new PmPoolClient("172.168.0.40", "12346");
+    PmPoolClient *client =
+        new PmPoolClient("172.168.0.40", "12346", queue_depths.back());
     client->init();
     client->begin_tx();
     addresses.push_back(client->write(str, buffer_size));
     client->end_tx();
     clients.push_back(client);
+    read_buffers.push_back(
+        static_cast<char *>(std::malloc(queue_depths.back() * buffer_size)));
+    if (register_user_buffer) {
+      client->register_buffer(read_buffers.back(),
+                              queue_depths.back() * buffer_size);
+    }
   }
-  uint64_t start = timestamp_now();
-  for (int i = 0; i < thread_num; i++) {
-    auto t = new std::thread(func, i);
-    threads.push_back(t);
-  }
-  for (int i = 0; i < thread_num; i++) {
-    threads[i]->join();
-    delete threads[i];
+  for (auto depth : queue_depths) {
+    count = 0;
+    std::vector<std::thread *> threads;
+    uint64_t start = timestamp_now();
+    for (int i = 0; i < thread_num; i++) {
+      auto t = new std::thread(func, i, depth);
+      threads.push_back(t);
+    }
+    for (int i = 0; i < thread_num; i++) {
+      threads[i]->join();
+      delete threads[i];
+    }
+    uint64_t end = timestamp_now();
+    double seconds = (end - start) / 1000000.0;
+    std::cout << "remote read test: " << buffer_size << " bytes, "
+              << thread_num << " clients, queue depth " << depth
+              << ", consumes " << seconds << "s, IOPS is "
+              << buffer_num / seconds << ", bandwidth is "
+              << buffer_num / 1024.0 * buffer_size / 1024.0 / seconds
+              << "MB/s" << std::endl;
   }
-  uint64_t end = timestamp_now();
-  std::cout << "pmemkv put test: " << buffer_size << " "
-            << " bytes test, consumes " << (end - start) / 1000.0
-            << "s, throughput is "
-            << buffer_num / 1024.0 * buffer_size / 1024.0 /
-                   ((end - start) / 1000.0)
-            << "MB/s" << std::endl;
   for (int i = 0; i < thread_num; i++) {
     clients[i]->begin_tx();
     clients[i]->free(addresses[i]);
     clients[i]->end_tx();
+    std::free(read_buffers[i]);
   }
   std::cout << "finished." << std::endl;
   for (int i = 0; i < thread_num; i++) {
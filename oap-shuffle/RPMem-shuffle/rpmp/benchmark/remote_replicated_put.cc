@@ -0,0 +1,97 @@
+#include <string.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "pmpool/client/PmPoolClusterClient.h"
+
+uint64_t timestamp_now() {
+  return std::chrono::high_resolution_clock::now().time_since_epoch() /
+         std::chrono::microseconds(1);
+}
+
+std::vector<std::pair<std::string, std::string>> servers = {
+    {"172.168.0.40", "12346"},
+    {"172.168.0.41", "12346"},
+    {"172.168.0.42", "12346"}};
+std::atomic<uint64_t> count = {0};
+uint64_t buffer_size = 65536;
+uint64_t buffer_num = 102400;
+int thread_num = 4;
+std::vector<uint32_t> replica_nums = {1, 2, 3};
+
+std::string get_key(uint64_t i) {
+  return "shuffle_0_" + std::to_string(i) + "_0";
+}
+
+void func_put(PmPoolClusterClient *client, const char *str) {
+  while (true) {
+    uint64_t count_ = count++;
+    if (count_ >= buffer_num) {
+      break;
+    }
+    client->put(get_key(count_), str, buffer_size);
+  }
+}
+
+void func_read(PmPoolClusterClient *client) {
+  std::vector<char> data(buffer_size);
+  while (true) {
+    uint64_t count_ = count++;
+    if (count_ >= buffer_num) {
+      break;
+    }
+    client->read(get_key(count_), data.data(), buffer_size);
+  }
+}
+
+void report(const std::string &name, uint32_t replica_num, uint64_t start,
+            uint64_t end) {
+  double seconds = (end - start) / 1000000.0;
+  std::cout << name << " test: " << buffer_size << " bytes, " << thread_num
+            << " threads, replica num " << replica_num << ", consumes "
+            << seconds << "s, IOPS is " << buffer_num / seconds
+            << ", bandwidth is "
+            << buffer_num / 1024.0 * buffer_size / 1024.0 / seconds << "MB/s"
+            << std::endl;
+}
+
+template <typename F, typename... Args>
+void run(F f, Args... args) {
+  count = 0;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_num; i++) {
+    threads.emplace_back(f, args...);
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+}
+
+int main() {
+  std::vector<char> str(buffer_size, '0');
+  for (auto replica_num : replica_nums) {
+    PmPoolClusterClient client(servers, thread_num, DEFAULT_VIRTUAL_NODE_NUM,
+                               replica_num);
+    if (client.init()) {
+      std::cout << "failed to connect servers." << std::endl;
+      return -1;
+    }
+    uint64_t start = timestamp_now();
+    run(func_put, &client, str.data());
+    report("replicated put", replica_num, start, timestamp_now());
+    start = timestamp_now();
+    run(func_read, &client);
+    report("replicated read", replica_num, start, timestamp_now());
+    for (uint64_t i = 0; i < buffer_num; i++) {
+      client.del(get_key(i));
+    }
+    client.shutdown();
+  }
+  return 0;
+}
@@ -8,91 +8,98 @@
  */
 
 #include <string.h>
+
+#include <atomic>
+#include <deque>
+#include <future>  // NOLINT
 #include <thread>  // NOLINT
+#include <vector>
+
 #include "pmpool/client/PmPoolClient.h"
 
 uint64_t timestamp_now() {
   return std::chrono::high_resolution_clock::now().time_since_epoch() /
-         std::chrono::milliseconds(1);
+         std::chrono::microseconds(1);
 }
 
-int count = 0;
-std::mutex mtx;
-uint64_t addresses[20480];
+std::atomic<uint64_t> count = {0};
 char str[1048576];
+std::vector<PmPoolClient *> clients;
+std::vector<std::vector<uint64_t>> addresses;
+uint64_t buffer_size = 1048576;
+uint64_t buffer_num = 20480;
+int thread_num = 4;
+std::vector<uint64_t> queue_depths = {1, 2, 4, 8, 16, 32, 64};
+/// register source buffer to skip the staging copy on client.
+bool register_user_buffer = true;
 
-void func(PmPoolClient* client) {
+/// keep at most depth writes in flight per client.
+void func1(int i, uint64_t depth) {
+  std::deque<std::future<uint64_t>> inflight;
   while (true) {
-    std::unique_lock<std::mutex> lk(mtx);
     uint64_t count_ = count++;
-    lk.unlock();
-    if (count_ < 20480) {
-      client->begin_tx();
-      auto addr = client->alloc(1048576);
-      client->end_tx();
-      addresses[count_] = addr;
-    } else {
+    if (count_ >= buffer_num) {
       break;
     }
-  }
-}
-
-void func1(PmPoolClient* client) {
-  while (true) {
-    std::unique_lock<std::mutex> lk(mtx);
-    uint64_t count_ = count++;
-    lk.unlock();
-    if (count_ < 20480) {
-      client->begin_tx();
-      client->write(addresses[count_], str, 1048576);
-      client->end_tx();
-    } else {
-      break;
+    if (inflight.size() >= depth) {
+      addresses[i].push_back(inflight.front().get());
+      inflight.pop_front();
     }
+    inflight.push_back(clients[i]->write_async(str, buffer_size));
+  }
+  while (!inflight.empty()) {
+    addresses[i].push_back(inflight.front().get());
+    inflight.pop_front();
   }
 }
 
 int main() {
-  std::vector<std::thread*> threads;
-  PmPoolClient client("172.168.0.40", "12346");
-  memset(str, '0', 1048576);
-  client.init();
+  memset(str, '0', buffer_size);
 
-  int num = 0;
-  for (int i = 0; i < 1; i++) {
-    num++;
-    auto t = new std::thread(func, &client);
-    threads.push_back(t);
-  }
-  for (int i = 0; i < num; i++) {
-    threads[i]->join();
-    delete threads[i];
+  for (int i = 0; i < thread_num; i++) {
+    PmPoolClient *client =
+        new PmPoolClient("172.168.0.40", "12346", queue_depths.back());
+    client->begin_tx();
+    client->init();
+    client->end_tx();
+    if (register_user_buffer) {
+      client->register_buffer(str, buffer_size);
+    }
+    clients.push_back(client);
+    addresses.push_back(std::vector<uint64_t>());
   }
   std::cout << "start write." << std::endl;
-  num = 0;
-  count = 0;
-  std::vector<std::thread*> threads_1;
-  uint64_t start = timestamp_now();
-  for (int i = 0; i < 8; i++) {
-    num++;
-    auto t = new std::thread(func1, &client);
-    threads_1.push_back(t);
-  }
-  for (int i = 0; i < num; i++) {
-    threads_1[i]->join();
-    delete threads_1[i];
-  }
-  uint64_t end = timestamp_now();
-  std::cout << "pmemkv put test: 1048576 "
-            << " bytes test, consumes " << (end - start) / 1000.0
-            << "s, throughput is " << 20480 / ((end - start) / 1000.0) << "MB/s"
-            << std::endl;
-  for (int i = 0; i < 20480; i++) {
-    client.begin_tx();
-    client.free(addresses[i]);
-    client.end_tx();
+  for (auto depth : queue_depths) {
+    count = 0;
+    std::vector<std::thread *> threads;
+    uint64_t start = timestamp_now();
+    for (int i = 0; i < thread_num; i++) {
+      auto t = new std::thread(func1, i, depth);
+      threads.push_back(t);
+    }
+    for (int i = 0; i < thread_num; i++) {
+      threads[i]->join();
+      delete threads[i];
+    }
+    uint64_t end = timestamp_now();
+    double seconds = (end - start) / 1000000.0;
+    std::cout << "remote write test: " << buffer_size << " bytes, "
+              << thread_num << " clients, queue depth " << depth
+              << ", consumes " << seconds << "s, IOPS is "
+              << buffer_num / seconds << ", bandwidth is "
+              << buffer_num / 1024.0 * buffer_size / 1024.0 / seconds
+              << "MB/s" << std::endl;
+    for (int i = 0; i < thread_num; i++) {
+      for (auto address : addresses[i]) {
+        clients[i]->free(address);
+      }
+      addresses[i].clear();
+    }
   }
   std::cout << "freed." << std::endl;
-  client.wait();
+  for (int i = 0; i < thread_num; i++) {
+    clients[i]->wait();
+    delete clients[i];
+  }
   return 0;
 }
@@ -13,6 +13,9 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
+
+#include "Base.h"
 
 class Chunk;
 
@@ -30,6 +33,13 @@ struct Addr {
   uint64_t size;
 };
 
+/// block put under a key, seq orders the blocks of one key.
+struct KeyedBlock {
+  uint64_t key;
+  uint64_t seq;
+  block_meta bm;
+};
+
 struct DiskInfo {
   DiskInfo(string& path_, uint64_t size_) : path(path_), size(size_) {}
   string path;
@@ -42,10 +52,20 @@ class Allocator {
   virtual uint64_t allocate_and_write(uint64_t buffer_size,
                                       const char* content = nullptr) = 0;
   virtual int write(uint64_t address, const char* content, uint64_t size) = 0;
+  virtual int persist(uint64_t address, uint64_t size) = 0;
+  /// flush without waiting, data is persistent after the next drain.
+  virtual int flush(uint64_t address, uint64_t size) = 0;
+  virtual void drain() = 0;
+  /// persist the keys of a batch of blocks, they become visible to recovery.
+  virtual int set_block_keys(const std::vector<KeyedBlock>& blocks) = 0;
+  /// collect all blocks that were put under a key.
+  virtual int get_keyed_blocks(std::vector<KeyedBlock>* blocks) = 0;
   virtual int release(uint64_t address) = 0;
   virtual int release_all() = 0;
   virtual int dump_all() = 0;
   virtual uint64_t get_virtual_address(uint64_t address) = 0;
+  /// bytes of blocks that are allocated and not yet released.
+  virtual uint64_t get_used_bytes() = 0;
   virtual Chunk* get_rma_chunk() = 0;
 };
 #endif  // PMPOOL_ALLOCATOR_H_
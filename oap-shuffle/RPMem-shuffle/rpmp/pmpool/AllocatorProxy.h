@@ -10,13 +10,14 @@
 #ifndef PMPOOL_ALLOCATORPROXY_H_
 #define PMPOOL_ALLOCATORPROXY_H_
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
-#include <unordered_map>
 
 #include "Allocator.h"
+#include "BlockIndex.h"
 #include "Config.h"
 #include "DataServer.h"
 #include "Log.h"
@@ -25,7 +26,6 @@
 
 using std::atomic;
 using std::make_shared;
-using std::unordered_map;
 using std::string;
 using std::vector;
 
@@ -61,9 +61,11 @@ class AllocatorProxy {
 
   int init() {
     for (int i = 0; i < diskInfos_.size(); i++) {
-      allocators_[i]->init();
+      if (allocators_[i]->init()) {
+        return -1;
+      }
     }
-    return 0;
+    return recover_index();
   }
 
   uint64_t allocate_and_write(uint64_t size, const char *content = nullptr,
@@ -76,6 +78,7 @@ class AllocatorProxy {
       addr = allocators_[index % diskInfos_.size()]->allocate_and_write(
           size, content);
     }
+    return addr;
   }
 
   int write(uint64_t address, const char *content, uint64_t size) {
@@ -83,6 +86,18 @@ class AllocatorProxy {
     return allocators_[wid]->write(address, content, size);
   }
 
+  int persist(uint64_t address, uint64_t size) {
+    uint32_t wid = GET_WID(address);
+    return allocators_[wid]->persist(address, size);
+  }
+
+  int flush(uint64_t address, uint64_t size) {
+    uint32_t wid = GET_WID(address);
+    return allocators_[wid]->flush(address, size);
+  }
+
+  void drain(uint32_t wid) { allocators_[wid]->drain(); }
+
   int release(uint64_t address) {
     uint32_t wid = GET_WID(address);
     return allocators_[wid]->release(address);
@@ -107,6 +122,12 @@ class AllocatorProxy {
     return allocators_[wid]->get_virtual_address(address);
   }
 
+  uint64_t get_used_bytes(uint32_t wid) {
+    return allocators_[wid]->get_used_bytes();
+  }
+
+  uint64_t get_capacity(uint32_t wid) { return diskInfos_[wid]->size; }
+
   Chunk *get_rma_chunk(uint64_t address) {
     uint32_t wid = GET_WID(address);
     return allocators_[wid]->get_rma_chunk();
@@ -118,26 +139,59 @@ class AllocatorProxy {
   }
 
   void cache_chunk(uint64_t key, block_meta bm) {
-    if (kv_meta_map.count(key)) {
-      kv_meta_map[key].push_back(bm);
-    } else {
-      vector<block_meta> bml;
-      bml.push_back(bm);
-      kv_meta_map[key] = bml;
+    vector<KeyedBlock> blocks = {{key, 0, bm}};
+    cache_chunks(&blocks);
+  }
+
+  /// persist the keys of a batch of put blocks with one barrier per
+  /// allocator, then index them in order.
+  void cache_chunks(vector<KeyedBlock> *blocks) {
+    vector<vector<KeyedBlock>> blocks_per_allocator(diskInfos_.size());
+    for (auto &block : *blocks) {
+      block.seq = seq_++;
+      blocks_per_allocator[GET_WID(block.bm.address)].push_back(block);
+    }
+    for (int i = 0; i < diskInfos_.size(); i++) {
+      if (!blocks_per_allocator[i].empty()) {
+        allocators_[i]->set_block_keys(blocks_per_allocator[i]);
+      }
+    }
+    for (auto &block : *blocks) {
+      kv_index_.append(block.key, block.bm);
     }
   }
 
   vector<block_meta> get_cached_chunk(uint64_t key) {
-    if (kv_meta_map.count(key)) {
-      return kv_meta_map[key];
-    }
-    return vector<block_meta>();
+    return kv_index_.get(key);
   }
 
-  void del_chunk(uint64_t key) {
-    if (kv_meta_map.count(key))  {
-      kv_meta_map.erase(key);
+  void del_chunk(uint64_t key) { kv_index_.remove(key); }
+
+ private:
+  /// rebuild key index from the block headers persisted in every allocator.
+  int recover_index() {
+    vector<KeyedBlock> blocks;
+    for (int i = 0; i < diskInfos_.size(); i++) {
+      if (allocators_[i]->get_keyed_blocks(&blocks)) {
+        return -1;
+      }
     }
+    std::sort(blocks.begin(), blocks.end(),
+              [](const KeyedBlock &a, const KeyedBlock &b) {
+                return a.key < b.key || (a.key == b.key && a.seq < b.seq);
+              });
+    uint64_t max_seq = 0;
+    for (auto &block : blocks) {
+      kv_index_.append(block.key, block.bm);
+      max_seq = std::max(max_seq, block.seq);
+    }
+    seq_ = max_seq + 1;
+    if (!blocks.empty()) {
+      log_->get_file_log()->info("recovered " + std::to_string(blocks.size()) +
+                                 " blocks of " +
+                                 std::to_string(kv_index_.size()) + " keys.");
+    }
+    return 0;
   }
 
  private:
@@ -146,7 +200,8 @@ class AllocatorProxy {
   vector<Allocator *> allocators_;
   vector<DiskInfo *> diskInfos_;
   atomic<uint64_t> buffer_id_{0};
-  unordered_map<uint64_t, vector<block_meta>> kv_meta_map;
+  atomic<uint64_t> seq_{1};
+  BlockIndex kv_index_;
 };
 
 #endif  // PMPOOL_ALLOCATORPROXY_H_
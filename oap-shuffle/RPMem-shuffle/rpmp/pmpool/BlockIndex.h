@@ -0,0 +1,137 @@
+#ifndef PMPOOL_BLOCKINDEX_H_
+#define PMPOOL_BLOCKINDEX_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "Base.h"
+#include "Common.h"
+
+#define BLOCK_INDEX_BUCKET_NUM 65536
+
+using std::shared_ptr;
+using std::vector;
+
+/**
+ * @brief Concurrent index from key to the list of blocks put under that key.
+ * Lookups don't take the bucket lock, they load an immutable snapshot of the
+ * block list with the atomic shared_ptr operations. Those are not lock-free:
+ * libstdc++ implements them with a small pool of global mutexes picked by
+ * address, so a reader only holds such a mutex for the pointer copy and never
+ * waits on a writer's bucket lock. Writers that hit the same bucket are
+ * serialized by its spin lock. Appending a block publishes a new list node
+ * pointing to the previous snapshot, so readers see either the old or the new
+ * list, never a partial one.
+ */
+class BlockIndex {
+ public:
+  explicit BlockIndex(uint64_t bucket_num = BLOCK_INDEX_BUCKET_NUM)
+      : bucket_num_(bucket_num), buckets_(new Bucket[bucket_num]) {}
+  BlockIndex(const BlockIndex &) = delete;
+  BlockIndex &operator=(const BlockIndex &) = delete;
+
+  /// append block to the block list of key, create key if absent.
+  void append(uint64_t key, const block_meta &bm) {
+    Bucket &bucket = get_bucket(key);
+    std::lock_guard<spin_mutex> l(bucket.mtx);
+    shared_ptr<KeyNode> node = find(bucket, key);
+    if (node == nullptr) {
+      node = std::make_shared<KeyNode>();
+      node->key = key;
+      node->next = std::atomic_load(&bucket.head);
+      std::atomic_store(&bucket.head, node);
+      key_num_++;
+    }
+    auto prev = std::atomic_load(&node->blocks);
+    auto block = std::make_shared<BlockNode>();
+    block->bm = bm;
+    block->count = prev == nullptr ? 1 : prev->count + 1;
+    block->prev = prev;
+    std::atomic_store(&node->blocks,
+                      std::shared_ptr<const BlockNode>(std::move(block)));
+  }
+
+  /// return blocks of key in the order they were appended.
+  vector<block_meta> get(uint64_t key) {
+    vector<block_meta> bml;
+    shared_ptr<KeyNode> node = find(get_bucket(key), key);
+    if (node == nullptr) {
+      return bml;
+    }
+    auto block = std::atomic_load(&node->blocks);
+    if (block == nullptr) {
+      return bml;
+    }
+    bml.resize(block->count);
+    for (uint64_t i = block->count; block != nullptr; block = block->prev) {
+      bml[--i] = block->bm;
+    }
+    return bml;
+  }
+
+  /// remove key and its block list.
+  /// Return true if key exists.
+  bool remove(uint64_t key) {
+    Bucket &bucket = get_bucket(key);
+    std::lock_guard<spin_mutex> l(bucket.mtx);
+    shared_ptr<KeyNode> prev = nullptr;
+    shared_ptr<KeyNode> node = std::atomic_load(&bucket.head);
+    while (node != nullptr) {
+      if (node->key == key) {
+        auto next = std::atomic_load(&node->next);
+        if (prev == nullptr) {
+          std::atomic_store(&bucket.head, next);
+        } else {
+          std::atomic_store(&prev->next, next);
+        }
+        key_num_--;
+        return true;
+      }
+      prev = node;
+      node = std::atomic_load(&node->next);
+    }
+    return false;
+  }
+
+  /// return the number of keys.
+  uint64_t size() { return key_num_.load(); }
+
+ private:
+  struct BlockNode {
+    block_meta bm;
+    uint64_t count;
+    shared_ptr<const BlockNode> prev;
+  };
+
+  struct KeyNode {
+    uint64_t key;
+    shared_ptr<const BlockNode> blocks;
+    shared_ptr<KeyNode> next;
+  };
+
+  struct Bucket {
+    spin_mutex mtx;
+    shared_ptr<KeyNode> head;
+  };
+
+  Bucket &get_bucket(uint64_t key) { return buckets_[key % bucket_num_]; }
+
+  shared_ptr<KeyNode> find(Bucket &bucket, uint64_t key) {
+    shared_ptr<KeyNode> node = std::atomic_load(&bucket.head);
+    while (node != nullptr && node->key != key) {
+      node = std::atomic_load(&node->next);
+    }
+    return node;
+  }
+
+ private:
+  uint64_t bucket_num_;
+  std::unique_ptr<Bucket[]> buckets_;
+  std::atomic<uint64_t> key_num_{0};
+};
+
+#endif  // PMPOOL_BLOCKINDEX_H_
@@ -12,6 +12,9 @@
 
 #include <atomic>
 
+/// default number of requests one client keeps in flight.
+#define DEFAULT_MAX_INFLIGHT 64
+
 class spin_mutex {
  public:
   std::atomic_flag flag = ATOMIC_FLAG_INIT;
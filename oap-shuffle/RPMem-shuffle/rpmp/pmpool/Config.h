@@ -46,6 +46,17 @@ class Config {
                                        "set network wroker number")(
           "paths,ps", value<vector<string>>(), "set memory pool path")(
           "sizes,ss", value<vector<int>>(), "set memory pool size")(
+          "affinities,af", value<vector<uint64_t>>(),
+          "set cpu of workers per memory pool, by default workers run on "
+          "the NUMA node of their memory pool")(
+          "recv_affinities,raf", value<vector<uint64_t>>(),
+          "set cpu of recv workers per memory pool, defaults to affinities")(
+          "metrics_path,mp", value<string>()->default_value(""),
+          "set file that metrics are dumped to, empty to disable")(
+          "metrics_interval,mi", value<int>()->default_value(10000),
+          "set metrics dump interval in milliseconds")(
+          "trace_sample_rate,tsr", value<int>()->default_value(0),
+          "trace one of every n requests, 0 to disable")(
           "log,l", value<string>()->default_value("/tmp/rpmp.log"),
           "set rpmp log file path")("log_level,ll",
                                     value<string>()->default_value("warn"),
@@ -72,10 +83,15 @@ class Config {
       sizes_.push_back(126833655808L);
       sizes_.push_back(126833655808L);
       sizes_.push_back(126833655808L);
-      affinities_.push_back(2);
-      affinities_.push_back(41);
-      affinities_.push_back(22);
-      affinities_.push_back(60);
+      if (vm.count("affinities")) {
+        set_affinities_(vm["affinities"].as<vector<uint64_t>>());
+      }
+      if (vm.count("recv_affinities")) {
+        set_recv_affinities(vm["recv_affinities"].as<vector<uint64_t>>());
+      }
+      set_metrics_path(vm["metrics_path"].as<string>());
+      set_metrics_interval(vm["metrics_interval"].as<int>());
+      set_trace_sample_rate(vm["trace_sample_rate"].as<int>());
       set_log_path(vm["log"].as<string>());
       set_log_level(vm["log_level"].as<string>());
     } catch (const error &ex) {
@@ -116,6 +132,27 @@ class Config {
   int get_pool_size() { return sizes_.size(); }
 
   std::vector<uint64_t> get_affinities_() { return affinities_; }
+  void set_affinities_(vector<uint64_t> affinities) {
+    affinities_ = affinities;
+  }
+
+  std::vector<uint64_t> get_recv_affinities() { return recv_affinities_; }
+  void set_recv_affinities(vector<uint64_t> recv_affinities) {
+    recv_affinities_ = recv_affinities;
+  }
+
+  string get_metrics_path() { return metrics_path_; }
+  void set_metrics_path(string metrics_path) { metrics_path_ = metrics_path; }
+
+  int get_metrics_interval() { return metrics_interval_; }
+  void set_metrics_interval(int metrics_interval) {
+    metrics_interval_ = metrics_interval;
+  }
+
+  int get_trace_sample_rate() { return trace_sample_rate_; }
+  void set_trace_sample_rate(int trace_sample_rate) {
+    trace_sample_rate_ = trace_sample_rate;
+  }
 
   string get_log_path() { return log_path_; }
   void set_log_path(string log_path) { log_path_ = log_path; }
@@ -132,6 +169,10 @@ class Config {
   vector<string> pool_paths_;
   vector<uint64_t> sizes_;
   vector<uint64_t> affinities_;
+  vector<uint64_t> recv_affinities_;
+  string metrics_path_;
+  int metrics_interval_ = 10000;
+  int trace_sample_rate_ = 0;
   string log_path_;
   string log_level_;
 };
@@ -0,0 +1,117 @@
+/*
+ * Filename: /mnt/spark-pmof/tool/rpmp/pmpool/ConsistentHash.h
+ * Path: /mnt/spark-pmof/tool/rpmp/pmpool
+ * Created Date: Saturday, October 17th 2026, 1:12:05 pm
+ * Author: root
+ *
+ * Copyright (c) 2026 Intel
+ */
+
+#ifndef PMPOOL_CONSISTENTHASH_H_
+#define PMPOOL_CONSISTENTHASH_H_
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Digest.h"
+
+#define DEFAULT_VIRTUAL_NODE_NUM 128
+
+using std::string;
+
+/**
+ * @brief Hash ring that maps key hash to RPMP server. Every server is placed
+ * on the ring as virtual_node_num virtual nodes, a key belongs to the first
+ * virtual node clockwise from its hash. Adding or removing a server only
+ * remaps the keys of its own virtual nodes.
+ */
+class ConsistentHash {
+ public:
+  explicit ConsistentHash(uint32_t virtual_node_num = DEFAULT_VIRTUAL_NODE_NUM)
+      : virtual_node_num_(virtual_node_num) {}
+
+  void add_node(const string &node) {
+    if (!nodes_.insert(node).second) {
+      return;
+    }
+    for (uint32_t i = 0; i < virtual_node_num_; i++) {
+      uint64_t hash;
+      Digest::computeKeyHash(node + "#" + std::to_string(i), &hash);
+      ring_.insert(std::make_pair(hash, node));
+    }
+  }
+
+  void remove_node(const string &node) {
+    if (!nodes_.erase(node)) {
+      return;
+    }
+    for (auto it = ring_.begin(); it != ring_.end();) {
+      if (it->second == node) {
+        it = ring_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  /// Return the node that owns key hash, empty string if ring is empty.
+  string get_node(uint64_t key_hash) const {
+    if (ring_.empty()) {
+      return "";
+    }
+    auto it = ring_.lower_bound(key_hash);
+    if (it == ring_.end()) {
+      it = ring_.begin();
+    }
+    return it->second;
+  }
+
+  string get_node(const string &key) const {
+    uint64_t key_hash;
+    Digest::computeKeyHash(key, &key_hash);
+    return get_node(key_hash);
+  }
+
+  /// Return up to num distinct nodes clockwise from key hash, the first one
+  /// is the owner of key and the others hold its replicas.
+  std::vector<string> get_nodes(uint64_t key_hash, uint64_t num) const {
+    std::vector<string> nodes;
+    if (ring_.empty()) {
+      return nodes;
+    }
+    num = std::min<uint64_t>(num, nodes_.size());
+    auto it = ring_.lower_bound(key_hash);
+    while (nodes.size() < num) {
+      if (it == ring_.end()) {
+        it = ring_.begin();
+      }
+      if (std::find(nodes.begin(), nodes.end(), it->second) == nodes.end()) {
+        nodes.push_back(it->second);
+      }
+      ++it;
+    }
+    return nodes;
+  }
+
+  std::vector<string> get_nodes(const string &key, uint64_t num) const {
+    uint64_t key_hash;
+    Digest::computeKeyHash(key, &key_hash);
+    return get_nodes(key_hash, num);
+  }
+
+  bool contains(const string &node) const { return nodes_.count(node) != 0; }
+
+  uint64_t size() const { return nodes_.size(); }
+
+ private:
+  uint32_t virtual_node_num_;
+  std::map<uint64_t, string> ring_;
+  std::set<string> nodes_;
+};
+
+#endif  // PMPOOL_CONSISTENTHASH_H_
@@ -31,7 +31,8 @@ RequestContext &Request::get_rc() { return requestContext_; }
 
 void Request::encode() {
   OpType rt = requestContext_.type;
-  assert(rt == ALLOC || rt == FREE || rt == WRITE || rt == READ);
+  assert(rt == ALLOC || rt == FREE || rt == WRITE || rt == READ ||
+         rt == PUT || rt == GET_META || rt == DELETE);
   requestMsg_.type = requestContext_.type;
   requestMsg_.rid = requestContext_.rid;
   requestMsg_.address = requestContext_.address;
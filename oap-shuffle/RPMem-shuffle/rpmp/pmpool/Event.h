@@ -68,7 +68,13 @@ struct RequestReplyContext {
   uint64_t key;
   Connection* con;
   Chunk* ck;
+  /// true if RMA targets PMem directly instead of DRAM circular buffer.
+  bool rma_direct;
   vector <block_meta> bml;
+  /// server side timestamps in nanoseconds, for metrics and tracing.
+  uint64_t recv_ts;
+  uint64_t rma_ts;
+  bool traced;
 };
 
 template <class T>
@@ -115,6 +121,8 @@ struct RequestContext {
   uint64_t size;
   uint64_t key;
   Connection* con;
+  /// server side timestamp in nanoseconds when request was received.
+  uint64_t recv_ts;
 };
 
 class Request {
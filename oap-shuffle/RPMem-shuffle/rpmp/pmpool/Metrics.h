@@ -0,0 +1,273 @@
+#ifndef PMPOOL_METRICS_H_
+#define PMPOOL_METRICS_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <fstream>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "ThreadWrapper.h"
+
+using std::string;
+using std::vector;
+
+// values below 2^HISTOGRAM_SUB_BUCKET_BITS are recorded exactly, larger
+// values with a relative error below 2^-HISTOGRAM_SUB_BUCKET_BITS.
+#define HISTOGRAM_SUB_BUCKET_BITS 5
+#define HISTOGRAM_SUB_BUCKET_NUM (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_BUCKET_NUM \
+  (HISTOGRAM_SUB_BUCKET_NUM * (64 - HISTOGRAM_SUB_BUCKET_BITS + 1))
+// number of request types that metrics are kept for.
+#define METRICS_OP_NUM 16
+
+inline uint64_t metrics_now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * @brief Lock-free HDR style histogram. Buckets are log-linear, every power
+ * of two range is split into HISTOGRAM_SUB_BUCKET_NUM linear sub buckets.
+ * Recording is a relaxed atomic increment, reading while recording gives an
+ * approximate snapshot.
+ */
+class Histogram {
+ public:
+  Histogram() {
+    for (auto &bucket : buckets_) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+  Histogram(const Histogram &) = delete;
+  Histogram &operator=(const Histogram &) = delete;
+
+  void record(uint64_t value) {
+    buckets_[get_bucket(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (value > max &&
+           !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  uint64_t count() { return count_.load(std::memory_order_relaxed); }
+  uint64_t sum() { return sum_.load(std::memory_order_relaxed); }
+  uint64_t max() { return max_.load(std::memory_order_relaxed); }
+
+  /// return the upper bound of the bucket holding the p-th percentile,
+  /// p is in [0, 100].
+  uint64_t percentile(double p) {
+    uint64_t total = 0;
+    uint64_t counts[HISTOGRAM_BUCKET_NUM];
+    for (int i = 0; i < HISTOGRAM_BUCKET_NUM; i++) {
+      counts[i] = buckets_[i].load(std::memory_order_relaxed);
+      total += counts[i];
+    }
+    if (total == 0) {
+      return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(p / 100 * total + 0.5);
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKET_NUM; i++) {
+      seen += counts[i];
+      if (seen >= rank) {
+        return std::min(get_upper_bound(i), max());
+      }
+    }
+    return max();
+  }
+
+  static int get_bucket(uint64_t value) {
+    if (value < HISTOGRAM_SUB_BUCKET_NUM) {
+      return value;
+    }
+    int exp = 63 - __builtin_clzll(value);
+    int shift = exp - HISTOGRAM_SUB_BUCKET_BITS;
+    int sub = (value >> shift) - HISTOGRAM_SUB_BUCKET_NUM;
+    return HISTOGRAM_SUB_BUCKET_NUM * (shift + 1) + sub;
+  }
+
+  static uint64_t get_upper_bound(int bucket) {
+    if (bucket < HISTOGRAM_SUB_BUCKET_NUM) {
+      return bucket;
+    }
+    int shift = bucket / HISTOGRAM_SUB_BUCKET_NUM - 1;
+    uint64_t sub = bucket % HISTOGRAM_SUB_BUCKET_NUM;
+    uint64_t lower = (HISTOGRAM_SUB_BUCKET_NUM + sub) << shift;
+    return lower + ((1ULL << shift) - 1);
+  }
+
+ private:
+  std::atomic<uint64_t> buckets_[HISTOGRAM_BUCKET_NUM];
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> max_{0};
+};
+
+/// metrics of one request type.
+struct OpMetrics {
+  std::atomic<uint64_t> requests{0};
+  std::atomic<uint64_t> errors{0};
+  std::atomic<uint64_t> bytes_in{0};
+  std::atomic<uint64_t> bytes_out{0};
+  /// nanoseconds from receiving request to sending reply.
+  Histogram latency;
+};
+
+/**
+ * @brief Server metrics: per request type counters and latency histograms,
+ * plus gauges that are read when metrics are dumped, e.g. queue depths and
+ * pool usage. One in trace_sample_rate requests is traced, 0 disables
+ * tracing.
+ */
+class Metrics {
+ public:
+  explicit Metrics(uint64_t trace_sample_rate = 0)
+      : trace_sample_rate_(trace_sample_rate) {}
+  Metrics(const Metrics &) = delete;
+  Metrics &operator=(const Metrics &) = delete;
+
+  void record(uint32_t type, uint64_t latency_ns, uint64_t bytes_in,
+              uint64_t bytes_out, bool success) {
+    OpMetrics &op = ops_[get_op_index(type)];
+    op.requests.fetch_add(1, std::memory_order_relaxed);
+    if (!success) {
+      op.errors.fetch_add(1, std::memory_order_relaxed);
+    }
+    op.bytes_in.fetch_add(bytes_in, std::memory_order_relaxed);
+    op.bytes_out.fetch_add(bytes_out, std::memory_order_relaxed);
+    op.latency.record(latency_ns);
+  }
+
+  OpMetrics &get_op_metrics(uint32_t type) { return ops_[get_op_index(type)]; }
+
+  /// return true if request should be traced. rids restart at 0 on every
+  /// client, so the choice is a hash of rid and client instead of rid % rate,
+  /// which would trace the first request of every client.
+  bool sample(uint64_t rid, uint64_t client = 0) {
+    return trace_sample_rate_ != 0 &&
+           mix(rid ^ mix(client)) % trace_sample_rate_ == 0;
+  }
+
+  /// register gauge, gauges have to be registered before metrics are dumped.
+  void add_gauge(const string &name, std::function<uint64_t()> gauge) {
+    std::lock_guard<std::mutex> l(gauges_mtx_);
+    gauges_.push_back(std::make_pair(name, gauge));
+  }
+
+  /// dump all metrics, one "name value" per line.
+  string dump() {
+    std::stringstream ss;
+    for (int i = 0; i < METRICS_OP_NUM; i++) {
+      OpMetrics &op = ops_[i];
+      uint64_t requests = op.requests.load(std::memory_order_relaxed);
+      if (requests == 0) {
+        continue;
+      }
+      string prefix = "rpmp_" + get_op_name(i) + "_";
+      ss << prefix << "requests " << requests << "\n";
+      ss << prefix << "errors " << op.errors.load() << "\n";
+      ss << prefix << "bytes_in " << op.bytes_in.load() << "\n";
+      ss << prefix << "bytes_out " << op.bytes_out.load() << "\n";
+      ss << prefix << "latency_ns_mean "
+         << op.latency.sum() / std::max<uint64_t>(op.latency.count(), 1)
+         << "\n";
+      for (double p : {50.0, 90.0, 99.0, 99.9, 99.99}) {
+        std::stringstream name;
+        name << prefix << "latency_ns_p" << p;
+        ss << name.str() << " " << op.latency.percentile(p) << "\n";
+      }
+      ss << prefix << "latency_ns_max " << op.latency.max() << "\n";
+    }
+    std::lock_guard<std::mutex> l(gauges_mtx_);
+    for (auto &gauge : gauges_) {
+      ss << "rpmp_" << gauge.first << " " << gauge.second() << "\n";
+    }
+    return ss.str();
+  }
+
+  static string get_op_name(int index) {
+    static const char *names[] = {"unknown", "alloc", "free",     "prepare",
+                                  "write",   "read",  "put",      "get",
+                                  "get_meta", "delete"};
+    if (index < sizeof(names) / sizeof(names[0])) {
+      return names[index];
+    }
+    return "op" + std::to_string(index);
+  }
+
+ private:
+  /// request and its reply share the same slot.
+  static int get_op_index(uint32_t type) {
+    return (type & 0xffff) % METRICS_OP_NUM;
+  }
+
+ private:
+  /// splitmix64 finalizer
+  static uint64_t mix(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  uint64_t trace_sample_rate_;
+  OpMetrics ops_[METRICS_OP_NUM];
+  std::mutex gauges_mtx_;
+  vector<std::pair<string, std::function<uint64_t()>>> gauges_;
+};
+
+/**
+ * @brief Dump metrics to file periodically. The file is replaced atomically
+ * so that readers never see a partial dump.
+ */
+class MetricsReporter : public ThreadWrapper {
+ public:
+  MetricsReporter(Metrics *metrics, const string &path, uint64_t interval_ms)
+      : metrics_(metrics), path_(path), interval_ms_(interval_ms) {}
+  ~MetricsReporter() override = default;
+
+  int entry() override {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    uint64_t now = metrics_now_ns();
+    if (now - last_dump_ns_ >= interval_ms_ * 1000000) {
+      dump();
+      last_dump_ns_ = now;
+    }
+    return 0;
+  }
+
+  void abort() override {}
+
+  int dump() {
+    string tmp_path = path_ + ".tmp";
+    {
+      std::ofstream out(tmp_path, std::ios::trunc);
+      if (!out) {
+        return -1;
+      }
+      out << metrics_->dump();
+    }
+    return rename(tmp_path.c_str(), path_.c_str());
+  }
+
+ private:
+  Metrics *metrics_;
+  string path_;
+  uint64_t interval_ms_;
+  uint64_t last_dump_ns_ = 0;
+};
+
+#endif  // PMPOOL_METRICS_H_
@@ -100,6 +100,14 @@ void NetworkServer::reclaim_pmem_buffer(RequestReplyContext *rrc) {
 
 ChunkMgr *NetworkServer::get_chunk_mgr() { return chunkMgr_.get(); }
 
+uint64_t NetworkServer::get_dram_buffer_used_num() {
+  return circularBuffer_->get_used_num();
+}
+
+uint64_t NetworkServer::get_dram_buffer_num() {
+  return circularBuffer_->get_buffer_num();
+}
+
 void NetworkServer::set_recv_callback(Callback *callback) {
   server_->set_recv_callback(callback);
 }
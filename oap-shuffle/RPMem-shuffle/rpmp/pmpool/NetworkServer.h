@@ -61,6 +61,10 @@ class NetworkServer : public RmaBufferRegister {
   /// return the pointer of chunk manager.
   ChunkMgr *get_chunk_mgr();
 
+  /// return the number of used and total slots of DRAM circular buffer.
+  uint64_t get_dram_buffer_used_num();
+  uint64_t get_dram_buffer_num();
+
   /// since the network implementation is asynchronous,
   /// we need to define callback better before starting network service.
   void set_recv_callback(Callback *callback);
@@ -0,0 +1,137 @@
+#ifndef PMPOOL_NUMA_H_
+#define PMPOOL_NUMA_H_
+
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * @brief NUMA topology of local host, read from sysfs so that no libnuma is
+ * required. Every lookup returns -1 or an empty list when the topology is
+ * unknown, e.g. on single socket hosts or in containers without sysfs.
+ */
+class Numa {
+ public:
+  /// return the number of online nodes.
+  static int get_node_num() {
+    auto nodes = parse_list(read_line("/sys/devices/system/node/online"));
+    return nodes.empty() ? 0 : nodes.back() + 1;
+  }
+
+  /// return the cpus of node.
+  static vector<int> get_cpus_of_node(int node) {
+    return parse_list(read_line("/sys/devices/system/node/node" +
+                                std::to_string(node) + "/cpulist"));
+  }
+
+  /// return the node of the device behind path, path is either a device dax
+  /// character device, a pmem block device or a file on a DAX file system.
+  static int get_node_of_path(const string &path) {
+    struct stat st;
+    if (stat(path.c_str(), &st)) {
+      return -1;
+    }
+    string dev;
+    if (S_ISCHR(st.st_mode)) {
+      dev = "/sys/dev/char/" + dev_name(st.st_rdev);
+      // device dax reports the node of the memory in target_node
+      int node = read_int(dev + "/target_node");
+      if (node >= 0) {
+        return node;
+      }
+    } else if (S_ISBLK(st.st_mode)) {
+      dev = "/sys/dev/block/" + dev_name(st.st_rdev);
+    } else {
+      dev = "/sys/dev/block/" + dev_name(st.st_dev);
+    }
+    int node = read_int(dev + "/device/numa_node");
+    if (node < 0) {
+      // partition, the node is reported by its parent device
+      node = read_int(dev + "/../device/numa_node");
+    }
+    return node;
+  }
+
+  /// return the node of the NIC that ip is configured on.
+  static int get_node_of_address(const string &ip) {
+    struct ifaddrs *ifaddr;
+    if (getifaddrs(&ifaddr)) {
+      return -1;
+    }
+    int node = -1;
+    for (struct ifaddrs *ifa = ifaddr; ifa != nullptr; ifa = ifa->ifa_next) {
+      if (ifa->ifa_addr == nullptr || ifa->ifa_addr->sa_family != AF_INET) {
+        continue;
+      }
+      char host[INET_ADDRSTRLEN];
+      auto sin = reinterpret_cast<struct sockaddr_in *>(ifa->ifa_addr);
+      inet_ntop(AF_INET, &sin->sin_addr, host, sizeof(host));
+      if (ip == host) {
+        node = read_int("/sys/class/net/" + string(ifa->ifa_name) +
+                        "/device/numa_node");
+        break;
+      }
+    }
+    freeifaddrs(ifaddr);
+    return node;
+  }
+
+ private:
+  static string dev_name(dev_t dev) {
+    return std::to_string(major(dev)) + ":" + std::to_string(minor(dev));
+  }
+
+  static string read_line(const string &path) {
+    std::ifstream in(path);
+    string line;
+    std::getline(in, line);
+    return line;
+  }
+
+  static int read_int(const string &path) {
+    string line = read_line(path);
+    if (line.empty()) {
+      return -1;
+    }
+    try {
+      return std::stoi(line);
+    } catch (...) {
+      return -1;
+    }
+  }
+
+  /// parse sysfs list format, e.g. "0-3,8,10-11".
+  static vector<int> parse_list(const string &list) {
+    vector<int> res;
+    std::stringstream ss(list);
+    string range;
+    while (std::getline(ss, range, ',')) {
+      if (range.empty()) {
+        continue;
+      }
+      try {
+        auto dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last =
+            dash == string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int i = first; i <= last; i++) {
+          res.push_back(i);
+        }
+      } catch (...) {
+        return vector<int>();
+      }
+    }
+    return res;
+  }
+};
+
+#endif  // PMPOOL_NUMA_H_
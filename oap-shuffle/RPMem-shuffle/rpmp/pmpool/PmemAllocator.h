@@ -11,12 +11,16 @@
 #define PMPOOL_PMEMALLOCATOR_H_
 
 #include <libpmemobj.h>
+#include <stddef.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>  // NOLINT
 #include <iostream>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
 #include <vector>
 
@@ -28,7 +32,26 @@
 using std::shared_ptr;
 using std::unordered_map;
 
-#define PMEMOBJ_ALLOCATOR_LAYOUT_NAME "pmemobj_allocator_layout"
+#define PMEMOBJ_ALLOCATOR_LAYOUT_NAME "pmemobj_allocator_layout_v4"
+// layouts of earlier releases, pools created with them can't be opened by
+// this version and have to be recreated
+static const char *const PMEMOBJ_ALLOCATOR_OLD_LAYOUT_NAMES[] = {
+    "pmemobj_allocator_layout", "pmemobj_allocator_layout_v2",
+    "pmemobj_allocator_layout_v3"};
+// number of independent block lists per pool, every list has its own lock.
+#define PMEM_ARENA_NUM 16
+// number of shards of in-memory address index.
+#define INDEX_SHARD_NUM 64
+// number of block entries pre-allocated per slab of block entry class.
+#define BLOCK_ENTRY_UNITS_PER_SLAB 4096
+// blocks up to this size are appended to extents instead of being allocated.
+#define SMALL_BLOCK_SIZE (64 * 1024)
+// size of one log-structured extent that small blocks are appended to.
+#define EXTENT_SIZE (4 * 1024 * 1024)
+// records in extents are aligned to cache line.
+#define EXTENT_RECORD_ALIGN 64
+// mixed with the pool offset of a record header to tag it as written.
+#define EXTENT_RECORD_MAGIC 0x52504d5065787472ULL
 
 // block header stored in pmem
 struct block_hdr {
@@ -36,6 +59,10 @@ struct block_hdr {
   PMEMoid pre;
   uint64_t addr;
   uint64_t size;
+  uint64_t arena_id;
+  // key of put interface, 0 if block is not put under a key
+  uint64_t key;
+  uint64_t seq;
 };
 
 // block data entry stored in pmem
@@ -44,12 +71,48 @@ struct block_entry {
   PMEMoid data;
 };
 
-// pmem root entry
-struct Base {
+// extent header stored in pmem, records follow the header
+struct extent_hdr {
+  PMEMoid next;
+  PMEMoid pre;
+  uint64_t arena_id;
+  char pad[EXTENT_RECORD_ALIGN - 2 * sizeof(PMEMoid) - sizeof(uint64_t)];
+};
+
+// states of extent record. A record is ALLOCATED when it is handed out and
+// COMMITTED once its data was written, only committed records are recovered.
+enum record_state {
+  RECORD_END,
+  RECORD_ALLOCATED,
+  RECORD_RELEASED,
+  RECORD_COMMITTED
+};
+
+// small block stored in extent, data follows the record
+struct extent_record {
+  uint64_t size;
+  uint64_t state;
+  // key of put interface, 0 if block is not put under a key
+  uint64_t key;
+  uint64_t seq;
+  // record_tag of the header position, recovery skips slots without it
+  uint64_t tag;
+  char pad[EXTENT_RECORD_ALIGN - 5 * sizeof(uint64_t)];
+};
+
+// list of blocks and extents allocated by the threads bound to this arena
+struct Arena {
   PMEMoid head;
   PMEMoid tail;
-  PMEMrwlock rwlock;
+  PMEMoid extent_head;
+  PMEMoid extent_tail;
   uint64_t bytes_written;
+  PMEMmutex lock;
+};
+
+// pmem root entry
+struct Base {
+  Arena arenas[PMEM_ARENA_NUM];
 };
 
 struct PmemContext {
@@ -58,12 +121,41 @@ struct PmemContext {
   Base *base;
 };
 
+// block entry of a block, or extent that holds a small block
+struct BlockRef {
+  PMEMoid oid;
+  bool in_extent;
+};
+
+// in-memory index from global address to block
+struct IndexShard {
+  std::mutex mtx;
+  unordered_map<uint64_t, BlockRef> index_map;
+};
+
+// extent that small blocks of an arena are appended to
+struct ExtentCursor {
+  std::mutex mtx;
+  PMEMoid extent = OID_NULL;
+  uint64_t offset = 0;
+};
+
 // pmem data allocation types
-enum types { BLOCK_ENTRY_TYPE, DATA_TYPE, MAX_TYPE };
+enum types { BLOCK_ENTRY_TYPE, DATA_TYPE, EXTENT_TYPE, MAX_TYPE };
 
 /**
  * @brief libpmemobj based implementation of Allocator interface.
- *
+ * Blocks are kept in PMEM_ARENA_NUM persistent lists, each thread sticks to
+ * one arena so that concurrent allocations only contend when they share an
+ * arena. Data objects are allocated and persisted outside of transactions,
+ * the transaction only links the block entry to its arena. Block entries come
+ * from a dedicated allocation class pre-allocated in slabs.
+ * Small blocks are appended to the current extent of the arena instead, as a
+ * record header followed by data. Appending needs neither allocation nor
+ * transaction nor drain, the header is made persistent together with the
+ * data by the drain of the write batch. An extent is freed once all of its
+ * records are released.
+ * Arenas are independent, so they are rebuilt in parallel on open.
  */
 class PmemObjAllocator : public Allocator {
  public:
@@ -74,13 +166,13 @@ class PmemObjAllocator : public Allocator {
   ~PmemObjAllocator() { close(); }
 
   int init() override {
-    memset(str, '0', 1048576);
     if (create()) {
       int res = open();
       if (res) {
         string err_msg = pmemobj_errormsg();
         log_->get_file_log()->error("failed to open pmem pool, errmsg: " +
                                     err_msg);
+        return -1;
       }
     }
     return 0;
@@ -88,210 +180,581 @@ class PmemObjAllocator : public Allocator {
 
   uint64_t allocate_and_write(uint64_t size,
                               const char *content = nullptr) override {
+    if (size <= SMALL_BLOCK_SIZE) {
+      return append_to_extent(size, content);
+    }
+    // data object is allocated and persisted without transaction, it becomes
+    // reachable once its block entry is linked, orphans are reclaimed on open.
+    PMEMoid data;
+    if (pmemobj_alloc(pmemContext_.pop, &data, size, DATA_TYPE, nullptr,
+                      nullptr)) {
+      perror("pmemobj_alloc failed in allocate_and_write");
+      return -1;
+    }
+    char *pmem_data = static_cast<char *>(pmemobj_direct(data));
+    if (content != nullptr) {
+      pmemobj_memcpy_persist(pmemContext_.pop, pmem_data, content, size);
+    }
+    uint64_t addr =
+        TO_GLOB((uint64_t)pmem_data, (uint64_t)pmemContext_.pop, wid_);
+    uint32_t arena_id = get_arena_id();
+    Arena *arena = &pmemContext_.base->arenas[arena_id];
+
     jmp_buf env;
     if (setjmp(env)) {
       // end the transaction
       (void)pmemobj_tx_end();
+      pmemobj_free(&data);
       return -1;
     }
 
-    // begin a transaction, also acquiring the write lock for the data
-    if (pmemobj_tx_begin(pmemContext_.pop, env, TX_PARAM_RWLOCK,
-                         &pmemContext_.base->rwlock, TX_PARAM_NONE)) {
-      perror("pmemobj_tx_begin failed in pmemkv put");
+    // begin a transaction, also acquiring the lock of the arena
+    if (pmemobj_tx_begin(pmemContext_.pop, env, TX_PARAM_MUTEX, &arena->lock,
+                         TX_PARAM_NONE)) {
+      perror("pmemobj_tx_begin failed in allocate_and_write");
+      pmemobj_free(&data);
       return -1;
     }
 
     // allocate the new node to be inserted
-    PMEMoid beo =
-        pmemobj_tx_alloc(sizeof(struct block_entry), BLOCK_ENTRY_TYPE);
-    if (beo.off == 0 && beo.pool_uuid_lo == 0) {
-      (void)pmemobj_tx_end();
-      perror("pmemobj_tx_alloc failed in pmemkv put");
-      return -1;
-    }
+    PMEMoid beo = pmemobj_tx_xalloc(sizeof(struct block_entry),
+                                    BLOCK_ENTRY_TYPE,
+                                    POBJ_CLASS_ID(block_entry_class_));
     struct block_entry *bep = (struct block_entry *)pmemobj_direct(beo);
-    bep->data = pmemobj_tx_zalloc(size, DATA_TYPE);
+    bep->data = data;
     bep->hdr.next = OID_NULL;
-    bep->hdr.addr = TO_GLOB((uint64_t)pmemobj_direct(bep->data),
-                            (uint64_t)pmemContext_.pop, wid_);
+    bep->hdr.addr = addr;
     bep->hdr.size = size;
+    bep->hdr.arena_id = arena_id;
+    bep->hdr.key = 0;
+    bep->hdr.seq = 0;
 
-    uint64_t start =
-        std::chrono::high_resolution_clock::now().time_since_epoch() /
-        std::chrono::milliseconds(1);
-    char *pmem_data = static_cast<char *>(pmemobj_direct(bep->data));
-    if (content != nullptr) {
-      memcpy(pmem_data, content, size);
-    }
-    uint64_t end =
-        std::chrono::high_resolution_clock::now().time_since_epoch() /
-        std::chrono::milliseconds(1);
-    total += (end - start);
-    // std::cout << "index " << wid_ << ", total is " << total / 1000.0
-    //           << std::endl;
-
-    // add the modified root object to the undo data
-    pmemobj_tx_add_range(pmemContext_.poid, 0, sizeof(struct Base));
-    if (pmemContext_.base->tail.off == 0) {
+    // add the modified arena to the undo data, the lock is not logged
+    pmemobj_tx_add_range_direct(arena, offsetof(struct Arena, lock));
+    if (OID_IS_NULL(arena->tail)) {
       // update head
-      pmemContext_.base->head = beo;
+      arena->head = beo;
       bep->hdr.pre = OID_NULL;
     } else {
       // add the modified tail entry to the undo data
-      bep->hdr.pre = pmemContext_.base->tail;
-      pmemobj_tx_add_range(pmemContext_.base->tail, 0,
-                           sizeof(struct block_entry));
-      ((struct block_entry *)pmemobj_direct(pmemContext_.base->tail))
-          ->hdr.next = beo;
+      bep->hdr.pre = arena->tail;
+      struct block_entry *tail_bep =
+          (struct block_entry *)pmemobj_direct(arena->tail);
+      pmemobj_tx_add_range_direct(&tail_bep->hdr.next, sizeof(PMEMoid));
+      tail_bep->hdr.next = beo;
     }
 
-    pmemContext_.base->tail = beo;  // update tail
-    pmemContext_.base->bytes_written += size;
+    arena->tail = beo;  // update tail
+    arena->bytes_written += size;
     pmemobj_tx_commit();
     (void)pmemobj_tx_end();
 
     // update in-memory index
-    if (update_meta(beo)) {
+    if (update_meta(addr, beo, false)) {
       return -1;
     }
+    used_bytes_ += size;
 
-    return bep->hdr.addr;
+    return addr;
   }
 
   int write(uint64_t address, const char *content, uint64_t size) override {
-    std::unique_lock<std::mutex> l(mtx);
-    if (!index_map.count(address)) {
+    BlockRef ref;
+    if (get_meta(address, &ref)) {
       return -1;
     }
-    PMEMoid data = index_map[address];
-    struct block_entry *bep = (struct block_entry *)pmemobj_direct(data);
-    char *pmem_data = static_cast<char *>(pmemobj_direct(bep->data));
-    // pmemobj_memcpy_persist(pmemContext_.pop, pmem_data, content, size);
-    uint64_t start =
-        std::chrono::high_resolution_clock::now().time_since_epoch() /
-        std::chrono::milliseconds(1);
-    memcpy(pmem_data, content, size);
-    uint64_t end =
-        std::chrono::high_resolution_clock::now().time_since_epoch() /
-        std::chrono::milliseconds(1);
-    total += (end - start);
-    l.unlock();
+    pmemobj_memcpy(pmemContext_.pop, to_virtual_address(address), content,
+                   size, PMEMOBJ_F_MEM_NODRAIN);
+    if (ref.in_extent) {
+      commit_record(address);
+    }
+    pmemobj_drain(pmemContext_.pop);
+    return 0;
+  }
+
+  /// flush data that was written to the block by RMA, bypassing write().
+  int persist(uint64_t address, uint64_t size) override {
+    if (flush(address, size)) {
+      return -1;
+    }
+    pmemobj_drain(pmemContext_.pop);
+    return 0;
+  }
+
+  /// small blocks are committed here, their header is flushed along with the
+  /// data and both are persistent after the next drain.
+  int flush(uint64_t address, uint64_t size) override {
+    BlockRef ref;
+    if (get_meta(address, &ref)) {
+      return -1;
+    }
+    pmemobj_flush(pmemContext_.pop, to_virtual_address(address), size);
+    if (ref.in_extent) {
+      commit_record(address);
+    }
+    return 0;
+  }
+
+  void drain() override { pmemobj_drain(pmemContext_.pop); }
+
+  int set_block_keys(const std::vector<KeyedBlock> &blocks) override {
+    std::vector<std::pair<uint64_t *, uint64_t *>> fields;
+    for (auto &block : blocks) {
+      uint64_t *key;
+      uint64_t *seq;
+      if (get_key_fields(block.bm.address, &key, &seq)) {
+        return -1;
+      }
+      fields.push_back(std::make_pair(key, seq));
+    }
+    // seqs of the whole batch go first, a block whose key is not yet
+    // persisted is skipped by recovery.
+    for (int i = 0; i < blocks.size(); i++) {
+      *fields[i].second = blocks[i].seq;
+      pmemobj_flush(pmemContext_.pop, fields[i].second, sizeof(uint64_t));
+    }
+    pmemobj_drain(pmemContext_.pop);
+    for (int i = 0; i < blocks.size(); i++) {
+      *fields[i].first = blocks[i].key;
+      pmemobj_flush(pmemContext_.pop, fields[i].first, sizeof(uint64_t));
+    }
+    pmemobj_drain(pmemContext_.pop);
     return 0;
   }
 
+  int get_keyed_blocks(std::vector<KeyedBlock> *blocks) override {
+    vector<vector<KeyedBlock>> arena_blocks(PMEM_ARENA_NUM);
+    std::atomic<int> res{0};
+    for_each_arena_parallel([&](uint32_t arena_id) {
+      Arena *arena = &pmemContext_.base->arenas[arena_id];
+      if (pmemobj_mutex_lock(pmemContext_.pop, &arena->lock) != 0) {
+        res = -1;
+        return;
+      }
+      vector<KeyedBlock> &keyed = arena_blocks[arena_id];
+      struct block_entry *bep =
+          (struct block_entry *)pmemobj_direct(arena->head);
+      while (bep != nullptr) {
+        if (bep->hdr.key != 0) {
+          keyed.push_back(
+              {bep->hdr.key, bep->hdr.seq, {bep->hdr.addr, bep->hdr.size}});
+        }
+        bep = (struct block_entry *)pmemobj_direct(bep->hdr.next);
+      }
+      for_each_record(arena, [&](uint64_t addr, struct extent_record *record,
+                                 PMEMoid extent) {
+        if (record->key != 0) {
+          keyed.push_back({record->key, record->seq, {addr, record->size}});
+        }
+      });
+      pmemobj_mutex_unlock(pmemContext_.pop, &arena->lock);
+    });
+    for (auto &keyed : arena_blocks) {
+      blocks->insert(blocks->end(), keyed.begin(), keyed.end());
+    }
+    return res;
+  }
+
   uint64_t get_virtual_address(uint64_t address) {
-    std::unique_lock<std::mutex> l(mtx);
-    if (!index_map.count(address)) {
+    BlockRef ref;
+    if (get_meta(address, &ref)) {
       return -1;
     }
-    PMEMoid data = index_map[address];
-    struct block_entry *bep = (struct block_entry *)pmemobj_direct(data);
-    char *pmem_data = static_cast<char *>(pmemobj_direct(bep->data));
-    l.unlock();
-    return (uint64_t)pmem_data;
+    return (uint64_t)to_virtual_address(address);
   }
 
   int release(uint64_t address) override {
+    BlockRef ref;
+    if (remove_meta(address, &ref)) {
+      perror("address not found");
+      return -1;
+    }
+    if (ref.in_extent) {
+      return release_record(address, ref.oid);
+    }
+    PMEMoid data = ref.oid;
+    struct block_entry *bep = (struct block_entry *)pmemobj_direct(data);
+    Arena *arena = &pmemContext_.base->arenas[bep->hdr.arena_id];
+    uint64_t size = bep->hdr.size;
+
     jmp_buf env;
     if (setjmp(env)) {
       // end the transaction
       (void)pmemobj_tx_end();
+      update_meta(address, data, false);
       return -1;
     }
 
-    // begin a transaction, also acquiring the write lock for the data
-    if (pmemobj_tx_begin(pmemContext_.pop, env, TX_PARAM_RWLOCK,
-                         &pmemContext_.base->rwlock, TX_PARAM_NONE)) {
-      perror("pmemobj_tx_begin failed in pmemkv put");
+    // begin a transaction, also acquiring the lock of the owning arena
+    if (pmemobj_tx_begin(pmemContext_.pop, env, TX_PARAM_MUTEX, &arena->lock,
+                         TX_PARAM_NONE)) {
+      perror("pmemobj_tx_begin failed in release");
+      update_meta(address, data, false);
       return -1;
     }
-    if (!index_map.count(address)) {
-      (void)pmemobj_tx_end();
-      perror("address not found");
-      return -1;
-    }
-    PMEMoid data = index_map[address];
-    struct block_entry *bep = (struct block_entry *)pmemobj_direct(data);
-    struct block_entry *prev_bep =
-        (struct block_entry *)pmemobj_direct(bep->hdr.pre);
-    struct block_entry *next_bep =
-        (struct block_entry *)pmemobj_direct(bep->hdr.next);
-    pmemobj_tx_add_range(pmemContext_.poid, 0, sizeof(struct Base));
-    if (prev_bep == nullptr) {
-      if (next_bep == nullptr) {
-        pmemContext_.base->head = OID_NULL;
-        pmemContext_.base->tail = OID_NULL;
-      } else {
-        pmemContext_.base->head = bep->hdr.next;
-        next_bep->hdr.pre = OID_NULL;
-      }
+    pmemobj_tx_add_range_direct(arena, offsetof(struct Arena, lock));
+    if (OID_IS_NULL(bep->hdr.pre)) {
+      arena->head = bep->hdr.next;
     } else {
-      pmemobj_tx_add_range(bep->hdr.pre, 0, sizeof(struct Base));
+      struct block_entry *prev_bep =
+          (struct block_entry *)pmemobj_direct(bep->hdr.pre);
+      pmemobj_tx_add_range_direct(&prev_bep->hdr.next, sizeof(PMEMoid));
       prev_bep->hdr.next = bep->hdr.next;
     }
-    pmemContext_.base->bytes_written -= bep->hdr.size;
-    pmemobj_tx_add_range(data, 0, sizeof(struct Base));
-    bep->hdr.pre = OID_NULL;
-    bep->hdr.next = OID_NULL;
-    pmemobj_free(&data);
-    pmemobj_free(&bep->data);
+    if (OID_IS_NULL(bep->hdr.next)) {
+      arena->tail = bep->hdr.pre;
+    } else {
+      struct block_entry *next_bep =
+          (struct block_entry *)pmemobj_direct(bep->hdr.next);
+      pmemobj_tx_add_range_direct(&next_bep->hdr.pre, sizeof(PMEMoid));
+      next_bep->hdr.pre = bep->hdr.pre;
+    }
+    arena->bytes_written -= bep->hdr.size;
+    pmemobj_tx_free(bep->data);
+    pmemobj_tx_free(data);
 
     pmemobj_tx_commit();
     (void)pmemobj_tx_end();
+    used_bytes_ -= size;
 
     return 0;
   }
 
   int release_all() override {
-    PMEMoid cur_oid = pmemContext_.base->head;
-    while (cur_oid.off != 0 && cur_oid.pool_uuid_lo != 0) {
-      struct block_entry *cur_bep =
-          (struct block_entry *)pmemobj_direct(cur_oid);
-      PMEMoid next_oid = cur_bep->hdr.next;
-      struct block_entry *next_bep =
-          (struct block_entry *)pmemobj_direct(next_oid);
-      pmemobj_free(&cur_oid);
-      pmemobj_free(&cur_bep->data);
-      cur_oid = next_oid;
+    for (int i = 0; i < PMEM_ARENA_NUM; i++) {
+      Arena *arena = &pmemContext_.base->arenas[i];
+      std::lock_guard<std::mutex> l(cursors_[i].mtx);
+      pmemobj_mutex_lock(pmemContext_.pop, &arena->lock);
+      PMEMoid cur_oid = arena->head;
+      while (!OID_IS_NULL(cur_oid)) {
+        struct block_entry *cur_bep =
+            (struct block_entry *)pmemobj_direct(cur_oid);
+        PMEMoid next_oid = cur_bep->hdr.next;
+        pmemobj_free(&cur_bep->data);
+        pmemobj_free(&cur_oid);
+        cur_oid = next_oid;
+      }
+      cur_oid = arena->extent_head;
+      while (!OID_IS_NULL(cur_oid)) {
+        struct extent_hdr *cur_ehp =
+            (struct extent_hdr *)pmemobj_direct(cur_oid);
+        PMEMoid next_oid = cur_ehp->next;
+        pmemobj_free(&cur_oid);
+        cur_oid = next_oid;
+      }
+      arena->head = OID_NULL;
+      arena->tail = OID_NULL;
+      arena->extent_head = OID_NULL;
+      arena->extent_tail = OID_NULL;
+      arena->bytes_written = 0;
+      pmemobj_persist(pmemContext_.pop, arena, offsetof(struct Arena, lock));
+      pmemobj_mutex_unlock(pmemContext_.pop, &arena->lock);
+      cursors_[i].extent = OID_NULL;
+      cursors_[i].offset = 0;
     }
-    pmemContext_.base->head = OID_NULL;
-    pmemContext_.base->tail = OID_NULL;
-    pmemContext_.base->bytes_written = 0;
-
+    free_meta();
+    used_bytes_ = 0;
+    std::lock_guard<std::mutex> l(extents_mtx_);
+    extent_live_.clear();
     return 0;
   }
 
   int dump_all() override {
     std::cout << "******************worker " << wid_
               << " start dump*********************" << std::endl;
-    if (pmemobj_rwlock_rdlock(pmemContext_.pop, &pmemContext_.base->rwlock) !=
-        0) {
-      return -1;
+    uint64_t bytes_written = 0;
+    for (int i = 0; i < PMEM_ARENA_NUM; i++) {
+      Arena *arena = &pmemContext_.base->arenas[i];
+      if (pmemobj_mutex_lock(pmemContext_.pop, &arena->lock) != 0) {
+        return -1;
+      }
+      struct block_entry *next_bep =
+          (struct block_entry *)pmemobj_direct(arena->head);
+      while (next_bep != nullptr) {
+        std::cout << "dump address " << next_bep->hdr.addr << std::endl;
+        next_bep = (struct block_entry *)pmemobj_direct(next_bep->hdr.next);
+      }
+      bytes_written += arena->bytes_written;
+      for_each_record(arena, [&](uint64_t addr, struct extent_record *record,
+                                 PMEMoid extent) {
+        std::cout << "dump address " << addr << std::endl;
+        bytes_written += record->size;
+      });
+      pmemobj_mutex_unlock(pmemContext_.pop, &arena->lock);
     }
-    struct block_entry *next_bep =
-        (struct block_entry *)pmemobj_direct(pmemContext_.base->head);
-    uint64_t read_offset = 0;
-    while (next_bep != nullptr) {
-      char *pmem_data =
-          reinterpret_cast<char *>(pmemobj_direct(next_bep->data));
-      char *tmp = reinterpret_cast<char *>(std::malloc(next_bep->hdr.size));
-      memcpy(tmp, pmem_data, next_bep->hdr.size);
-      std::cout << "dump address " << next_bep->hdr.addr << std::endl;
-      read_offset += next_bep->hdr.size;
-      std::free(tmp);
-      next_bep = (struct block_entry *)pmemobj_direct(next_bep->hdr.next);
-    }
-    pmemobj_rwlock_unlock(pmemContext_.pop, &pmemContext_.base->rwlock);
-    std::cout << "total size " << pmemContext_.base->bytes_written << std::endl;
+    std::cout << "total size " << bytes_written << std::endl;
     std::cout << "******************worker " << wid_
               << " end dump*********************" << std::endl;
     return 0;
   }
 
+  uint64_t get_used_bytes() override { return used_bytes_; }
+
   Chunk *get_rma_chunk() { return base_ck; }
 
  private:
+  /// threads are spread over arenas round-robin and stick to their arena.
+  static uint32_t get_arena_id() {
+    static std::atomic<uint32_t> thread_seq{0};
+    static thread_local uint32_t arena_id = thread_seq++ % PMEM_ARENA_NUM;
+    return arena_id;
+  }
+
+  /// append small block to the current extent of the arena. The record
+  /// header is only flushed under the cursor lock, it is drained with the
+  /// data: here if content is given, else by the drain after the block was
+  /// written and flushed. Headers may therefore become persistent out of
+  /// order, recovery skips the slots of headers that never did by their tag.
+  uint64_t append_to_extent(uint64_t size, const char *content) {
+    uint32_t arena_id = get_arena_id();
+    ExtentCursor &cursor = cursors_[arena_id];
+    uint64_t record_size = align_record(sizeof(struct extent_record) + size);
+    PMEMoid extent;
+    struct extent_record *record;
+    {
+      std::lock_guard<std::mutex> l(cursor.mtx);
+      if (OID_IS_NULL(cursor.extent) ||
+          cursor.offset + record_size > EXTENT_SIZE) {
+        if (open_extent(arena_id, &cursor)) {
+          return -1;
+        }
+      }
+      extent = cursor.extent;
+      char *base = static_cast<char *>(pmemobj_direct(extent));
+      record = (struct extent_record *)(base + cursor.offset);
+      cursor.offset += record_size;
+      record->size = size;
+      record->state = content != nullptr ? RECORD_COMMITTED : RECORD_ALLOCATED;
+      record->tag = record_tag(record);
+      pmemobj_flush(pmemContext_.pop, record, sizeof(struct extent_record));
+      std::lock_guard<std::mutex> el(extents_mtx_);
+      extent_live_[extent.off]++;
+    }
+    char *pmem_data = reinterpret_cast<char *>(record + 1);
+    if (content != nullptr) {
+      pmemobj_memcpy(pmemContext_.pop, pmem_data, content, size,
+                     PMEMOBJ_F_MEM_NODRAIN);
+      pmemobj_drain(pmemContext_.pop);
+    }
+    uint64_t addr =
+        TO_GLOB((uint64_t)pmem_data, (uint64_t)pmemContext_.pop, wid_);
+    if (update_meta(addr, extent, true)) {
+      return -1;
+    }
+    used_bytes_ += size;
+    return addr;
+  }
+
+  /// link a new extent to the arena and make it current, the previous
+  /// extent is freed if all of its records were already released.
+  /// Caller holds the cursor lock.
+  int open_extent(uint32_t arena_id, ExtentCursor *cursor) {
+    // zeroed so that no slot past the last record carries a valid tag
+    PMEMoid extent;
+    if (pmemobj_zalloc(pmemContext_.pop, &extent, EXTENT_SIZE, EXTENT_TYPE)) {
+      perror("pmemobj_zalloc failed in open_extent");
+      return -1;
+    }
+    struct extent_hdr *ehp = (struct extent_hdr *)pmemobj_direct(extent);
+    ehp->arena_id = arena_id;
+    pmemobj_persist(pmemContext_.pop, ehp, sizeof(struct extent_hdr));
+    Arena *arena = &pmemContext_.base->arenas[arena_id];
+
+    jmp_buf env;
+    if (setjmp(env)) {
+      (void)pmemobj_tx_end();
+      pmemobj_free(&extent);
+      return -1;
+    }
+    if (pmemobj_tx_begin(pmemContext_.pop, env, TX_PARAM_MUTEX, &arena->lock,
+                         TX_PARAM_NONE)) {
+      perror("pmemobj_tx_begin failed in open_extent");
+      pmemobj_free(&extent);
+      return -1;
+    }
+    pmemobj_tx_add_range_direct(arena, offsetof(struct Arena, lock));
+    pmemobj_tx_add_range_direct(ehp, sizeof(struct extent_hdr));
+    ehp->next = OID_NULL;
+    ehp->pre = arena->extent_tail;
+    if (OID_IS_NULL(arena->extent_tail)) {
+      arena->extent_head = extent;
+    } else {
+      struct extent_hdr *tail_ehp =
+          (struct extent_hdr *)pmemobj_direct(arena->extent_tail);
+      pmemobj_tx_add_range_direct(&tail_ehp->next, sizeof(PMEMoid));
+      tail_ehp->next = extent;
+    }
+    arena->extent_tail = extent;
+    pmemobj_tx_commit();
+    (void)pmemobj_tx_end();
+
+    PMEMoid sealed = cursor->extent;
+    cursor->extent = extent;
+    cursor->offset = sizeof(struct extent_hdr);
+    if (!OID_IS_NULL(sealed)) {
+      std::unique_lock<std::mutex> el(extents_mtx_);
+      if (extent_live_[sealed.off] == 0) {
+        extent_live_.erase(sealed.off);
+        el.unlock();
+        free_extent(sealed);
+      }
+    }
+    return 0;
+  }
+
+  /// mark the record of a small block committed once its data was written.
+  /// The caller drains.
+  void commit_record(uint64_t address) {
+    struct extent_record *record =
+        (struct extent_record *)to_virtual_address(address) - 1;
+    record->state = RECORD_COMMITTED;
+    pmemobj_flush(pmemContext_.pop, record, sizeof(struct extent_record));
+  }
+
+  uint64_t record_tag(struct extent_record *record) {
+    return EXTENT_RECORD_MAGIC ^
+           ((uint64_t)record - (uint64_t)pmemContext_.pop);
+  }
+
+  /// mark the record released, free its extent once it holds no live record
+  /// and is no longer appended to.
+  int release_record(uint64_t address, PMEMoid extent) {
+    struct extent_record *record =
+        (struct extent_record *)to_virtual_address(address) - 1;
+    record->state = RECORD_RELEASED;
+    pmemobj_persist(pmemContext_.pop, &record->state, sizeof(uint64_t));
+    used_bytes_ -= record->size;
+    struct extent_hdr *ehp = (struct extent_hdr *)pmemobj_direct(extent);
+    ExtentCursor &cursor = cursors_[ehp->arena_id];
+    std::lock_guard<std::mutex> l(cursor.mtx);
+    std::unique_lock<std::mutex> el(extents_mtx_);
+    if (--extent_live_[extent.off] != 0 || OID_EQUALS(cursor.extent, extent)) {
+      return 0;
+    }
+    extent_live_.erase(extent.off);
+    el.unlock();
+    return free_extent(extent);
+  }
+
+  int free_extent(PMEMoid extent) {
+    struct extent_hdr *ehp = (struct extent_hdr *)pmemobj_direct(extent);
+    Arena *arena = &pmemContext_.base->arenas[ehp->arena_id];
+
+    jmp_buf env;
+    if (setjmp(env)) {
+      (void)pmemobj_tx_end();
+      return -1;
+    }
+    if (pmemobj_tx_begin(pmemContext_.pop, env, TX_PARAM_MUTEX, &arena->lock,
+                         TX_PARAM_NONE)) {
+      perror("pmemobj_tx_begin failed in free_extent");
+      return -1;
+    }
+    pmemobj_tx_add_range_direct(arena, offsetof(struct Arena, lock));
+    if (OID_IS_NULL(ehp->pre)) {
+      arena->extent_head = ehp->next;
+    } else {
+      struct extent_hdr *prev_ehp =
+          (struct extent_hdr *)pmemobj_direct(ehp->pre);
+      pmemobj_tx_add_range_direct(&prev_ehp->next, sizeof(PMEMoid));
+      prev_ehp->next = ehp->next;
+    }
+    if (OID_IS_NULL(ehp->next)) {
+      arena->extent_tail = ehp->pre;
+    } else {
+      struct extent_hdr *next_ehp =
+          (struct extent_hdr *)pmemobj_direct(ehp->next);
+      pmemobj_tx_add_range_direct(&next_ehp->pre, sizeof(PMEMoid));
+      next_ehp->pre = ehp->pre;
+    }
+    pmemobj_tx_free(extent);
+    pmemobj_tx_commit();
+    (void)pmemobj_tx_end();
+    return 0;
+  }
+
+  /// call func with the global address, record and extent of every
+  /// committed record in the extents of arena. Records that were handed out
+  /// but never written are skipped and so reclaimed with their extent. A slot
+  /// without a valid tag holds a header that never became persistent, or is
+  /// past the last record, the walk steps over it by the record alignment.
+  template <typename F>
+  void for_each_record(Arena *arena, F func) {
+    PMEMoid extent = arena->extent_head;
+    while (!OID_IS_NULL(extent)) {
+      char *base = static_cast<char *>(pmemobj_direct(extent));
+      uint64_t offset = sizeof(struct extent_hdr);
+      while (offset + sizeof(struct extent_record) <= EXTENT_SIZE) {
+        struct extent_record *record = (struct extent_record *)(base + offset);
+        uint64_t record_size =
+            align_record(sizeof(struct extent_record) + record->size);
+        if (record->tag != record_tag(record) ||
+            record->size > SMALL_BLOCK_SIZE ||
+            offset + record_size > EXTENT_SIZE) {
+          offset += EXTENT_RECORD_ALIGN;
+          continue;
+        }
+        if (record->state == RECORD_COMMITTED) {
+          func(TO_GLOB((uint64_t)(record + 1), (uint64_t)pmemContext_.pop,
+                       wid_),
+               record, extent);
+        }
+        offset += record_size;
+      }
+      extent = ((struct extent_hdr *)base)->next;
+    }
+  }
+
+  static uint64_t align_record(uint64_t size) {
+    return (size + EXTENT_RECORD_ALIGN - 1) &
+           ~(uint64_t)(EXTENT_RECORD_ALIGN - 1);
+  }
+
+  char *to_virtual_address(uint64_t address) {
+    return reinterpret_cast<char *>(pmemContext_.pop) +
+           (address & ((1ULL << 48) - 1));
+  }
+
+  /// locate the persistent key and seq of block.
+  int get_key_fields(uint64_t address, uint64_t **key, uint64_t **seq) {
+    BlockRef ref;
+    if (get_meta(address, &ref)) {
+      return -1;
+    }
+    if (ref.in_extent) {
+      struct extent_record *record =
+          (struct extent_record *)to_virtual_address(address) - 1;
+      *key = &record->key;
+      *seq = &record->seq;
+    } else {
+      struct block_entry *bep = (struct block_entry *)pmemobj_direct(ref.oid);
+      *key = &bep->hdr.key;
+      *seq = &bep->hdr.seq;
+    }
+    return 0;
+  }
+
+  /// register the allocation class that block entries are carved from,
+  /// runtime ctl settings have to be applied every time the pool is opened.
+  int register_alloc_class() {
+    struct pobj_alloc_class_desc desc;
+    desc.unit_size = sizeof(struct block_entry);
+    desc.alignment = 0;
+    desc.units_per_block = BLOCK_ENTRY_UNITS_PER_SLAB;
+    desc.header_type = POBJ_HEADER_NONE;
+    if (pmemobj_ctl_set(pmemContext_.pop, "heap.alloc_class.new.desc",
+                        &desc)) {
+      string err_msg = pmemobj_errormsg();
+      log_->get_file_log()->warn(
+          "failed to register block entry allocation class, errmsg: " +
+          err_msg);
+      block_entry_class_ = 0;
+      return -1;
+    }
+    block_entry_class_ = desc.class_id;
+    return 0;
+  }
+
   int create() {
     // debug setting
     int sds_write_value = 0;
@@ -305,11 +768,10 @@ class PmemObjAllocator : public Allocator {
                                  err_msg);
       return -1;
     }
+    register_alloc_class();
+    // root object is zeroed by libpmemobj, every arena starts empty
     pmemContext_.poid = pmemobj_root(pmemContext_.pop, sizeof(struct Base));
     pmemContext_.base = (struct Base *)pmemobj_direct(pmemContext_.poid);
-    pmemContext_.base->head = OID_NULL;
-    pmemContext_.base->tail = OID_NULL;
-    pmemContext_.base->bytes_written = 0;
 
     if (server_) {
       base_ck = server_->register_rma_buffer(
@@ -330,8 +792,10 @@ class PmemObjAllocator : public Allocator {
     pmemContext_.pop =
         pmemobj_open(diskInfo_->path.c_str(), PMEMOBJ_ALLOCATOR_LAYOUT_NAME);
     if (pmemContext_.pop == nullptr) {
+      report_old_layout();
       return -1;
     }
+    register_alloc_class();
 
     if (server_) {
       base_ck = server_->register_rma_buffer(
@@ -344,15 +808,134 @@ class PmemObjAllocator : public Allocator {
 
     pmemContext_.poid = pmemobj_root(pmemContext_.pop, sizeof(struct Base));
     pmemContext_.base = (struct Base *)pmemobj_direct(pmemContext_.poid);
-    PMEMoid next = pmemContext_.base->head;
-    while (next.off != 0 && next.pool_uuid_lo != 0) {
-      if (update_meta(next)) {
+    // arenas are independent lists, rebuild them in parallel
+    vector<ArenaRecovery> recovered(PMEM_ARENA_NUM);
+    for_each_arena_parallel([&](uint32_t arena_id) {
+      recover_arena(arena_id, &recovered[arena_id]);
+    });
+    vector<uint64_t> linked_data;
+    for (auto &arena : recovered) {
+      if (arena.res) {
         return -1;
       }
+      used_bytes_ += arena.used_bytes;
+      linked_data.insert(linked_data.end(), arena.linked_data.begin(),
+                         arena.linked_data.end());
+      extent_live_.insert(arena.extent_live.begin(), arena.extent_live.end());
+      for (auto &extent : arena.empty_extents) {
+        extent_live_.erase(extent.off);
+        free_extent(extent);
+      }
+    }
+    std::sort(linked_data.begin(), linked_data.end());
+    reclaim_orphans(linked_data);
+    return 0;
+  }
+
+  /// pools written by an earlier release fail to open with a layout
+  /// mismatch, name the layout they were created with so the error says the
+  /// pool has to be recreated.
+  void report_old_layout() {
+    for (auto layout : PMEMOBJ_ALLOCATOR_OLD_LAYOUT_NAMES) {
+      PMEMobjpool *pop = pmemobj_open(diskInfo_->path.c_str(), layout);
+      if (pop != nullptr) {
+        pmemobj_close(pop);
+        log_->get_console_log()->error(
+            "pmem pool " + diskInfo_->path + " was created with layout " +
+            layout + ", this version needs " + PMEMOBJ_ALLOCATOR_LAYOUT_NAME +
+            ", recreate the pool to use it");
+        return;
+      }
+    }
+  }
+
+  /// state rebuilt from one arena on open.
+  struct ArenaRecovery {
+    // offsets of data objects and extents reachable from the arena
+    vector<uint64_t> linked_data;
+    unordered_map<uint64_t, uint64_t> extent_live;
+    vector<PMEMoid> empty_extents;
+    uint64_t used_bytes = 0;
+    int res = 0;
+  };
+
+  void recover_arena(uint32_t arena_id, ArenaRecovery *recovery) {
+    Arena *arena = &pmemContext_.base->arenas[arena_id];
+    PMEMoid next = arena->head;
+    while (!OID_IS_NULL(next)) {
       struct block_entry *bep = (struct block_entry *)pmemobj_direct(next);
+      if (update_meta(bep->hdr.addr, next, false)) {
+        recovery->res = -1;
+        return;
+      }
+      recovery->used_bytes += bep->hdr.size;
+      recovery->linked_data.push_back(bep->data.off);
       next = bep->hdr.next;
     }
-    return 0;
+    for (next = arena->extent_head; !OID_IS_NULL(next);
+         next = ((struct extent_hdr *)pmemobj_direct(next))->next) {
+      recovery->linked_data.push_back(next.off);
+      recovery->extent_live[next.off] = 0;
+    }
+    for_each_record(arena, [&](uint64_t addr, struct extent_record *record,
+                               PMEMoid extent) {
+      recovery->res |= update_meta(addr, extent, true);
+      recovery->extent_live[extent.off]++;
+      recovery->used_bytes += record->size;
+    });
+    // appending restarts in a new extent, drop those left with no record.
+    for (next = arena->extent_head; !OID_IS_NULL(next);
+         next = ((struct extent_hdr *)pmemobj_direct(next))->next) {
+      if (recovery->extent_live[next.off] == 0) {
+        recovery->empty_extents.push_back(next);
+      }
+    }
+  }
+
+  /// call func(arena_id) for every arena, spread over up to one thread per
+  /// cpu.
+  template <typename F>
+  void for_each_arena_parallel(F func) {
+    unsigned thread_num = std::max(1u, std::thread::hardware_concurrency());
+    thread_num = std::min<unsigned>(thread_num, PMEM_ARENA_NUM);
+    std::atomic<uint32_t> next_arena{0};
+    vector<std::thread> threads;
+    for (unsigned i = 0; i < thread_num; i++) {
+      threads.emplace_back([&] {
+        for (uint32_t arena_id = next_arena++; arena_id < PMEM_ARENA_NUM;
+             arena_id = next_arena++) {
+          func(arena_id);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+  /// free data objects and extents that were allocated but never linked to
+  /// an arena because of a crash in between.
+  /// linked_data is sorted.
+  void reclaim_orphans(const vector<uint64_t> &linked_data) {
+    std::vector<PMEMoid> orphans;
+    for (PMEMoid oid = pmemobj_first(pmemContext_.pop); !OID_IS_NULL(oid);
+         oid = pmemobj_next(oid)) {
+      if ((pmemobj_type_num(oid) == DATA_TYPE ||
+           pmemobj_type_num(oid) == EXTENT_TYPE) &&
+          !std::binary_search(linked_data.begin(), linked_data.end(),
+                              oid.off)) {
+        orphans.push_back(oid);
+      }
+    }
+    for (auto &oid : orphans) {
+      pmemobj_free(&oid);
+    }
+    if (!orphans.empty()) {
+      log_->get_file_log()->warn("reclaimed " +
+                                 std::to_string(orphans.size()) +
+                                 " unlinked data objects in " +
+                                 diskInfo_->path);
+    }
   }
 
   void close() {
@@ -360,20 +943,51 @@ class PmemObjAllocator : public Allocator {
     free_meta();
   }
 
-  int update_meta(const PMEMoid &oid) {
-    std::lock_guard<std::mutex> l(mtx);
-    struct block_entry *bep = (struct block_entry *)pmemobj_direct(oid);
-    if (!index_map.count(bep->hdr.addr)) {
-      index_map[bep->hdr.addr] = oid;
+  IndexShard &get_shard(uint64_t address) {
+    return index_shards_[(address >> 6) % INDEX_SHARD_NUM];
+  }
+
+  /// oid is the block entry of address, or its extent if in_extent is set.
+  int update_meta(uint64_t address, const PMEMoid &oid, bool in_extent) {
+    IndexShard &shard = get_shard(address);
+    std::lock_guard<std::mutex> l(shard.mtx);
+    if (!shard.index_map.count(address)) {
+      shard.index_map[address] = {oid, in_extent};
     } else {
       assert("invalide operation.");
     }
     return 0;
   }
 
+  int get_meta(uint64_t address, BlockRef *ref) {
+    IndexShard &shard = get_shard(address);
+    std::lock_guard<std::mutex> l(shard.mtx);
+    auto it = shard.index_map.find(address);
+    if (it == shard.index_map.end()) {
+      return -1;
+    }
+    *ref = it->second;
+    return 0;
+  }
+
+  int remove_meta(uint64_t address, BlockRef *ref) {
+    IndexShard &shard = get_shard(address);
+    std::lock_guard<std::mutex> l(shard.mtx);
+    auto it = shard.index_map.find(address);
+    if (it == shard.index_map.end()) {
+      return -1;
+    }
+    *ref = it->second;
+    shard.index_map.erase(it);
+    return 0;
+  }
+
   int free_meta() {
-    std::lock_guard<std::mutex> l(mtx);
-    index_map.clear();
+    for (int i = 0; i < INDEX_SHARD_NUM; i++) {
+      std::lock_guard<std::mutex> l(index_shards_[i].mtx);
+      index_shards_[i].index_map.clear();
+    }
+    return 0;
   }
 
  private:
@@ -382,11 +996,14 @@ class PmemObjAllocator : public Allocator {
   NetworkServer *server_;
   int wid_;
   PmemContext pmemContext_;
-  std::mutex mtx;
-  unordered_map<uint64_t, PMEMoid> index_map;
-  uint64_t total = 0;
-  char str[1048576];
-  Chunk *base_ck;
+  IndexShard index_shards_[INDEX_SHARD_NUM];
+  ExtentCursor cursors_[PMEM_ARENA_NUM];
+  // number of allocated records per extent, keyed by extent offset
+  std::mutex extents_mtx_;
+  unordered_map<uint64_t, uint64_t> extent_live_;
+  std::atomic<uint64_t> used_bytes_{0};
+  unsigned block_entry_class_ = 0;
+  Chunk *base_ck = nullptr;
 };
 
 #endif  // PMPOOL_PMEMALLOCATOR_H_
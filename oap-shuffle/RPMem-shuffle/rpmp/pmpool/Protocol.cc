@@ -10,6 +10,7 @@
 #include "pmpool/Protocol.h"
 
 #include <assert.h>
+#include <sched.h>
 
 #include "AllocatorProxy.h"
 #include "Config.h"
@@ -17,6 +18,7 @@
 #include "Event.h"
 #include "Log.h"
 #include "NetworkServer.h"
+#include "Numa.h"
 
 RecvCallback::RecvCallback(Protocol *protocol, ChunkMgr *chunkMgr)
     : protocol_(protocol), chunkMgr_(chunkMgr) {}
@@ -28,6 +30,7 @@ void RecvCallback::operator()(void *buffer_id, void *buffer_size) {
   Request *request = new Request(reinterpret_cast<char *>(ck->buffer), ck->size,
                                  reinterpret_cast<Connection *>(ck->con));
   request->decode();
+  request->get_rc().recv_ts = metrics_now_ns();
   protocol_->enqueue_recv_msg(request);
   chunkMgr_->reclaim(ck, static_cast<Connection *>(ck->con));
 }
@@ -59,21 +62,23 @@ void WriteCallback::operator()(void *buffer_id, void *buffer_size) {
   protocol_->enqueue_rma_msg(buffer_id_);
 }
 
-RecvWorker::RecvWorker(Protocol *protocol, int index)
-    : protocol_(protocol), index_(index) {
+RecvWorker::RecvWorker(Protocol *protocol, int wid, std::vector<int> cpus)
+    : protocol_(protocol), wid_(wid), cpus_(cpus) {
   init = false;
 }
 
 int RecvWorker::entry() {
   if (!init) {
-    set_affinity(index_);
+    if (!cpus_.empty()) {
+      set_affinity(cpus_);
+    }
     init = true;
   }
   Request *request;
   bool res = pendingRecvRequestQueue_.wait_dequeue_timed(
       request, std::chrono::milliseconds(1000));
   if (res) {
-    protocol_->handle_recv_msg(request);
+    protocol_->handle_recv_msg(request, wid_);
   }
   return 0;
 }
@@ -84,21 +89,23 @@ void RecvWorker::addTask(Request *request) {
   pendingRecvRequestQueue_.enqueue(request);
 }
 
-ReadWorker::ReadWorker(Protocol *protocol, int index)
-    : protocol_(protocol), index_(index) {
+ReadWorker::ReadWorker(Protocol *protocol, std::vector<int> cpus)
+    : protocol_(protocol), cpus_(cpus) {
   init = false;
 }
 
 int ReadWorker::entry() {
   if (!init) {
-    set_affinity(index_);
+    if (!cpus_.empty()) {
+      set_affinity(cpus_);
+    }
     init = true;
   }
-  RequestReply *requestReply;
-  bool res = pendingReadRequestQueue_.wait_dequeue_timed(
-      requestReply, std::chrono::milliseconds(1000));
-  if (res) {
-    protocol_->handle_rma_msg(requestReply);
+  RequestReply *requestReplies[WORKER_BATCH_SIZE];
+  size_t num = pendingReadRequestQueue_.wait_dequeue_bulk_timed(
+      requestReplies, WORKER_BATCH_SIZE, std::chrono::milliseconds(1000));
+  if (num) {
+    protocol_->handle_rma_msgs(requestReplies, num);
   }
   return 0;
 }
@@ -109,14 +116,21 @@ void ReadWorker::addTask(RequestReply *rr) {
   pendingReadRequestQueue_.enqueue(rr);
 }
 
-FinalizeWorker::FinalizeWorker(Protocol *protocol) : protocol_(protocol) {}
+FinalizeWorker::FinalizeWorker(Protocol *protocol, std::vector<int> cpus)
+    : protocol_(protocol), cpus_(cpus) {}
 
 int FinalizeWorker::entry() {
-  RequestReply *requestReply;
-  bool res = pendingRequestReplyQueue_.wait_dequeue_timed(
-      requestReply, std::chrono::milliseconds(1000));
-  if (res) {
-    protocol_->handle_finalize_msg(requestReply);
+  if (!init) {
+    if (!cpus_.empty()) {
+      set_affinity(cpus_);
+    }
+    init = true;
+  }
+  RequestReply *requestReplies[WORKER_BATCH_SIZE];
+  size_t num = pendingRequestReplyQueue_.wait_dequeue_bulk_timed(
+      requestReplies, WORKER_BATCH_SIZE, std::chrono::milliseconds(1000));
+  if (num) {
+    protocol_->handle_finalize_msgs(requestReplies, num);
   }
   return 0;
 }
@@ -147,6 +161,15 @@ Protocol::~Protocol() {
   }
   finalizeWorker_->stop();
   finalizeWorker_->join();
+  if (metricsReporter_) {
+    metricsReporter_->stop();
+    metricsReporter_->join();
+    metricsReporter_->dump();
+  }
+  log_->get_file_log()->info(
+      std::to_string(cross_socket_requests_) + " of " +
+      std::to_string(cross_socket_requests_ + local_socket_requests_) +
+      " requests were received on another socket than their memory pool.");
 }
 
 int Protocol::init() {
@@ -157,17 +180,26 @@ int Protocol::init() {
   readCallback_ = std::make_shared<ReadCallback>(this);
   writeCallback_ = std::make_shared<WriteCallback>(this);
 
+  init_numa();
+  init_metrics();
+
   for (int i = 0; i < config_->get_pool_size(); i++) {
-    auto recvWorker = new RecvWorker(this, config_->get_affinities_()[i] - 1);
+    auto recvWorker = new RecvWorker(this, i, get_pool_cpus(i, true));
     recvWorker->start();
     recvWorkers_.push_back(std::shared_ptr<RecvWorker>(recvWorker));
   }
 
-  finalizeWorker_ = make_shared<FinalizeWorker>(this);
+  // replies are sent from the node of the NIC
+  int nic_node = Numa::get_node_of_address(config_->get_ip());
+  std::vector<int> nic_cpus;
+  if (nic_node >= 0) {
+    nic_cpus = Numa::get_cpus_of_node(nic_node);
+  }
+  finalizeWorker_ = make_shared<FinalizeWorker>(this, nic_cpus);
   finalizeWorker_->start();
 
   for (int i = 0; i < config_->get_pool_size(); i++) {
-    auto readWorker = new ReadWorker(this, config_->get_affinities_()[i]);
+    auto readWorker = new ReadWorker(this, get_pool_cpus(i, false));
     readWorker->start();
     readWorkers_.push_back(std::shared_ptr<ReadWorker>(readWorker));
   }
@@ -179,25 +211,156 @@ int Protocol::init() {
   return 0;
 }
 
+void Protocol::init_metrics() {
+  metrics_ = std::make_shared<Metrics>(config_->get_trace_sample_rate());
+  for (int i = 0; i < config_->get_pool_size(); i++) {
+    string pool = "pool" + std::to_string(i) + "_";
+    metrics_->add_gauge(pool + "recv_queue_depth", [this, i]() {
+      return recvWorkers_.size() > i ? recvWorkers_[i]->get_queue_depth() : 0;
+    });
+    metrics_->add_gauge(pool + "rma_queue_depth", [this, i]() {
+      return readWorkers_.size() > i ? readWorkers_[i]->get_queue_depth() : 0;
+    });
+    metrics_->add_gauge(pool + "used_bytes", [this, i]() {
+      return allocatorProxy_->get_used_bytes(i);
+    });
+    metrics_->add_gauge(pool + "capacity_bytes", [this, i]() {
+      return allocatorProxy_->get_capacity(i);
+    });
+  }
+  metrics_->add_gauge("finalize_queue_depth", [this]() {
+    return finalizeWorker_ ? finalizeWorker_->get_queue_depth() : 0;
+  });
+  metrics_->add_gauge("dram_buffer_used_slots", [this]() {
+    return networkServer_->get_dram_buffer_used_num();
+  });
+  metrics_->add_gauge("dram_buffer_slots", [this]() {
+    return networkServer_->get_dram_buffer_num();
+  });
+  metrics_->add_gauge("local_socket_requests",
+                      [this]() { return local_socket_requests_.load(); });
+  metrics_->add_gauge("cross_socket_requests",
+                      [this]() { return cross_socket_requests_.load(); });
+  if (!config_->get_metrics_path().empty()) {
+    metricsReporter_ = std::make_shared<MetricsReporter>(
+        metrics_.get(), config_->get_metrics_path(),
+        config_->get_metrics_interval());
+    metricsReporter_->start();
+  }
+}
+
+void Protocol::record_metrics(RequestReply *requestReply) {
+  RequestReplyContext &rrc = requestReply->get_rrc();
+  uint64_t now = metrics_now_ns();
+  uint64_t bytes_in = 0;
+  uint64_t bytes_out = 0;
+  if (rrc.type == WRITE_REPLY || rrc.type == PUT_REPLY) {
+    bytes_in = rrc.size;
+  } else if (rrc.type == READ_REPLY) {
+    bytes_out = rrc.size;
+  }
+  metrics_->record(rrc.type, now - rrc.recv_ts, bytes_in, bytes_out,
+                   rrc.success == 0);
+  if (rrc.traced) {
+    string trace = "trace rid " + std::to_string(rrc.rid) + " " +
+                   Metrics::get_op_name(rrc.type & 0xffff) + " size " +
+                   std::to_string(rrc.size) + " total_ns " +
+                   std::to_string(now - rrc.recv_ts);
+    if (rrc.rma_ts != 0) {
+      trace += " recv_to_rma_ns " + std::to_string(rrc.rma_ts - rrc.recv_ts) +
+               " rma_to_reply_ns " + std::to_string(now - rrc.rma_ts);
+    }
+    log_->get_file_log()->info(trace);
+  }
+}
+
+void Protocol::init_numa() {
+  for (int node = 0; node < Numa::get_node_num(); node++) {
+    for (int cpu : Numa::get_cpus_of_node(node)) {
+      if (cpu >= cpu_nodes_.size()) {
+        cpu_nodes_.resize(cpu + 1, -1);
+      }
+      cpu_nodes_[cpu] = node;
+    }
+  }
+  auto paths = config_->get_pool_paths();
+  for (uint32_t i = 0; i < config_->get_pool_size(); i++) {
+    int node = i < paths.size() ? Numa::get_node_of_path(paths[i]) : -1;
+    pool_nodes_.push_back(node);
+    log_->get_file_log()->info("memory pool " + std::to_string(i) +
+                               " is on node " + std::to_string(node));
+  }
+}
+
+std::vector<int> Protocol::get_pool_cpus(uint32_t wid, bool recv) {
+  // explicitly configured cpus, recv workers may have a list of their own
+  auto recv_affinities = config_->get_recv_affinities();
+  if (recv && wid < recv_affinities.size()) {
+    return {static_cast<int>(recv_affinities[wid])};
+  }
+  auto affinities = config_->get_affinities_();
+  if (wid < affinities.size()) {
+    return {static_cast<int>(affinities[wid])};
+  }
+  if (pool_nodes_[wid] < 0) {
+    return std::vector<int>();
+  }
+  return Numa::get_cpus_of_node(pool_nodes_[wid]);
+}
+
+int Protocol::get_current_node() {
+  // network threads belong to HPNL and are not pinned, this only tells where
+  // the request happened to be received
+  int cpu = sched_getcpu();
+  if (cpu < 0 || cpu >= cpu_nodes_.size()) {
+    return -1;
+  }
+  return cpu_nodes_[cpu];
+}
+
+uint32_t Protocol::select_pool(uint64_t size, uint64_t rid) {
+  // blocks are spread over the pools of every node, the recv worker of the
+  // chosen pool already runs on its node. Full pools are skipped.
+  uint32_t pool_size = config_->get_pool_size();
+  for (uint32_t i = 0; i < pool_size; i++) {
+    uint32_t wid = (rid + i) % pool_size;
+    if (allocatorProxy_->get_used_bytes(wid) + size <=
+        allocatorProxy_->get_capacity(wid)) {
+      return wid;
+    }
+  }
+  return rid % pool_size;
+}
+
 void Protocol::enqueue_recv_msg(Request *request) {
   RequestContext rc = request->get_rc();
+  uint32_t wid;
   if (rc.address != 0) {
-    auto wid = GET_WID(rc.address);
-    recvWorkers_[wid]->addTask(request);
+    wid = GET_WID(rc.address);
+  } else {
+    wid = select_pool(rc.size, rc.rid);
+  }
+  int node = get_current_node();
+  if (node >= 0 && pool_nodes_[wid] >= 0 && node != pool_nodes_[wid]) {
+    cross_socket_requests_++;
   } else {
-    recvWorkers_[rc.rid % config_->get_pool_size()]->addTask(request);
+    local_socket_requests_++;
   }
+  recvWorkers_[wid]->addTask(request);
 }
 
-void Protocol::handle_recv_msg(Request *request) {
+void Protocol::handle_recv_msg(Request *request, uint32_t wid) {
   RequestContext rc = request->get_rc();
   RequestReplyContext rrc;
+  rrc.recv_ts = rc.recv_ts;
+  rrc.rma_ts = 0;
+  rrc.traced =
+      metrics_->sample(rc.rid, reinterpret_cast<uint64_t>(rc.con));
   switch (rc.type) {
     case ALLOC: {
-      uint64_t addr = allocatorProxy_->allocate_and_write(
-          rc.size, nullptr, rc.rid % config_->get_pool_size());
-      auto wid = GET_WID(addr);
-      assert(wid == rc.rid % config_->get_pool_size());
+      uint64_t addr =
+          allocatorProxy_->allocate_and_write(rc.size, nullptr, wid);
+      assert(GET_WID(addr) == wid);
       rrc.type = ALLOC_REPLY;
       rrc.success = 0;
       rrc.rid = rc.rid;
@@ -230,7 +393,7 @@ void Protocol::handle_recv_msg(Request *request) {
       rrc.src_rkey = rc.src_rkey;
       rrc.size = rc.size;
       rrc.con = rc.con;
-      networkServer_->get_dram_buffer(&rrc);
+      get_rma_dest_buffer(&rrc, wid);
       RequestReply *requestReply = new RequestReply(rrc);
       rrc.ck->ptr = requestReply;
 
@@ -272,7 +435,7 @@ void Protocol::handle_recv_msg(Request *request) {
       rrc.size = rc.size;
       rrc.key = rc.key;
       rrc.con = rc.con;
-      networkServer_->get_dram_buffer(&rrc);
+      get_rma_dest_buffer(&rrc, wid);
       RequestReply *requestReply = new RequestReply(rrc);
       rrc.ck->ptr = requestReply;
 
@@ -292,6 +455,7 @@ void Protocol::handle_recv_msg(Request *request) {
       RequestReply *requestReply = new RequestReply(rrc);
       rrc.ck->ptr = requestReply;
       enqueue_finalize_msg(requestReply);
+      break;
     }
     case DELETE: {
       rrc.type = DELETE_REPLY;
@@ -299,6 +463,9 @@ void Protocol::handle_recv_msg(Request *request) {
       rrc.con = rc.con;
       rrc.rid = rc.rid;
       rrc.success = 0;
+      RequestReply *requestReply = new RequestReply(rrc);
+      enqueue_finalize_msg(requestReply);
+      break;
     }
     default: { break; }
   }
@@ -311,23 +478,45 @@ void Protocol::enqueue_finalize_msg(RequestReply *requestReply) {
 }
 
 void Protocol::handle_finalize_msg(RequestReply *requestReply) {
+  handle_finalize_msgs(&requestReply, 1);
+}
+
+void Protocol::handle_finalize_msgs(RequestReply **requestReplies,
+                                    size_t num) {
+  // keys of all puts in the batch are persisted together
+  std::vector<KeyedBlock> blocks;
+  for (size_t i = 0; i < num; i++) {
+    RequestReplyContext &rrc = requestReplies[i]->get_rrc();
+    if (rrc.type == PUT_REPLY) {
+      blocks.push_back({rrc.key, 0, {rrc.address, rrc.size}});
+    }
+  }
+  if (!blocks.empty()) {
+    allocatorProxy_->cache_chunks(&blocks);
+  }
+  for (size_t i = 0; i < num; i++) {
+    finalize(requestReplies[i]);
+  }
+}
+
+void Protocol::finalize(RequestReply *requestReply) {
   RequestReplyContext rrc = requestReply->get_rrc();
-  if (rrc.type == PUT_REPLY) {
-    allocatorProxy_->cache_chunk(rrc.key, rrc.address, rrc.size);
-  } else if (rrc.type == GET_META_REPLY) {
+  if (rrc.type == GET_META_REPLY) {
     auto bml = allocatorProxy_->get_cached_chunk(rrc.key);
     requestReply->requestReplyContext_.bml = bml;
   } else if (rrc.type == DELETE_REPLY) {
     auto bml = allocatorProxy_->get_cached_chunk(rrc.key);
     for (auto bm : bml) {
-      rrc.success = allocatorProxy_->release(bm.address);
-      if (rrc.success) {
+      requestReply->requestReplyContext_.success =
+          allocatorProxy_->release(bm.address);
+      if (requestReply->requestReplyContext_.success) {
         break;
       }
     }
     allocatorProxy_->del_chunk(rrc.key);
   } else {
   }
+  record_metrics(requestReply);
   requestReply->encode();
   networkServer_->send(reinterpret_cast<char *>(requestReply->data_),
                        requestReply->size_, rrc.con);
@@ -347,32 +536,63 @@ void Protocol::enqueue_rma_msg(uint64_t buffer_id) {
 }
 
 void Protocol::handle_rma_msg(RequestReply *requestReply) {
-  RequestReplyContext &rrc = requestReply->get_rrc();
-  switch (rrc.type) {
-    case WRITE_REPLY: {
-      char *buffer = static_cast<char *>(rrc.ck->buffer);
-      if (rrc.address == 0) {
-        rrc.address = allocatorProxy_->allocate_and_write(
-            rrc.size, buffer, rrc.rid % config_->get_pool_size());
-      } else {
-        allocatorProxy_->write(rrc.address, buffer, rrc.size);
-      }
-      networkServer_->reclaim_dram_buffer(&rrc);
-      break;
+  handle_rma_msgs(&requestReply, 1);
+}
+
+void Protocol::handle_rma_msgs(RequestReply **requestReplies, size_t num) {
+  // data that was RMA read into PMem is flushed per request and drained once
+  // per pool for the whole batch.
+  std::vector<bool> flushed(config_->get_pool_size(), false);
+  for (size_t i = 0; i < num; i++) {
+    RequestReplyContext &rrc = requestReplies[i]->get_rrc();
+    if ((rrc.type == WRITE_REPLY || rrc.type == PUT_REPLY) && rrc.rma_direct) {
+      allocatorProxy_->flush(rrc.address, rrc.size);
+      flushed[GET_WID(rrc.address)] = true;
     }
-    case READ_REPLY: {
-      networkServer_->reclaim_pmem_buffer(&rrc);
-      break;
+  }
+  for (int wid = 0; wid < flushed.size(); wid++) {
+    if (flushed[wid]) {
+      allocatorProxy_->drain(wid);
     }
-    case PUT_REPLY: {
-      char *buffer = static_cast<char *>(rrc.ck->buffer);
-      assert(rrc.address == 0);
-      rrc.address = allocatorProxy_->allocate_and_write(
-          rrc.size, buffer, rrc.rid % config_->get_pool_size());
-      networkServer_->reclaim_dram_buffer(&rrc);
-      break;
+  }
+  for (size_t i = 0; i < num; i++) {
+    RequestReplyContext &rrc = requestReplies[i]->get_rrc();
+    if (rrc.traced) {
+      rrc.rma_ts = metrics_now_ns();
     }
-    default: { break; }
+    switch (rrc.type) {
+      case WRITE_REPLY:
+      case PUT_REPLY: {
+        if (rrc.rma_direct) {
+          networkServer_->reclaim_pmem_buffer(&rrc);
+        } else {
+          char *buffer = static_cast<char *>(rrc.ck->buffer);
+          allocatorProxy_->write(rrc.address, buffer, rrc.size);
+          networkServer_->reclaim_dram_buffer(&rrc);
+        }
+        break;
+      }
+      case READ_REPLY: {
+        networkServer_->reclaim_pmem_buffer(&rrc);
+        break;
+      }
+      default: { break; }
+    }
+    enqueue_finalize_msg(requestReplies[i]);
+  }
+}
+
+void Protocol::get_rma_dest_buffer(RequestReplyContext *rrc, uint32_t wid) {
+  if (rrc->address == 0) {
+    rrc->address = allocatorProxy_->allocate_and_write(rrc->size, nullptr, wid);
+  }
+  Chunk *base_ck = allocatorProxy_->get_rma_chunk(rrc->address);
+  if (base_ck != nullptr) {
+    rrc->rma_direct = true;
+    rrc->dest_address = allocatorProxy_->get_virtual_address(rrc->address);
+    networkServer_->get_pmem_buffer(rrc, base_ck);
+  } else {
+    rrc->rma_direct = false;
+    networkServer_->get_dram_buffer(rrc);
   }
-  enqueue_finalize_msg(requestReply);
 }
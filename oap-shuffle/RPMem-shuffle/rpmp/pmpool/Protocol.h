@@ -14,6 +14,7 @@
 #include <HPNL/ChunkMgr.h>
 #include <HPNL/Connection.h>
 
+#include <atomic>
 #include <cassert>
 #include <chrono>  // NOLINT
 #include <cstring>
@@ -23,6 +24,7 @@
 #include <vector>
 
 #include "Event.h"
+#include "Metrics.h"
 #include "ThreadWrapper.h"
 #include "queue/blockingconcurrentqueue.h"
 #include "queue/concurrentqueue.h"
@@ -37,6 +39,10 @@ class Log;
 using moodycamel::BlockingConcurrentQueue;
 using std::make_shared;
 
+/// max number of events a rma or finalize worker handles in one batch, a
+/// batch of puts shares one persistence barrier.
+#define WORKER_BATCH_SIZE 32
+
 struct MessageHeader {
   MessageHeader(uint8_t msg_type, uint64_t sequence_id) {
     msg_type_ = msg_type;
@@ -95,15 +101,18 @@ class WriteCallback : public Callback {
 class RecvWorker : public ThreadWrapper {
  public:
   RecvWorker() = delete;
-  RecvWorker(Protocol *protocol, int index);
+  /// worker of memory pool wid, running on any of cpus.
+  RecvWorker(Protocol *protocol, int wid, std::vector<int> cpus);
   ~RecvWorker() override = default;
   int entry() override;
   void abort() override;
   void addTask(Request *request);
+  size_t get_queue_depth() { return pendingRecvRequestQueue_.size_approx(); }
 
  private:
   Protocol *protocol_;
-  int index_;
+  int wid_;
+  std::vector<int> cpus_;
   bool init;
   BlockingConcurrentQueue<Request *> pendingRecvRequestQueue_;
 };
@@ -111,15 +120,16 @@ class RecvWorker : public ThreadWrapper {
 class ReadWorker : public ThreadWrapper {
  public:
   ReadWorker() = delete;
-  ReadWorker(Protocol *protocol, int index);
+  ReadWorker(Protocol *protocol, std::vector<int> cpus);
   ~ReadWorker() override = default;
   int entry() override;
   void abort() override;
   void addTask(RequestReply *requestReply);
+  size_t get_queue_depth() { return pendingReadRequestQueue_.size_approx(); }
 
  private:
   Protocol *protocol_;
-  int index_;
+  std::vector<int> cpus_;
   bool init;
   BlockingConcurrentQueue<RequestReply *> pendingReadRequestQueue_;
 };
@@ -127,14 +137,19 @@ class ReadWorker : public ThreadWrapper {
 class FinalizeWorker : public ThreadWrapper {
  public:
   FinalizeWorker() = delete;
-  explicit FinalizeWorker(Protocol *protocol);
+  FinalizeWorker(Protocol *protocol, std::vector<int> cpus);
   ~FinalizeWorker() override = default;
   int entry() override;
   void abort() override;
   void addTask(RequestReply *requestReply);
+  size_t get_queue_depth() {
+    return pendingRequestReplyQueue_.size_approx();
+  }
 
  private:
   Protocol *protocol_;
+  std::vector<int> cpus_;
+  bool init = false;
   BlockingConcurrentQueue<RequestReply *> pendingRequestReplyQueue_;
 };
 
@@ -158,13 +173,46 @@ class Protocol {
   friend class RecvWorker;
 
   void enqueue_recv_msg(Request *request);
-  void handle_recv_msg(Request *request);
+  /// handle request on the worker of memory pool wid.
+  void handle_recv_msg(Request *request, uint32_t wid);
 
   void enqueue_finalize_msg(RequestReply *requestReply);
   void handle_finalize_msg(RequestReply *requestReply);
+  void handle_finalize_msgs(RequestReply **requestReplies, size_t num);
 
   void enqueue_rma_msg(uint64_t buffer_id);
   void handle_rma_msg(RequestReply *requestReply);
+  void handle_rma_msgs(RequestReply **requestReplies, size_t num);
+
+ private:
+  /// Prepare the local buffer that WRITE/PUT data is RMA read into.
+  /// Data lands in the allocated PMem block directly if the pool is
+  /// registered as RMA region, otherwise it is staged in DRAM circular buffer.
+  void get_rma_dest_buffer(RequestReplyContext *rrc, uint32_t wid);
+  /// Reply to request, after the keys of a put batch were persisted.
+  void finalize(RequestReply *requestReply);
+
+  /// Register gauges and start dumping metrics if configured.
+  void init_metrics();
+  /// Record metrics of request that is about to be replied.
+  void record_metrics(RequestReply *requestReply);
+
+  /// Build NUMA placement of memory pools and workers.
+  void init_numa();
+  /// Return cpus that the workers of memory pool wid run on.
+  std::vector<int> get_pool_cpus(uint32_t wid, bool recv);
+  /// Return the node of the cpu the calling thread runs on, -1 if unknown.
+  int get_current_node();
+  /// Choose memory pool for new block of size, round-robin over all pools
+  /// that still have room for it.
+  uint32_t select_pool(uint64_t size, uint64_t rid);
+
+ public:
+  Metrics *get_metrics() { return metrics_.get(); }
+  uint64_t get_local_socket_requests() { return local_socket_requests_; }
+  /// requests received by a network thread running on another socket than
+  /// their memory pool.
+  uint64_t get_cross_socket_requests() { return cross_socket_requests_; }
 
  public:
   Config *config_;
@@ -188,6 +236,15 @@ class Protocol {
 
   std::mutex rrcMtx_;
   std::unordered_map<uint64_t, RequestReply *> rrcMap_;
+
+  // node of every memory pool, and of every cpu
+  std::vector<int> pool_nodes_;
+  std::vector<int> cpu_nodes_;
+  std::atomic<uint64_t> local_socket_requests_{0};
+  std::atomic<uint64_t> cross_socket_requests_{0};
+
+  std::shared_ptr<Metrics> metrics_;
+  std::shared_ptr<MetricsReporter> metricsReporter_;
   uint64_t time;
 };
 
@@ -17,6 +17,7 @@
 #include <iostream>
 #include <mutex>  // NOLINT
 #include <thread> // NOLINT
+#include <vector>
 
 class ThreadWrapper {
  public:
@@ -47,6 +48,21 @@ class ThreadWrapper {
     if (res) {
       abort();
     }
+#endif
+  }
+  /// allow the thread to run on any of cpus, e.g. all cpus of a NUMA node.
+  void set_affinity(const std::vector<int> &cpus) {
+#ifdef __linux__
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (int cpu : cpus) {
+      CPU_SET(cpu, &cpuset);
+    }
+    int res = pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t),
+                                     &cpuset);
+    if (res) {
+      abort();
+    }
 #endif
   }
   void thread_body() {
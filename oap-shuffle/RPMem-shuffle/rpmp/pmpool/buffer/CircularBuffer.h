@@ -19,18 +19,26 @@
 #include <sys/mman.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>  // NOLINT
 #include <iostream>
+#include <memory>
 #include <mutex>  // NOLINT
-#include <vector>
 
-#include "../Common.h"
-#include "../NetworkServer.h"
 #include "../RmaBufferRegister.h"
 
 #define p2align(x, a) (((x) + (a)-1) & ~((a)-1))
 
+/**
+ * @brief Multi-producer ring of fixed size slots used as RMA staging area.
+ * head_ and tail_ are monotonic slot counters, slots in [tail_, head_) are in
+ * use. get() reserves contiguous slots by CAS on head_, put() marks slots in
+ * an atomic bitmap and the thread that finds the slot at tail_ released moves
+ * tail_ forward. Nothing is locked on the fast path, the wait mutex is only
+ * taken by producers when the ring is full and by put() when there are
+ * waiters, which are woken once per put() rather than once per slot.
+ */
 class CircularBuffer {
  public:
   CircularBuffer() = delete;
@@ -40,9 +48,9 @@ class CircularBuffer {
       : buffer_size_(buffer_size),
         buffer_num_(buffer_num),
         rbr_(rbr),
-        read_(0),
-        write_(0) {
-    uint64_t total = buffer_num_ * buffer_size_;
+        ck_(nullptr),
+        word_num_((buffer_num + 63) / 64),
+        bits_(new std::atomic<uint64_t>[word_num_]) {
     buffer_ = static_cast<char *>(mmap(0, buffer_num_ * buffer_size_,
                                        PROT_READ | PROT_WRITE,
                                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
@@ -59,8 +67,8 @@ class CircularBuffer {
       ck_ = rbr_->register_rma_buffer(buffer_, buffer_num_ * buffer_size_);
     }
 
-    for (int i = 0; i < buffer_num; i++) {
-      bits.push_back(0);
+    for (uint64_t i = 0; i < word_num_; i++) {
+      bits_[i].store(0);
     }
   }
   ~CircularBuffer() {
@@ -83,135 +91,130 @@ class CircularBuffer {
 
   void dump() {
     std::cout << "********************************************" << std::endl;
-    std::cout << "read_ " << read_ << " write_ " << write_ << std::endl;
-    for (int i = 0; i < buffer_num_; i++) {
-      std::cout << bits[i] << " ";
+    std::cout << "read_ " << get_read_() << " write_ " << get_write_()
+              << std::endl;
+    for (uint64_t i = 0; i < buffer_num_; i++) {
+      std::cout << is_released(i) << " ";
     }
     std::cout << std::endl;
     std::cout << "********************************************" << std::endl;
   }
-  uint64_t get_read_() { return read_; }
-  uint64_t get_write_() { return write_; }
+  uint64_t get_read_() { return tail_.load() % buffer_num_; }
+  uint64_t get_write_() { return head_.load() % buffer_num_; }
+  /// number of slots handed out and not yet passed by tail.
+  uint64_t get_used_num() { return head_.load() - tail_.load(); }
+  uint64_t get_buffer_num() { return buffer_num_; }
 
   bool get(uint64_t bytes, uint64_t *offset) {
-    uint32_t alloc_num = p2align(bytes, buffer_size_) / buffer_size_;
+    uint64_t alloc_num = p2align(bytes, buffer_size_) / buffer_size_;
     if (alloc_num > buffer_num_) {
       return false;
     }
-    std::lock_guard<spin_mutex> write_lk(write_mtx);
-    std::unique_lock<std::mutex> read_lk(read_mtx);
-    uint64_t available = 0;
-    uint64_t end = 0;
-    uint64_t index = 0;
-  read_lt_write:
-    if (write_ >= read_) {  // --------read_--------write_--------
-      available = buffer_num_ - write_;
-      if (available >= alloc_num) {
-        index = write_;
-        end = write_ + alloc_num;
-        while (index < end) {
-          bits[index++] = 1;
-        }
-        *offset = write_;
-        write_ += alloc_num;
-        if (write_ == buffer_num_) {
-          write_ = 0;
+    while (true) {
+      uint64_t head = head_.load();
+      uint64_t tail = tail_.load();
+      uint64_t pos = head % buffer_num_;
+      if (pos + alloc_num > buffer_num_) {
+        // not enough contiguous slots before the end of ring,
+        // skip the remaining slots and restart from the beginning.
+        uint64_t pad = buffer_num_ - pos;
+        if (head + pad - tail <= buffer_num_) {
+          if (head_.compare_exchange_weak(head, head + pad)) {
+            release(pos, pad);
+          }
+          continue;
         }
-        goto success;
-      } else {
-        uint64_t index = write_;
-        while (index < buffer_num_) {
-          bits[index++] = 0;
-        }
-        write_ = 0;
-        goto write_lt_read;
-      }
-    }
-  write_lt_read:
-    // --------write_--------read_-----------
-    available = read_ - write_;
-    if (available >= alloc_num) {
-      index = write_;
-      end = write_ + alloc_num;
-      while (index < end) {
-        bits[index++] = 1;
-      }
-      *offset = write_;
-      write_ += alloc_num;
-      if (write_ == buffer_num_) {
-        write_ = 0;
-      }
-      goto success;
-    } else {
-      // wait
-      while ((available = read_ - write_) < alloc_num) {
-        read_cv.wait(read_lk);
-        if (read_ == 0) {
-          goto read_lt_write;
+      } else if (head + alloc_num - tail <= buffer_num_) {
+        if (head_.compare_exchange_weak(head, head + alloc_num)) {
+          *offset = pos;
+          return true;
         }
+        continue;
       }
-      index = write_;
-      end = write_ + alloc_num;
-      while (index < end) {
-        bits[index++] = 1;
-      }
-      *offset = write_;
-      write_ += alloc_num;
-      if (write_ == buffer_num_) {
-        write_ = 0;
-      }
-      goto success;
+      wait(head, tail);
     }
-  success:
-    return true;
   }
   void put(uint64_t offset, uint64_t bytes) {
-    uint32_t alloc_num = p2align(bytes, buffer_size_) / buffer_size_;
-    assert(alloc_num <= buffer_num_ - read_);
-    std::unique_lock<std::mutex> read_lk(read_mtx);
+    uint64_t alloc_num = p2align(bytes, buffer_size_) / buffer_size_;
+    if (offset + alloc_num > buffer_num_) {
+      alloc_num = buffer_num_ - offset;
+    }
+    release(offset, alloc_num);
+  }
+  Chunk *get_rma_chunk() { return ck_; }
+  uint64_t get_offset(uint64_t data) { return (data - (uint64_t)buffer_); }
+
+ private:
+  bool is_released(uint64_t index) {
+    return (bits_[index / 64].load() >> (index % 64)) & 1;
+  }
+
+  /// mark slots released, one atomic op per bitmap word, then move tail_.
+  void release(uint64_t offset, uint64_t num) {
     uint64_t index = offset;
-    uint64_t end = index + alloc_num;
+    uint64_t end = offset + num;
     while (index < end) {
-      bits[index] = 0;
-      if (read_ == index) {
-        read_++;
-        if (read_ == buffer_num_) {
-          read_ = 0;
-        }
-      }
-      index++;
-      read_cv.notify_all();
+      uint64_t bit = index % 64;
+      uint64_t len = std::min<uint64_t>(64 - bit, end - index);
+      uint64_t mask = (len == 64 ? ~0ULL : ((1ULL << len) - 1)) << bit;
+      bits_[index / 64].fetch_or(mask);
+      index += len;
+    }
+    if (advance() && waiters_.load() > 0) {
+      std::lock_guard<std::mutex> lk(wait_mtx_);
+      wait_cv_.notify_all();
     }
-    index = read_;
-    while (bits[index] == 0) {
-      read_++;
-      index++;
-      if (read_ == buffer_num_) {
-        read_ = 0;
-        read_cv.notify_all();
+  }
+
+  /// move tail_ over released slots. The thread that clears the bit of the
+  /// slot at tail_ owns the move, a bit cleared for a later round of the ring
+  /// is given back.
+  bool advance() {
+    bool advanced = false;
+    while (true) {
+      uint64_t tail = tail_.load();
+      uint64_t index = tail % buffer_num_;
+      uint64_t mask = 1ULL << (index % 64);
+      std::atomic<uint64_t> &word = bits_[index / 64];
+      if (!(word.load() & mask)) {
         break;
-      } else {
-        read_cv.notify_all();
       }
+      if (!(word.fetch_and(~mask) & mask)) {
+        continue;
+      }
+      if (!tail_.compare_exchange_strong(tail, tail + 1)) {
+        word.fetch_or(mask);
+        continue;
+      }
+      advanced = true;
     }
+    return advanced;
+  }
+
+  /// block until head_ or tail_ moves.
+  void wait(uint64_t head, uint64_t tail) {
+    std::unique_lock<std::mutex> lk(wait_mtx_);
+    waiters_++;
+    wait_cv_.wait(lk, [&] {
+      return head_.load() != head || tail_.load() != tail;
+    });
+    waiters_--;
   }
-  Chunk *get_rma_chunk() { return ck_; }
-  uint64_t get_offset(uint64_t data) { return (data - (uint64_t)buffer_); }
 
  private:
   char *buffer_;
-  char *tmp_;
   uint64_t buffer_size_;
   uint64_t buffer_num_;
   RmaBufferRegister *rbr_;
   Chunk *ck_;
-  std::vector<uint16_t> bits;
-  uint64_t read_;
-  uint64_t write_;
-  std::mutex read_mtx;
-  std::condition_variable read_cv;
-  spin_mutex write_mtx;
-  char tmp[4096];
+  uint64_t word_num_;
+  /// bit is set when slot is released but tail_ has not passed it yet.
+  std::unique_ptr<std::atomic<uint64_t>[]> bits_;
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> tail_{0};
+  std::atomic<uint64_t> waiters_{0};
+  std::mutex wait_mtx_;
+  std::condition_variable wait_cv_;
 };
 
 #endif  // PMPOOL_BUFFER_CIRCULARBUFFER_H_
@@ -9,6 +9,8 @@
 
 #include "pmpool/client/NetworkClient.h"
 
+#include <algorithm>
+
 #include <HPNL/Callback.h>
 #include <HPNL/ChunkMgr.h>
 #include <HPNL/Connection.h>
@@ -21,80 +23,75 @@ uint64_t timestamp_now() {
          std::chrono::milliseconds(1);
 }
 
-RequestHandler::RequestHandler(NetworkClient *networkClient)
-    : networkClient_(networkClient) {}
-
-void RequestHandler::addTask(Request *request) { handleRequest(request); }
+RequestHandler::RequestHandler(NetworkClient *networkClient,
+                               uint64_t max_inflight)
+    : networkClient_(networkClient), max_inflight_(max_inflight) {}
 
-void RequestHandler::addTask(Request *request, std::function<void()> func) {
-  callback_map[request->get_rc().rid] = func;
-  handleRequest(request);
+Future RequestHandler::addTask(Request *request) {
+  auto promise = make_shared<Promise>();
+  Future future = promise->get_future();
+  addTask(request,
+          [promise](RequestReplyContext &rrc) { promise->set_value(rrc); });
+  return future;
 }
 
-void RequestHandler::wait() {
+void RequestHandler::addTask(Request *request, RequestCallback func) {
   unique_lock<mutex> lk(h_mtx);
-  while (!op_finished) {
+  while (inflight_ >= max_inflight_) {
     cv.wait(lk);
   }
+  inflight_++;
+  // register callback before sending, reply may arrive before send returns.
+  callback_map[request->get_rc().rid] = func;
+  lk.unlock();
+  handleRequest(request);
 }
 
 void RequestHandler::notify(RequestReply *requestReply) {
+  RequestReplyContext &rrc = requestReply->get_rrc();
   unique_lock<mutex> lk(h_mtx);
-  requestReplyContext = requestReply->get_rrc();
-  op_finished = true;
-  if (callback_map.count(requestReplyContext.rid) != 0) {
-    callback_map[requestReplyContext.rid]();
-    callback_map.erase(requestReplyContext.rid);
-  } else {
-    cv.notify_one();
-    lk.unlock();
+  auto it = callback_map.find(rrc.rid);
+  if (it == callback_map.end()) {
+    return;
   }
+  RequestCallback func = std::move(it->second);
+  callback_map.erase(it);
+  inflight_--;
+  cv.notify_one();
+  lk.unlock();
+  func(rrc);
+}
+
+void RequestHandler::set_max_inflight(uint64_t max_inflight) {
+  unique_lock<mutex> lk(h_mtx);
+  max_inflight_ = max_inflight;
+  cv.notify_all();
+}
+
+uint64_t RequestHandler::get_inflight() {
+  unique_lock<mutex> lk(h_mtx);
+  return inflight_;
 }
 
 void RequestHandler::handleRequest(Request *request) {
-  op_finished = false;
   OpType rt = request->get_rc().type;
   switch (rt) {
-    case ALLOC: {
-      request->encode();
-      networkClient_->send(reinterpret_cast<char *>(request->data_),
-                           request->size_);
-      break;
-    }
-    case FREE: {
-      request->encode();
-      networkClient_->send(reinterpret_cast<char *>(request->data_),
-                           request->size_);
-      break;
-    }
-    case WRITE: {
+    case ALLOC:
+    case FREE:
+    case WRITE:
+    case READ:
+    case PUT:
+    case GET_META:
+    case DELETE: {
       request->encode();
       networkClient_->send(reinterpret_cast<char *>(request->data_),
                            request->size_);
       break;
     }
-    case READ: {
-      request->encode();
-      networkClient_->send(reinterpret_cast<char *>(request->data_),
-                           request->size_);
-      break;
-    }
-    case PUT: {
-      request->encode();
-      networkClient_->send(reinterpret_cast<char *>(request->data_),
-                           request->size_);
-    }
-    case GET_META: {
-      request->encode();
-      networkClient_->send(reinterpret_cast<char *>(request->data_),
-                           request->size_);
-    }
     default: {}
   }
 }
 
-RequestReplyContext &RequestHandler::get() { return requestReplyContext; }
-
 ClientConnectedCallback::ClientConnectedCallback(NetworkClient *networkClient) {
   networkClient_ = networkClient;
 }
@@ -141,19 +138,13 @@ void ClientRecvCallback::operator()(void *param_1, void *param_2) {
   requestReply.decode();
   RequestReplyContext rrc = requestReply.get_rrc();
   switch (rrc.type) {
-    case ALLOC_REPLY: {
-      requestHandler_->notify(&requestReply);
-      break;
-    }
-    case FREE_REPLY: {
-      requestHandler_->notify(&requestReply);
-      break;
-    }
-    case WRITE_REPLY: {
-      requestHandler_->notify(&requestReply);
-      break;
-    }
-    case READ_REPLY: {
+    case ALLOC_REPLY:
+    case FREE_REPLY:
+    case WRITE_REPLY:
+    case READ_REPLY:
+    case PUT_REPLY:
+    case GET_META_REPLY:
+    case DELETE_REPLY: {
       requestHandler_->notify(&requestReply);
       break;
     }
@@ -163,8 +154,10 @@ void ClientRecvCallback::operator()(void *param_1, void *param_2) {
 }
 
 NetworkClient::NetworkClient(const string &remote_address,
-                             const string &remote_port)
-    : NetworkClient(remote_address, remote_port, 1, 32, 65536, 64) {}
+                             const string &remote_port, uint64_t max_inflight)
+    : NetworkClient(remote_address, remote_port, 1,
+                    std::max<int>(32, max_inflight), 65536,
+                    std::max<int>(64, max_inflight)) {}
 
 NetworkClient::NetworkClient(const string &remote_address,
                              const string &remote_port, int worker_num,
@@ -212,6 +205,7 @@ int NetworkClient::init(RequestHandler *requestHandler) {
   }
 
   circularBuffer_ = make_shared<CircularBuffer>(1024 * 1024, 512, false, this);
+  return 0;
 }
 
 void NetworkClient::shutdown() { client_->shutdown(); }
@@ -242,6 +236,51 @@ uint64_t NetworkClient::get_rkey() {
   return circularBuffer_->get_rma_chunk()->mr->key;
 }
 
+int NetworkClient::register_buffer(char *buffer, uint64_t size) {
+  Chunk *ck = register_rma_buffer(buffer, size);
+  if (ck == nullptr) {
+    return -1;
+  }
+  unique_lock<mutex> lk(reg_mtx);
+  registered_buffers_[(uint64_t)buffer] = std::make_pair(size, ck);
+  return 0;
+}
+
+void NetworkClient::unregister_buffer(char *buffer) {
+  unique_lock<mutex> lk(reg_mtx);
+  auto it = registered_buffers_.find((uint64_t)buffer);
+  if (it == registered_buffers_.end()) {
+    return;
+  }
+  int buffer_id = it->second.second->buffer_id;
+  registered_buffers_.erase(it);
+  lk.unlock();
+  unregister_rma_buffer(buffer_id);
+}
+
+uint64_t NetworkClient::get_rma_buffer(const char *data, uint64_t size,
+                                       bool copy, uint64_t *rkey) {
+  unique_lock<mutex> lk(reg_mtx);
+  auto it = registered_buffers_.upper_bound((uint64_t)data);
+  if (it != registered_buffers_.begin()) {
+    --it;
+    if ((uint64_t)data + size <= it->first + it->second.first) {
+      *rkey = it->second.second->mr->key;
+      return (uint64_t)data;
+    }
+  }
+  lk.unlock();
+  *rkey = get_rkey();
+  return get_dram_buffer(copy ? data : nullptr, size);
+}
+
+void NetworkClient::reclaim_rma_buffer(const char *data, uint64_t src_address,
+                                       uint64_t size) {
+  if (src_address != (uint64_t)data) {
+    reclaim_dram_buffer(src_address, size);
+  }
+}
+
 void NetworkClient::connected(Connection *con) {
   std::unique_lock<std::mutex> lk(con_mtx);
   con_ = con;
@@ -252,6 +291,12 @@ void NetworkClient::connected(Connection *con) {
 
 void NetworkClient::send(char *data, uint64_t size) {
   auto ck = chunkMgr_->get(con_);
+  // the window can be raised past the buffer count with set_max_inflight,
+  // wait for an earlier send to complete and give its buffer back
+  while (ck == nullptr) {
+    std::this_thread::yield();
+    ck = chunkMgr_->get(con_);
+  }
   std::memcpy(reinterpret_cast<char *>(ck->buffer), data, size);
   ck->size = size;
   con_->send(ck);
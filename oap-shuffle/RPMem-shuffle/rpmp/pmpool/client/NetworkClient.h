@@ -16,12 +16,16 @@
 #include <atomic>
 #include <condition_variable>  // NOLINT
 #include <cstring>
+#include <functional>
 #include <future>  // NOLINT
+#include <map>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
 #include <utility>
 
+#include "../Common.h"
 #include "../Event.h"
 #include "../RmaBufferRegister.h"
 #include "../ThreadWrapper.h"
@@ -48,31 +52,38 @@ class ChunkMgr;
 typedef promise<RequestReplyContext> Promise;
 typedef future<RequestReplyContext> Future;
 
+typedef std::function<void(RequestReplyContext &)> RequestCallback;
+
+/**
+ * @brief RequestHandler tracks every in-flight request by rid in a completion
+ * table. Requests are sent without waiting for the previous reply, the
+ * callback registered for a rid runs when its reply arrives. At most
+ * max_inflight requests are outstanding, addTask blocks when the window is
+ * full.
+ */
 class RequestHandler {
  public:
-  explicit RequestHandler(NetworkClient *networkClient);
+  explicit RequestHandler(NetworkClient *networkClient,
+                          uint64_t max_inflight = DEFAULT_MAX_INFLIGHT);
   ~RequestHandler() = default;
-  void addTask(Request *request);
-  void addTask(Request *request, std::function<void()> func);
+  /// send request and return the future of its reply.
+  Future addTask(Request *request);
+  /// send request, func is called on network thread when reply arrives.
+  void addTask(Request *request, RequestCallback func);
   void notify(RequestReply *requestReply);
-  void wait();
-  RequestReplyContext &get();
+  void set_max_inflight(uint64_t max_inflight);
+  uint64_t get_inflight();
 
  private:
   void handleRequest(Request *request);
 
  private:
   NetworkClient *networkClient_;
-  BlockingConcurrentQueue<Request *> pendingRequestQueue_;
   std::mutex h_mtx;
-  unordered_map<uint64_t, std::function<void()>> callback_map;
-  uint64_t total_num = 0;
-  uint64_t begin = 0;
-  uint64_t end = 0;
-  uint64_t time = 0;
-  bool op_finished = false;
   std::condition_variable cv;
-  RequestReplyContext requestReplyContext;
+  uint64_t max_inflight_;
+  uint64_t inflight_ = 0;
+  unordered_map<uint64_t, RequestCallback> callback_map;
 };
 
 class ClientShutdownCallback : public Callback {
@@ -126,7 +137,10 @@ class NetworkClient : public RmaBufferRegister {
  public:
   friend ClientConnectedCallback;
   NetworkClient() = delete;
-  NetworkClient(const string &remote_address, const string &remote_port);
+  /// every in-flight request holds a send buffer until its send completes,
+  /// so at least max_inflight buffers are allocated per connection.
+  NetworkClient(const string &remote_address, const string &remote_port,
+                uint64_t max_inflight = DEFAULT_MAX_INFLIGHT);
   NetworkClient(const string &remote_address, const string &remote_port,
                 int worker_num, int buffer_num_per_con, int buffer_size,
                 int init_buffer_num);
@@ -139,6 +153,18 @@ class NetworkClient : public RmaBufferRegister {
   uint64_t get_dram_buffer(const char *data, uint64_t size);
   void reclaim_dram_buffer(uint64_t src_address, uint64_t size);
   uint64_t get_rkey();
+  /// register user buffer as RDMA region, so that it can be the source or
+  /// destination of RMA without being staged in DRAM circular buffer.
+  int register_buffer(char *buffer, uint64_t size);
+  void unregister_buffer(char *buffer);
+  /// Return the address that server does RMA against. The user buffer itself
+  /// if it lies in a registered region, a staging buffer otherwise. Data is
+  /// copied to the staging buffer only if copy is true.
+  uint64_t get_rma_buffer(const char *data, uint64_t size, bool copy,
+                          uint64_t *rkey);
+  /// release the buffer returned by get_rma_buffer.
+  void reclaim_rma_buffer(const char *data, uint64_t src_address,
+                          uint64_t size);
   void connected(Connection *con);
   void send(char *data, uint64_t size);
   void read(Request *request);
@@ -162,6 +188,9 @@ class NetworkClient : public RmaBufferRegister {
   condition_variable con_v;
   shared_ptr<CircularBuffer> circularBuffer_;
   atomic<uint64_t> buffer_id_{0};
+  mutex reg_mtx;
+  /// start address of registered user buffer -> (size, registered chunk)
+  std::map<uint64_t, std::pair<uint64_t, Chunk *>> registered_buffers_;
 };
 
 #endif  // PMPOOL_CLIENT_NETWORKCLIENT_H_
@@ -15,16 +15,20 @@
 #include "pmpool/Protocol.h"
 
 PmPoolClient::PmPoolClient(const string &remote_address,
-                           const string &remote_port) {
+                           const string &remote_port, uint64_t max_inflight) {
   tx_finished = true;
   op_finished = false;
-  networkClient_ = make_shared<NetworkClient>(remote_address, remote_port);
-  requestHandler_ = make_shared<RequestHandler>(networkClient_.get());
+  networkClient_ =
+      make_shared<NetworkClient>(remote_address, remote_port, max_inflight);
+  requestHandler_ =
+      make_shared<RequestHandler>(networkClient_.get(), max_inflight);
 }
 
 PmPoolClient::~PmPoolClient() {}
 
-int PmPoolClient::init() { networkClient_->init(requestHandler_.get()); }
+int PmPoolClient::init() {
+  return networkClient_->init(requestHandler_.get());
+}
 
 void PmPoolClient::begin_tx() {
   std::unique_lock<std::mutex> lk(tx_mtx);
@@ -40,9 +44,7 @@ uint64_t PmPoolClient::alloc(uint64_t size) {
   rc.rid = rid_++;
   rc.size = size;
   Request request(rc);
-  requestHandler_->addTask(&request);
-  requestHandler_->wait();
-  return requestHandler_->get().address;
+  return requestHandler_->addTask(&request).get().address;
 }
 
 int PmPoolClient::free(uint64_t address) {
@@ -51,9 +53,7 @@ int PmPoolClient::free(uint64_t address) {
   rc.rid = rid_++;
   rc.address = address;
   Request request(rc);
-  requestHandler_->addTask(&request);
-  requestHandler_->wait();
-  return requestHandler_->get().success;
+  return requestHandler_->addTask(&request).get().success;
 }
 
 void PmPoolClient::shutdown() { networkClient_->shutdown(); }
@@ -61,57 +61,15 @@ void PmPoolClient::shutdown() { networkClient_->shutdown(); }
 void PmPoolClient::wait() { networkClient_->wait(); }
 
 int PmPoolClient::write(uint64_t address, const char *data, uint64_t size) {
-  RequestContext rc = {};
-  rc.type = WRITE;
-  rc.rid = rid_++;
-  rc.size = size;
-  rc.address = address;
-  // allocate memory for RMA read from client.
-  rc.src_address = networkClient_->get_dram_buffer(data, rc.size);
-  rc.src_rkey = networkClient_->get_rkey();
-  Request request(rc);
-  requestHandler_->addTask(&request);
-  requestHandler_->wait();
-  auto res = requestHandler_->get().success;
-  networkClient_->reclaim_dram_buffer(rc.src_address, rc.size);
-  return res;
+  return write_async(address, data, size).get();
 }
 
 uint64_t PmPoolClient::write(const char *data, uint64_t size) {
-  RequestContext rc = {};
-  rc.type = WRITE;
-  rc.rid = rid_++;
-  rc.size = size;
-  rc.address = 0;
-  // allocate memory for RMA read from client.
-  rc.src_address = networkClient_->get_dram_buffer(data, rc.size);
-  rc.src_rkey = networkClient_->get_rkey();
-  Request request(rc);
-  requestHandler_->addTask(&request);
-  requestHandler_->wait();
-  auto res = requestHandler_->get().address;
-  networkClient_->reclaim_dram_buffer(rc.src_address, rc.size);
-  return res;
+  return write_async(data, size).get();
 }
 
 int PmPoolClient::read(uint64_t address, char *data, uint64_t size) {
-  RequestContext rc = {};
-  rc.type = READ;
-  rc.rid = rid_++;
-  rc.size = size;
-  rc.address = address;
-  // allocate memory for RMA read from client.
-  rc.src_address = networkClient_->get_dram_buffer(nullptr, rc.size);
-  rc.src_rkey = networkClient_->get_rkey();
-  Request request(rc);
-  requestHandler_->addTask(&request);
-  requestHandler_->wait();
-  auto res = requestHandler_->get().success;
-  if (!res) {
-    memcpy(data, reinterpret_cast<char *>(rc.src_address), size);
-  }
-  networkClient_->reclaim_dram_buffer(rc.src_address, rc.size);
-  return res;
+  return read_async(address, data, size).get();
 }
 
 int PmPoolClient::read(uint64_t address, char *data, uint64_t size,
@@ -121,17 +79,17 @@ int PmPoolClient::read(uint64_t address, char *data, uint64_t size,
   rc.rid = rid_++;
   rc.size = size;
   rc.address = address;
-  // allocate memory for RMA read from client.
-  rc.src_address = networkClient_->get_dram_buffer(nullptr, rc.size);
-  rc.src_rkey = networkClient_->get_rkey();
+  // registered user memory is RMA written directly, others are staged.
+  rc.src_address =
+      networkClient_->get_rma_buffer(data, rc.size, false, &rc.src_rkey);
   Request request(rc);
-  requestHandler_->addTask(&request, [&] {
-    auto res = requestHandler_->get().success;
-    if (res) {
-      memcpy(data, reinterpret_cast<char *>(rc.src_address), size);
+  requestHandler_->addTask(&request, [this, rc, data,
+                                      func](RequestReplyContext &rrc) {
+    if (!rrc.success && rc.src_address != (uint64_t)data) {
+      memcpy(data, reinterpret_cast<char *>(rc.src_address), rc.size);
     }
-    networkClient_->reclaim_dram_buffer(rc.src_address, rc.size);
-    func(res);
+    networkClient_->reclaim_rma_buffer(data, rc.src_address, rc.size);
+    func(rrc.success);
   });
   return 0;
 }
@@ -144,50 +102,184 @@ void PmPoolClient::end_tx() {
 
 uint64_t PmPoolClient::put(const string &key, const char *value,
                            uint64_t size) {
+  return put_async(key, value, size).get();
+}
+
+vector<block_meta> PmPoolClient::get(const string &key) {
+  return get_async(key).get();
+}
+
+int PmPoolClient::del(const string &key) {
   uint64_t key_uint;
   Digest::computeKeyHash(key, &key_uint);
   RequestContext rc = {};
-  rc.type = PUT;
+  rc.type = DELETE;
+  rc.rid = rid_++;
+  rc.key = key_uint;
+  Request request(rc);
+  return requestHandler_->addTask(&request).get().success;
+}
+
+std::future<int> PmPoolClient::write_async(uint64_t address, const char *data,
+                                           uint64_t size) {
+  RequestContext rc = {};
+  rc.type = WRITE;
+  rc.rid = rid_++;
+  rc.size = size;
+  rc.address = address;
+  // registered user memory is RMA read directly, others are staged.
+  rc.src_address =
+      networkClient_->get_rma_buffer(data, rc.size, true, &rc.src_rkey);
+  auto promise = make_shared<std::promise<int>>();
+  auto future = promise->get_future();
+  Request request(rc);
+  requestHandler_->addTask(
+      &request, [this, rc, data, promise](RequestReplyContext &rrc) {
+        networkClient_->reclaim_rma_buffer(data, rc.src_address, rc.size);
+        promise->set_value(rrc.success);
+      });
+  return future;
+}
+
+std::future<uint64_t> PmPoolClient::write_async(const char *data,
+                                                uint64_t size) {
+  RequestContext rc = {};
+  rc.type = WRITE;
   rc.rid = rid_++;
   rc.size = size;
   rc.address = 0;
-  // allocate memory for RMA read from client.
-  rc.src_address = networkClient_->get_dram_buffer(value, rc.size);
-  rc.src_rkey = networkClient_->get_rkey();
-  rc.key = key_uint;
+  // registered user memory is RMA read directly, others are staged.
+  rc.src_address =
+      networkClient_->get_rma_buffer(data, rc.size, true, &rc.src_rkey);
+  auto promise = make_shared<std::promise<uint64_t>>();
+  auto future = promise->get_future();
   Request request(rc);
-  requestHandler_->addTask(&request);
-  requestHandler_->wait();
-  auto address = requestHandler_->get().address;
-  networkClient_->reclaim_dram_buffer(rc.src_address, rc.size);
-  return address;
+  requestHandler_->addTask(
+      &request, [this, rc, data, promise](RequestReplyContext &rrc) {
+        networkClient_->reclaim_rma_buffer(data, rc.src_address, rc.size);
+        promise->set_value(rrc.address);
+      });
+  return future;
 }
 
-vector<block_meta> PmPoolClient::get(const string &key) {
+std::future<int> PmPoolClient::read_async(uint64_t address, char *data,
+                                          uint64_t size) {
+  RequestContext rc = {};
+  rc.type = READ;
+  rc.rid = rid_++;
+  rc.size = size;
+  rc.address = address;
+  // registered user memory is RMA written directly, others are staged.
+  rc.src_address =
+      networkClient_->get_rma_buffer(data, rc.size, false, &rc.src_rkey);
+  auto promise = make_shared<std::promise<int>>();
+  auto future = promise->get_future();
+  Request request(rc);
+  requestHandler_->addTask(
+      &request, [this, rc, data, promise](RequestReplyContext &rrc) {
+        if (!rrc.success && rc.src_address != (uint64_t)data) {
+          memcpy(data, reinterpret_cast<char *>(rc.src_address), rc.size);
+        }
+        networkClient_->reclaim_rma_buffer(data, rc.src_address, rc.size);
+        promise->set_value(rrc.success);
+      });
+  return future;
+}
+
+std::future<uint64_t> PmPoolClient::put_async(const string &key,
+                                              const char *value, uint64_t size,
+                                              bool stage) {
   uint64_t key_uint;
   Digest::computeKeyHash(key, &key_uint);
   RequestContext rc = {};
-  rc.type = GET_META;
+  rc.type = PUT;
   rc.rid = rid_++;
+  rc.size = size;
   rc.address = 0;
+  // registered user memory is RMA read directly unless stage is set, others
+  // are staged.
+  if (stage) {
+    rc.src_address = networkClient_->get_dram_buffer(value, rc.size);
+    rc.src_rkey = networkClient_->get_rkey();
+  } else {
+    rc.src_address =
+        networkClient_->get_rma_buffer(value, rc.size, true, &rc.src_rkey);
+  }
   rc.key = key_uint;
+  auto promise = make_shared<std::promise<uint64_t>>();
+  auto future = promise->get_future();
   Request request(rc);
-  requestHandler_->addTask(&request);
-  requestHandler_->wait();
-  auto bml = requestHandler_->get().bml;
-  return bml;
+  requestHandler_->addTask(
+      &request, [this, rc, value, promise](RequestReplyContext &rrc) {
+        networkClient_->reclaim_rma_buffer(value, rc.src_address, rc.size);
+        promise->set_value(rrc.address);
+      });
+  return future;
 }
 
-int PmPoolClient::del(const string &key) {
+std::future<vector<block_meta>> PmPoolClient::get_async(const string &key) {
   uint64_t key_uint;
   Digest::computeKeyHash(key, &key_uint);
   RequestContext rc = {};
-  rc.type = DELETE;
+  rc.type = GET_META;
   rc.rid = rid_++;
+  rc.address = 0;
   rc.key = key_uint;
+  auto promise = make_shared<std::promise<vector<block_meta>>>();
+  auto future = promise->get_future();
   Request request(rc);
-  requestHandler_->addTask(&request);
-  requestHandler_->wait();
-  auto res = requestHandler_->get().success;
+  requestHandler_->addTask(&request, [promise](RequestReplyContext &rrc) {
+    promise->set_value(rrc.bml);
+  });
+  return future;
+}
+
+vector<uint64_t> PmPoolClient::put_many(const vector<string> &keys,
+                                        const vector<const char *> &values,
+                                        const vector<uint64_t> &sizes) {
+  assert(keys.size() == values.size() && keys.size() == sizes.size());
+  vector<std::future<uint64_t>> futures;
+  futures.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    futures.push_back(put_async(keys[i], values[i], sizes[i]));
+  }
+  vector<uint64_t> addresses;
+  addresses.reserve(keys.size());
+  for (auto &future : futures) {
+    addresses.push_back(future.get());
+  }
+  return addresses;
+}
+
+vector<int> PmPoolClient::read_many(const vector<uint64_t> &addresses,
+                                    const vector<char *> &data,
+                                    const vector<uint64_t> &sizes) {
+  assert(addresses.size() == data.size() && addresses.size() == sizes.size());
+  vector<std::future<int>> futures;
+  futures.reserve(addresses.size());
+  for (size_t i = 0; i < addresses.size(); i++) {
+    futures.push_back(read_async(addresses[i], data[i], sizes[i]));
+  }
+  vector<int> res;
+  res.reserve(addresses.size());
+  for (auto &future : futures) {
+    res.push_back(future.get());
+  }
   return res;
 }
+
+int PmPoolClient::register_buffer(char *buffer, uint64_t size) {
+  return networkClient_->register_buffer(buffer, size);
+}
+
+void PmPoolClient::unregister_buffer(char *buffer) {
+  networkClient_->unregister_buffer(buffer);
+}
+
+void PmPoolClient::set_max_inflight(uint64_t max_inflight) {
+  requestHandler_->set_max_inflight(max_inflight);
+}
+
+uint64_t PmPoolClient::get_inflight() {
+  return requestHandler_->get_inflight();
+}
@@ -46,7 +46,8 @@ using std::vector;
 class PmPoolClient {
  public:
   PmPoolClient() = delete;
-  PmPoolClient(const string &remote_address, const string &remote_port);
+  PmPoolClient(const string &remote_address, const string &remote_port,
+               uint64_t max_inflight = DEFAULT_MAX_INFLIGHT);
   ~PmPoolClient();
   int init();
 
@@ -83,6 +84,43 @@ class PmPoolClient {
   vector<block_meta> get(const string &key);
   int del(const string &key);
 
+  /// asynchronous interface
+  /// Requests are pipelined, up to max_inflight requests are outstanding
+  /// and the returned future is fulfilled when the reply arrives.
+  /// Data must stay valid until the future is ready.
+  std::future<int> write_async(uint64_t address, const char *data,
+                               uint64_t size);
+  std::future<uint64_t> write_async(const char *data, uint64_t size);
+  std::future<int> read_async(uint64_t address, char *data, uint64_t size);
+  /// With stage, value is copied to the client DRAM buffer even if it is
+  /// registered, so it may be reused before the future is ready.
+  std::future<uint64_t> put_async(const string &key, const char *value,
+                                  uint64_t size, bool stage = false);
+  std::future<vector<block_meta>> get_async(const string &key);
+
+  /// batched interface
+  /// Submit all requests without waiting for replies, then wait for all.
+  /// Return the global address of every value, in the order of keys.
+  vector<uint64_t> put_many(const vector<string> &keys,
+                            const vector<const char *> &values,
+                            const vector<uint64_t> &sizes);
+  /// Return 0 for every block succeed to read, others value if fail.
+  vector<int> read_many(const vector<uint64_t> &addresses,
+                        const vector<char *> &data,
+                        const vector<uint64_t> &sizes);
+
+  /// Register user buffer as RDMA region. Data read from or written to a
+  /// registered buffer is transferred by RMA directly, without being staged
+  /// in the client DRAM buffer.
+  /// Return 0 if succeed, return others value if fail.
+  int register_buffer(char *buffer, uint64_t size);
+  void unregister_buffer(char *buffer);
+
+  /// change the number of requests allowed in flight.
+  void set_max_inflight(uint64_t max_inflight);
+  /// return the number of requests waiting for reply.
+  uint64_t get_inflight();
+
   void shutdown();
   void wait();
 
@@ -0,0 +1,307 @@
+/*
+ * Filename: /mnt/spark-pmof/tool/rpmp/pmpool/client/PmPoolClusterClient.cc
+ * Path: /mnt/spark-pmof/tool/rpmp/pmpool/client
+ * Created Date: Saturday, October 17th 2026, 1:48:22 pm
+ * Author: root
+ *
+ * Copyright (c) 2026 Intel
+ */
+
+#include "pmpool/client/PmPoolClusterClient.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+
+#include "pmpool/client/PmPoolClient.h"
+
+PmPoolClusterClient::PmPoolClusterClient(
+    const vector<std::pair<string, string>> &servers,
+    int connections_per_server, uint32_t virtual_node_num,
+    uint32_t replica_num)
+    : servers_(servers),
+      connections_per_server_(connections_per_server),
+      replica_num_(std::max<uint32_t>(replica_num, 1)),
+      ring_(virtual_node_num) {}
+
+PmPoolClusterClient::~PmPoolClusterClient() {}
+
+PmPoolClusterClient::ServerConnections::~ServerConnections() {
+  if (closed) {
+    return;
+  }
+  shutdown();
+  for (auto &client : clients) {
+    client->wait();
+  }
+}
+
+void PmPoolClusterClient::ServerConnections::shutdown() {
+  if (closed.exchange(true)) {
+    return;
+  }
+  for (auto &client : clients) {
+    client->shutdown();
+  }
+}
+
+int PmPoolClusterClient::init() {
+  for (auto &server : servers_) {
+    if (add_server(server.first, server.second)) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+shared_ptr<PmPoolClusterClient::ServerConnections> PmPoolClusterClient::connect(
+    const string &remote_address, const string &remote_port) {
+  auto connections = std::make_shared<ServerConnections>();
+  for (int i = 0; i < connections_per_server_; i++) {
+    auto client = std::make_shared<PmPoolClient>(remote_address, remote_port);
+    if (client->init()) {
+      return nullptr;
+    }
+    connections->clients.push_back(client);
+  }
+  return connections;
+}
+
+int PmPoolClusterClient::add_server(const string &remote_address,
+                                    const string &remote_port) {
+  string node = remote_address + ":" + remote_port;
+  {
+    std::lock_guard<std::mutex> l(ring_mtx_);
+    if (ring_.contains(node)) {
+      return 0;
+    }
+  }
+  // connect before the server is visible on the ring
+  auto connections = connect(remote_address, remote_port);
+  if (connections == nullptr) {
+    return -1;
+  }
+  std::lock_guard<std::mutex> l(ring_mtx_);
+  connections_[node] = connections;
+  ring_.add_node(node);
+  return 0;
+}
+
+int PmPoolClusterClient::remove_server(const string &remote_address,
+                                       const string &remote_port) {
+  string node = remote_address + ":" + remote_port;
+  // requests that routed to the server before hold it until they are done,
+  // the last one shuts its connections down
+  std::lock_guard<std::mutex> l(ring_mtx_);
+  if (!ring_.contains(node)) {
+    return -1;
+  }
+  ring_.remove_node(node);
+  connections_.erase(node);
+  return 0;
+}
+
+string PmPoolClusterClient::get_server(const string &key) {
+  std::lock_guard<std::mutex> l(ring_mtx_);
+  return ring_.get_node(key);
+}
+
+vector<string> PmPoolClusterClient::get_replica_servers(const string &key) {
+  std::lock_guard<std::mutex> l(ring_mtx_);
+  return ring_.get_nodes(key, replica_num_);
+}
+
+void PmPoolClusterClient::set_replica_timeout(uint64_t timeout_ms) {
+  replica_timeout_ms_ = timeout_ms;
+}
+
+uint64_t PmPoolClusterClient::ServerConnections::load() {
+  uint64_t inflight = 0;
+  for (auto &client : clients) {
+    inflight += client->get_inflight();
+  }
+  return inflight;
+}
+
+shared_ptr<PmPoolClusterClient::ServerConnections> PmPoolClusterClient::route(
+    const string &key) {
+  std::lock_guard<std::mutex> l(ring_mtx_);
+  string node = ring_.get_node(key);
+  if (node.empty()) {
+    return nullptr;
+  }
+  return connections_[node];
+}
+
+vector<shared_ptr<PmPoolClusterClient::ServerConnections>>
+PmPoolClusterClient::route_replicas(const string &key) {
+  vector<shared_ptr<ServerConnections>> replicas;
+  std::lock_guard<std::mutex> l(ring_mtx_);
+  for (auto &node : ring_.get_nodes(key, replica_num_)) {
+    replicas.push_back(connections_[node]);
+  }
+  return replicas;
+}
+
+template <typename T>
+bool PmPoolClusterClient::wait_replica(
+    const shared_ptr<ServerConnections> &replica, std::future<T> *future) {
+  if (future->wait_for(std::chrono::milliseconds(replica_timeout_ms_)) ==
+      std::future_status::timeout) {
+    replica->failed = true;
+    return false;
+  }
+  replica->failed = false;
+  return true;
+}
+
+uint64_t PmPoolClusterClient::put(const string &key, const char *value,
+                                  uint64_t size) {
+  if (replica_num_ == 1) {
+    auto server = route(key);
+    if (server == nullptr) {
+      return -1;
+    }
+    return server->next_client()->put(key, value, size);
+  }
+  auto replicas = route_replicas(key);
+  if (replicas.empty()) {
+    return -1;
+  }
+  return put_replicas(replicas, key, value, size);
+}
+
+uint64_t PmPoolClusterClient::put_replicas(
+    const vector<shared_ptr<ServerConnections>> &replicas, const string &key,
+    const char *value, uint64_t size) {
+  // value is staged in client buffers, a replica that times out may still RMA
+  // read it after put returned and the caller reused value.
+  vector<std::future<uint64_t>> futures(replicas.size());
+  for (size_t i = 0; i < replicas.size(); i++) {
+    if (replicas[i]->usable()) {
+      futures[i] =
+          replicas[i]->next_client()->put_async(key, value, size, true);
+    }
+  }
+  uint64_t address = -1;
+  for (size_t i = 0; i < replicas.size(); i++) {
+    if (futures[i].valid() && wait_replica(replicas[i], &futures[i])) {
+      uint64_t replica_address = futures[i].get();
+      // replicas[0] owns key, reads by address are routed to it.
+      if (i == 0) {
+        address = replica_address;
+      }
+    }
+  }
+  return address;
+}
+
+vector<block_meta> PmPoolClusterClient::get(const string &key) {
+  auto server = route(key);
+  if (server == nullptr) {
+    return vector<block_meta>();
+  }
+  return server->next_client()->get(key);
+}
+
+int PmPoolClusterClient::read(const string &key, uint64_t address, char *data,
+                              uint64_t size) {
+  auto server = route(key);
+  if (server == nullptr) {
+    return -1;
+  }
+  return server->next_client()->read(address, data, size);
+}
+
+uint64_t PmPoolClusterClient::read(const string &key, char *data,
+                                   uint64_t size) {
+  auto replicas = route_replicas(key);
+  // live replicas first, then the least loaded one.
+  vector<std::pair<uint64_t, shared_ptr<ServerConnections>>> candidates;
+  for (auto &replica : replicas) {
+    if (!replica->usable()) {
+      continue;
+    }
+    uint64_t rank = replica->failed ? UINT64_MAX : replica->load();
+    candidates.push_back(std::make_pair(rank, replica));
+  }
+  std::stable_sort(
+      candidates.begin(), candidates.end(),
+      [](const std::pair<uint64_t, shared_ptr<ServerConnections>> &a,
+         const std::pair<uint64_t, shared_ptr<ServerConnections>> &b) {
+        return a.first < b.first;
+      });
+  for (auto &candidate : candidates) {
+    auto &replica = candidate.second;
+    auto client = replica->next_client();
+    auto meta = client->get_async(key);
+    if (!wait_replica(replica, &meta)) {
+      continue;
+    }
+    auto bml = meta.get();
+    if (bml.empty()) {
+      continue;
+    }
+    uint64_t total = 0;
+    for (auto &bm : bml) {
+      total += bm.size;
+    }
+    if (total > size) {
+      return -1;
+    }
+    // block reads are not timed out, a late reply must never land in data
+    // after it was filled from another replica.
+    vector<std::future<int>> futures;
+    uint64_t offset = 0;
+    for (auto &bm : bml) {
+      futures.push_back(client->read_async(bm.address, data + offset, bm.size));
+      offset += bm.size;
+    }
+    bool succeed = true;
+    for (auto &future : futures) {
+      if (future.get() != 0) {
+        succeed = false;
+      }
+    }
+    if (succeed) {
+      return total;
+    }
+  }
+  return -1;
+}
+
+int PmPoolClusterClient::del(const string &key) {
+  if (replica_num_ == 1) {
+    auto server = route(key);
+    if (server == nullptr) {
+      return -1;
+    }
+    return server->next_client()->del(key);
+  }
+  auto replicas = route_replicas(key);
+  if (replicas.empty()) {
+    return -1;
+  }
+  int res = 0;
+  for (auto &replica : replicas) {
+    if (!replica->usable() || replica->next_client()->del(key)) {
+      res = -1;
+    }
+  }
+  return res;
+}
+
+void PmPoolClusterClient::shutdown() {
+  std::lock_guard<std::mutex> l(ring_mtx_);
+  for (auto &connections : connections_) {
+    connections.second->shutdown();
+  }
+}
+
+void PmPoolClusterClient::wait() {
+  std::lock_guard<std::mutex> l(ring_mtx_);
+  for (auto &connections : connections_) {
+    for (auto &client : connections.second->clients) {
+      client->wait();
+    }
+  }
+}
@@ -0,0 +1,132 @@
+/*
+ * Filename: /mnt/spark-pmof/tool/rpmp/pmpool/client/PmPoolClusterClient.h
+ * Path: /mnt/spark-pmof/tool/rpmp/pmpool/client
+ * Created Date: Saturday, October 17th 2026, 1:48:22 pm
+ * Author: root
+ *
+ * Copyright (c) 2026 Intel
+ */
+
+#ifndef PMPOOL_CLIENT_PMPOOLCLUSTERCLIENT_H_
+#define PMPOOL_CLIENT_PMPOOLCLUSTERCLIENT_H_
+
+#include <atomic>
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../Base.h"
+#include "../ConsistentHash.h"
+
+#define DEFAULT_CONNECTIONS_PER_SERVER 4
+#define DEFAULT_REPLICA_NUM 1
+#define DEFAULT_REPLICA_TIMEOUT_MS 5000
+
+class PmPoolClient;
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+/**
+ * @brief PmPoolClusterClient spreads key-value storage over a list of RPMP
+ * servers. Keys are routed by consistent hashing, every server is served by
+ * several PmPoolClient connections that are used round-robin.
+ * Block addresses returned by get are only valid on the server that owns the
+ * key, so reads are routed by key as well.
+ * With replica_num > 1 every key is also put on the next replica_num - 1
+ * distinct servers of the ring, all replicas are written in parallel. Whole
+ * value reads go to the least loaded live replica and fail over to the others
+ * when a replica does not answer.
+ */
+class PmPoolClusterClient {
+ public:
+  PmPoolClusterClient() = delete;
+  /// servers is the list of (remote_address, remote_port).
+  explicit PmPoolClusterClient(
+      const vector<std::pair<string, string>> &servers,
+      int connections_per_server = DEFAULT_CONNECTIONS_PER_SERVER,
+      uint32_t virtual_node_num = DEFAULT_VIRTUAL_NODE_NUM,
+      uint32_t replica_num = DEFAULT_REPLICA_NUM);
+  ~PmPoolClusterClient();
+  int init();
+
+  /// Connect to a new server and add it to the hash ring.
+  /// Return 0 if succeed, return others value if fail.
+  int add_server(const string &remote_address, const string &remote_port);
+  /// Remove server from the hash ring, keys it owns move to other servers.
+  /// Its connections are shut down once the requests still using them are done.
+  int remove_server(const string &remote_address, const string &remote_port);
+
+  /// key-value storage interface
+  /// put returns the address of value on the server that owns key, once
+  /// every live replica has acked. Return -1 if the owner did not ack, even
+  /// if other replicas did, because addresses are only read from the owner.
+  uint64_t put(const string &key, const char *value, uint64_t size);
+  vector<block_meta> get(const string &key);
+  /// Read the block of key at address that is returned by get.
+  int read(const string &key, uint64_t address, char *data, uint64_t size);
+  /// Read all blocks of key into data from any replica.
+  /// Return the number of bytes read, return -1 if no replica has key.
+  uint64_t read(const string &key, char *data, uint64_t size);
+  int del(const string &key);
+
+  /// Return the server(address:port) that owns key.
+  string get_server(const string &key);
+  /// Return the servers that hold key, the owner comes first.
+  vector<string> get_replica_servers(const string &key);
+
+  /// time to wait for a replica before it is considered down.
+  void set_replica_timeout(uint64_t timeout_ms);
+
+  void shutdown();
+  void wait();
+
+ private:
+  struct ServerConnections {
+    /// shuts the connections down unless shutdown() did. A removed server is
+    /// destroyed by the last request that still holds it.
+    ~ServerConnections();
+    /// shut every connection down, only the first call has an effect.
+    void shutdown();
+    vector<shared_ptr<PmPoolClient>> clients;
+    std::atomic<bool> closed{false};
+    std::atomic<uint64_t> next{0};
+    /// set when a request timed out, the server is read last afterwards.
+    std::atomic<bool> failed{false};
+    shared_ptr<PmPoolClient> next_client() {
+      return clients[next++ % clients.size()];
+    }
+    /// requests in flight over all connections.
+    uint64_t load();
+    /// false while a failed server still has requests in flight. Those may
+    /// never be answered and more requests would block in addTask once the
+    /// in-flight window is full, the server is retried when they drained.
+    bool usable() { return !failed || load() == 0; }
+  };
+
+  shared_ptr<ServerConnections> connect(const string &remote_address,
+                                        const string &remote_port);
+  shared_ptr<ServerConnections> route(const string &key);
+  vector<shared_ptr<ServerConnections>> route_replicas(const string &key);
+  uint64_t put_replicas(const vector<shared_ptr<ServerConnections>> &replicas,
+                        const string &key, const char *value, uint64_t size);
+  template <typename T>
+  bool wait_replica(const shared_ptr<ServerConnections> &replica,
+                    std::future<T> *future);
+
+ private:
+  vector<std::pair<string, string>> servers_;
+  int connections_per_server_;
+  uint32_t replica_num_;
+  std::atomic<uint64_t> replica_timeout_ms_{DEFAULT_REPLICA_TIMEOUT_MS};
+  std::mutex ring_mtx_;
+  ConsistentHash ring_;
+  std::unordered_map<string, shared_ptr<ServerConnections>> connections_;
+};
+
+#endif  // PMPOOL_CLIENT_PMPOOLCLUSTERCLIENT_H_
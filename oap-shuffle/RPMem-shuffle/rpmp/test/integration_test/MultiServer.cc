@@ -0,0 +1,112 @@
+/*
+ * Filename: /mnt/spark-pmof/tool/rpmp/test/integration_test/MultiServer.cc
+ * Path: /mnt/spark-pmof/tool/rpmp/test/integration_test
+ * Created Date: Saturday, October 17th 2026, 2:20:13 pm
+ * Author: root
+ *
+ * Copyright (c) 2026 Intel
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "pmpool/Config.h"
+#include "pmpool/DataServer.h"
+#include "pmpool/Log.h"
+#include "pmpool/client/PmPoolClusterClient.h"
+
+/// run several DataServer instances on different ports of local host, each
+/// with a file backed pool, and put/get keys through the cluster client.
+std::string address = "172.168.0.40";
+int server_num = 3;
+int base_port = 12346;
+uint64_t pool_size = 1024 * 1024 * 1024;
+int key_num = 1000;
+
+int main() {
+  std::vector<std::shared_ptr<Config>> configs;
+  std::vector<std::shared_ptr<DataServer>> servers;
+  std::vector<std::pair<std::string, std::string>> server_list;
+  std::shared_ptr<Log> log;
+  for (int i = 0; i < server_num; i++) {
+    std::string port = std::to_string(base_port + i);
+    auto config = std::make_shared<Config>();
+    config->init(0, nullptr);
+    config->set_ip(address);
+    config->set_port(port);
+    config->set_pool_paths({"/tmp/rpmp_multi_server_" + port});
+    config->set_pool_sizes({pool_size});
+    config->set_affinities_({static_cast<uint64_t>(i + 1)});
+    if (log == nullptr) {
+      log = std::make_shared<Log>(config.get());
+    }
+    auto server = std::make_shared<DataServer>(config.get(), log.get());
+    assert(server->init() == 0);
+    configs.push_back(config);
+    servers.push_back(server);
+    server_list.push_back(std::make_pair(address, port));
+  }
+
+  PmPoolClusterClient client(server_list, 2);
+  assert(client.init() == 0);
+
+  std::map<std::string, int> keys_per_server;
+  char value[64];
+  char read_value[64];
+  for (int i = 0; i < key_num; i++) {
+    std::string key = "shuffle_0_" + std::to_string(i) + "_0";
+    snprintf(value, sizeof(value), "value of %s", key.c_str());
+    client.put(key, value, sizeof(value));
+    keys_per_server[client.get_server(key)]++;
+  }
+  for (int i = 0; i < key_num; i++) {
+    std::string key = "shuffle_0_" + std::to_string(i) + "_0";
+    snprintf(value, sizeof(value), "value of %s", key.c_str());
+    auto bml = client.get(key);
+    assert(bml.size() == 1);
+    client.read(key, bml[0].address, read_value, bml[0].size);
+    assert(strncmp(read_value, value, sizeof(value)) == 0);
+  }
+  for (auto &count : keys_per_server) {
+    std::cout << count.first << " owns " << count.second << " keys."
+              << std::endl;
+  }
+  assert(keys_per_server.size() == server_num);
+  for (int i = 0; i < key_num; i++) {
+    client.del("shuffle_0_" + std::to_string(i) + "_0");
+  }
+  client.shutdown();
+
+  // every key is put on two servers and read back from either of them.
+  PmPoolClusterClient replicated_client(server_list, 2,
+                                        DEFAULT_VIRTUAL_NODE_NUM, 2);
+  assert(replicated_client.init() == 0);
+  for (int i = 0; i < key_num; i++) {
+    std::string key = "shuffle_1_" + std::to_string(i) + "_0";
+    snprintf(value, sizeof(value), "value of %s", key.c_str());
+    replicated_client.put(key, value, sizeof(value));
+    auto replica_servers = replicated_client.get_replica_servers(key);
+    assert(replica_servers.size() == 2);
+    assert(replica_servers[0] != replica_servers[1]);
+  }
+  for (int i = 0; i < key_num; i++) {
+    std::string key = "shuffle_1_" + std::to_string(i) + "_0";
+    snprintf(value, sizeof(value), "value of %s", key.c_str());
+    assert(replicated_client.read(key, read_value, sizeof(read_value)) ==
+           sizeof(value));
+    assert(strncmp(read_value, value, sizeof(value)) == 0);
+  }
+  for (int i = 0; i < key_num; i++) {
+    replicated_client.del("shuffle_1_" + std::to_string(i) + "_0");
+  }
+  std::cout << "finished." << std::endl;
+  replicated_client.shutdown();
+  return 0;
+}
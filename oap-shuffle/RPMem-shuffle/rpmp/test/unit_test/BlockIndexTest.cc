@@ -0,0 +1,56 @@
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "pmpool/BlockIndex.h"
+#include "gtest/gtest.h"
+
+TEST(blockindex, append_get_remove) {
+  BlockIndex index(16);
+  ASSERT_TRUE(index.get(1).empty());
+  index.append(1, {100, 10});
+  index.append(17, {200, 20});
+  index.append(1, {300, 30});
+  ASSERT_EQ(index.size(), 2);
+  auto bml = index.get(1);
+  ASSERT_EQ(bml.size(), 2);
+  ASSERT_EQ(bml[0].address, 100);
+  ASSERT_EQ(bml[1].address, 300);
+  ASSERT_EQ(bml[1].size, 30);
+  ASSERT_EQ(index.get(17).size(), 1);
+  ASSERT_TRUE(index.remove(1));
+  ASSERT_FALSE(index.remove(1));
+  ASSERT_TRUE(index.get(1).empty());
+  ASSERT_EQ(index.get(17)[0].address, 200);
+  ASSERT_EQ(index.size(), 1);
+}
+
+void append_func(BlockIndex* index, uint64_t key, uint64_t num) {
+  for (uint64_t i = 0; i < num; i++) {
+    index->append(key, {i + 1, key});
+  }
+}
+
+TEST(blockindex, multithread) {
+  BlockIndex index(4);
+  std::vector<std::thread> threads;
+  for (uint64_t key = 1; key <= 8; key++) {
+    threads.emplace_back(append_func, &index, key, 1000);
+  }
+  // readers run concurrently with writers and always see an ordered prefix.
+  for (int i = 0; i < 100; i++) {
+    auto bml = index.get(1);
+    for (uint64_t j = 0; j < bml.size(); j++) {
+      ASSERT_EQ(bml[j].address, j + 1);
+    }
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(index.size(), 8);
+  for (uint64_t key = 1; key <= 8; key++) {
+    auto bml = index.get(key);
+    ASSERT_EQ(bml.size(), 1000);
+    ASSERT_EQ(bml[999].address, 1000);
+    ASSERT_EQ(bml[999].size, key);
+  }
+}
@@ -7,11 +7,13 @@
  * Copyright (c) 2019 Intel
  */
 
+#include <atomic>
 #include <thread>  // NOLINT
 #include <chrono>  // NOLINT
 #include <iostream>
+#include <vector>
 
-#include "../pmpool/buffer/CircularBuffer.h"
+#include "pmpool/buffer/CircularBuffer.h"
 #include "gtest/gtest.h"
 
 #define private public
@@ -112,3 +114,40 @@ TEST(circularbuffer, multithread) {
   ASSERT_EQ(addr, 0);
   t.join();
 }
+
+void stress_func(CircularBuffer* buffer, std::atomic<int>* owners, int id,
+                 std::atomic<bool>* overlapped) {
+  for (int i = 0; i < 20000; i++) {
+    uint64_t num = (i + id) % 5 + 1;
+    uint64_t addr = 0;
+    buffer->get(num, &addr);
+    for (uint64_t j = addr; j < addr + num; j++) {
+      int expected = 0;
+      if (!owners[j].compare_exchange_strong(expected, id)) {
+        *overlapped = true;
+      }
+    }
+    for (uint64_t j = addr; j < addr + num; j++) {
+      owners[j].store(0);
+    }
+    buffer->put(addr, num);
+  }
+}
+
+TEST(circularbuffer, concurrent) {
+  CircularBuffer buffer(1, 16);
+  std::atomic<int> owners[16];
+  for (int i = 0; i < 16; i++) {
+    owners[i].store(0);
+  }
+  std::atomic<bool> overlapped = {false};
+  std::vector<std::thread> threads;
+  for (int i = 1; i <= 8; i++) {
+    threads.emplace_back(stress_func, &buffer, owners, i, &overlapped);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_FALSE(overlapped.load());
+  ASSERT_EQ(buffer.get_read_(), buffer.get_write_());
+}
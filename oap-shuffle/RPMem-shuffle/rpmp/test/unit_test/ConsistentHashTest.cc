@@ -0,0 +1,77 @@
+/*
+ * Filename: /mnt/spark-pmof/tool/rpmp/test/ConsistentHashTest.cc
+ * Path: /mnt/spark-pmof/tool/rpmp/test
+ * Created Date: Saturday, October 17th 2026, 1:31:40 pm
+ * Author: root
+ *
+ * Copyright (c) 2026 Intel
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "pmpool/ConsistentHash.h"
+#include "gtest/gtest.h"
+
+TEST(consistenthash, route) {
+  ConsistentHash ring;
+  ASSERT_EQ(ring.get_node("key"), "");
+  ring.add_node("172.168.0.40:12346");
+  ring.add_node("172.168.0.41:12346");
+  ring.add_node("172.168.0.42:12346");
+  ASSERT_EQ(ring.size(), 3);
+  std::map<string, int> counts;
+  for (int i = 0; i < 30000; i++) {
+    string key = "shuffle_0_" + std::to_string(i) + "_0";
+    string node = ring.get_node(key);
+    ASSERT_EQ(node, ring.get_node(key));
+    counts[node]++;
+  }
+  ASSERT_EQ(counts.size(), 3);
+  for (auto& count : counts) {
+    ASSERT_GT(count.second, 5000);
+  }
+}
+
+TEST(consistenthash, remap) {
+  ConsistentHash ring;
+  for (int i = 0; i < 4; i++) {
+    ring.add_node("172.168.0.4" + std::to_string(i) + ":12346");
+  }
+  int key_num = 20000;
+  std::vector<string> before;
+  for (int i = 0; i < key_num; i++) {
+    before.push_back(ring.get_node("key_" + std::to_string(i)));
+  }
+  ring.add_node("172.168.0.44:12346");
+  int moved = 0;
+  for (int i = 0; i < key_num; i++) {
+    string node = ring.get_node("key_" + std::to_string(i));
+    if (node != before[i]) {
+      // keys only move to the new server
+      ASSERT_EQ(node, "172.168.0.44:12346");
+      moved++;
+    }
+  }
+  ASSERT_LT(moved, key_num / 3);
+  ring.remove_node("172.168.0.44:12346");
+  for (int i = 0; i < key_num; i++) {
+    ASSERT_EQ(ring.get_node("key_" + std::to_string(i)), before[i]);
+  }
+}
+
+TEST(consistenthash, replicas) {
+  ConsistentHash ring;
+  ring.add_node("172.168.0.40:12346");
+  ring.add_node("172.168.0.41:12346");
+  ring.add_node("172.168.0.42:12346");
+  for (int i = 0; i < 1000; i++) {
+    string key = "key_" + std::to_string(i);
+    auto nodes = ring.get_nodes(key, 2);
+    ASSERT_EQ(nodes.size(), 2);
+    ASSERT_EQ(nodes[0], ring.get_node(key));
+    ASSERT_NE(nodes[0], nodes[1]);
+  }
+  ASSERT_EQ(ring.get_nodes("key", 5).size(), 3);
+}
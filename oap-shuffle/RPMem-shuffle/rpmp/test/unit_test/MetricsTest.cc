@@ -0,0 +1,74 @@
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "pmpool/Event.h"
+#include "pmpool/Metrics.h"
+#include "gtest/gtest.h"
+
+TEST(metrics, histogram_bucket) {
+  for (uint64_t value : {0UL, 1UL, 31UL, 32UL, 33UL, 1000UL, 123456789UL,
+                         UINT64_MAX}) {
+    int bucket = Histogram::get_bucket(value);
+    ASSERT_LT(bucket, HISTOGRAM_BUCKET_NUM);
+    uint64_t upper = Histogram::get_upper_bound(bucket);
+    ASSERT_GE(upper, value);
+    // relative error is bounded by sub bucket resolution
+    ASSERT_LE(upper - value, value / HISTOGRAM_SUB_BUCKET_NUM);
+  }
+}
+
+TEST(metrics, histogram_percentile) {
+  Histogram histogram;
+  for (uint64_t i = 1; i <= 10000; i++) {
+    histogram.record(i * 1000);
+  }
+  ASSERT_EQ(histogram.count(), 10000);
+  ASSERT_EQ(histogram.max(), 10000000);
+  uint64_t p50 = histogram.percentile(50);
+  uint64_t p99 = histogram.percentile(99);
+  ASSERT_NEAR(p50, 5000000, 5000000 / HISTOGRAM_SUB_BUCKET_NUM);
+  ASSERT_NEAR(p99, 9900000, 9900000 / HISTOGRAM_SUB_BUCKET_NUM);
+  ASSERT_EQ(histogram.percentile(100), 10000000);
+}
+
+TEST(metrics, concurrent_record) {
+  Metrics metrics;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&metrics]() {
+      for (int j = 0; j < 10000; j++) {
+        metrics.record(PUT, j, 64, 0, true);
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  OpMetrics &op = metrics.get_op_metrics(PUT_REPLY);
+  ASSERT_EQ(op.requests.load(), 40000);
+  ASSERT_EQ(op.bytes_in.load(), 40000 * 64);
+  ASSERT_EQ(op.latency.count(), 40000);
+  metrics.add_gauge("test_gauge", []() { return 42; });
+  std::string dump = metrics.dump();
+  ASSERT_NE(dump.find("rpmp_put_requests 40000"), std::string::npos);
+  ASSERT_NE(dump.find("rpmp_test_gauge 42"), std::string::npos);
+}
+
+TEST(metrics, trace_sample) {
+  Metrics disabled;
+  ASSERT_FALSE(disabled.sample(0));
+  Metrics metrics(100);
+  int sampled = 0;
+  for (int i = 0; i < 100000; i++) {
+    sampled += metrics.sample(i);
+  }
+  ASSERT_GT(sampled, 800);
+  ASSERT_LT(sampled, 1200);
+  // the first request of every client is not traced
+  int first_sampled = 0;
+  for (uint64_t client = 1; client <= 100; client++) {
+    first_sampled += metrics.sample(0, client);
+  }
+  ASSERT_LT(first_sampled, 10);
+}